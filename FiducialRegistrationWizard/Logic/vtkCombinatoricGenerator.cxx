@@ -240,23 +240,11 @@ std::vector< std::vector< int > > vtkCombinatoricGenerator::GetOutputSets()
   }
 
   // return a deep copy
-  std::vector< std::vector< int > > returnValue;
-  returnValue.reserve( this->OutputSets.size() );
-  for ( unsigned int setIndex = 0; setIndex < this->OutputSets.size(); setIndex++ )
-  {
-    std::vector< int > innerList;
-    innerList.reserve( this->OutputSets[ setIndex ].size() );
-    for ( unsigned int elementIndex = 0; elementIndex < this->OutputSets[ setIndex ].size(); elementIndex++ )
-    {
-      innerList.push_back( this->OutputSets[ setIndex ][ elementIndex ] );
-    }
-    returnValue.push_back( this->OutputSets[ setIndex ] );
-  }
-  return returnValue;
+  return this->OutputSets;
 }
 
 //------------------------------------------------------------------------------
-unsigned int vtkCombinatoricGenerator::ComputeNumberOfOutputSets()
+vtkIdType vtkCombinatoricGenerator::ComputeNumberOfOutputSets() const
 {
   switch ( this->Combinatoric )
   {
@@ -333,28 +321,24 @@ void vtkCombinatoricGenerator::Update()
     return;
   }
 
-  switch ( this->Combinatoric )
+  this->OutputSets.clear();
+  if ( this->InputSets.size() == 0 )
   {
-    case COMBINATORIC_CARTESIAN_PRODUCT:
-    {
-      this->UpdateCartesianProducts();
-      break;
-    }
-    case COMBINATORIC_PERMUTATION:
-    {
-      this->UpdatePermutations();
-      break;
-    }
-    case COMBINATORIC_COMBINATION:
-    {
-      this->UpdateCombinations();
-      break;
-    }
-    default:
-    {
-      vtkErrorMacro( "Unknown combinatoric. Cannot update." );
-      break;
-    }
+    vtkGenericWarningMacro( "There is no input. Output will be empty." );
+  }
+  else if ( this->InputSets.size() > 1 && this->Combinatoric != COMBINATORIC_CARTESIAN_PRODUCT )
+  {
+    vtkGenericWarningMacro( "There are multiple inputs. Only the set with index = " << MAIN_SET_INDEX_FOR_PERMUTATION_AND_COMBINATION << " will be used for this operation." );
+  }
+
+  // the stored output is just the complete traversal
+  TraversalState traversalState;
+  this->InitTraversal( traversalState );
+  this->OutputSets.reserve( traversalState.EndSetIndex );
+  std::vector< int > outputSet;
+  while ( this->GetNextSet( traversalState, outputSet ) )
+  {
+    this->OutputSets.push_back( outputSet );
   }
 
   this->OutputChangedTime.Modified();
@@ -367,329 +351,339 @@ bool vtkCombinatoricGenerator::UpdateNeeded()
 }
 
 //------------------------------------------------------------------------------
-void vtkCombinatoricGenerator::UpdateCartesianProducts()
-{
-  // error/warning checking
-  if ( !this->OutputSets.empty() )
-  {
-    vtkGenericWarningMacro( "Output is not empty. Clearing contents." );
-    this->OutputSets.clear();
-  }
-
-  if ( this->InputSets.size() == 0 )
-  {
-    vtkGenericWarningMacro( "There is no input. Output will be empty." );
-    return;
-  }
-  
-  // size the output appropriately
-  unsigned int numberOfPossibleCartesianProducts = this->NumberOfPossibleCartesianProducts();
-  this->OutputSets.reserve( numberOfPossibleCartesianProducts );
-
-  // prepare the recursive call
-  unsigned int numberOfComputedCartesianProducts = 0;
-  std::vector< int > currentProduct; // starts empty
-  this->UpdateCartesianProductsHelper( currentProduct, numberOfComputedCartesianProducts );
+// TRAVERSAL
+//------------------------------------------------------------------------------
 
-  // sanity check
-  if ( numberOfComputedCartesianProducts != numberOfPossibleCartesianProducts )
-  {
-    vtkGenericWarningMacro( "Number of computed cartesian products " << numberOfComputedCartesianProducts << " does not match the " <<
-                            "number of possible cartesian products " << numberOfPossibleCartesianProducts << ". " <<
-                            "This is a bug and results are likely to contain errors. Please report this issue." );
-  }
+//------------------------------------------------------------------------------
+void vtkCombinatoricGenerator::InitTraversal( TraversalState& state ) const
+{
+  this->InitTraversal( state, 0, this->ComputeNumberOfOutputSets() );
 }
 
 //------------------------------------------------------------------------------
-unsigned int vtkCombinatoricGenerator::NumberOfPossibleCartesianProducts()
+void vtkCombinatoricGenerator::InitTraversal( TraversalState& state, vtkIdType beginSetIndex, vtkIdType endSetIndex ) const
 {
-  if ( this->InputSets.size() == 0 )
+  vtkIdType numberOfSets = this->ComputeNumberOfOutputSets();
+  if ( endSetIndex > numberOfSets )
   {
-    return 0;
+    endSetIndex = numberOfSets;
   }
-
-  int numberOfCartesianProducts = 1;
-  for ( unsigned int setIndex = 0; setIndex < this->InputSets.size(); setIndex++ )
+  if ( beginSetIndex < 0 )
   {
-    numberOfCartesianProducts *= this->InputSets[ setIndex ].size();
+    beginSetIndex = 0;
   }
-  return numberOfCartesianProducts;
-}
-
-//------------------------------------------------------------------------------
-// Recursive function to iterate through all input sets, and generate the cartesian products.
-// Elements are added to the currentProduct variable in each function call.
-void vtkCombinatoricGenerator::UpdateCartesianProductsHelper( std::vector< int >& currentProduct, unsigned int& cartesianProductCount )
-{
-  unsigned int numberOfInputSetsProcessed = currentProduct.size();
-
-  // base case, we've iterated through all input sets. So copy the current product to the output
-  if ( numberOfInputSetsProcessed >= this->InputSets.size() )
+  if ( beginSetIndex > endSetIndex )
   {
-    std::vector< int > currentProductCopy( numberOfInputSetsProcessed ); // initialize with size numberOfInputSetsProcessed
-    for ( unsigned int elementIndex = 0; elementIndex < numberOfInputSetsProcessed; elementIndex++ )
-    {
-      currentProductCopy[ elementIndex ] = currentProduct[ elementIndex ];
-    }
-    this->OutputSets.push_back( currentProductCopy );
-    cartesianProductCount++;
-    return;
+    beginSetIndex = endSetIndex;
   }
 
-  // recursive case, we need to iterate through all products containing each element
-  int inputSetIndex = numberOfInputSetsProcessed;
-  for ( unsigned int elementIndex = 0; elementIndex < this->InputSets[ inputSetIndex ].size(); elementIndex++ )
+  state.NextSetIndex = beginSetIndex;
+  state.EndSetIndex = endSetIndex;
+  state.ElementIndices.clear();
+  if ( beginSetIndex < endSetIndex )
   {
-    currentProduct.push_back( this->InputSets[ inputSetIndex ][ elementIndex ] );
-    this->UpdateCartesianProductsHelper( currentProduct, cartesianProductCount );
-    currentProduct.pop_back();
+    this->ComputeElementIndicesForSet( beginSetIndex, state.ElementIndices );
   }
 }
 
 //------------------------------------------------------------------------------
-void vtkCombinatoricGenerator::UpdateCombinations()
+bool vtkCombinatoricGenerator::GetNextSet( TraversalState& state, std::vector< int >& outputSet ) const
 {
-  // error/warning checking
-  if ( !this->OutputSets.empty() )
-  {
-    vtkGenericWarningMacro( "Output is not empty. Clearing contents." );
-    this->OutputSets.clear();
-  }
-  
-  if ( this->InputSets.size() == 0 )
+  if ( state.NextSetIndex >= state.EndSetIndex )
   {
-    vtkGenericWarningMacro( "There is no input. Output will be empty." );
-    return;
+    return false;
   }
-  
-  if ( this->InputSets.size() > 1 )
+
+  unsigned int numberOfElements = state.ElementIndices.size();
+  outputSet.resize( numberOfElements ); // no reallocation after the first set
+  for ( unsigned int elementIndex = 0; elementIndex < numberOfElements; elementIndex++ )
   {
-    vtkGenericWarningMacro( "There are multiple inputs. Only the first input will be used for this operation." );
+    unsigned int inputSetIndex = ( this->Combinatoric == COMBINATORIC_CARTESIAN_PRODUCT ? elementIndex : MAIN_SET_INDEX_FOR_PERMUTATION_AND_COMBINATION );
+    outputSet[ elementIndex ] = this->InputSets[ inputSetIndex ][ state.ElementIndices[ elementIndex ] ];
   }
 
-  // size the output appropriately
-  unsigned int numberOfPossibleCombinations = this->NumberOfPossibleCombinations();
-  this->OutputSets.reserve( numberOfPossibleCombinations );
-
-  // prepare the recursive call
-  unsigned int inputElementIndex = 0; // Traverse the input set from first element to last
-  std::vector< int > initialSubset; // empty at the start
-  initialSubset.reserve( this->SubsetSize ); // reserve enough space for output sets
-  unsigned int numberOfComputedCombinations = 0;
-  this->UpdateCombinationsHelper( inputElementIndex, initialSubset, numberOfComputedCombinations );
-
-  // sanity check
-  if ( numberOfComputedCombinations != numberOfPossibleCombinations )
+  state.NextSetIndex++;
+  if ( state.NextSetIndex < state.EndSetIndex )
   {
-    vtkGenericWarningMacro( "Number of computed combinations " << numberOfComputedCombinations << " does not match the " <<
-                            "number of possible combinations " << numberOfPossibleCombinations << ". " <<
-                            "This is a bug and results are likely to contain errors. Please report this issue." );
+    this->AdvanceElementIndices( state.ElementIndices );
   }
+  return true;
 }
 
 //------------------------------------------------------------------------------
-// conventionally N choose K combinations,
-// ( N = input set size, K = subset size )
-// The number of combinations is N! / (K! * (N-K)!)
-// See: https://en.wikipedia.org/wiki/Combination
-unsigned int vtkCombinatoricGenerator::NumberOfPossibleCombinations()
+bool vtkCombinatoricGenerator::ComputeOutputSet( vtkIdType setIndex, std::vector< int >& outputSet ) const
 {
-  if ( this->InputSets.size() == 0 )
-  {
-    return 0;
-  }
-
-  int setSize = this->GetInputSetSize( MAIN_SET_INDEX_FOR_PERMUTATION_AND_COMBINATION );
-  int setSizeFactorial = Factorial( setSize );
+  TraversalState state;
+  this->InitTraversal( state, setIndex, setIndex + 1 );
+  return this->GetNextSet( state, outputSet );
+}
 
-  int subsetSize = this->SubsetSize;
-  if ( setSize < subsetSize )
+//------------------------------------------------------------------------------
+// Compute the element positions of the setIndex'th output set directly, without
+// generating the preceding sets. This allows starting a traversal anywhere.
+void vtkCombinatoricGenerator::ComputeElementIndicesForSet( vtkIdType setIndex, std::vector< int >& elementIndices ) const
+{
+  switch ( this->Combinatoric )
   {
-    vtkWarningMacro( "Set size " << setSize << " must be greater than subset size " << subsetSize << ". Will set subset size to " << setSize << " for this computation." );
-    subsetSize = setSize;
+    case COMBINATORIC_CARTESIAN_PRODUCT:
+    {
+      // mixed radix number, the last input set changes fastest
+      unsigned int numberOfInputSets = this->InputSets.size();
+      elementIndices.resize( numberOfInputSets );
+      for ( int inputSetIndex = numberOfInputSets - 1; inputSetIndex >= 0; inputSetIndex-- )
+      {
+        vtkIdType inputSetSize = this->InputSets[ inputSetIndex ].size();
+        elementIndices[ inputSetIndex ] = setIndex % inputSetSize;
+        setIndex /= inputSetSize;
+      }
+      break;
+    }
+    case COMBINATORIC_COMBINATION:
+    {
+      // lexicographic order: skip over all combinations that start with a smaller element
+      vtkIdType setSize = this->InputSets[ MAIN_SET_INDEX_FOR_PERMUTATION_AND_COMBINATION ].size();
+      elementIndices.resize( this->SubsetSize );
+      int candidateElementIndex = 0;
+      for ( unsigned int subsetElementIndex = 0; subsetElementIndex < this->SubsetSize; subsetElementIndex++ )
+      {
+        while ( true )
+        {
+          vtkIdType numberOfCombinationsWithCandidate = NumberOfCombinations( setSize - candidateElementIndex - 1, this->SubsetSize - subsetElementIndex - 1 );
+          if ( setIndex < numberOfCombinationsWithCandidate )
+          {
+            break;
+          }
+          setIndex -= numberOfCombinationsWithCandidate;
+          candidateElementIndex++;
+        }
+        elementIndices[ subsetElementIndex ] = candidateElementIndex;
+        candidateElementIndex++;
+      }
+      break;
+    }
+    case COMBINATORIC_PERMUTATION:
+    {
+      // lexicographic order: each position is a digit in a factorial-like number system
+      vtkIdType setSize = this->InputSets[ MAIN_SET_INDEX_FOR_PERMUTATION_AND_COMBINATION ].size();
+      elementIndices.resize( this->SubsetSize );
+      for ( unsigned int subsetElementIndex = 0; subsetElementIndex < this->SubsetSize; subsetElementIndex++ )
+      {
+        vtkIdType numberOfPermutationsPerElement = NumberOfKPermutations( setSize - subsetElementIndex - 1, this->SubsetSize - subsetElementIndex - 1 );
+        vtkIdType unusedElementRank = setIndex / numberOfPermutationsPerElement;
+        setIndex %= numberOfPermutationsPerElement;
+        // find the unusedElementRank'th element that is not used yet
+        int elementIndex = 0;
+        while ( true )
+        {
+          if ( !IsElementIndexUsed( elementIndices, subsetElementIndex, elementIndex ) )
+          {
+            if ( unusedElementRank == 0 )
+            {
+              break;
+            }
+            unusedElementRank--;
+          }
+          elementIndex++;
+        }
+        elementIndices[ subsetElementIndex ] = elementIndex;
+      }
+      break;
+    }
+    default:
+    {
+      vtkGenericWarningMacro( "Unknown combinatoric. Cannot compute output set." );
+      elementIndices.clear();
+      break;
+    }
   }
-  int subsetSizeFactorial = Factorial( subsetSize );    
-  
-  int setSizeMinusSubsetSize = setSize - subsetSize;
-  int setSizeMinusSubsetSizeFactorial = Factorial( setSizeMinusSubsetSize );
-
-  int numberOfCombinations = setSizeFactorial / ( subsetSizeFactorial * setSizeMinusSubsetSizeFactorial );
-  return numberOfCombinations;
 }
 
 //------------------------------------------------------------------------------
-// this recursive function traverses the input set from beginning to end,
-// and creates all combinations of the input list containing exactly N (SubsetSize) elements.
-// The combination will either contain element at index elementIndex, or it won't.
-void vtkCombinatoricGenerator::UpdateCombinationsHelper( unsigned int elementIndex, std::vector< int >& currentSubset, unsigned int& combinationCount )
+// Change the element positions in place to those of the next output set
+void vtkCombinatoricGenerator::AdvanceElementIndices( std::vector< int >& elementIndices ) const
 {
-  unsigned int currentSubsetSize = currentSubset.size();
-  unsigned int maximumSubsetSize = this->SubsetSize;
-
-  // Base cases
-  // The subset is complete, and should be added to the output
-  if ( currentSubsetSize == maximumSubsetSize )
+  int numberOfElements = elementIndices.size();
+  switch ( this->Combinatoric )
   {
-    std::vector< int > currentSubsetCopy( maximumSubsetSize ); // initialize with size maximumSubsetSize
-    for ( unsigned int elementIndex = 0; elementIndex < maximumSubsetSize; elementIndex++ )
+    case COMBINATORIC_CARTESIAN_PRODUCT:
+    {
+      for ( int inputSetIndex = numberOfElements - 1; inputSetIndex >= 0; inputSetIndex-- )
+      {
+        elementIndices[ inputSetIndex ]++;
+        if ( elementIndices[ inputSetIndex ] < ( int ) this->InputSets[ inputSetIndex ].size() )
+        {
+          return;
+        }
+        elementIndices[ inputSetIndex ] = 0;
+      }
+      break;
+    }
+    case COMBINATORIC_COMBINATION:
     {
-      int element = currentSubset[ elementIndex ];
-      currentSubsetCopy[ elementIndex ] = element;
+      // increment the rightmost element that can be incremented, then reset all elements after it
+      int setSize = this->InputSets[ MAIN_SET_INDEX_FOR_PERMUTATION_AND_COMBINATION ].size();
+      int subsetElementIndex = numberOfElements - 1;
+      while ( subsetElementIndex >= 0 && elementIndices[ subsetElementIndex ] == setSize - numberOfElements + subsetElementIndex )
+      {
+        subsetElementIndex--;
+      }
+      if ( subsetElementIndex < 0 )
+      {
+        return; // this was the last combination
+      }
+      elementIndices[ subsetElementIndex ]++;
+      for ( int followingElementIndex = subsetElementIndex + 1; followingElementIndex < numberOfElements; followingElementIndex++ )
+      {
+        elementIndices[ followingElementIndex ] = elementIndices[ followingElementIndex - 1 ] + 1;
+      }
+      break;
+    }
+    case COMBINATORIC_PERMUTATION:
+    {
+      // replace the rightmost element that can be replaced by a larger unused element,
+      // then fill all positions after it with the smallest unused elements
+      int setSize = this->InputSets[ MAIN_SET_INDEX_FOR_PERMUTATION_AND_COMBINATION ].size();
+      for ( int subsetElementIndex = numberOfElements - 1; subsetElementIndex >= 0; subsetElementIndex-- )
+      {
+        int largerElementIndex = elementIndices[ subsetElementIndex ] + 1;
+        while ( largerElementIndex < setSize && IsElementIndexUsed( elementIndices, subsetElementIndex, largerElementIndex ) )
+        {
+          largerElementIndex++;
+        }
+        if ( largerElementIndex >= setSize )
+        {
+          continue;
+        }
+        elementIndices[ subsetElementIndex ] = largerElementIndex;
+        for ( int followingElementIndex = subsetElementIndex + 1; followingElementIndex < numberOfElements; followingElementIndex++ )
+        {
+          int smallestUnusedElementIndex = 0;
+          while ( IsElementIndexUsed( elementIndices, followingElementIndex, smallestUnusedElementIndex ) )
+          {
+            smallestUnusedElementIndex++;
+          }
+          elementIndices[ followingElementIndex ] = smallestUnusedElementIndex;
+        }
+        return;
+      }
+      break; // this was the last permutation
+    }
+    default:
+    {
+      vtkGenericWarningMacro( "Unknown combinatoric. Cannot compute output set." );
+      break;
     }
-    this->OutputSets.push_back( currentSubsetCopy );
-    combinationCount++;
-    return;
   }
+}
 
-  // We're out of elements in the input set, so return without adding the subset to the output
-  if ( elementIndex == this->GetInputSetSize( MAIN_SET_INDEX_FOR_PERMUTATION_AND_COMBINATION ) )
+//------------------------------------------------------------------------------
+bool vtkCombinatoricGenerator::IsElementIndexUsed( const std::vector< int >& elementIndices, unsigned int numberOfIndicesToCheck, int elementIndex )
+{
+  for ( unsigned int index = 0; index < numberOfIndicesToCheck; index++ )
   {
-    return;
+    if ( elementIndices[ index ] == elementIndex )
+    {
+      return true;
+    }
   }
-
-  // Recursive cases
-  // *Does* contain the input set element at elementIndex:
-  currentSubset.push_back( this->GetInputElement( MAIN_SET_INDEX_FOR_PERMUTATION_AND_COMBINATION, elementIndex ) );
-  this->UpdateCombinationsHelper( elementIndex + 1, currentSubset, combinationCount );
-  currentSubset.pop_back(); // housekeeping
-
-  // *Does not* contain the input set element at elementIndex:
-  this->UpdateCombinationsHelper( elementIndex + 1, currentSubset, combinationCount );
+  return false;
 }
 
 //------------------------------------------------------------------------------
-void vtkCombinatoricGenerator::UpdatePermutations()
+// NUMBER OF OUTPUT SETS
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+vtkIdType vtkCombinatoricGenerator::NumberOfPossibleCartesianProducts() const
 {
-  // error/warning checking
-  if ( !this->OutputSets.empty() )
-  {
-    vtkGenericWarningMacro( "Output is not empty. Clearing contents." );
-    this->OutputSets.clear();
-  }
-  
   if ( this->InputSets.size() == 0 )
   {
-    vtkGenericWarningMacro( "There is no input. Output will be empty." );
-    return;
+    return 0;
   }
 
-  if ( this->InputSets.size() > 1 )
+  vtkIdType numberOfCartesianProducts = 1;
+  for ( unsigned int setIndex = 0; setIndex < this->InputSets.size(); setIndex++ )
   {
-    vtkGenericWarningMacro( "There are multiple inputs. Only the set with index = " << MAIN_SET_INDEX_FOR_PERMUTATION_AND_COMBINATION << " will be used for this operation." );
+    numberOfCartesianProducts *= this->InputSets[ setIndex ].size();
   }
+  return numberOfCartesianProducts;
+}
 
-  // size the output appropriately
-  unsigned int numberOfPossiblePermutations = this->NumberOfPossiblePermutations();
-  this->OutputSets.reserve( numberOfPossiblePermutations );
-
-  // prepare the recursive call
-  unsigned int numberOfComputedPermutations = 0; // variable is modified in place by the function below.
-  std::vector< int > workingCopyOfMainInputSet;
-  workingCopyOfMainInputSet.resize( this->GetInputSetSize( MAIN_SET_INDEX_FOR_PERMUTATION_AND_COMBINATION ) );
-  for ( unsigned int elementIndex = 0; elementIndex < this->GetInputSetSize( MAIN_SET_INDEX_FOR_PERMUTATION_AND_COMBINATION ); elementIndex++ )
+//------------------------------------------------------------------------------
+// conventionally N choose K combinations,
+// ( N = input set size, K = subset size )
+// See: https://en.wikipedia.org/wiki/Combination
+vtkIdType vtkCombinatoricGenerator::NumberOfPossibleCombinations() const
+{
+  if ( this->InputSets.size() == 0 )
   {
-    workingCopyOfMainInputSet[ elementIndex ] = this->GetInputElement( MAIN_SET_INDEX_FOR_PERMUTATION_AND_COMBINATION, elementIndex );
+    return 0;
   }
-  unsigned int initialSubsetSize = 0; // nothing has been processed yet, start at 0
-  this->UpdatePermutationsHelper( initialSubsetSize, workingCopyOfMainInputSet, numberOfComputedPermutations );
 
-  // sanity check
-  if ( numberOfComputedPermutations != numberOfPossiblePermutations )
+  vtkIdType setSize = this->InputSets[ MAIN_SET_INDEX_FOR_PERMUTATION_AND_COMBINATION ].size();
+  if ( setSize < ( vtkIdType ) this->SubsetSize )
   {
-    vtkGenericWarningMacro( "Number of computed permutations " << numberOfComputedPermutations << " does not match the " <<
-                            "number of possible permutations " << numberOfPossiblePermutations << ". " <<
-                            "This is a bug and results are likely to contain errors. Please report this issue." );
+    vtkGenericWarningMacro( "Set size " << setSize << " is smaller than subset size " << this->SubsetSize << ". There are no combinations." );
+    return 0;
   }
+  return NumberOfCombinations( setSize, this->SubsetSize );
 }
 
 //------------------------------------------------------------------------------
 // we're actually interested in the number of K-permutations on a set of N elements
 // ( N = input set size, K = subset size )
-// The number of K-permutations is N! / ( N - K )!
 // See: https://en.wikipedia.org/wiki/Permutation#k-permutations_of_n
-unsigned int vtkCombinatoricGenerator::NumberOfPossiblePermutations()
+vtkIdType vtkCombinatoricGenerator::NumberOfPossiblePermutations() const
 {
-
   if ( this->InputSets.size() == 0 )
   {
     return 0;
   }
 
-  int setSize = this->GetInputSetSize( MAIN_SET_INDEX_FOR_PERMUTATION_AND_COMBINATION );
-  int setSizeFactorial = Factorial( setSize );
-
-  int subsetSize = this->SubsetSize;
-  if ( setSize < subsetSize )
+  vtkIdType setSize = this->InputSets[ MAIN_SET_INDEX_FOR_PERMUTATION_AND_COMBINATION ].size();
+  if ( setSize < ( vtkIdType ) this->SubsetSize )
   {
-    vtkWarningMacro( "Input set size " << setSize << " must be greater than subset size " << subsetSize << ". Will set subset size to " << setSize << " for this computation." );
-    subsetSize = setSize;
+    vtkGenericWarningMacro( "Input set size " << setSize << " is smaller than subset size " << this->SubsetSize << ". There are no permutations." );
+    return 0;
   }
-
-  int setSizeMinusSubsetSize = setSize - subsetSize;
-  int setSizeMinusSubsetSizeFactorial = Factorial( setSizeMinusSubsetSize );
-
-  int numberOfPermutations = setSizeFactorial / setSizeMinusSubsetSizeFactorial;
-  return numberOfPermutations;
+  return NumberOfKPermutations( setSize, this->SubsetSize );
 }
 
 //------------------------------------------------------------------------------
-// This recursive function generates all possible N-permutations (N == SubsetSize) of the base set.
-// (Note: Base set is a working copy of the input set. This was done to abstract some of the input storage details out from this method.)
-// Output sets are constructed by one element at a time each time this function is called.
-// The permutation is actually done in-place on the InputSet
-void vtkCombinatoricGenerator::UpdatePermutationsHelper( unsigned int currentSubsetSize, std::vector< int >& baseSet, unsigned int& permutationCount )
+// N! / (K! * (N-K)!), computed incrementally so that intermediate values do not overflow
+vtkIdType vtkCombinatoricGenerator::NumberOfCombinations( vtkIdType setSize, vtkIdType subsetSize )
 {
-  // Base case, subset is complete... just copy to the output
-  unsigned int maximumSubsetSize = this->SubsetSize;
-  if ( currentSubsetSize == maximumSubsetSize )
+  if ( subsetSize < 0 || subsetSize > setSize )
   {
-    std::vector< int > baseSetCopyUpToSubsetSize( maximumSubsetSize ); // initialize with size maximumSubsetSize
-    for ( unsigned int elementIndex = 0; elementIndex < maximumSubsetSize; elementIndex++ )
-    {
-      int element = baseSet[ elementIndex ];
-      baseSetCopyUpToSubsetSize[ elementIndex ] = element;
-    }
-    this->OutputSets.push_back( baseSetCopyUpToSubsetSize );
-    permutationCount++;
-    return;
+    return 0;
   }
 
-  // Recursive case, try keeping element where it is, and...
-  this->UpdatePermutationsHelper( currentSubsetSize + 1, baseSet, permutationCount );
-  
-  // also generate permutations by swapping the front value with each of the
-  // following values. This will be done in-place on the input set.
-  for ( unsigned int swapIndex = currentSubsetSize + 1; swapIndex < baseSet.size(); swapIndex++ )
+  if ( subsetSize > setSize - subsetSize )
   {
-    // get the relevant indices and values _before_ swapping
-    unsigned int frontIndex = currentSubsetSize;
-    int frontElement = baseSet[ currentSubsetSize ];
-    int swapElement = baseSet[ swapIndex ];
-
-    // swap the values
-    baseSet[ swapIndex ] = frontElement;
-    baseSet[ frontIndex ] = swapElement;
-
-    // recursive step
-    this->UpdatePermutationsHelper( currentSubsetSize + 1, baseSet, permutationCount );
-
-    baseSet[ frontIndex ] = frontElement;
-    baseSet[ swapIndex ] = swapElement;
+    subsetSize = setSize - subsetSize;
   }
+  vtkIdType numberOfCombinations = 1;
+  for ( vtkIdType factorIndex = 1; factorIndex <= subsetSize; factorIndex++ )
+  {
+    // always divisible, the product of factorIndex consecutive integers is divisible by factorIndex!
+    numberOfCombinations = numberOfCombinations * ( setSize - subsetSize + factorIndex ) / factorIndex;
+  }
+  return numberOfCombinations;
 }
 
 //------------------------------------------------------------------------------
-unsigned int vtkCombinatoricGenerator::Factorial( unsigned int x )
+// N! / ( N - K )!
+vtkIdType vtkCombinatoricGenerator::NumberOfKPermutations( vtkIdType setSize, vtkIdType subsetSize )
 {
-  if ( x == 0 )
+  if ( subsetSize < 0 || subsetSize > setSize )
   {
-    return 1;
+    return 0;
   }
 
-  unsigned int factorial = 1;
-  for ( unsigned int multiplier = 2; multiplier <= x; multiplier++ )
+  vtkIdType numberOfPermutations = 1;
+  for ( vtkIdType factorIndex = 0; factorIndex < subsetSize; factorIndex++ )
   {
-    factorial *= multiplier;
+    numberOfPermutations *= ( setSize - factorIndex );
   }
-  return factorial;
+  return numberOfPermutations;
 }
@@ -5,6 +5,7 @@
 #include <vtkSetGet.h>
 #include <vtkObject.h>
 #include <vtkTimeStamp.h>
+#include <vtkType.h>
 
 // std includes
 #include <vector>
@@ -75,6 +76,7 @@ class VTK_SLICER_FIDUCIALREGISTRATIONWIZARD_MODULE_LOGIC_EXPORT vtkCombinatoricG
     //  2, 3
     //  3, 1
     //  3, 2
+    // Outputs are in lexicographic order of the positions of the elements in the input set.
     void SetCombinatoricToPermutation();
     
     // Accessor for the combinatoric, return a string result
@@ -103,7 +105,7 @@ class VTK_SLICER_FIDUCIALREGISTRATIONWIZARD_MODULE_LOGIC_EXPORT vtkCombinatoricG
     int GetInputElement( unsigned int setIndex, unsigned int elementIndex );
 
     // Output accessors
-    unsigned int ComputeNumberOfOutputSets(); // returns the number of sets that *would* be computed on update
+    vtkIdType ComputeNumberOfOutputSets() const; // returns the number of sets that *would* be computed on update
     std::vector< std::vector< int > > GetOutputSets(); // returns a deep copy
     unsigned int GetOutputSetSize();
     int GetOutputElement( unsigned int setIndex, unsigned int elementIndex );
@@ -111,6 +113,35 @@ class VTK_SLICER_FIDUCIALREGISTRATIONWIZARD_MODULE_LOGIC_EXPORT vtkCombinatoricG
     // logic
     void Update();
 
+    // Lazy traversal of the output sets, without storing them (Update() does not need to be called).
+    // Usage is similar to vtkCollectionSimpleIterator:
+    //   vtkCombinatoricGenerator::TraversalState state;
+    //   generator->InitTraversal( state );
+    //   std::vector< int > outputSet;
+    //   while ( generator->GetNextSet( state, outputSet ) ) { ... }
+    // GetNextSet overwrites outputSet in place, so memory is only allocated for the first set.
+    // Traversal can be stopped at any time by not calling GetNextSet anymore.
+    // The index range of the sets can be restricted to [beginSetIndex, endSetIndex), which allows
+    // splitting the work between parallel workers. Sets are in the same order as in GetOutputSets().
+    // Each worker must use its own TraversalState. Traversals only read the generator, so they can run
+    // concurrently, as long as the inputs are not modified.
+    class TraversalState
+    {
+      public:
+        TraversalState() : NextSetIndex( 0 ), EndSetIndex( 0 ) {}
+        vtkIdType GetNextSetIndex() const { return this->NextSetIndex; }
+      private:
+        friend class vtkCombinatoricGenerator;
+        std::vector< int > ElementIndices; // positions in the input set(s) of the elements of the next set
+        vtkIdType NextSetIndex;
+        vtkIdType EndSetIndex;
+    };
+    void InitTraversal( TraversalState& state ) const;
+    void InitTraversal( TraversalState& state, vtkIdType beginSetIndex, vtkIdType endSetIndex ) const;
+    bool GetNextSet( TraversalState& state, std::vector< int >& outputSet ) const;
+    // Compute only the setIndex'th output set. Returns false if there is no such set.
+    bool ComputeOutputSet( vtkIdType setIndex, std::vector< int >& outputSet ) const;
+
   protected:
     vtkCombinatoricGenerator();
     ~vtkCombinatoricGenerator();
@@ -133,22 +164,16 @@ class VTK_SLICER_FIDUCIALREGISTRATIONWIZARD_MODULE_LOGIC_EXPORT vtkCombinatoricG
     vtkTimeStamp OutputChangedTime;
     bool UpdateNeeded();
 
-    // logic methods for cartesian product computation
-    void UpdateCartesianProducts();
-    void UpdateCartesianProductsHelper( std::vector< int >& currentProduct, unsigned int& cartesianProductCount ); // recursive helper
-    unsigned int NumberOfPossibleCartesianProducts();
+    vtkIdType NumberOfPossibleCartesianProducts() const;
+    vtkIdType NumberOfPossibleCombinations() const;
+    vtkIdType NumberOfPossiblePermutations() const;
+    static vtkIdType NumberOfCombinations( vtkIdType setSize, vtkIdType subsetSize ); // N choose K
+    static vtkIdType NumberOfKPermutations( vtkIdType setSize, vtkIdType subsetSize ); // N! / ( N - K )!
 
-    // logic methods for combination computation
-    void UpdateCombinations();
-    void UpdateCombinationsHelper( unsigned int inputElementIndex, std::vector< int >& currentSubset, unsigned int& combinationCount ); // recursive helper
-    unsigned int NumberOfPossibleCombinations();
-    
-    // logic methods for permutation computation
-    void UpdatePermutations();
-    void UpdatePermutationsHelper( unsigned int currentSubsetSize, std::vector< int >& baseSet, unsigned int& permutationCount ); // recursive helper
-    unsigned int NumberOfPossiblePermutations();
-    
-    unsigned int Factorial( unsigned int x );
+    // traversal helpers
+    void ComputeElementIndicesForSet( vtkIdType setIndex, std::vector< int >& elementIndices ) const;
+    void AdvanceElementIndices( std::vector< int >& elementIndices ) const;
+    static bool IsElementIndexUsed( const std::vector< int >& elementIndices, unsigned int numberOfIndicesToCheck, int elementIndex );
 
     vtkCombinatoricGenerator(const vtkCombinatoricGenerator&); // Not implemented.
     void operator=(const vtkCombinatoricGenerator&); // Not implemented.
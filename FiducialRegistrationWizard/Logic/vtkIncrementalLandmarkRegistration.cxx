@@ -0,0 +1,395 @@
+#include "vtkIncrementalLandmarkRegistration.h"
+
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkObjectFactory.h> //for vtkStandardNewMacro() macro
+#include <vtkPoints.h>
+
+// std includes
+#include <algorithm>
+
+#define MINIMUM_NUMBER_OF_POINT_PAIRS_FOR_REGISTRATION 3
+#define MAXIMUM_NUMBER_OF_INCREMENTAL_UPDATES 1000
+#define COORDINATES_PER_POINT_PAIR 6
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro( vtkIncrementalLandmarkRegistration );
+
+//------------------------------------------------------------------------------
+vtkIncrementalLandmarkRegistration::vtkIncrementalLandmarkRegistration()
+{
+  this->Mode = MODE_RIGID_BODY;
+  this->ResetSums();
+}
+
+//------------------------------------------------------------------------------
+vtkIncrementalLandmarkRegistration::~vtkIncrementalLandmarkRegistration()
+{
+}
+
+//------------------------------------------------------------------------------
+void vtkIncrementalLandmarkRegistration::PrintSelf( std::ostream &os, vtkIndent indent )
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Mode: " << ( this->Mode == MODE_SIMILARITY ? "Similarity" : "RigidBody" ) << std::endl;
+  os << indent << "NumberOfPointPairs: " << this->NumberOfPointPairs << std::endl;
+  os << indent << "NumberOfIncrementalUpdates: " << this->NumberOfIncrementalUpdates << std::endl;
+}
+
+//------------------------------------------------------------------------------
+void vtkIncrementalLandmarkRegistration::SetModeToRigidBody()
+{
+  if ( this->Mode == MODE_RIGID_BODY )
+  {
+    return;
+  }
+  this->Mode = MODE_RIGID_BODY;
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+void vtkIncrementalLandmarkRegistration::SetModeToSimilarity()
+{
+  if ( this->Mode == MODE_SIMILARITY )
+  {
+    return;
+  }
+  this->Mode = MODE_SIMILARITY;
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+// POINT PAIRS
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+void vtkIncrementalLandmarkRegistration::SetPointPairs( vtkPoints* fromPoints, vtkPoints* toPoints )
+{
+  if ( fromPoints == NULL || toPoints == NULL )
+  {
+    vtkGenericWarningMacro( "Input points are null. Returning." );
+    return;
+  }
+
+  int numberOfPointPairs = fromPoints->GetNumberOfPoints();
+  if ( toPoints->GetNumberOfPoints() != numberOfPointPairs )
+  {
+    vtkGenericWarningMacro( "Number of from points " << numberOfPointPairs << " does not match number of to points " << toPoints->GetNumberOfPoints() << ". Returning." );
+    return;
+  }
+
+  this->PointPairCoordinates.resize( COORDINATES_PER_POINT_PAIR * numberOfPointPairs );
+  this->ResetSums();
+  for ( int pairIndex = 0; pairIndex < numberOfPointPairs; pairIndex++ )
+  {
+    double* pointPair = &this->PointPairCoordinates[ COORDINATES_PER_POINT_PAIR * pairIndex ];
+    fromPoints->GetPoint( pairIndex, pointPair );
+    toPoints->GetPoint( pairIndex, pointPair + 3 );
+    this->AccumulatePointPair( pointPair, pointPair + 3, 1.0 );
+  }
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+void vtkIncrementalLandmarkRegistration::AddPointPair( const double fromPoint[ 3 ], const double toPoint[ 3 ] )
+{
+  this->PointPairCoordinates.insert( this->PointPairCoordinates.end(), fromPoint, fromPoint + 3 );
+  this->PointPairCoordinates.insert( this->PointPairCoordinates.end(), toPoint, toPoint + 3 );
+  this->AccumulatePointPair( fromPoint, toPoint, 1.0 );
+  this->NumberOfIncrementalUpdates++;
+  this->RecomputeSumsIfNeeded();
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+void vtkIncrementalLandmarkRegistration::RemovePointPair( int pairIndex )
+{
+  if ( pairIndex < 0 || pairIndex >= this->NumberOfPointPairs )
+  {
+    vtkGenericWarningMacro( "Point pair index " << pairIndex << " is out of range (number of pairs: " << this->NumberOfPointPairs << "). Returning." );
+    return;
+  }
+  std::vector< double >::iterator pointPairIt = this->PointPairCoordinates.begin() + COORDINATES_PER_POINT_PAIR * pairIndex;
+  this->AccumulatePointPair( &( *pointPairIt ), &( *pointPairIt ) + 3, -1.0 );
+  this->PointPairCoordinates.erase( pointPairIt, pointPairIt + COORDINATES_PER_POINT_PAIR );
+  this->NumberOfIncrementalUpdates++;
+  this->RecomputeSumsIfNeeded();
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+void vtkIncrementalLandmarkRegistration::UpdatePointPair( int pairIndex, const double fromPoint[ 3 ], const double toPoint[ 3 ] )
+{
+  if ( pairIndex < 0 || pairIndex >= this->NumberOfPointPairs )
+  {
+    vtkGenericWarningMacro( "Point pair index " << pairIndex << " is out of range (number of pairs: " << this->NumberOfPointPairs << "). Returning." );
+    return;
+  }
+  double* pointPair = &this->PointPairCoordinates[ COORDINATES_PER_POINT_PAIR * pairIndex ];
+  if ( std::equal( fromPoint, fromPoint + 3, pointPair ) && std::equal( toPoint, toPoint + 3, pointPair + 3 ) )
+  {
+    return;
+  }
+  this->AccumulatePointPair( pointPair, pointPair + 3, -1.0 );
+  std::copy( fromPoint, fromPoint + 3, pointPair );
+  std::copy( toPoint, toPoint + 3, pointPair + 3 );
+  this->AccumulatePointPair( pointPair, pointPair + 3, 1.0 );
+  this->NumberOfIncrementalUpdates++;
+  this->RecomputeSumsIfNeeded();
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+void vtkIncrementalLandmarkRegistration::RemoveAllPointPairs()
+{
+  this->PointPairCoordinates.clear();
+  this->ResetSums();
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+int vtkIncrementalLandmarkRegistration::GetNumberOfPointPairs()
+{
+  return this->NumberOfPointPairs;
+}
+
+//------------------------------------------------------------------------------
+void vtkIncrementalLandmarkRegistration::AccumulatePointPair( const double fromPoint[ 3 ], const double toPoint[ 3 ], double weight )
+{
+  this->NumberOfPointPairs += ( weight > 0.0 ? 1 : -1 );
+  for ( int i = 0; i < 3; i++ )
+  {
+    this->SumOfFromPoints[ i ] += weight * fromPoint[ i ];
+    this->SumOfToPoints[ i ] += weight * toPoint[ i ];
+    for ( int j = 0; j < 3; j++ )
+    {
+      this->SumOfFromToOuterProducts[ i ][ j ] += weight * fromPoint[ i ] * toPoint[ j ];
+      this->SumOfFromFromOuterProducts[ i ][ j ] += weight * fromPoint[ i ] * fromPoint[ j ];
+      this->SumOfToToOuterProducts[ i ][ j ] += weight * toPoint[ i ] * toPoint[ j ];
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+void vtkIncrementalLandmarkRegistration::ResetSums()
+{
+  this->NumberOfPointPairs = 0;
+  for ( int i = 0; i < 3; i++ )
+  {
+    this->SumOfFromPoints[ i ] = 0.0;
+    this->SumOfToPoints[ i ] = 0.0;
+    for ( int j = 0; j < 3; j++ )
+    {
+      this->SumOfFromToOuterProducts[ i ][ j ] = 0.0;
+      this->SumOfFromFromOuterProducts[ i ][ j ] = 0.0;
+      this->SumOfToToOuterProducts[ i ][ j ] = 0.0;
+    }
+  }
+  this->NumberOfIncrementalUpdates = 0;
+}
+
+//------------------------------------------------------------------------------
+void vtkIncrementalLandmarkRegistration::RecomputeSumsIfNeeded()
+{
+  if ( this->NumberOfIncrementalUpdates <= MAXIMUM_NUMBER_OF_INCREMENTAL_UPDATES )
+  {
+    return;
+  }
+  this->ResetSums();
+  int numberOfPointPairs = this->PointPairCoordinates.size() / COORDINATES_PER_POINT_PAIR;
+  for ( int pairIndex = 0; pairIndex < numberOfPointPairs; pairIndex++ )
+  {
+    const double* pointPair = &this->PointPairCoordinates[ COORDINATES_PER_POINT_PAIR * pairIndex ];
+    this->AccumulatePointPair( pointPair, pointPair + 3, 1.0 );
+  }
+}
+
+//------------------------------------------------------------------------------
+void vtkIncrementalLandmarkRegistration::GetFromPointsCovariance( double covariance[ 3 ][ 3 ] )
+{
+  vtkIncrementalLandmarkRegistration::GetCovariance( this->NumberOfPointPairs, this->SumOfFromPoints, this->SumOfFromFromOuterProducts, covariance );
+}
+
+//------------------------------------------------------------------------------
+void vtkIncrementalLandmarkRegistration::GetToPointsCovariance( double covariance[ 3 ][ 3 ] )
+{
+  vtkIncrementalLandmarkRegistration::GetCovariance( this->NumberOfPointPairs, this->SumOfToPoints, this->SumOfToToOuterProducts, covariance );
+}
+
+//------------------------------------------------------------------------------
+void vtkIncrementalLandmarkRegistration::GetCovariance( int numberOfPoints, const double sumOfPoints[ 3 ], const double sumOfOuterProducts[ 3 ][ 3 ], double covariance[ 3 ][ 3 ] )
+{
+  for ( int i = 0; i < 3; i++ )
+  {
+    for ( int j = 0; j < 3; j++ )
+    {
+      covariance[ i ][ j ] = 0.0;
+      if ( numberOfPoints > 1 )
+      {
+        covariance[ i ][ j ] = ( sumOfOuterProducts[ i ][ j ] - sumOfPoints[ i ] * sumOfPoints[ j ] / numberOfPoints ) / ( numberOfPoints - 1 );
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// REGISTRATION
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Least squares rotation from the SVD of the centered cross-covariance matrix
+// H = sum( ( from - fromCentroid ) * ( to - toCentroid )^T ) = U * W * V^T
+// rotation = V * D * U^T, where D corrects for reflection (Kabsch/Umeyama).
+// Scaling is the same as in vtkLandmarkTransform: ratio of root mean square distances from the centroids.
+bool vtkIncrementalLandmarkRegistration::GetMatrix( vtkMatrix4x4* matrix )
+{
+  if ( matrix == NULL )
+  {
+    vtkGenericWarningMacro( "Output matrix is null. Returning." );
+    return false;
+  }
+
+  if ( this->NumberOfPointPairs < MINIMUM_NUMBER_OF_POINT_PAIRS_FOR_REGISTRATION )
+  {
+    vtkGenericWarningMacro( "There are " << this->NumberOfPointPairs << " point pairs, at least " << MINIMUM_NUMBER_OF_POINT_PAIRS_FOR_REGISTRATION << " are needed for registration." );
+    return false;
+  }
+
+  double numberOfPointPairs = this->NumberOfPointPairs;
+  double fromCentroid[ 3 ];
+  double toCentroid[ 3 ];
+  double crossCovariance[ 3 ][ 3 ];
+  for ( int i = 0; i < 3; i++ )
+  {
+    fromCentroid[ i ] = this->SumOfFromPoints[ i ] / numberOfPointPairs;
+    toCentroid[ i ] = this->SumOfToPoints[ i ] / numberOfPointPairs;
+  }
+  for ( int i = 0; i < 3; i++ )
+  {
+    for ( int j = 0; j < 3; j++ )
+    {
+      crossCovariance[ i ][ j ] = this->SumOfFromToOuterProducts[ i ][ j ] - numberOfPointPairs * fromCentroid[ i ] * toCentroid[ j ];
+    }
+  }
+
+  double u[ 3 ][ 3 ];
+  double w[ 3 ];
+  double vt[ 3 ][ 3 ];
+  vtkMath::SingularValueDecomposition3x3( crossCovariance, u, w, vt );
+
+  // vtkMath returns rotations for U and V^T, with possibly negative singular values.
+  // Make the singular values non-negative, then flip the smallest one if needed to avoid a reflection.
+  for ( int k = 0; k < 3; k++ )
+  {
+    if ( w[ k ] < 0.0 )
+    {
+      w[ k ] = -w[ k ];
+      for ( int i = 0; i < 3; i++ )
+      {
+        u[ i ][ k ] = -u[ i ][ k ];
+      }
+    }
+  }
+  double reflectionCorrection[ 3 ] = { 1.0, 1.0, 1.0 };
+  if ( vtkMath::Determinant3x3( u ) * vtkMath::Determinant3x3( vt ) < 0.0 )
+  {
+    int smallestSingularValueIndex = 0;
+    for ( int k = 1; k < 3; k++ )
+    {
+      if ( w[ k ] < w[ smallestSingularValueIndex ] )
+      {
+        smallestSingularValueIndex = k;
+      }
+    }
+    reflectionCorrection[ smallestSingularValueIndex ] = -1.0;
+  }
+
+  double rotation[ 3 ][ 3 ];
+  for ( int i = 0; i < 3; i++ )
+  {
+    for ( int j = 0; j < 3; j++ )
+    {
+      rotation[ i ][ j ] = 0.0;
+      for ( int k = 0; k < 3; k++ )
+      {
+        rotation[ i ][ j ] += vt[ k ][ i ] * reflectionCorrection[ k ] * u[ j ][ k ];
+      }
+    }
+  }
+
+  double scale = 1.0;
+  if ( this->Mode == MODE_SIMILARITY )
+  {
+    double sumOfFromSquaredNorms = this->SumOfFromFromOuterProducts[ 0 ][ 0 ] + this->SumOfFromFromOuterProducts[ 1 ][ 1 ] + this->SumOfFromFromOuterProducts[ 2 ][ 2 ];
+    double sumOfToSquaredNorms = this->SumOfToToOuterProducts[ 0 ][ 0 ] + this->SumOfToToOuterProducts[ 1 ][ 1 ] + this->SumOfToToOuterProducts[ 2 ][ 2 ];
+    double fromSumOfSquaredDistancesFromCentroid = sumOfFromSquaredNorms - numberOfPointPairs * vtkMath::Dot( fromCentroid, fromCentroid );
+    double toSumOfSquaredDistancesFromCentroid = sumOfToSquaredNorms - numberOfPointPairs * vtkMath::Dot( toCentroid, toCentroid );
+    if ( fromSumOfSquaredDistancesFromCentroid <= 0.0 || toSumOfSquaredDistancesFromCentroid < 0.0 )
+    {
+      vtkGenericWarningMacro( "Points are coincident, cannot compute scaling." );
+      return false;
+    }
+    scale = sqrt( toSumOfSquaredDistancesFromCentroid / fromSumOfSquaredDistancesFromCentroid );
+  }
+
+  double rotatedFromCentroid[ 3 ];
+  vtkMath::Multiply3x3( rotation, fromCentroid, rotatedFromCentroid );
+  matrix->Identity();
+  for ( int i = 0; i < 3; i++ )
+  {
+    for ( int j = 0; j < 3; j++ )
+    {
+      matrix->SetElement( i, j, scale * rotation[ i ][ j ] );
+    }
+    matrix->SetElement( i, 3, toCentroid[ i ] - scale * rotatedFromCentroid[ i ] );
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// sum( | A * from + t - to |^2 ) expanded in terms of the sums:
+// trace( A^T A * sum( from from^T ) ) + 2 t^T A sum( from ) - 2 trace( A * sum( from to^T ) )
+//   + n |t|^2 - 2 t^T sum( to ) + trace( sum( to to^T ) )
+double vtkIncrementalLandmarkRegistration::ComputeRootMeanSquareError( vtkMatrix4x4* matrix )
+{
+  if ( matrix == NULL )
+  {
+    vtkGenericWarningMacro( "Input matrix is null. Returning." );
+    return VTK_DOUBLE_MAX;
+  }
+  if ( this->NumberOfPointPairs <= 0 )
+  {
+    return 0.0;
+  }
+
+  double linear[ 3 ][ 3 ];
+  double translation[ 3 ];
+  for ( int i = 0; i < 3; i++ )
+  {
+    for ( int j = 0; j < 3; j++ )
+    {
+      linear[ i ][ j ] = matrix->GetElement( i, j );
+    }
+    translation[ i ] = matrix->GetElement( i, 3 );
+  }
+
+  double sumOfSquaredErrors = this->NumberOfPointPairs * vtkMath::Dot( translation, translation );
+  for ( int i = 0; i < 3; i++ )
+  {
+    sumOfSquaredErrors += this->SumOfToToOuterProducts[ i ][ i ] - 2.0 * translation[ i ] * this->SumOfToPoints[ i ];
+    for ( int j = 0; j < 3; j++ )
+    {
+      sumOfSquaredErrors += 2.0 * translation[ i ] * linear[ i ][ j ] * this->SumOfFromPoints[ j ];
+      sumOfSquaredErrors -= 2.0 * linear[ i ][ j ] * this->SumOfFromToOuterProducts[ j ][ i ];
+      for ( int k = 0; k < 3; k++ )
+      {
+        // ( A^T A )[ j ][ k ] = sum over i of A[ i ][ j ] * A[ i ][ k ]
+        sumOfSquaredErrors += linear[ i ][ j ] * linear[ i ][ k ] * this->SumOfFromFromOuterProducts[ k ][ j ];
+      }
+    }
+  }
+
+  // may be slightly negative due to rounding errors
+  return sqrt( std::max( 0.0, sumOfSquaredErrors ) / this->NumberOfPointPairs );
+}
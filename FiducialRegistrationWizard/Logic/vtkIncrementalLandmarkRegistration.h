@@ -0,0 +1,95 @@
+#ifndef __vtkIncrementalLandmarkRegistration_h
+#define __vtkIncrementalLandmarkRegistration_h
+
+#include <vtkObject.h>
+
+// std includes
+#include <vector>
+
+class vtkMatrix4x4;
+class vtkPoints;
+
+// export
+#include "vtkSlicerFiducialRegistrationWizardModuleLogicExport.h"
+
+// Computes the same rigid body or similarity registration as vtkLandmarkTransform,
+// but keeps running sums (centroids, covariances and cross-covariance) of the point pairs.
+// Adding, moving or removing a single pair updates the sums in constant time,
+// and the registration, its error, and the covariance of the point sets are computed
+// from the sums with 3x3 matrix operations, so the cost does not grow with the number of points.
+class VTK_SLICER_FIDUCIALREGISTRATIONWIZARD_MODULE_LOGIC_EXPORT vtkIncrementalLandmarkRegistration : public vtkObject
+{
+  public:
+    vtkTypeMacro( vtkIncrementalLandmarkRegistration, vtkObject );
+    static vtkIncrementalLandmarkRegistration* New();
+
+    void PrintSelf( ostream &os, vtkIndent indent ) override;
+
+    enum RegistrationMode
+    {
+      MODE_RIGID_BODY = 0,
+      MODE_SIMILARITY,
+      MODE_LAST // Valid types go above this line
+    };
+
+    // Rigid body (default) or similarity (rigid body + isotropic scaling) registration
+    vtkGetMacro( Mode, int );
+    void SetModeToRigidBody();
+    void SetModeToSimilarity();
+
+    // Replace all point pairs with the ordered point lists (the sums are recomputed).
+    // The lists must be the same length.
+    void SetPointPairs( vtkPoints* fromPoints, vtkPoints* toPoints );
+
+    // Operations on single pairs, in constant time (except for moving the stored pairs
+    // after the removed one). Pairs are identified by their index, in the order they were added.
+    void AddPointPair( const double fromPoint[ 3 ], const double toPoint[ 3 ] );
+    void RemovePointPair( int pairIndex );
+    void UpdatePointPair( int pairIndex, const double fromPoint[ 3 ], const double toPoint[ 3 ] );
+    void RemoveAllPointPairs();
+    int GetNumberOfPointPairs();
+
+    // Compute the from->to registration matrix from the current sums.
+    // Returns false if there are too few pairs for a registration.
+    bool GetMatrix( vtkMatrix4x4* matrix );
+
+    // Root mean square distance between the to points and the from points transformed by the matrix
+    double ComputeRootMeanSquareError( vtkMatrix4x4* matrix );
+
+    // Sample covariance matrix of the from or to points (same as the one used by vtkPCAStatistics)
+    void GetFromPointsCovariance( double covariance[ 3 ][ 3 ] );
+    void GetToPointsCovariance( double covariance[ 3 ][ 3 ] );
+
+  protected:
+    vtkIncrementalLandmarkRegistration();
+    ~vtkIncrementalLandmarkRegistration();
+
+  private:
+    int Mode;
+
+    // current pairs (x, y, z of from point, then x, y, z of to point)
+    std::vector< double > PointPairCoordinates;
+
+    // running sums
+    int NumberOfPointPairs;
+    double SumOfFromPoints[ 3 ];
+    double SumOfToPoints[ 3 ];
+    double SumOfFromToOuterProducts[ 3 ][ 3 ]; // sum of from * to^T
+    double SumOfFromFromOuterProducts[ 3 ][ 3 ]; // sum of from * from^T
+    double SumOfToToOuterProducts[ 3 ][ 3 ]; // sum of to * to^T
+
+    // Removing pairs by subtraction accumulates rounding errors,
+    // so the sums are recomputed from scratch after a number of incremental updates
+    int NumberOfIncrementalUpdates;
+
+    void AccumulatePointPair( const double fromPoint[ 3 ], const double toPoint[ 3 ], double weight );
+    void ResetSums();
+    // Recompute the sums from the stored pairs if there were many incremental updates
+    void RecomputeSumsIfNeeded();
+    static void GetCovariance( int numberOfPoints, const double sumOfPoints[ 3 ], const double sumOfOuterProducts[ 3 ][ 3 ], double covariance[ 3 ][ 3 ] );
+
+    vtkIncrementalLandmarkRegistration(const vtkIncrementalLandmarkRegistration&); // Not implemented.
+    void operator=(const vtkIncrementalLandmarkRegistration&); // Not implemented.
+};
+
+#endif
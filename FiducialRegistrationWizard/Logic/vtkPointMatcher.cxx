@@ -5,16 +5,55 @@
 #include <vtkGeneralTransform.h>
 #include <vtkIterativeClosestPointTransform.h>
 #include <vtkLandmarkTransform.h>
+#include <vtkMatrix4x4.h>
 #include <vtkPointLocator.h>
 #include <vtkPolyData.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
 #include <vtkSmartPointer.h>
-#include <vtkTransform.h>
+#include <vtkStaticPointLocator.h>
+#include <vtkTimerLog.h>
 #include <vtkTransformPolyDataFilter.h>
 #include <vtkMath.h>
 
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
 #define RESET_VALUE_COMPUTED_ROOT_MEAN_DISTANCE_ERROR VTK_DOUBLE_MAX
 #define MINIMUM_NUMBER_OF_POINTS_NEEDED_TO_MATCH 3
 #define MAXIMUM_NUMBER_OF_POINTS_NEEDED_FOR_DETERMINISTIC_MATCH 5
+#define MAXIMUM_NUMBER_OF_CANDIDATES_PER_SOURCE_POINT 3
+#define NUMBER_OF_SEARCH_NODES_BETWEEN_TIME_CHECKS 1000
+#define MAXIMUM_NUMBER_OF_POINTS_FOR_BRANCH_AND_BOUND 40
+#define BRANCH_AND_BOUND_FRACTION_OF_TIME_LIMIT 0.25 // rest of the time is left for the other algorithms
+#define BRANCH_AND_BOUND_TIME_LIMIT_SEC 1.0 // used if there is no overall time limit
+#define MAXIMUM_NUMBER_OF_ICP_ITERATIONS 50 // same as the vtkIterativeClosestPointTransform default
+
+namespace
+{
+  // A possible source point -> target point pairing, used by the distance signature matching
+  struct PointPairCandidate
+  {
+    int SourcePointIndex;
+    int TargetPointIndex;
+    int SignatureScore; // number of distances to other points that are shared by the two points
+  };
+
+  bool IsCandidateMoreSimilar( const PointPairCandidate& candidate1, const PointPairCandidate& candidate2 )
+  {
+    // ties are broken by the indices, so that the order (and the result of the matching) is deterministic
+    if ( candidate1.SignatureScore != candidate2.SignatureScore )
+    {
+      return candidate1.SignatureScore > candidate2.SignatureScore;
+    }
+    if ( candidate1.SourcePointIndex != candidate2.SourcePointIndex )
+    {
+      return candidate1.SourcePointIndex < candidate2.SourcePointIndex;
+    }
+    return candidate1.TargetPointIndex < candidate2.TargetPointIndex;
+  }
+}
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro( vtkPointMatcher );
@@ -31,6 +70,10 @@ vtkPointMatcher::vtkPointMatcher()
   this->AmbiguityDistanceErrorMultiple = 0.05;
   this->AmbiguityDistanceError = 0.0;
   this->MatchingAmbiguous = false;
+  this->MaximumComputationTimeSec = 0.0;
+  this->UpdateStartTimeSec = 0.0;
+  this->ComputationTimeLimitReached = false;
+  this->MatchingIncomplete = false;
   // outputs are never null
   this->OutputSourcePoints = vtkSmartPointer< vtkPoints >::New();
   this->OutputTargetPoints = vtkSmartPointer< vtkPoints >::New();
@@ -67,6 +110,9 @@ void vtkPointMatcher::PrintSelf( std::ostream &os, vtkIndent indent )
   os << indent << "AmbiguityDistanceErrorMultiple: " << this->AmbiguityDistanceErrorMultiple << std::endl;
   os << indent << "AmbiguityDistanceError: " << this->AmbiguityDistanceError << std::endl;
   os << indent << "MatchingAmbiguous: " << this->MatchingAmbiguous << std::endl;
+  os << indent << "MaximumComputationTimeSec: " << this->MaximumComputationTimeSec << std::endl;
+  os << indent << "ComputationTimeLimitReached: " << this->ComputationTimeLimitReached << std::endl;
+  os << indent << "MatchingIncomplete: " << this->MatchingIncomplete << std::endl;
 }
 
 //------------------------------------------------------------------------------
@@ -166,6 +212,28 @@ double vtkPointMatcher::GetAmbiguityDistanceError()
   return this->AmbiguityDistanceError;
 }
 
+//------------------------------------------------------------------------------
+bool vtkPointMatcher::IsComputationTimeLimitReached()
+{
+  if ( this->UpdateNeeded() )
+  {
+    this->Update();
+  }
+
+  return this->ComputationTimeLimitReached;
+}
+
+//------------------------------------------------------------------------------
+bool vtkPointMatcher::IsMatchingIncomplete()
+{
+  if ( this->UpdateNeeded() )
+  {
+    this->Update();
+  }
+
+  return this->MatchingIncomplete;
+}
+
 //------------------------------------------------------------------------------
 // LOGIC
 //------------------------------------------------------------------------------
@@ -189,6 +257,9 @@ void vtkPointMatcher::Update()
   this->TolerableDistanceError = maximumDistanceInTargetPoints * this->TolerableDistanceErrorMultiple;
   this->AmbiguityDistanceError = maximumDistanceInTargetPoints * this->AmbiguityDistanceErrorMultiple;
   this->MatchingAmbiguous = false;
+  this->UpdateStartTimeSec = vtkTimerLog::GetUniversalTime();
+  this->ComputationTimeLimitReached = false;
+  this->MatchingIncomplete = false;
   this->OutputSourcePoints->Reset();
   this->OutputTargetPoints->Reset();
 
@@ -249,19 +320,50 @@ bool vtkPointMatcher::MatchPointsGenerally()
     return true;
   }
 
+  // exact, and fast unless the point layout is highly symmetric (then it stops at its own time limit,
+  // and the algorithms below are tried). If it stops, then its best matching so far is kept in the outputs
+  // and the algorithms below only replace it with a better one.
+  matchingSuccessful = this->MatchPointsGenerallyUsingBranchAndBound();
+  if ( matchingSuccessful )
+  {
+    return true;
+  }
+
+  if ( this->IsComputationTimeExceeded() )
+  {
+    return this->MatchingIncomplete;
+  }
+
+  // scales polynomially with the number of points, so it is suitable for large point sets
+  matchingSuccessful = this->MatchPointsGenerallyUsingDistanceSignatures();
+  if ( matchingSuccessful )
+  {
+    return true;
+  }
+
+  if ( this->IsComputationTimeExceeded() )
+  {
+    return this->MatchingIncomplete;
+  }
+
   matchingSuccessful = this->MatchPointsGenerallyUsingUniqueDistances();
   if ( matchingSuccessful )
   {
     return true;
   }
 
+  if ( this->IsComputationTimeExceeded() )
+  {
+    return this->MatchingIncomplete;
+  }
+
   matchingSuccessful = this->MatchPointsGenerallyUsingICP();
   if ( matchingSuccessful )
   {
     return true;
   }
 
-  return false;
+  return this->MatchingIncomplete;
 }
 
 //------------------------------------------------------------------------------
@@ -406,6 +508,10 @@ bool vtkPointMatcher::MatchPointsGenerallyUsingSubsample( vtkPoints* unmatchedRe
   {
     return false;
   }
+  if ( this->KeepIncompleteMatching( distanceError ) )
+  {
+    return true;
+  }
 
   this->MatchingAmbiguous = matchingAmbiguous;
   this->ComputedDistanceError = distanceError;
@@ -415,6 +521,203 @@ bool vtkPointMatcher::MatchPointsGenerallyUsingSubsample( vtkPoints* unmatchedRe
 }
 
 //------------------------------------------------------------------------------
+// Runs point-to-point ICP from one initial orientation per start index, for MatchPointsGenerallyUsingICP.
+// Each thread has its own ICP state (landmark transform and buffers); the target point locator is
+// built once and shared. Every start writes its result to its own element of StartResults, so the
+// results can be combined in a deterministic order after the parallel loop.
+// Starts after the first one that is within the tolerable error are skipped, while all the starts
+// before it are always run, so the combined result does not depend on the threads either.
+class vtkPointMatcherICPStartFunctor
+{
+public:
+  struct StartResult
+  {
+    bool MatchingSuccessful;
+    double DistanceError;
+    std::vector< int > TargetPointIndexForSourcePoint; // -1 for outliers
+  };
+
+  vtkPointMatcherICPStartFunctor()
+    : InitialRotationAxes( NULL )
+    , InitialRotationAnglesDeg( NULL )
+    , SourceCoordinates( NULL )
+    , TargetCoordinates( NULL )
+    , TargetPointLocator( NULL )
+    , ThresholdDistance2ForOutlier( 0.0 )
+    , MaximumOutlierCount( 0 )
+    , TolerableDistanceError( 0.0 )
+    , FirstStartIndexWithinTolerance( VTK_ID_MAX )
+  {
+    this->SourceCentroid[ 0 ] = this->SourceCentroid[ 1 ] = this->SourceCentroid[ 2 ] = 0.0;
+    this->TargetCentroid[ 0 ] = this->TargetCentroid[ 1 ] = this->TargetCentroid[ 2 ] = 0.0;
+  }
+
+  // inputs, shared between the threads (read only)
+  const double* InitialRotationAxes; // 3 components per start
+  const double* InitialRotationAnglesDeg; // 1 component per start
+  const std::vector< double >* SourceCoordinates;
+  const std::vector< double >* TargetCoordinates;
+  double SourceCentroid[ 3 ];
+  double TargetCentroid[ 3 ];
+  vtkStaticPointLocator* TargetPointLocator; // must be built, FindClosestPoint is thread-safe
+  double ThresholdDistance2ForOutlier;
+  unsigned int MaximumOutlierCount;
+  double TolerableDistanceError; // ICP of a start stops as soon as its matching is within this error
+
+  // Lowest index of the starts whose matching is within the tolerable error, VTK_ID_MAX if none so far.
+  // Starts with a higher index cannot change the result, so they are not run.
+  std::atomic< vtkIdType > FirstStartIndexWithinTolerance;
+
+  // outputs, one per start
+  std::vector< StartResult > StartResults;
+
+  void Initialize()
+  {
+    ThreadState& state = this->ThreadStates.Local();
+    state.LandmarkTransform = vtkSmartPointer< vtkLandmarkTransform >::New();
+    state.LandmarkTransform->SetModeToRigidBody();
+    state.SourceLandmarks = vtkSmartPointer< vtkPoints >::New();
+    state.SourceLandmarks->SetDataTypeToDouble();
+    state.TargetLandmarks = vtkSmartPointer< vtkPoints >::New();
+    state.TargetLandmarks->SetDataTypeToDouble();
+    state.LandmarkTransform->SetSourceLandmarks( state.SourceLandmarks );
+    state.LandmarkTransform->SetTargetLandmarks( state.TargetLandmarks );
+  }
+
+  void operator()( vtkIdType beginStartIndex, vtkIdType endStartIndex )
+  {
+    ThreadState& state = this->ThreadStates.Local();
+    for ( vtkIdType startIndex = beginStartIndex; startIndex < endStartIndex; startIndex++ )
+    {
+      StartResult& result = this->StartResults[ startIndex ];
+      if ( startIndex > this->FirstStartIndexWithinTolerance.load() )
+      {
+        result.MatchingSuccessful = false;
+        continue;
+      }
+      this->RunICP( startIndex, state, result );
+      if ( result.MatchingSuccessful && result.DistanceError <= this->TolerableDistanceError )
+      {
+        vtkIdType firstStartIndex = this->FirstStartIndexWithinTolerance.load();
+        while ( startIndex < firstStartIndex &&
+                !this->FirstStartIndexWithinTolerance.compare_exchange_weak( firstStartIndex, startIndex ) )
+        {
+        }
+      }
+    }
+  }
+
+  void Reduce()
+  {
+    // results are already stored per start
+  }
+
+private:
+  struct ThreadState
+  {
+    vtkSmartPointer< vtkLandmarkTransform > LandmarkTransform;
+    vtkSmartPointer< vtkPoints > SourceLandmarks;
+    vtkSmartPointer< vtkPoints > TargetLandmarks;
+    std::vector< int > ClosestTargetPointIndices;
+    std::vector< int > PreviousClosestTargetPointIndices;
+    std::vector< double > MatchedSourceCoordinates;
+    std::vector< double > MatchedTargetCoordinates;
+  };
+  vtkSMPThreadLocal< ThreadState > ThreadStates;
+
+  void RunICP( vtkIdType startIndex, ThreadState& state, StartResult& result )
+  {
+    int numberOfSourcePoints = this->SourceCoordinates->size() / 3;
+
+    // initial orientation, then match the centroids (like vtkIterativeClosestPointTransform::StartByMatchingCentroidsOn)
+    double axis[ 3 ] = { this->InitialRotationAxes[ 3 * startIndex ], this->InitialRotationAxes[ 3 * startIndex + 1 ], this->InitialRotationAxes[ 3 * startIndex + 2 ] };
+    vtkMath::Normalize( axis );
+    double halfAngleRad = vtkMath::RadiansFromDegrees( this->InitialRotationAnglesDeg[ startIndex ] ) / 2.0;
+    double quaternion[ 4 ] = { cos( halfAngleRad ), sin( halfAngleRad ) * axis[ 0 ], sin( halfAngleRad ) * axis[ 1 ], sin( halfAngleRad ) * axis[ 2 ] };
+    double rotation[ 3 ][ 3 ];
+    vtkMath::QuaternionToMatrix3x3( quaternion, rotation );
+    double rotatedSourceCentroid[ 3 ];
+    vtkMath::Multiply3x3( rotation, this->SourceCentroid, rotatedSourceCentroid );
+    double transformMatrix[ 16 ] =
+    {
+      rotation[ 0 ][ 0 ], rotation[ 0 ][ 1 ], rotation[ 0 ][ 2 ], this->TargetCentroid[ 0 ] - rotatedSourceCentroid[ 0 ],
+      rotation[ 1 ][ 0 ], rotation[ 1 ][ 1 ], rotation[ 1 ][ 2 ], this->TargetCentroid[ 1 ] - rotatedSourceCentroid[ 1 ],
+      rotation[ 2 ][ 0 ], rotation[ 2 ][ 1 ], rotation[ 2 ][ 2 ], this->TargetCentroid[ 2 ] - rotatedSourceCentroid[ 2 ],
+      0.0, 0.0, 0.0, 1.0
+    };
+
+    for ( int iterationIndex = 0; ; iterationIndex++ )
+    {
+      this->ComputeMatching( transformMatrix, state, result );
+      bool converged = ( iterationIndex > 0 && state.ClosestTargetPointIndices == state.PreviousClosestTargetPointIndices );
+      bool withinTolerance = ( result.MatchingSuccessful && result.DistanceError <= this->TolerableDistanceError );
+      if ( converged || withinTolerance || iterationIndex >= MAXIMUM_NUMBER_OF_ICP_ITERATIONS )
+      {
+        return;
+      }
+
+      // register all source points to their closest target points
+      state.SourceLandmarks->SetNumberOfPoints( numberOfSourcePoints );
+      state.TargetLandmarks->SetNumberOfPoints( numberOfSourcePoints );
+      for ( int sourcePointIndex = 0; sourcePointIndex < numberOfSourcePoints; sourcePointIndex++ )
+      {
+        state.SourceLandmarks->SetPoint( sourcePointIndex, &( *this->SourceCoordinates )[ 3 * sourcePointIndex ] );
+        state.TargetLandmarks->SetPoint( sourcePointIndex, &( *this->TargetCoordinates )[ 3 * state.ClosestTargetPointIndices[ sourcePointIndex ] ] );
+      }
+      state.SourceLandmarks->Modified();
+      state.TargetLandmarks->Modified();
+      state.LandmarkTransform->Update();
+      vtkMatrix4x4* landmarkMatrix = state.LandmarkTransform->GetMatrix();
+      std::copy( &landmarkMatrix->Element[ 0 ][ 0 ], &landmarkMatrix->Element[ 0 ][ 0 ] + 16, transformMatrix );
+      std::swap( state.ClosestTargetPointIndices, state.PreviousClosestTargetPointIndices );
+    }
+  }
+
+  // Same criteria as vtkPointMatcher::ComputePointMatchingBasedOnRegistration
+  void ComputeMatching( const double transformMatrix[ 16 ], ThreadState& state, StartResult& result ) const
+  {
+    int numberOfSourcePoints = this->SourceCoordinates->size() / 3;
+    state.ClosestTargetPointIndices.resize( numberOfSourcePoints );
+    result.TargetPointIndexForSourcePoint.resize( numberOfSourcePoints );
+    state.MatchedSourceCoordinates.clear();
+    state.MatchedTargetCoordinates.clear();
+    unsigned int outlierCount = 0;
+    for ( int sourcePointIndex = 0; sourcePointIndex < numberOfSourcePoints; sourcePointIndex++ )
+    {
+      const double* sourcePoint = &( *this->SourceCoordinates )[ 3 * sourcePointIndex ];
+      double sourcePointHomogeneous[ 4 ] = { sourcePoint[ 0 ], sourcePoint[ 1 ], sourcePoint[ 2 ], 1.0 };
+      double registeredSourcePoint[ 4 ];
+      vtkMatrix4x4::MultiplyPoint( transformMatrix, sourcePointHomogeneous, registeredSourcePoint );
+      int closestTargetPointIndex = this->TargetPointLocator->FindClosestPoint( registeredSourcePoint );
+      state.ClosestTargetPointIndices[ sourcePointIndex ] = closestTargetPointIndex;
+      const double* targetPoint = &( *this->TargetCoordinates )[ 3 * closestTargetPointIndex ];
+      if ( vtkMath::Distance2BetweenPoints( registeredSourcePoint, targetPoint ) < this->ThresholdDistance2ForOutlier )
+      {
+        result.TargetPointIndexForSourcePoint[ sourcePointIndex ] = closestTargetPointIndex;
+        state.MatchedSourceCoordinates.insert( state.MatchedSourceCoordinates.end(), sourcePoint, sourcePoint + 3 );
+        state.MatchedTargetCoordinates.insert( state.MatchedTargetCoordinates.end(), targetPoint, targetPoint + 3 );
+      }
+      else
+      {
+        result.TargetPointIndexForSourcePoint[ sourcePointIndex ] = -1;
+        outlierCount++;
+      }
+    }
+
+    int numberOfMatchedPoints = state.MatchedSourceCoordinates.size() / 3;
+    result.MatchingSuccessful = ( outlierCount <= this->MaximumOutlierCount && numberOfMatchedPoints >= MINIMUM_NUMBER_OF_POINTS_NEEDED_TO_MATCH );
+    result.DistanceError = VTK_DOUBLE_MAX;
+    if ( result.MatchingSuccessful )
+    {
+      result.DistanceError = vtkPointMatcher::ComputeRigidRegistrationRootMeanSquareError(
+        &state.MatchedSourceCoordinates[ 0 ], &state.MatchedTargetCoordinates[ 0 ], numberOfMatchedPoints );
+    }
+  }
+};
+
+//------------------------------------------------------------------------------
+// Try ICP from several different starting orientations. The starts are run in parallel,
+// and the later starts are skipped once a start is within the tolerable error.
 bool vtkPointMatcher::MatchPointsGenerallyUsingICP()
 {
   // try ICP from several different starting orientations
@@ -448,91 +751,309 @@ bool vtkPointMatcher::MatchPointsGenerallyUsingICP()
     315
   };
 
-  vtkSmartPointer< vtkPolyData > unmatchedSourcePointsPolyData = vtkSmartPointer< vtkPolyData >::New();
-  bool polyDataGenerated = vtkPointMatcher::GeneratePolyDataFromPoints( this->InputSourcePoints, unmatchedSourcePointsPolyData );
-  if ( !polyDataGenerated )
+  // starts in the same order as the nested axis and angle loops would visit them
+  int numberOfStarts = numberOfAxes * numberOfAngles;
+  std::vector< double > startAxes( 3 * numberOfStarts );
+  std::vector< double > startAngles( numberOfStarts );
+  for ( int axisIndex = 0; axisIndex < numberOfAxes; axisIndex++ )
   {
-    vtkGenericWarningMacro( "Unable to generate poly data from source points" );
-    return false;
+    for ( int angleIndex = 0; angleIndex < numberOfAngles; angleIndex++ )
+    {
+      int startIndex = axisIndex * numberOfAngles + angleIndex;
+      std::copy( axes + 3 * axisIndex, axes + 3 * axisIndex + 3, &startAxes[ 3 * startIndex ] );
+      startAngles[ startIndex ] = angles[ angleIndex ];
+    }
   }
 
   vtkSmartPointer< vtkPolyData > unmatchedTargetPointsPolyData = vtkSmartPointer< vtkPolyData >::New();
-  polyDataGenerated = vtkPointMatcher::GeneratePolyDataFromPoints( this->InputTargetPoints, unmatchedTargetPointsPolyData );
+  bool polyDataGenerated = vtkPointMatcher::GeneratePolyDataFromPoints( this->InputTargetPoints, unmatchedTargetPointsPolyData );
   if ( !polyDataGenerated )
   {
     vtkGenericWarningMacro( "Unable to generate poly data from target points" );
     return false;
   }
 
+  // the target points are the same for all starts, so the locator is only built once
+  vtkSmartPointer< vtkStaticPointLocator > targetPointLocator = vtkSmartPointer< vtkStaticPointLocator >::New();
+  targetPointLocator->SetDataSet( unmatchedTargetPointsPolyData );
+  targetPointLocator->BuildLocator();
+
+  // threads read coordinates from plain arrays, because vtkPoints::GetPoint( id ) is not thread-safe
+  int numberOfSourcePoints = this->InputSourcePoints->GetNumberOfPoints();
+  std::vector< double > sourceCoordinates( 3 * numberOfSourcePoints );
+  for ( int pointIndex = 0; pointIndex < numberOfSourcePoints; pointIndex++ )
+  {
+    this->InputSourcePoints->GetPoint( pointIndex, &sourceCoordinates[ 3 * pointIndex ] );
+  }
+  int numberOfTargetPoints = this->InputTargetPoints->GetNumberOfPoints();
+  std::vector< double > targetCoordinates( 3 * numberOfTargetPoints );
+  for ( int pointIndex = 0; pointIndex < numberOfTargetPoints; pointIndex++ )
+  {
+    this->InputTargetPoints->GetPoint( pointIndex, &targetCoordinates[ 3 * pointIndex ] );
+  }
+
+  vtkPointMatcherICPStartFunctor icpStartFunctor;
+  icpStartFunctor.InitialRotationAxes = &startAxes[ 0 ];
+  icpStartFunctor.InitialRotationAnglesDeg = &startAngles[ 0 ];
+  icpStartFunctor.SourceCoordinates = &sourceCoordinates;
+  icpStartFunctor.TargetCoordinates = &targetCoordinates;
+  vtkPointMatcher::ComputeCentroidOfPoints( this->InputSourcePoints, icpStartFunctor.SourceCentroid );
+  vtkPointMatcher::ComputeCentroidOfPoints( this->InputTargetPoints, icpStartFunctor.TargetCentroid );
+  icpStartFunctor.TargetPointLocator = targetPointLocator;
+  icpStartFunctor.ThresholdDistance2ForOutlier = this->Distance2ForOutlierRemovalAfterInitialRegistration();
+  icpStartFunctor.MaximumOutlierCount = this->MaximumDifferenceInNumberOfPoints;
+  icpStartFunctor.TolerableDistanceError = this->TolerableDistanceError;
+  icpStartFunctor.StartResults.resize( numberOfStarts );
+  vtkSMPTools::For( 0, numberOfStarts, icpStartFunctor );
+
+  // combine the results in start order, so that the outcome does not depend on the threads.
+  // Starts after the first one within tolerance may or may not have run, so they are ignored.
+  int numberOfStartsToCombine = numberOfStarts;
+  if ( icpStartFunctor.FirstStartIndexWithinTolerance.load() < numberOfStarts )
+  {
+    numberOfStartsToCombine = icpStartFunctor.FirstStartIndexWithinTolerance.load() + 1;
+  }
+  int bestStartIndex = -1;
+  double bestDistanceError = VTK_DOUBLE_MAX;
+  bool matchingAmbiguous = false;
+  for ( int startIndex = 0; startIndex < numberOfStartsToCombine; startIndex++ )
+  {
+    const vtkPointMatcherICPStartFunctor::StartResult& startResult = icpStartFunctor.StartResults[ startIndex ];
+    if ( !startResult.MatchingSuccessful )
+    {
+      continue;
+    }
+
+    if ( bestStartIndex >= 0 && startResult.TargetPointIndexForSourcePoint == icpStartFunctor.StartResults[ bestStartIndex ].TargetPointIndexForSourcePoint )
+    {
+      // same matching as the best one, found from a different start. It does not make the result ambiguous.
+      continue;
+    }
+
+    vtkPointMatcher::UpdateAmbiguityFlag( startResult.DistanceError, bestDistanceError, this->AmbiguityDistanceError, matchingAmbiguous );
+    if ( startResult.DistanceError == bestDistanceError )
+    {
+      bestStartIndex = startIndex;
+    }
+  }
+
+  if ( bestStartIndex < 0 || bestDistanceError > this->TolerableDistanceError )
+  {
+    return false;
+  }
+  if ( this->KeepIncompleteMatching( bestDistanceError ) )
+  {
+    return true;
+  }
+
+  this->MatchingAmbiguous = matchingAmbiguous;
+  this->ComputedDistanceError = bestDistanceError;
+  this->OutputSourcePoints->Reset();
+  this->OutputTargetPoints->Reset();
+  const std::vector< int >& bestTargetPointIndexForSourcePoint = icpStartFunctor.StartResults[ bestStartIndex ].TargetPointIndexForSourcePoint;
+  for ( int sourcePointIndex = 0; sourcePointIndex < numberOfSourcePoints; sourcePointIndex++ )
+  {
+    int targetPointIndex = bestTargetPointIndexForSourcePoint[ sourcePointIndex ];
+    if ( targetPointIndex < 0 )
+    {
+      continue;
+    }
+    this->OutputSourcePoints->InsertNextPoint( &sourceCoordinates[ 3 * sourcePointIndex ] );
+    this->OutputTargetPoints->InsertNextPoint( &targetCoordinates[ 3 * targetPointIndex ] );
+  }
+  this->OutputSourcePoints->Modified();
+  this->OutputTargetPoints->Modified();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Distances between points are invariant to rigid transforms, so corresponding
+// points share most of their (sorted) distances to the other points - this is the
+// 'signature' of the point. Signatures are used to find a few candidate pairings
+// for each source point. Starting from each candidate, a consensus set is grown
+// from the other candidates whose distances to all pairs already in the set agree.
+// Each consensus set gives a registration, which is evaluated on all points.
+// Computation is polynomial in the number of points.
+bool vtkPointMatcher::MatchPointsGenerallyUsingDistanceSignatures()
+{
+  int numberOfSourcePoints = this->InputSourcePoints->GetNumberOfPoints();
+  int numberOfTargetPoints = this->InputTargetPoints->GetNumberOfPoints();
+
+  std::vector< double > sourceDistances;
+  vtkPointMatcher::ComputeDistancesWithinPointSet( this->InputSourcePoints, sourceDistances );
+  std::vector< double > targetDistances;
+  vtkPointMatcher::ComputeDistancesWithinPointSet( this->InputTargetPoints, targetDistances );
+
+  std::vector< std::vector< double > > sourceSignatures;
+  vtkPointMatcher::ComputeDistanceSignatures( sourceDistances, numberOfSourcePoints, sourceSignatures );
+  std::vector< std::vector< double > > targetSignatures;
+  vtkPointMatcher::ComputeDistanceSignatures( targetDistances, numberOfTargetPoints, targetSignatures );
+
+  // each of the two points may be off by the tolerable error, so the distance between them may be off by twice as much
+  double distanceTolerance = 2.0 * this->TolerableDistanceError;
+
+  // keep the most similar target points as candidates for each source point
+  std::vector< PointPairCandidate > candidates;
+  for ( int sourcePointIndex = 0; sourcePointIndex < numberOfSourcePoints; sourcePointIndex++ )
+  {
+    std::vector< PointPairCandidate > candidatesForSourcePoint;
+    for ( int targetPointIndex = 0; targetPointIndex < numberOfTargetPoints; targetPointIndex++ )
+    {
+      PointPairCandidate candidate;
+      candidate.SourcePointIndex = sourcePointIndex;
+      candidate.TargetPointIndex = targetPointIndex;
+      candidate.SignatureScore = vtkPointMatcher::CountMatchingDistancesInSignatures( sourceSignatures[ sourcePointIndex ], targetSignatures[ targetPointIndex ], distanceTolerance );
+      if ( candidate.SignatureScore < MINIMUM_NUMBER_OF_POINTS_NEEDED_TO_MATCH - 1 )
+      {
+        // the pair would not be consistent with enough other pairs to form a matching
+        continue;
+      }
+      candidatesForSourcePoint.push_back( candidate );
+    }
+    std::sort( candidatesForSourcePoint.begin(), candidatesForSourcePoint.end(), IsCandidateMoreSimilar );
+    if ( candidatesForSourcePoint.size() > MAXIMUM_NUMBER_OF_CANDIDATES_PER_SOURCE_POINT )
+    {
+      candidatesForSourcePoint.resize( MAXIMUM_NUMBER_OF_CANDIDATES_PER_SOURCE_POINT );
+    }
+    candidates.insert( candidates.end(), candidatesForSourcePoint.begin(), candidatesForSourcePoint.end() );
+  }
+  std::sort( candidates.begin(), candidates.end(), IsCandidateMoreSimilar );
+  int numberOfCandidates = candidates.size();
+
   // re-used variables
-  vtkSmartPointer< vtkTransform > initialAlignmentTransform = vtkSmartPointer< vtkTransform >::New();
-  vtkSmartPointer< vtkTransformPolyDataFilter > initialAlignmentransformFilter = vtkSmartPointer< vtkTransformPolyDataFilter >::New();
-  vtkSmartPointer< vtkIterativeClosestPointTransform > icpTransform = vtkSmartPointer< vtkIterativeClosestPointTransform >::New();
-  icpTransform->GetLandmarkTransform()->SetModeToRigidBody();
-  icpTransform->StartByMatchingCentroidsOn();
-  vtkSmartPointer< vtkGeneralTransform > concatenatedAlignment = vtkSmartPointer< vtkGeneralTransform >::New();
+  std::vector< int > consensusSourcePointIndices;
+  std::vector< int > consensusTargetPointIndices;
+  std::vector< int > consensusTargetPointIndexForSourcePoint( numberOfSourcePoints ); // -1 if the source point is not in the consensus
+  std::vector< bool > targetPointInConsensus( numberOfTargetPoints );
+  std::vector< bool > candidateInEvaluatedConsensus( numberOfCandidates, false );
+  vtkSmartPointer< vtkPoints > consensusSourcePoints = vtkSmartPointer< vtkPoints >::New();
+  vtkSmartPointer< vtkPoints > consensusTargetPoints = vtkSmartPointer< vtkPoints >::New();
+  vtkSmartPointer< vtkLandmarkTransform > consensusRegistration = vtkSmartPointer< vtkLandmarkTransform >::New();
+  consensusRegistration->SetModeToRigidBody();
   double thresholdDistance2ForOutlier = this->Distance2ForOutlierRemovalAfterInitialRegistration();
   vtkSmartPointer< vtkPoints > matchedSourcePoints = vtkSmartPointer< vtkPoints >::New();
   vtkSmartPointer< vtkPoints > matchedTargetPoints = vtkSmartPointer< vtkPoints >::New();
   vtkSmartPointer< vtkPoints > bestMatchedSourcePoints = vtkSmartPointer< vtkPoints >::New();
   vtkSmartPointer< vtkPoints > bestMatchedTargetPoints = vtkSmartPointer< vtkPoints >::New();
   double bestDistanceError = VTK_DOUBLE_MAX;
-  bool matchingAmbiguous;
-  for ( int axisIndex = 0; axisIndex < numberOfAxes; axisIndex++ )
+  bool matchingAmbiguous = false;
+  for ( int seedCandidateIndex = 0; seedCandidateIndex < numberOfCandidates; seedCandidateIndex++ )
   {
-    double axis[ 3 ];
-    axis[ 0 ] = axes[ axisIndex * 3 ];
-    axis[ 1 ] = axes[ axisIndex * 3 + 1 ];
-    axis[ 2 ] = axes[ axisIndex * 3 + 2 ];
-    for ( int angleIndex = 0; angleIndex < numberOfAngles; angleIndex++ )
+    if ( candidateInEvaluatedConsensus[ seedCandidateIndex ] )
     {
-      double angle = angles[ angleIndex ];
-      initialAlignmentTransform->Identity();
-      initialAlignmentTransform->RotateWXYZ( angle, axis );
-  
-      initialAlignmentransformFilter->SetTransform( initialAlignmentTransform );
-      initialAlignmentransformFilter->SetInputData( unmatchedSourcePointsPolyData );
-      initialAlignmentransformFilter->Update();
+      // growing the consensus from this pair would most likely lead to the same matching again
+      continue;
+    }
+
+    if ( this->IsComputationTimeExceeded() )
+    {
+      vtkWarningMacro( "Time limit of " << this->MaximumComputationTimeSec << "s reached during point matching. Using best matching found so far." );
+      break;
+    }
 
-      vtkPolyData* initiallyAlignedSourcePointsPolyData = vtkPolyData::SafeDownCast( initialAlignmentransformFilter->GetOutput() );
-      if ( initiallyAlignedSourcePointsPolyData == NULL )
+    // grow the consensus set, most similar candidates first
+    consensusSourcePointIndices.clear();
+    consensusTargetPointIndices.clear();
+    std::fill( consensusTargetPointIndexForSourcePoint.begin(), consensusTargetPointIndexForSourcePoint.end(), -1 );
+    std::fill( targetPointInConsensus.begin(), targetPointInConsensus.end(), false );
+    const PointPairCandidate& seedCandidate = candidates[ seedCandidateIndex ];
+    consensusSourcePointIndices.push_back( seedCandidate.SourcePointIndex );
+    consensusTargetPointIndices.push_back( seedCandidate.TargetPointIndex );
+    consensusTargetPointIndexForSourcePoint[ seedCandidate.SourcePointIndex ] = seedCandidate.TargetPointIndex;
+    targetPointInConsensus[ seedCandidate.TargetPointIndex ] = true;
+    for ( int candidateIndex = 0; candidateIndex < numberOfCandidates; candidateIndex++ )
+    {
+      const PointPairCandidate& candidate = candidates[ candidateIndex ];
+      if ( consensusTargetPointIndexForSourcePoint[ candidate.SourcePointIndex ] >= 0 || targetPointInConsensus[ candidate.TargetPointIndex ] )
       {
-        vtkGenericWarningMacro( "Initially aligned points poly data is null." );
-        return false;
+        continue;
       }
-
-      icpTransform->SetSource( initiallyAlignedSourcePointsPolyData );
-      icpTransform->SetTarget( unmatchedTargetPointsPolyData );
-      icpTransform->Update();
-
-      concatenatedAlignment->Identity();
-      concatenatedAlignment->PostMultiply();
-      concatenatedAlignment->Concatenate( initialAlignmentTransform );
-      concatenatedAlignment->Concatenate( icpTransform );
-      bool matchingSuccessful = vtkPointMatcher::ComputePointMatchingBasedOnRegistration( concatenatedAlignment,
-                                                                                          this->InputSourcePoints, this->InputTargetPoints,
-                                                                                          thresholdDistance2ForOutlier, this->MaximumDifferenceInNumberOfPoints,
-                                                                                          matchedSourcePoints, matchedTargetPoints );
-      if ( !matchingSuccessful )
+      bool consistentWithConsensus = true;
+      int consensusSize = consensusSourcePointIndices.size();
+      for ( int consensusIndex = 0; consensusIndex < consensusSize; consensusIndex++ )
+      {
+        double sourceDistance = sourceDistances[ candidate.SourcePointIndex * numberOfSourcePoints + consensusSourcePointIndices[ consensusIndex ] ];
+        double targetDistance = targetDistances[ candidate.TargetPointIndex * numberOfTargetPoints + consensusTargetPointIndices[ consensusIndex ] ];
+        if ( fabs( sourceDistance - targetDistance ) > distanceTolerance )
+        {
+          consistentWithConsensus = false;
+          break;
+        }
+      }
+      if ( !consistentWithConsensus )
       {
         continue;
       }
+      consensusSourcePointIndices.push_back( candidate.SourcePointIndex );
+      consensusTargetPointIndices.push_back( candidate.TargetPointIndex );
+      consensusTargetPointIndexForSourcePoint[ candidate.SourcePointIndex ] = candidate.TargetPointIndex;
+      targetPointInConsensus[ candidate.TargetPointIndex ] = true;
+    }
 
-      double currentDistanceError = vtkPointMatcher::ComputeRegistrationRootMeanSquareError( matchedSourcePoints, matchedTargetPoints );
-      vtkPointMatcher::UpdateAmbiguityFlag( currentDistanceError, bestDistanceError, this->AmbiguityDistanceError, matchingAmbiguous );
-      if ( currentDistanceError == bestDistanceError )
+    // pairs in this consensus do not need to be used as seeds again
+    for ( int candidateIndex = 0; candidateIndex < numberOfCandidates; candidateIndex++ )
+    {
+      const PointPairCandidate& candidate = candidates[ candidateIndex ];
+      if ( consensusTargetPointIndexForSourcePoint[ candidate.SourcePointIndex ] == candidate.TargetPointIndex )
       {
-        bestMatchedSourcePoints->DeepCopy( matchedSourcePoints );
-        bestMatchedTargetPoints->DeepCopy( matchedTargetPoints );
+        candidateInEvaluatedConsensus[ candidateIndex ] = true;
       }
     }
+
+    int consensusSize = consensusSourcePointIndices.size();
+    if ( consensusSize < MINIMUM_NUMBER_OF_POINTS_NEEDED_TO_MATCH )
+    {
+      continue;
+    }
+
+    // registration from the consensus, then pair up all the points
+    consensusSourcePoints->Reset();
+    consensusTargetPoints->Reset();
+    for ( int consensusIndex = 0; consensusIndex < consensusSize; consensusIndex++ )
+    {
+      consensusSourcePoints->InsertNextPoint( this->InputSourcePoints->GetPoint( consensusSourcePointIndices[ consensusIndex ] ) );
+      consensusTargetPoints->InsertNextPoint( this->InputTargetPoints->GetPoint( consensusTargetPointIndices[ consensusIndex ] ) );
+    }
+    consensusSourcePoints->Modified();
+    consensusTargetPoints->Modified();
+    consensusRegistration->SetSourceLandmarks( consensusSourcePoints );
+    consensusRegistration->SetTargetLandmarks( consensusTargetPoints );
+    consensusRegistration->Update();
+
+    bool matchingSuccessful = vtkPointMatcher::ComputePointMatchingBasedOnRegistration( consensusRegistration,
+                                                                                        this->InputSourcePoints, this->InputTargetPoints,
+                                                                                        thresholdDistance2ForOutlier, this->MaximumDifferenceInNumberOfPoints,
+                                                                                        matchedSourcePoints, matchedTargetPoints );
+    if ( !matchingSuccessful )
+    {
+      continue;
+    }
+
+    if ( vtkPointMatcher::ArePointListsEqual( matchedSourcePoints, bestMatchedSourcePoints ) &&
+         vtkPointMatcher::ArePointListsEqual( matchedTargetPoints, bestMatchedTargetPoints ) )
+    {
+      // same matching as the best one, found from a different consensus. It does not make the result ambiguous.
+      continue;
+    }
+
+    double currentDistanceError = vtkPointMatcher::ComputeRegistrationRootMeanSquareError( matchedSourcePoints, matchedTargetPoints );
+    vtkPointMatcher::UpdateAmbiguityFlag( currentDistanceError, bestDistanceError, this->AmbiguityDistanceError, matchingAmbiguous );
+    if ( currentDistanceError == bestDistanceError )
+    {
+      bestMatchedSourcePoints->DeepCopy( matchedSourcePoints );
+      bestMatchedTargetPoints->DeepCopy( matchedTargetPoints );
+    }
   }
 
   if ( bestDistanceError > this->TolerableDistanceError )
   {
     return false;
   }
-  
+  if ( this->KeepIncompleteMatching( bestDistanceError ) )
+  {
+    return true;
+  }
+
   this->MatchingAmbiguous = matchingAmbiguous;
   this->ComputedDistanceError = bestDistanceError;
   this->OutputSourcePoints->DeepCopy( bestMatchedSourcePoints );
@@ -540,6 +1061,300 @@ bool vtkPointMatcher::MatchPointsGenerallyUsingICP()
   return true;
 }
 
+//------------------------------------------------------------------------------
+// Depth-first search over partial correspondences. Source points are visited one at a time,
+// and each is either paired with an unused target point or left unmatched. A target point is
+// only tried if its distances to the already paired target points agree with the corresponding
+// source distances, so most of the permutation tree is pruned without being visited.
+// Each complete correspondence (NumberOfPairsToMatch pairs) is evaluated by rigid registration.
+// A partial correspondence is also pruned if a lower bound of its registration error
+// (see vtkPointMatcher::ComputeRootMeanSquareErrorLowerBound) shows that it cannot be the best
+// or be within the ambiguity distance of the best.
+class vtkPointMatcherCorrespondenceSearch
+{
+public:
+  vtkPointMatcherCorrespondenceSearch()
+    : Matcher( NULL )
+    , NumberOfSourcePoints( 0 )
+    , NumberOfTargetPoints( 0 )
+    , DistanceTolerance( 0.0 )
+    , NumberOfPairsToMatch( 0 )
+    , MaximumAcceptedDistanceError( VTK_DOUBLE_MAX )
+    , AmbiguityDistanceError( 0.0 )
+    , StopTimeSec( 0.0 )
+    , BestDistanceError( VTK_DOUBLE_MAX )
+    , SecondBestDistanceError( VTK_DOUBLE_MAX )
+    , Aborted( false )
+    , NumberOfVisitedNodes( 0 )
+  {
+  }
+
+  // inputs
+  vtkPointMatcher* Matcher; // only used for checking the time limit
+  int NumberOfSourcePoints;
+  int NumberOfTargetPoints;
+  std::vector< double > SourceCoordinates;
+  std::vector< double > TargetCoordinates;
+  std::vector< double > SourceDistances; // NumberOfSourcePoints x NumberOfSourcePoints
+  std::vector< double > TargetDistances; // NumberOfTargetPoints x NumberOfTargetPoints
+  std::vector< int > SourcePointOrder; // order in which source points are paired
+  double DistanceTolerance;
+  int NumberOfPairsToMatch;
+  double MaximumAcceptedDistanceError; // correspondences with larger error are rejected by the caller
+  double AmbiguityDistanceError;
+  double StopTimeSec; // time limit of the search (in addition to the time limit of the matcher), 0 if none
+
+  // outputs
+  double BestDistanceError;
+  double SecondBestDistanceError;
+  std::vector< int > BestTargetPointIndexForSourcePoint; // -1 if the source point is unmatched
+  bool Aborted; // true if a time limit was reached before the search completed
+
+  void Search()
+  {
+    this->BestDistanceError = VTK_DOUBLE_MAX;
+    this->SecondBestDistanceError = VTK_DOUBLE_MAX;
+    this->BestTargetPointIndexForSourcePoint.assign( this->NumberOfSourcePoints, -1 );
+    this->Aborted = false;
+    this->TargetPointIndexForSourcePoint.assign( this->NumberOfSourcePoints, -1 );
+    this->TargetPointUsed.assign( this->NumberOfTargetPoints, false );
+    this->PairedSourcePointIndices.clear();
+    this->MaximumDistanceDifferences.assign( 1, 0.0 );
+    this->PairedSourceCoordinates.resize( 3 * this->NumberOfPairsToMatch );
+    this->PairedTargetCoordinates.resize( 3 * this->NumberOfPairsToMatch );
+    this->ExtendCorrespondence( 0 );
+  }
+
+private:
+  std::vector< int > TargetPointIndexForSourcePoint; // current partial correspondence, -1 if not paired
+  std::vector< bool > TargetPointUsed;
+  std::vector< int > PairedSourcePointIndices; // in the order they were paired
+  std::vector< double > MaximumDistanceDifferences; // largest pairwise distance difference with 0, 1, 2... pairs
+  std::vector< double > PairedSourceCoordinates; // scratch buffers for evaluation
+  std::vector< double > PairedTargetCoordinates;
+  vtkIdType NumberOfVisitedNodes;
+
+  void ExtendCorrespondence( int orderIndex )
+  {
+    if ( this->Aborted )
+    {
+      return;
+    }
+    this->NumberOfVisitedNodes++;
+    if ( this->NumberOfVisitedNodes % NUMBER_OF_SEARCH_NODES_BETWEEN_TIME_CHECKS == 0 &&
+         ( this->Matcher->IsComputationTimeExceeded() || ( this->StopTimeSec > 0.0 && vtkTimerLog::GetUniversalTime() > this->StopTimeSec ) ) )
+    {
+      this->Aborted = true;
+      return;
+    }
+
+    int numberOfPairs = this->PairedSourcePointIndices.size();
+    if ( numberOfPairs == this->NumberOfPairsToMatch )
+    {
+      this->EvaluateCorrespondence();
+      return;
+    }
+    int numberOfRemainingSourcePoints = this->NumberOfSourcePoints - orderIndex;
+    if ( numberOfRemainingSourcePoints < this->NumberOfPairsToMatch - numberOfPairs )
+    {
+      // not enough source points left to complete the correspondence
+      return;
+    }
+
+    int sourcePointIndex = this->SourcePointOrder[ orderIndex ];
+    for ( int targetPointIndex = 0; targetPointIndex < this->NumberOfTargetPoints; targetPointIndex++ )
+    {
+      if ( this->TargetPointUsed[ targetPointIndex ] )
+      {
+        continue;
+      }
+      double maximumDistanceDifference = 0.0;
+      if ( !this->IsPairConsistent( sourcePointIndex, targetPointIndex, maximumDistanceDifference ) )
+      {
+        continue;
+      }
+      // The registration errors of any two pairs satisfy e_i^2 + e_j^2 >= difference^2 / 2, so the root mean square
+      // error of the complete correspondence is at least difference / sqrt( 2 * NumberOfPairsToMatch ).
+      // Correspondences worse than the best by more than the ambiguity distance cannot change the result.
+      double distanceErrorLowerBound = maximumDistanceDifference / sqrt( 2.0 * this->NumberOfPairsToMatch );
+      if ( distanceErrorLowerBound > std::min( this->BestDistanceError, this->MaximumAcceptedDistanceError ) + this->AmbiguityDistanceError )
+      {
+        continue;
+      }
+      this->TargetPointIndexForSourcePoint[ sourcePointIndex ] = targetPointIndex;
+      this->TargetPointUsed[ targetPointIndex ] = true;
+      this->PairedSourcePointIndices.push_back( sourcePointIndex );
+      this->MaximumDistanceDifferences.push_back( maximumDistanceDifference );
+      this->ExtendCorrespondence( orderIndex + 1 );
+      this->MaximumDistanceDifferences.pop_back();
+      this->PairedSourcePointIndices.pop_back();
+      this->TargetPointUsed[ targetPointIndex ] = false;
+      this->TargetPointIndexForSourcePoint[ sourcePointIndex ] = -1;
+    }
+
+    // leave the source point unmatched
+    this->ExtendCorrespondence( orderIndex + 1 );
+  }
+
+  // maximumDistanceDifference is set to the largest distance difference in the correspondence extended with the pair
+  bool IsPairConsistent( int sourcePointIndex, int targetPointIndex, double& maximumDistanceDifference ) const
+  {
+    maximumDistanceDifference = this->MaximumDistanceDifferences.back();
+    int numberOfPairs = this->PairedSourcePointIndices.size();
+    for ( int pairIndex = 0; pairIndex < numberOfPairs; pairIndex++ )
+    {
+      int pairedSourcePointIndex = this->PairedSourcePointIndices[ pairIndex ];
+      int pairedTargetPointIndex = this->TargetPointIndexForSourcePoint[ pairedSourcePointIndex ];
+      double sourceDistance = this->SourceDistances[ sourcePointIndex * this->NumberOfSourcePoints + pairedSourcePointIndex ];
+      double targetDistance = this->TargetDistances[ targetPointIndex * this->NumberOfTargetPoints + pairedTargetPointIndex ];
+      double distanceDifference = fabs( sourceDistance - targetDistance );
+      if ( distanceDifference > this->DistanceTolerance )
+      {
+        return false;
+      }
+      maximumDistanceDifference = std::max( maximumDistanceDifference, distanceDifference );
+    }
+    return true;
+  }
+
+  void EvaluateCorrespondence()
+  {
+    for ( int pairIndex = 0; pairIndex < this->NumberOfPairsToMatch; pairIndex++ )
+    {
+      const double* sourcePoint = &this->SourceCoordinates[ 3 * this->PairedSourcePointIndices[ pairIndex ] ];
+      const double* targetPoint = &this->TargetCoordinates[ 3 * this->TargetPointIndexForSourcePoint[ this->PairedSourcePointIndices[ pairIndex ] ] ];
+      std::copy( sourcePoint, sourcePoint + 3, &this->PairedSourceCoordinates[ 3 * pairIndex ] );
+      std::copy( targetPoint, targetPoint + 3, &this->PairedTargetCoordinates[ 3 * pairIndex ] );
+    }
+    double distanceError = vtkPointMatcher::ComputeRigidRegistrationRootMeanSquareError(
+      &this->PairedSourceCoordinates[ 0 ], &this->PairedTargetCoordinates[ 0 ], this->NumberOfPairsToMatch );
+
+    // the search order is fixed, so on ties the first correspondence found is kept
+    if ( distanceError < this->BestDistanceError )
+    {
+      this->SecondBestDistanceError = this->BestDistanceError;
+      this->BestDistanceError = distanceError;
+      this->BestTargetPointIndexForSourcePoint = this->TargetPointIndexForSourcePoint;
+    }
+    else if ( distanceError < this->SecondBestDistanceError )
+    {
+      this->SecondBestDistanceError = distanceError;
+    }
+  }
+};
+
+//------------------------------------------------------------------------------
+// Exact search for the correspondence with the most pairs whose registration error is tolerable.
+// Correspondences are built one pair at a time and pruned as soon as a pairwise distance
+// disagrees (see vtkPointMatcherCorrespondenceSearch), so asymmetric layouts are resolved
+// after visiting only a small part of the search tree.
+// Only correspondences that pass the pairwise distance test are considered for ambiguity.
+// Near-symmetric layouts can still require visiting most of the tree, so the search is limited to
+// a part of the computation time and to small point sets; if it does not complete then
+// the other (approximate) algorithms are used. A tolerable matching found before the search
+// stopped is kept in the outputs (see IsMatchingIncomplete) and returns false.
+bool vtkPointMatcher::MatchPointsGenerallyUsingBranchAndBound()
+{
+  int numberOfSourcePoints = this->InputSourcePoints->GetNumberOfPoints();
+  int numberOfTargetPoints = this->InputTargetPoints->GetNumberOfPoints();
+  if ( numberOfSourcePoints > MAXIMUM_NUMBER_OF_POINTS_FOR_BRANCH_AND_BOUND ||
+       numberOfTargetPoints > MAXIMUM_NUMBER_OF_POINTS_FOR_BRANCH_AND_BOUND )
+  {
+    return false;
+  }
+
+  vtkPointMatcherCorrespondenceSearch correspondenceSearch;
+  correspondenceSearch.Matcher = this;
+  correspondenceSearch.NumberOfSourcePoints = numberOfSourcePoints;
+  correspondenceSearch.NumberOfTargetPoints = numberOfTargetPoints;
+  correspondenceSearch.SourceCoordinates.resize( 3 * numberOfSourcePoints );
+  for ( int pointIndex = 0; pointIndex < numberOfSourcePoints; pointIndex++ )
+  {
+    this->InputSourcePoints->GetPoint( pointIndex, &correspondenceSearch.SourceCoordinates[ 3 * pointIndex ] );
+  }
+  correspondenceSearch.TargetCoordinates.resize( 3 * numberOfTargetPoints );
+  for ( int pointIndex = 0; pointIndex < numberOfTargetPoints; pointIndex++ )
+  {
+    this->InputTargetPoints->GetPoint( pointIndex, &correspondenceSearch.TargetCoordinates[ 3 * pointIndex ] );
+  }
+  vtkPointMatcher::ComputeDistancesWithinPointSet( this->InputSourcePoints, correspondenceSearch.SourceDistances );
+  vtkPointMatcher::ComputeDistancesWithinPointSet( this->InputTargetPoints, correspondenceSearch.TargetDistances );
+
+  // each of the two points may be off by the tolerable error, so the distance between them may be off by twice as much
+  correspondenceSearch.DistanceTolerance = 2.0 * this->TolerableDistanceError;
+  correspondenceSearch.MaximumAcceptedDistanceError = this->TolerableDistanceError;
+  correspondenceSearch.AmbiguityDistanceError = this->AmbiguityDistanceError;
+  double searchTimeLimitSec = BRANCH_AND_BOUND_TIME_LIMIT_SEC;
+  if ( this->MaximumComputationTimeSec > 0.0 )
+  {
+    searchTimeLimitSec = this->MaximumComputationTimeSec * BRANCH_AND_BOUND_FRACTION_OF_TIME_LIMIT;
+  }
+  correspondenceSearch.StopTimeSec = vtkTimerLog::GetUniversalTime() + searchTimeLimitSec;
+
+  // pair the points far from the others first, their long distances rule out most target points early on
+  std::vector< std::pair< double, int > > sourcePointsByNegativeSumOfDistances( numberOfSourcePoints );
+  for ( int sourcePointIndex = 0; sourcePointIndex < numberOfSourcePoints; sourcePointIndex++ )
+  {
+    double sumOfDistances = 0.0;
+    for ( int otherSourcePointIndex = 0; otherSourcePointIndex < numberOfSourcePoints; otherSourcePointIndex++ )
+    {
+      sumOfDistances += correspondenceSearch.SourceDistances[ sourcePointIndex * numberOfSourcePoints + otherSourcePointIndex ];
+    }
+    sourcePointsByNegativeSumOfDistances[ sourcePointIndex ] = std::make_pair( -sumOfDistances, sourcePointIndex );
+  }
+  std::sort( sourcePointsByNegativeSumOfDistances.begin(), sourcePointsByNegativeSumOfDistances.end() );
+  correspondenceSearch.SourcePointOrder.resize( numberOfSourcePoints );
+  for ( int orderIndex = 0; orderIndex < numberOfSourcePoints; orderIndex++ )
+  {
+    correspondenceSearch.SourcePointOrder[ orderIndex ] = sourcePointsByNegativeSumOfDistances[ orderIndex ].second;
+  }
+
+  // prefer matching as many points as possible, like UpdateBestMatchingForSubsetsOfPoints
+  int smallerPointListSize = vtkMath::Min( numberOfSourcePoints, numberOfTargetPoints );
+  int minimumSubsetSize = vtkMath::Max( ( smallerPointListSize - ( int )this->MaximumDifferenceInNumberOfPoints ), MINIMUM_NUMBER_OF_POINTS_NEEDED_TO_MATCH );
+  for ( int subsetSize = smallerPointListSize; subsetSize >= minimumSubsetSize; subsetSize-- )
+  {
+    correspondenceSearch.NumberOfPairsToMatch = subsetSize;
+    correspondenceSearch.Search();
+    if ( correspondenceSearch.BestDistanceError > this->TolerableDistanceError )
+    {
+      if ( correspondenceSearch.Aborted )
+      {
+        vtkDebugMacro( "Time limit of " << searchTimeLimitSec << "s reached during branch and bound point matching, trying other algorithms." );
+        return false;
+      }
+      continue;
+    }
+
+    this->MatchingAmbiguous = ( correspondenceSearch.SecondBestDistanceError - correspondenceSearch.BestDistanceError <= this->AmbiguityDistanceError );
+    this->ComputedDistanceError = correspondenceSearch.BestDistanceError;
+    this->OutputSourcePoints->Reset();
+    this->OutputTargetPoints->Reset();
+    for ( int sourcePointIndex = 0; sourcePointIndex < numberOfSourcePoints; sourcePointIndex++ )
+    {
+      int targetPointIndex = correspondenceSearch.BestTargetPointIndexForSourcePoint[ sourcePointIndex ];
+      if ( targetPointIndex < 0 )
+      {
+        continue;
+      }
+      this->OutputSourcePoints->InsertNextPoint( &correspondenceSearch.SourceCoordinates[ 3 * sourcePointIndex ] );
+      this->OutputTargetPoints->InsertNextPoint( &correspondenceSearch.TargetCoordinates[ 3 * targetPointIndex ] );
+    }
+    this->OutputSourcePoints->Modified();
+    this->OutputTargetPoints->Modified();
+    if ( correspondenceSearch.Aborted )
+    {
+      vtkDebugMacro( "Time limit of " << searchTimeLimitSec << "s reached during branch and bound point matching, "
+                     "trying other algorithms to improve the best matching found so far." );
+      this->MatchingIncomplete = true;
+      return false;
+    }
+    return true;
+  }
+
+  return false;
+}
+
 //------------------------------------------------------------------------------
 bool vtkPointMatcher::InputsValid( bool verbose )
 {
@@ -601,6 +1416,17 @@ void vtkPointMatcher::HandleMatchFailure()
   this->ComputedDistanceError = vtkPointMatcher::ComputeRegistrationRootMeanSquareError( this->OutputSourcePoints, this->OutputTargetPoints );
 }
 
+//------------------------------------------------------------------------------
+bool vtkPointMatcher::KeepIncompleteMatching( double distanceError )
+{
+  if ( this->MatchingIncomplete && this->ComputedDistanceError <= distanceError )
+  {
+    return true;
+  }
+  this->MatchingIncomplete = false;
+  return false;
+}
+
 //------------------------------------------------------------------------------
 double vtkPointMatcher::Distance2ForOutlierRemovalAfterInitialRegistration()
 {
@@ -694,6 +1520,188 @@ void vtkPointMatcher::UpdateBestMatchingForSubsetsOfPoints( int minimumSubsetSiz
 }
 
 //------------------------------------------------------------------------------
+// Evaluates all permutations for a range of (source combination, target combination) pairs.
+// The combinations and permutations are generated lazily, starting from the beginning of the range.
+// Used with vtkSMPTools: each thread keeps its own best result, and the results are combined
+// in Reduce() in a way that does not depend on how the work was split between the threads.
+class vtkPointMatcherSubsetMatchingFunctor
+{
+public:
+  vtkPointMatcherSubsetMatchingFunctor()
+    : SubsetSize( 0 )
+    , SourceCoordinates( NULL )
+    , TargetCoordinates( NULL )
+    , SourceCombinationGenerator( NULL )
+    , TargetCombinationGenerator( NULL )
+    , PermutationGenerator( NULL )
+    , AmbiguityDistanceError( 0.0 )
+    , SharedBestDistanceError( VTK_DOUBLE_MAX )
+    , BestDistanceError( VTK_DOUBLE_MAX )
+    , BestCandidateIndex( -1 )
+    , SecondBestDistanceError( VTK_DOUBLE_MAX )
+  {
+  }
+
+  // inputs, shared between the threads (read only)
+  int SubsetSize;
+  const std::vector< double >* SourceCoordinates;
+  const std::vector< double >* TargetCoordinates;
+  const vtkCombinatoricGenerator* SourceCombinationGenerator;
+  const vtkCombinatoricGenerator* TargetCombinationGenerator;
+  const vtkCombinatoricGenerator* PermutationGenerator;
+  double AmbiguityDistanceError;
+
+  // Lowest error found so far by any thread. Candidates that are certainly worse than this by more than
+  // the ambiguity distance cannot affect the best result or the ambiguity, so they are not evaluated.
+  std::atomic< double > SharedBestDistanceError;
+
+  // outputs, valid after Reduce()
+  double BestDistanceError;
+  vtkIdType BestCandidateIndex; // pairIndex * numberOfPermutations + permutationIndex, -1 if none was evaluated
+  double SecondBestDistanceError;
+
+  void Initialize()
+  {
+    ThreadResult& result = this->ThreadResults.Local();
+    result.BestDistanceError = VTK_DOUBLE_MAX;
+    result.BestCandidateIndex = -1;
+    result.SecondBestDistanceError = VTK_DOUBLE_MAX;
+    result.SourceSubsetCoordinates.resize( 3 * this->SubsetSize );
+    result.PermutedTargetSubsetCoordinates.resize( 3 * this->SubsetSize );
+  }
+
+  void operator()( vtkIdType beginPairIndex, vtkIdType endPairIndex )
+  {
+    ThreadResult& result = this->ThreadResults.Local();
+    vtkIdType numberOfTargetCombinations = this->TargetCombinationGenerator->ComputeNumberOfOutputSets();
+    vtkIdType numberOfPermutations = this->PermutationGenerator->ComputeNumberOfOutputSets();
+
+    // start the traversals at the first pair of the range
+    this->SourceCombinationGenerator->InitTraversal( result.SourceTraversal,
+      beginPairIndex / numberOfTargetCombinations, this->SourceCombinationGenerator->ComputeNumberOfOutputSets() );
+    this->TargetCombinationGenerator->InitTraversal( result.TargetTraversal,
+      beginPairIndex % numberOfTargetCombinations, numberOfTargetCombinations );
+    this->SourceCombinationGenerator->GetNextSet( result.SourceTraversal, result.SourceCombination );
+    this->CopySourceSubsetCoordinates( result );
+
+    for ( vtkIdType pairIndex = beginPairIndex; pairIndex < endPairIndex; pairIndex++ )
+    {
+      if ( !this->TargetCombinationGenerator->GetNextSet( result.TargetTraversal, result.TargetCombination ) )
+      {
+        // all target combinations have been paired with this source combination, move on to the next one
+        this->SourceCombinationGenerator->GetNextSet( result.SourceTraversal, result.SourceCombination );
+        this->CopySourceSubsetCoordinates( result );
+        this->TargetCombinationGenerator->InitTraversal( result.TargetTraversal );
+        this->TargetCombinationGenerator->GetNextSet( result.TargetTraversal, result.TargetCombination );
+      }
+
+      this->PermutationGenerator->InitTraversal( result.PermutationTraversal );
+      for ( vtkIdType permutationIndex = 0; this->PermutationGenerator->GetNextSet( result.PermutationTraversal, result.Permutation ); permutationIndex++ )
+      {
+        for ( int pointIndex = 0; pointIndex < this->SubsetSize; pointIndex++ )
+        {
+          const double* targetPoint = &( *this->TargetCoordinates )[ 3 * result.TargetCombination[ result.Permutation[ pointIndex ] ] ];
+          std::copy( targetPoint, targetPoint + 3, &result.PermutedTargetSubsetCoordinates[ 3 * pointIndex ] );
+        }
+
+        double distanceErrorLowerBound = vtkPointMatcher::ComputeRootMeanSquareErrorLowerBound(
+          &result.SourceSubsetCoordinates[ 0 ], &result.PermutedTargetSubsetCoordinates[ 0 ], this->SubsetSize );
+        if ( distanceErrorLowerBound > this->SharedBestDistanceError.load() + this->AmbiguityDistanceError )
+        {
+          continue;
+        }
+
+        double distanceError = vtkPointMatcher::ComputeRigidRegistrationRootMeanSquareError(
+          &result.SourceSubsetCoordinates[ 0 ], &result.PermutedTargetSubsetCoordinates[ 0 ], this->SubsetSize );
+
+        // ranges may be processed in any order, so ties are broken by the candidate index
+        vtkIdType candidateIndex = pairIndex * numberOfPermutations + permutationIndex;
+        if ( distanceError < result.BestDistanceError ||
+             ( distanceError == result.BestDistanceError && candidateIndex < result.BestCandidateIndex ) )
+        {
+          result.SecondBestDistanceError = result.BestDistanceError;
+          result.BestDistanceError = distanceError;
+          result.BestCandidateIndex = candidateIndex;
+        }
+        else if ( distanceError < result.SecondBestDistanceError )
+        {
+          result.SecondBestDistanceError = distanceError;
+        }
+
+        double sharedBestDistanceError = this->SharedBestDistanceError.load();
+        while ( distanceError < sharedBestDistanceError &&
+                !this->SharedBestDistanceError.compare_exchange_weak( sharedBestDistanceError, distanceError ) )
+        {
+          // sharedBestDistanceError is updated by compare_exchange_weak, try again
+        }
+      }
+    }
+  }
+
+  void Reduce()
+  {
+    this->BestDistanceError = VTK_DOUBLE_MAX;
+    this->BestCandidateIndex = -1;
+    this->SecondBestDistanceError = VTK_DOUBLE_MAX;
+    for ( vtkSMPThreadLocal< ThreadResult >::iterator resultIt = this->ThreadResults.begin(); resultIt != this->ThreadResults.end(); ++resultIt )
+    {
+      const ThreadResult& result = *resultIt;
+      if ( result.BestCandidateIndex < 0 )
+      {
+        continue;
+      }
+      this->SecondBestDistanceError = std::min( this->SecondBestDistanceError, result.SecondBestDistanceError );
+      if ( result.BestDistanceError < this->BestDistanceError ||
+           ( result.BestDistanceError == this->BestDistanceError && result.BestCandidateIndex < this->BestCandidateIndex ) )
+      {
+        this->SecondBestDistanceError = std::min( this->SecondBestDistanceError, this->BestDistanceError );
+        this->BestDistanceError = result.BestDistanceError;
+        this->BestCandidateIndex = result.BestCandidateIndex;
+      }
+      else
+      {
+        this->SecondBestDistanceError = std::min( this->SecondBestDistanceError, result.BestDistanceError );
+      }
+    }
+  }
+
+private:
+  struct ThreadResult
+  {
+    double BestDistanceError;
+    vtkIdType BestCandidateIndex;
+    double SecondBestDistanceError;
+    // scratch buffers, allocated once per thread
+    vtkCombinatoricGenerator::TraversalState SourceTraversal;
+    vtkCombinatoricGenerator::TraversalState TargetTraversal;
+    vtkCombinatoricGenerator::TraversalState PermutationTraversal;
+    std::vector< int > SourceCombination;
+    std::vector< int > TargetCombination;
+    std::vector< int > Permutation;
+    std::vector< double > SourceSubsetCoordinates;
+    std::vector< double > PermutedTargetSubsetCoordinates;
+  };
+  vtkSMPThreadLocal< ThreadResult > ThreadResults;
+
+  void CopySourceSubsetCoordinates( ThreadResult& result ) const
+  {
+    for ( int pointIndex = 0; pointIndex < this->SubsetSize; pointIndex++ )
+    {
+      const double* sourcePoint = &( *this->SourceCoordinates )[ 3 * result.SourceCombination[ pointIndex ] ];
+      std::copy( sourcePoint, sourcePoint + 3, &result.SourceSubsetCoordinates[ 3 * pointIndex ] );
+    }
+  }
+};
+
+//------------------------------------------------------------------------------
+// point pair matching will be based on the distances between each pair of ordered points.
+// For all combinations of subsetSize points in both lists, we want to reorder the target subset
+// such that the point-to-point distances are as close as possible to those in the source subset.
+// We will permute over all possibilities (and only ever keep the best result.)
+// The search is run in parallel. Only the lowest and second lowest errors are kept, and these are
+// passed to UpdateAmbiguityFlag in increasing order. UpdateAmbiguityFlag only reports ambiguity if the
+// second lowest error of all evaluated candidates is within the ambiguity distance of the lowest one,
+// so the result is the same as if all candidates were passed to it one by one.
 void vtkPointMatcher::UpdateBestMatchingForNSizedSubsetsOfPoints(
   int subsetSize,
   vtkPoints* unmatchedSourcePoints,
@@ -730,7 +1738,8 @@ void vtkPointMatcher::UpdateBestMatchingForNSizedSubsetsOfPoints(
     return;
   }
 
-  // generate sets of indices for all possible combinations of both input sets
+  // generators for the sets of indices of all possible combinations of both input sets,
+  // the sets are not stored but generated on the fly by the workers
   vtkSmartPointer< vtkCombinatoricGenerator > sourcePointsCombinationGenerator = vtkSmartPointer< vtkCombinatoricGenerator >::New();
   sourcePointsCombinationGenerator->SetCombinatoricToCombination();
   sourcePointsCombinationGenerator->SetSubsetSize( subsetSize );
@@ -739,8 +1748,6 @@ void vtkPointMatcher::UpdateBestMatchingForNSizedSubsetsOfPoints(
   {
     sourcePointsCombinationGenerator->AddInputElement( 0, pointIndex );
   }
-  sourcePointsCombinationGenerator->Update();
-  std::vector< std::vector< int > > sourcePointsCombinationIndices = sourcePointsCombinationGenerator->GetOutputSets();
 
   vtkSmartPointer< vtkCombinatoricGenerator > targetPointsCombinationGenerator = vtkSmartPointer< vtkCombinatoricGenerator >::New();
   targetPointsCombinationGenerator->SetCombinatoricToCombination();
@@ -750,114 +1757,108 @@ void vtkPointMatcher::UpdateBestMatchingForNSizedSubsetsOfPoints(
   {
     targetPointsCombinationGenerator->AddInputElement( 0, pointIndex );
   }
-  targetPointsCombinationGenerator->Update();
-  std::vector< std::vector< int > > targetPointsCombinationIndices = targetPointsCombinationGenerator->GetOutputSets();
 
-  // these will store the actual combinations of points themselves (not indices)
-  vtkSmartPointer< vtkPoints > unmatchedSourcePointsCombination = vtkSmartPointer< vtkPoints >::New();
-  unmatchedSourcePointsCombination->SetNumberOfPoints( subsetSize );
-  vtkSmartPointer< vtkPoints > unmatchedTargetPointsCombination = vtkSmartPointer< vtkPoints >::New();
-  unmatchedTargetPointsCombination->SetNumberOfPoints( subsetSize );
-  // iterate over all combinations of both input point sets
-  for ( unsigned int sourcePointsCombinationIndex = 0; sourcePointsCombinationIndex < sourcePointsCombinationIndices.size(); sourcePointsCombinationIndex++ )
+  // the permutations of the target subset are the same for all combinations
+  vtkSmartPointer< vtkCombinatoricGenerator > permutationGenerator = vtkSmartPointer< vtkCombinatoricGenerator >::New();
+  permutationGenerator->SetCombinatoricToPermutation();
+  permutationGenerator->SetSubsetSize( subsetSize );
+  permutationGenerator->SetNumberOfInputSets( 1 );
+  for ( int pointIndex = 0; pointIndex < subsetSize; pointIndex++ )
   {
-    for ( unsigned int targetPointsCombinationIndex = 0; targetPointsCombinationIndex < targetPointsCombinationIndices.size(); targetPointsCombinationIndex++ )
-    {
-      // store appropriate contents in the unmatchedSourcePointsCombination and unmatchedTargetPointsCombination variables
-      for ( vtkIdType combinationPointIndex = 0; combinationPointIndex < subsetSize; combinationPointIndex++ )
-      {
-        vtkIdType sourcePointIndex = ( vtkIdType ) sourcePointsCombinationIndices[ sourcePointsCombinationIndex ][ combinationPointIndex ];
-        double sourcePoint[ 3 ];
-        unmatchedSourcePoints->GetPoint( sourcePointIndex, sourcePoint );
-        unmatchedSourcePointsCombination->SetPoint( combinationPointIndex, sourcePoint );
-
-        vtkIdType targetPointIndex = ( vtkIdType ) targetPointsCombinationIndices[ targetPointsCombinationIndex ][ combinationPointIndex ];
-        double targetPoint[ 3 ];
-        unmatchedTargetPoints->GetPoint( targetPointIndex, targetPoint );
-        unmatchedTargetPointsCombination->SetPoint( combinationPointIndex, targetPoint );
-      }
-      // finally see how good this particular combination is
-      vtkPointMatcher::UpdateBestMatchingForSubsetOfPoints( unmatchedSourcePointsCombination, unmatchedTargetPointsCombination,
-                                                            ambiguityDistanceError, matchingAmbiguous,
-                                                            currentBestDistanceError,
-                                                            outputMatchedSourcePoints, outputMatchedTargetPoints );
-    }
+    permutationGenerator->AddInputElement( 0, pointIndex );
   }
-}
 
-//------------------------------------------------------------------------------
-// point pair matching will be based on the distances between each pair of ordered points.
-// we have two input point lists. We want to reorder the second list such that the 
-// point-to-point distances are as close as possible to those in the first.
-// We will permute over all possibilities (and only ever keep the best result.)
-void vtkPointMatcher::UpdateBestMatchingForSubsetOfPoints(
-  vtkPoints* sourceSubset, 
-  vtkPoints* targetSubset,
-  double ambiguityDistanceError,
-  bool& matchingAmbiguous,
-  double& currentBestDistanceError,
-  vtkPoints* outputMatchedSourcePoints,
-  vtkPoints* outputMatchedTargetPoints )
-{
-  // error checking
-  if ( sourceSubset == NULL )
+  vtkIdType numberOfTargetCombinations = targetPointsCombinationGenerator->ComputeNumberOfOutputSets();
+  vtkIdType numberOfPermutations = permutationGenerator->ComputeNumberOfOutputSets();
+  vtkIdType numberOfCombinationPairs = sourcePointsCombinationGenerator->ComputeNumberOfOutputSets() * numberOfTargetCombinations;
+  if ( numberOfCombinationPairs == 0 || numberOfPermutations == 0 )
   {
-    vtkGenericWarningMacro( "Source points are null." );
     return;
   }
 
-  if ( targetSubset == NULL )
+  // threads read coordinates from plain arrays, because vtkPoints::GetPoint( id ) is not thread-safe
+  std::vector< double > sourceCoordinates( 3 * numberOfUnmatchedSourcePoints );
+  for ( int pointIndex = 0; pointIndex < numberOfUnmatchedSourcePoints; pointIndex++ )
   {
-    vtkGenericWarningMacro( "Target points are null." );
-    return;
+    unmatchedSourcePoints->GetPoint( pointIndex, &sourceCoordinates[ 3 * pointIndex ] );
+  }
+  std::vector< double > targetCoordinates( 3 * numberOfUnmatchedTargetPoints );
+  for ( int pointIndex = 0; pointIndex < numberOfUnmatchedTargetPoints; pointIndex++ )
+  {
+    unmatchedTargetPoints->GetPoint( pointIndex, &targetCoordinates[ 3 * pointIndex ] );
   }
 
-  int numberOfPoints = sourceSubset->GetNumberOfPoints(); // sizes of both lists should be identical
-  if ( numberOfPoints != targetSubset->GetNumberOfPoints() )
+  vtkPointMatcherSubsetMatchingFunctor subsetMatchingFunctor;
+  subsetMatchingFunctor.SubsetSize = subsetSize;
+  subsetMatchingFunctor.SourceCoordinates = &sourceCoordinates;
+  subsetMatchingFunctor.TargetCoordinates = &targetCoordinates;
+  subsetMatchingFunctor.SourceCombinationGenerator = sourcePointsCombinationGenerator;
+  subsetMatchingFunctor.TargetCombinationGenerator = targetPointsCombinationGenerator;
+  subsetMatchingFunctor.PermutationGenerator = permutationGenerator;
+  subsetMatchingFunctor.AmbiguityDistanceError = ambiguityDistanceError;
+  subsetMatchingFunctor.SharedBestDistanceError.store( currentBestDistanceError );
+  vtkSMPTools::For( 0, numberOfCombinationPairs, subsetMatchingFunctor );
+
+  if ( subsetMatchingFunctor.BestCandidateIndex < 0 )
   {
-    vtkGenericWarningMacro( "Subsets are of different sizes." );
+    // all candidates were much worse than the current best
     return;
   }
 
-  // compute the permutations, store them in a vtkIntArray.
-  vtkSmartPointer< vtkCombinatoricGenerator > combinatoricGenerator = vtkSmartPointer< vtkCombinatoricGenerator >::New();
-  combinatoricGenerator->SetCombinatoricToPermutation();
-  combinatoricGenerator->SetSubsetSize( numberOfPoints );
-  combinatoricGenerator->SetNumberOfInputSets( 1 );
-  for ( int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+  // combine with the best matching found before (for other subset sizes).
+  // Candidates skipped by the lower bound test are worse than the best by more than the ambiguity distance,
+  // so they would not change the flag either.
+  double previousBestDistanceError = currentBestDistanceError;
+  vtkPointMatcher::UpdateAmbiguityFlag( subsetMatchingFunctor.BestDistanceError, currentBestDistanceError, ambiguityDistanceError, matchingAmbiguous );
+  if ( subsetMatchingFunctor.SecondBestDistanceError < VTK_DOUBLE_MAX )
   {
-    combinatoricGenerator->AddInputElement( 0, pointIndex );
+    vtkPointMatcher::UpdateAmbiguityFlag( subsetMatchingFunctor.SecondBestDistanceError, currentBestDistanceError, ambiguityDistanceError, matchingAmbiguous );
   }
-  combinatoricGenerator->Update();
-  std::vector< std::vector< int > > targetSubsetIndexPermutations = combinatoricGenerator->GetOutputSets();
-
-  // iterate over all permutations - look for the most 'suitable'
-  // point matching that gives distances most similar to the reference
-
-  // create + allocate the permuted compare list once outside
-  // the loop to avoid allocation/deallocation time costs.
-  vtkSmartPointer< vtkPoints > permutedTargetSubset = vtkSmartPointer< vtkPoints >::New();
-  permutedTargetSubset->SetNumberOfPoints( numberOfPoints );
-  int numberOfPermutations = targetSubsetIndexPermutations.size();
-  for ( int permutationIndex = 0; permutationIndex < numberOfPermutations; permutationIndex++ )
+  if ( subsetMatchingFunctor.BestDistanceError < previousBestDistanceError )
   {
-    // fill permutedTargetSubset with points from targetSubset,
-    // in the order indicate by the permuted indices
-    for ( int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+
+    // only the index of the best candidate is known, generate its sets directly
+    vtkIdType bestPairIndex = subsetMatchingFunctor.BestCandidateIndex / numberOfPermutations;
+    std::vector< int > bestPermutation;
+    std::vector< int > bestSourceCombination;
+    std::vector< int > bestTargetCombination;
+    permutationGenerator->ComputeOutputSet( subsetMatchingFunctor.BestCandidateIndex % numberOfPermutations, bestPermutation );
+    sourcePointsCombinationGenerator->ComputeOutputSet( bestPairIndex / numberOfTargetCombinations, bestSourceCombination );
+    targetPointsCombinationGenerator->ComputeOutputSet( bestPairIndex % numberOfTargetCombinations, bestTargetCombination );
+    outputMatchedSourcePoints->Reset();
+    outputMatchedTargetPoints->Reset();
+    for ( int pointIndex = 0; pointIndex < subsetSize; pointIndex++ )
     {
-      int permutedPointIndex = targetSubsetIndexPermutations[ permutationIndex][ pointIndex ];
-      double* permutedPoint = targetSubset->GetPoint( permutedPointIndex );
-      permutedTargetSubset->SetPoint( pointIndex, permutedPoint );
+      outputMatchedSourcePoints->InsertNextPoint( &sourceCoordinates[ 3 * bestSourceCombination[ pointIndex ] ] );
+      outputMatchedTargetPoints->InsertNextPoint( &targetCoordinates[ 3 * bestTargetCombination[ bestPermutation[ pointIndex ] ] ] );
     }
-    double distanceError = vtkPointMatcher::ComputeRegistrationRootMeanSquareError( sourceSubset, permutedTargetSubset );
+    outputMatchedSourcePoints->Modified();
+    outputMatchedTargetPoints->Modified();
+  }
+}
 
-    vtkPointMatcher::UpdateAmbiguityFlag( distanceError, currentBestDistanceError, ambiguityDistanceError, matchingAmbiguous );
-    if ( distanceError == currentBestDistanceError )
+//------------------------------------------------------------------------------
+// For any rigid registration, the registration errors e_i, e_j of two point pairs satisfy
+// | |s_i - s_j| - |t_i - t_j| | <= |e_i| + |e_j|, therefore e_i^2 + e_j^2 >= difference^2 / 2.
+// This gives a lower bound of the root mean square error without computing the registration.
+double vtkPointMatcher::ComputeRootMeanSquareErrorLowerBound( const double* sourceCoordinates, const double* targetCoordinates, int numberOfPoints )
+{
+  if ( numberOfPoints <= 0 )
+  {
+    return 0.0;
+  }
+
+  double maximumDistanceDifference = 0.0;
+  for ( int pointIndex1 = 0; pointIndex1 < numberOfPoints; pointIndex1++ )
+  {
+    for ( int pointIndex2 = pointIndex1 + 1; pointIndex2 < numberOfPoints; pointIndex2++ )
     {
-      outputMatchedSourcePoints->DeepCopy( sourceSubset );
-      outputMatchedTargetPoints->DeepCopy( permutedTargetSubset );
+      double sourceDistance = sqrt( vtkMath::Distance2BetweenPoints( sourceCoordinates + 3 * pointIndex1, sourceCoordinates + 3 * pointIndex2 ) );
+      double targetDistance = sqrt( vtkMath::Distance2BetweenPoints( targetCoordinates + 3 * pointIndex1, targetCoordinates + 3 * pointIndex2 ) );
+      maximumDistanceDifference = std::max( maximumDistanceDifference, fabs( sourceDistance - targetDistance ) );
     }
   }
+  return maximumDistanceDifference / sqrt( 2.0 * numberOfPoints );
 }
 
 //------------------------------------------------------------------------------
@@ -926,54 +1927,101 @@ double vtkPointMatcher::ComputeRegistrationRootMeanSquareError( vtkPoints* sourc
     return RESET_VALUE_COMPUTED_ROOT_MEAN_DISTANCE_ERROR;
   }
 
-  vtkSmartPointer< vtkLandmarkTransform > landmarkTransform = vtkSmartPointer< vtkLandmarkTransform >::New();
-  landmarkTransform->SetSourceLandmarks( sourcePoints );
-  landmarkTransform->SetTargetLandmarks( targetPoints );
-  landmarkTransform->SetModeToRigidBody();
-  landmarkTransform->Update();
-
-  vtkSmartPointer< vtkPolyData > sourcePointsPolyData = vtkSmartPointer< vtkPolyData >::New();
-  sourcePointsPolyData->SetPoints( sourcePoints );
-
-  vtkSmartPointer< vtkTransformPolyDataFilter > transformFilter = vtkSmartPointer< vtkTransformPolyDataFilter >::New();
-  transformFilter->SetTransform( landmarkTransform );
-  transformFilter->SetInputData( sourcePointsPolyData );
-  transformFilter->Update();
-
-  vtkPolyData* transformedSourcePointsPolyData = transformFilter->GetOutput();
-  if ( transformedSourcePointsPolyData == NULL )
+  int numberOfPoints = targetPoints->GetNumberOfPoints();
+  if ( sourcePoints->GetNumberOfPoints() != numberOfPoints )
   {
-    vtkGenericWarningMacro( "Transformed source points poly data is null Returning default value " << RESET_VALUE_COMPUTED_ROOT_MEAN_DISTANCE_ERROR << "." );
+    vtkGenericWarningMacro( "Point lists are not of same size " << sourcePoints->GetNumberOfPoints() << " and " << numberOfPoints << ". Returning default value " << RESET_VALUE_COMPUTED_ROOT_MEAN_DISTANCE_ERROR << "." );
     return RESET_VALUE_COMPUTED_ROOT_MEAN_DISTANCE_ERROR;
   }
 
-  vtkPoints* transformedSourcePoints = transformedSourcePointsPolyData->GetPoints();
-  if ( transformedSourcePoints == NULL )
+  std::vector< double > sourceCoordinates( 3 * numberOfPoints );
+  std::vector< double > targetCoordinates( 3 * numberOfPoints );
+  for ( int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
   {
-    vtkGenericWarningMacro( "Transformed source point list is null. Returning default value " << RESET_VALUE_COMPUTED_ROOT_MEAN_DISTANCE_ERROR << "." );
-    return RESET_VALUE_COMPUTED_ROOT_MEAN_DISTANCE_ERROR;
+    sourcePoints->GetPoint( pointIndex, &sourceCoordinates[ 3 * pointIndex ] );
+    targetPoints->GetPoint( pointIndex, &targetCoordinates[ 3 * pointIndex ] );
   }
+  return vtkPointMatcher::ComputeRigidRegistrationRootMeanSquareError( &sourceCoordinates[ 0 ], &targetCoordinates[ 0 ], numberOfPoints );
+}
 
-  int numberOfPoints = targetPoints->GetNumberOfPoints();
-  if ( transformedSourcePoints->GetNumberOfPoints() != numberOfPoints )
+//------------------------------------------------------------------------------
+// Closed form solution of the rigid registration error (Horn, "Closed-form solution of absolute
+// orientation using unit quaternions", 1987). With source and target points relative to their centroids
+// (a_i, b_i), the optimal rotation maximizes sum( b_i . R a_i ), and the maximum is the largest eigenvalue
+// of a 4x4 matrix built from the cross-covariance matrix. The residual sum of squares is then
+// sum( |a_i|^2 + |b_i|^2 ) - 2 * largest eigenvalue, so the transformed points never need to be computed.
+// This is called for every candidate matching, therefore it works on raw coordinates and does not allocate memory.
+double vtkPointMatcher::ComputeRigidRegistrationRootMeanSquareError( const double* sourceCoordinates, const double* targetCoordinates, int numberOfPoints )
+{
+  if ( sourceCoordinates == NULL || targetCoordinates == NULL || numberOfPoints <= 0 )
   {
-    vtkGenericWarningMacro( "Point lists are not of same size " << transformedSourcePoints->GetNumberOfPoints() << " and " << numberOfPoints << ". Returning default value " << RESET_VALUE_COMPUTED_ROOT_MEAN_DISTANCE_ERROR << "." );
+    vtkGenericWarningMacro( "Invalid input coordinates. Returning default value " << RESET_VALUE_COMPUTED_ROOT_MEAN_DISTANCE_ERROR << "." );
     return RESET_VALUE_COMPUTED_ROOT_MEAN_DISTANCE_ERROR;
   }
 
-  double sumOfSquaredDistances = 0.0;
+  double sourceCentroid[ 3 ] = { 0.0, 0.0, 0.0 };
+  double targetCentroid[ 3 ] = { 0.0, 0.0, 0.0 };
   for ( int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
   {
-    double transformedSourcePoint[ 3 ];
-    transformedSourcePoints->GetPoint( pointIndex, transformedSourcePoint );
+    for ( int axis = 0; axis < 3; axis++ )
+    {
+      sourceCentroid[ axis ] += sourceCoordinates[ 3 * pointIndex + axis ];
+      targetCentroid[ axis ] += targetCoordinates[ 3 * pointIndex + axis ];
+    }
+  }
+  for ( int axis = 0; axis < 3; axis++ )
+  {
+    sourceCentroid[ axis ] /= numberOfPoints;
+    targetCentroid[ axis ] /= numberOfPoints;
+  }
+
+  double sumOfSquaredNorms = 0.0;
+  double crossCovariance[ 3 ][ 3 ] = { { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 } };
+  for ( int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+  {
+    double sourcePoint[ 3 ];
     double targetPoint[ 3 ];
-    targetPoints->GetPoint( pointIndex, targetPoint );
-    double squaredDistance = vtkMath::Distance2BetweenPoints( transformedSourcePoint, targetPoint );
-    sumOfSquaredDistances += squaredDistance;
+    for ( int axis = 0; axis < 3; axis++ )
+    {
+      sourcePoint[ axis ] = sourceCoordinates[ 3 * pointIndex + axis ] - sourceCentroid[ axis ];
+      targetPoint[ axis ] = targetCoordinates[ 3 * pointIndex + axis ] - targetCentroid[ axis ];
+    }
+    sumOfSquaredNorms += vtkMath::Dot( sourcePoint, sourcePoint ) + vtkMath::Dot( targetPoint, targetPoint );
+    for ( int row = 0; row < 3; row++ )
+    {
+      for ( int column = 0; column < 3; column++ )
+      {
+        crossCovariance[ row ][ column ] += sourcePoint[ row ] * targetPoint[ column ];
+      }
+    }
+  }
+
+  const double ( &S )[ 3 ][ 3 ] = crossCovariance;
+  double N[ 4 ][ 4 ] =
+  {
+    { S[0][0] + S[1][1] + S[2][2], S[1][2] - S[2][1], S[2][0] - S[0][2], S[0][1] - S[1][0] },
+    { S[1][2] - S[2][1], S[0][0] - S[1][1] - S[2][2], S[0][1] + S[1][0], S[2][0] + S[0][2] },
+    { S[2][0] - S[0][2], S[0][1] + S[1][0], -S[0][0] + S[1][1] - S[2][2], S[1][2] + S[2][1] },
+    { S[0][1] - S[1][0], S[2][0] + S[0][2], S[1][2] + S[2][1], -S[0][0] - S[1][1] + S[2][2] }
+  };
+  double* NRows[ 4 ] = { N[ 0 ], N[ 1 ], N[ 2 ], N[ 3 ] };
+  double eigenvalues[ 4 ];
+  double eigenvectors[ 4 ][ 4 ];
+  double* eigenvectorRows[ 4 ] = { eigenvectors[ 0 ], eigenvectors[ 1 ], eigenvectors[ 2 ], eigenvectors[ 3 ] };
+  if ( !vtkMath::JacobiN( NRows, 4, eigenvalues, eigenvectorRows ) )
+  {
+    vtkGenericWarningMacro( "Failed to compute eigenvalues. Returning default value " << RESET_VALUE_COMPUTED_ROOT_MEAN_DISTANCE_ERROR << "." );
+    return RESET_VALUE_COMPUTED_ROOT_MEAN_DISTANCE_ERROR;
   }
-  double meanOfSquaredDistances = sumOfSquaredDistances / numberOfPoints;
-  double rootMeanSquareistanceErrors = sqrt( meanOfSquaredDistances );
-  return rootMeanSquareistanceErrors;
+
+  // eigenvalues are sorted in decreasing order
+  double sumOfSquaredDistances = sumOfSquaredNorms - 2.0 * eigenvalues[ 0 ];
+  if ( sumOfSquaredDistances < 0.0 )
+  {
+    // may happen due to rounding errors for perfectly matching points
+    sumOfSquaredDistances = 0.0;
+  }
+  return sqrt( sumOfSquaredDistances / numberOfPoints );
 }
 
 //------------------------------------------------------------------------------
@@ -1275,6 +2323,22 @@ bool vtkPointMatcher::UpdateNeeded()
   return ( this->GetMTime() > this->OutputChangedTime );
 }
 
+//------------------------------------------------------------------------------
+bool vtkPointMatcher::IsComputationTimeExceeded()
+{
+  if ( this->MaximumComputationTimeSec <= 0.0 )
+  {
+    return false;
+  }
+
+  double elapsedTimeSec = vtkTimerLog::GetUniversalTime() - this->UpdateStartTimeSec;
+  if ( elapsedTimeSec > this->MaximumComputationTimeSec )
+  {
+    this->ComputationTimeLimitReached = true;
+  }
+  return this->ComputationTimeLimitReached;
+}
+
 //------------------------------------------------------------------------------
 bool vtkPointMatcher::GeneratePolyDataFromPoints( vtkPoints* points, vtkPolyData* polyData )
 {
@@ -1443,3 +2507,113 @@ bool vtkPointMatcher::ExtractMaximumDistanceAndCentroidFeatures( vtkPoints* poin
 
   return true;
 }
+
+//------------------------------------------------------------------------------
+void vtkPointMatcher::ComputeDistancesWithinPointSet( vtkPoints* points, std::vector< double >& distances )
+{
+  distances.clear();
+  if ( points == NULL )
+  {
+    vtkGenericWarningMacro( "Points are null." );
+    return;
+  }
+
+  vtkSmartPointer< vtkPointDistanceMatrix > pointDistanceMatrix = vtkSmartPointer< vtkPointDistanceMatrix >::New();
+  pointDistanceMatrix->SetPointList1( points );
+  pointDistanceMatrix->SetPointList2( points );
+  pointDistanceMatrix->Update();
+
+  // copy to a plain array, the distances are looked up very many times
+  vtkSmartPointer< vtkDoubleArray > allDistancesArray = vtkSmartPointer< vtkDoubleArray >::New();
+  pointDistanceMatrix->GetDistances( allDistancesArray );
+  int numberOfDistances = allDistancesArray->GetNumberOfTuples();
+  distances.resize( numberOfDistances );
+  for ( int distanceIndex = 0; distanceIndex < numberOfDistances; distanceIndex++ )
+  {
+    distances[ distanceIndex ] = allDistancesArray->GetValue( distanceIndex );
+  }
+}
+
+//------------------------------------------------------------------------------
+void vtkPointMatcher::ComputeDistanceSignatures( const std::vector< double >& distances, int numberOfPoints, std::vector< std::vector< double > >& signatures )
+{
+  signatures.clear();
+  if ( distances.size() != ( size_t ) ( numberOfPoints * numberOfPoints ) )
+  {
+    vtkGenericWarningMacro( "Number of distances " << distances.size() << " does not match number of points " << numberOfPoints << "." );
+    return;
+  }
+
+  signatures.resize( numberOfPoints );
+  for ( int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+  {
+    std::vector< double >& signature = signatures[ pointIndex ];
+    signature.reserve( numberOfPoints - 1 );
+    for ( int otherPointIndex = 0; otherPointIndex < numberOfPoints; otherPointIndex++ )
+    {
+      if ( otherPointIndex == pointIndex )
+      {
+        continue;
+      }
+      signature.push_back( distances[ pointIndex * numberOfPoints + otherPointIndex ] );
+    }
+    std::sort( signature.begin(), signature.end() );
+  }
+}
+
+//------------------------------------------------------------------------------
+int vtkPointMatcher::CountMatchingDistancesInSignatures( const std::vector< double >& signature1, const std::vector< double >& signature2, double distanceTolerance )
+{
+  // both signatures are sorted, so a single simultaneous pass is enough
+  int numberOfMatchingDistances = 0;
+  size_t index1 = 0;
+  size_t index2 = 0;
+  while ( index1 < signature1.size() && index2 < signature2.size() )
+  {
+    double difference = signature1[ index1 ] - signature2[ index2 ];
+    if ( fabs( difference ) <= distanceTolerance )
+    {
+      numberOfMatchingDistances++;
+      index1++;
+      index2++;
+    }
+    else if ( difference < 0 )
+    {
+      index1++;
+    }
+    else
+    {
+      index2++;
+    }
+  }
+  return numberOfMatchingDistances;
+}
+
+//------------------------------------------------------------------------------
+bool vtkPointMatcher::ArePointListsEqual( vtkPoints* pointList1, vtkPoints* pointList2 )
+{
+  if ( pointList1 == NULL || pointList2 == NULL )
+  {
+    vtkGenericWarningMacro( "At least one of the point lists is null." );
+    return false;
+  }
+
+  int numberOfPoints = pointList1->GetNumberOfPoints();
+  if ( pointList2->GetNumberOfPoints() != numberOfPoints )
+  {
+    return false;
+  }
+
+  for ( int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+  {
+    double point1[ 3 ];
+    pointList1->GetPoint( pointIndex, point1 );
+    double point2[ 3 ];
+    pointList2->GetPoint( pointIndex, point2 );
+    if ( point1[ 0 ] != point2[ 0 ] || point1[ 1 ] != point2[ 1 ] || point1[ 2 ] != point2[ 2 ] )
+    {
+      return false;
+    }
+  }
+  return true;
+}
@@ -5,10 +5,16 @@
 #include <vtkTimeStamp.h>
 #include <vtkSmartPointer.h>
 
+// std includes
+#include <vector>
+
 class vtkAbstractTransform;
 class vtkDoubleArray;
 class vtkPoints;
 class vtkPolyData;
+class vtkPointMatcherSubsetMatchingFunctor;
+class vtkPointMatcherCorrespondenceSearch;
+class vtkPointMatcherICPStartFunctor;
 
 // export
 #include "vtkSlicerFiducialRegistrationWizardModuleLogicExport.h"
@@ -52,6 +58,12 @@ class VTK_SLICER_FIDUCIALREGISTRATIONWIZARD_MODULE_LOGIC_EXPORT vtkPointMatcher
     vtkGetMacro( AmbiguityDistanceErrorMultiple, double );
     vtkSetMacro( AmbiguityDistanceErrorMultiple, double );
 
+    // Time limit for the matching, in seconds. When it is reached, the search stops
+    // and the best matching found so far is reported.
+    // Non-positive value means there is no time limit.
+    vtkGetMacro( MaximumComputationTimeSec, double );
+    vtkSetMacro( MaximumComputationTimeSec, double );
+
     // Output Accessors
     // these points will be ordered pairs and the lists will be the same length as one another
     vtkPoints* GetOutputSourcePoints();
@@ -66,9 +78,23 @@ class VTK_SLICER_FIDUCIALREGISTRATIONWIZARD_MODULE_LOGIC_EXPORT vtkPointMatcher
     bool IsMatchingAmbiguous();
     double GetAmbiguityDistanceError();
 
+    // True if the last update was stopped early because MaximumComputationTimeSec was reached
+    bool IsComputationTimeLimitReached();
+
+    // True if the output is the best matching found by a search that was stopped before it completed
+    // (no other algorithm found a better one), so a better matching may exist
+    bool IsMatchingIncomplete();
+
     // Logic
     void Update();
 
+    // Root mean square distance error of the rigid registration of ordered point pairs.
+    // Can be used for checking if a previously found matching is still valid after the points moved.
+    static double ComputeRegistrationRootMeanSquareError( vtkPoints* sourcePoints, vtkPoints* targetPoints );
+
+    // The tolerable and ambiguity distance errors are computed as multiples of this value (computed for the target points)
+    static double ComputeMaximumDistanceInPointSet( vtkPoints* points );
+
   protected:
     vtkPointMatcher();
     ~vtkPointMatcher();
@@ -88,6 +114,11 @@ class VTK_SLICER_FIDUCIALREGISTRATIONWIZARD_MODULE_LOGIC_EXPORT vtkPointMatcher
 
     double ComputedDistanceError;
 
+    double MaximumComputationTimeSec;
+    double UpdateStartTimeSec;
+    bool ComputationTimeLimitReached;
+    bool MatchingIncomplete;
+
     vtkSmartPointer< vtkPoints > OutputSourcePoints;
     vtkSmartPointer< vtkPoints > OutputTargetPoints;
 
@@ -95,6 +126,9 @@ class VTK_SLICER_FIDUCIALREGISTRATIONWIZARD_MODULE_LOGIC_EXPORT vtkPointMatcher
     vtkTimeStamp OutputChangedTime;
     bool UpdateNeeded();
 
+    // Returns true (and sets ComputationTimeLimitReached) if the time limit of the current update is exceeded
+    bool IsComputationTimeExceeded();
+
     // error checking
     bool InputsValid( bool verbose=true );
 
@@ -107,9 +141,15 @@ class VTK_SLICER_FIDUCIALREGISTRATIONWIZARD_MODULE_LOGIC_EXPORT vtkPointMatcher
     bool MatchPointsGenerallyUsingMaximumDistancesAndCentroid();
     bool MatchPointsGenerallyUsingSubsample( vtkPoints* unmatchedReducedSourcePoints, vtkPoints* unmatchedReducedTargetPoints ); // helper to the functions above
     bool MatchPointsGenerallyUsingICP();
+    bool MatchPointsGenerallyUsingDistanceSignatures();
+    bool MatchPointsGenerallyUsingBranchAndBound();
 
     void HandleMatchFailure(); // copies input point list to output point list. Used when matching is otherwise impossible.
 
+    // Returns true if the outputs hold an incomplete matching that is not worse than distanceError.
+    // Otherwise the incomplete flag is cleared, as the caller replaces the outputs.
+    bool KeepIncompleteMatching( double distanceError );
+
     double Distance2ForOutlierRemovalAfterInitialRegistration();
 
     static void UpdateBestMatchingForSubsetsOfPoints( int minimumSubsetSize, int maximumSubsetSize,
@@ -122,17 +162,13 @@ class VTK_SLICER_FIDUCIALREGISTRATIONWIZARD_MODULE_LOGIC_EXPORT vtkPointMatcher
                                                             double ambiguityDistance, bool& matchingAmbiguous, 
                                                             double& computedDistanceError,
                                                             vtkPoints* outputMatchedPointList1, vtkPoints* outputMatchedPointList2 );
-    static void UpdateBestMatchingForSubsetOfPoints( vtkPoints* unmatchedPointList1, vtkPoints* unmatchedPointList2,
-                                                     double ambiguityDistance, bool& matchingAmbiguous, 
-                                                     double& computedDistanceError,
-                                                     vtkPoints* outputMatchedPointList1, vtkPoints* outputMatchedPointList2 );
     static void UpdateAmbiguityFlag( double currentDistance, double& bestDistance, double ambiguityDistance, bool& ambiguityFlag );
-    static double ComputeRegistrationRootMeanSquareError( vtkPoints* sourcePoints, vtkPoints* targetPoints );
+    static double ComputeRigidRegistrationRootMeanSquareError( const double* sourceCoordinates, const double* targetCoordinates, int numberOfPoints );
+    static double ComputeRootMeanSquareErrorLowerBound( const double* sourceCoordinates, const double* targetCoordinates, int numberOfPoints );
     static bool ComputePointMatchingBasedOnRegistration( vtkAbstractTransform* registration,
                                                          vtkPoints* unmatchedSourcePoints, vtkPoints* unmatchedTargetPoints,
                                                          double thresholdDistance2ForOutlier, unsigned int maximumOutlierCount,
                                                          vtkPoints* matchedSourcePoints, vtkPoints* matchedTargetPoints );
-    static double ComputeMaximumDistanceInPointSet( vtkPoints* points );
     static void CopyFirstNPoints( vtkPoints* inputList, vtkPoints* outputList, int n );
     static void ReorderPointsAccordingToUniqueGeometry( vtkPoints* inputUnsortedPointList, vtkPoints* outputSortedPointList );
     static void ComputeUniquenessesForPoints( vtkPoints* points, vtkDoubleArray* uniquenesses );
@@ -140,6 +176,17 @@ class VTK_SLICER_FIDUCIALREGISTRATIONWIZARD_MODULE_LOGIC_EXPORT vtkPointMatcher
     static bool GeneratePolyDataFromPoints( vtkPoints*, vtkPolyData* );
     static bool ComputeCentroidOfPoints( vtkPoints*, double* centroid );
     static bool ExtractMaximumDistanceAndCentroidFeatures( vtkPoints* points, vtkPoints* features );
+    static void ComputeDistancesWithinPointSet( vtkPoints* points, std::vector< double >& distances );
+    static void ComputeDistanceSignatures( const std::vector< double >& distances, int numberOfPoints, std::vector< std::vector< double > >& signatures );
+    static int CountMatchingDistancesInSignatures( const std::vector< double >& signature1, const std::vector< double >& signature2, double distanceTolerance );
+    static bool ArePointListsEqual( vtkPoints* pointList1, vtkPoints* pointList2 );
+
+    // Parallel worker of UpdateBestMatchingForNSizedSubsetsOfPoints
+    friend class vtkPointMatcherSubsetMatchingFunctor;
+    // Depth-first search of MatchPointsGenerallyUsingBranchAndBound
+    friend class vtkPointMatcherCorrespondenceSearch;
+    // Parallel worker of MatchPointsGenerallyUsingICP
+    friend class vtkPointMatcherICPStartFunctor;
 
     // Not implemented:
 		vtkPointMatcher(const vtkPointMatcher&);
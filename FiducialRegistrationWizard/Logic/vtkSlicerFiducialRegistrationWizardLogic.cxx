@@ -23,32 +23,44 @@
 // FiducialRegistrationWizard includes
 #include "vtkSlicerFiducialRegistrationWizardLogic.h"
 #include "vtkPointMatcher.h"
+#include "vtkThinPlateSplineApproximator.h"
 
 // MRML includes
 #include "vtkMRMLLinearTransformNode.h"
 #include "vtkMRMLMarkupsFiducialNode.h"
+#include "vtkMRMLScalarVolumeNode.h"
 #include "vtkMRMLScene.h"
 
 // VTK includes
 #include <vtkDoubleArray.h>
+#include <vtkImageData.h>
 #include <vtkMath.h>
 #include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkOrientedGridTransform.h>
 #include <vtkPCAStatistics.h>
+#include <vtkSMPTools.h>
 #include <vtkSmartPointer.h>
 #include <vtkTable.h>
 #include <vtkThinPlateSplineTransform.h>
 #include <vtkTransform.h>
+#include <vtkTransformToGrid.h>
 
 // STD includes
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <sstream>
 
 
 // Helper methods -------------------------------------------------------------------
 
 double EIGENVALUE_THRESHOLD = 1e-4;
+double POINT_MATCHING_TOLERABLE_DISTANCE_ERROR_MULTIPLE = 0.05;
+double POINT_MATCHING_AMBIGUITY_DISTANCE_ERROR_MULTIPLE = 0.025;
+double WARPING_GRID_MARGIN_FRACTION = 0.2; // relative to the size of the fiducials bounding box
+vtkIdType WARPING_GRID_MAXIMUM_NUMBER_OF_VOXELS = 256 * 256 * 256;
 
 //------------------------------------------------------------------------------
 void MarkupsFiducialNodeToVTKPoints(vtkMRMLMarkupsFiducialNode* markupsFiducialNode, vtkPoints* points)
@@ -62,6 +74,48 @@ void MarkupsFiducialNodeToVTKPoints(vtkMRMLMarkupsFiducialNode* markupsFiducialN
   }
 }
 
+//------------------------------------------------------------------------------
+// Find the index of each point of subsetPoints in allPoints. Matched points are copies of the input points,
+// so their coordinates are exactly equal. Returns false if any of the points is not found.
+bool FindPointIndicesInList(vtkPoints* allPoints, vtkPoints* subsetPoints, std::vector<int>& indices)
+{
+  indices.clear();
+  std::vector<bool> pointUsed(allPoints->GetNumberOfPoints(), false);
+  for (int subsetPointIndex = 0; subsetPointIndex < subsetPoints->GetNumberOfPoints(); subsetPointIndex++)
+  {
+    double subsetPoint[3] = { 0, 0, 0 };
+    subsetPoints->GetPoint(subsetPointIndex, subsetPoint);
+    int foundPointIndex = -1;
+    for (int pointIndex = 0; pointIndex < allPoints->GetNumberOfPoints(); pointIndex++)
+    {
+      double point[3] = { 0, 0, 0 };
+      allPoints->GetPoint(pointIndex, point);
+      if (!pointUsed[pointIndex] && vtkMath::Distance2BetweenPoints(point, subsetPoint) == 0.0)
+      {
+        foundPointIndex = pointIndex;
+        break;
+      }
+    }
+    if (foundPointIndex < 0)
+    {
+      return false;
+    }
+    pointUsed[foundPointIndex] = true;
+    indices.push_back(foundPointIndex);
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void GetControlPointIDs(vtkMRMLMarkupsFiducialNode* markupsFiducialNode, std::vector<std::string>& pointIDs)
+{
+  pointIDs.clear();
+  for (int i = 0; i < markupsFiducialNode->GetNumberOfControlPoints(); i++)
+  {
+    pointIDs.push_back(markupsFiducialNode->GetNthControlPointID(i));
+  }
+}
+
 
 // Slicer methods -------------------------------------------------------------------
 
@@ -127,6 +181,7 @@ void vtkSlicerFiducialRegistrationWizardLogic::OnMRMLSceneNodeAdded(vtkMRMLNode*
     vtkNew<vtkIntArray> events;
     events->InsertNextValue(vtkCommand::ModifiedEvent);
     events->InsertNextValue(vtkMRMLFiducialRegistrationWizardNode::InputDataModifiedEvent);
+    events->InsertNextValue(vtkMRMLFiducialRegistrationWizardNode::InputPointModifiedEvent);
     vtkObserveMRMLNodeEventsMacro(frwNode, events.GetPointer());
 
     if (frwNode->GetUpdateMode() == vtkMRMLFiducialRegistrationWizardNode::UPDATE_MODE_AUTOMATIC)
@@ -149,6 +204,11 @@ void vtkSlicerFiducialRegistrationWizardLogic::OnMRMLSceneNodeRemoved(vtkMRMLNod
   {
     vtkDebugMacro("OnMRMLSceneNodeRemoved");
     vtkUnObserveMRMLNodeMacro(node);
+    if (node->GetID())
+    {
+      this->PointMatchingCache.erase(node->GetID());
+      this->IncrementalRegistrations.erase(node->GetID());
+    }
   }
 }
 
@@ -251,6 +311,40 @@ bool vtkSlicerFiducialRegistrationWizardLogic::UpdateCalibration(vtkMRMLNode* no
   // if we get up to here without errors, clear the status message to prepare it for future contents:
   fiducialRegistrationWizardNode->ClearCalibrationStatusMessage();
 
+  // With manual point matching and automatic update the point pairs of rigid and similarity registration are
+  // kept up to date by the point events of the lists, so the registration is computed without visiting all points.
+  // Manually requested updates recompute everything, in case the lists were changed without point events.
+  if (fiducialRegistrationWizardNode->GetPointMatching() == vtkMRMLFiducialRegistrationWizardNode::POINT_MATCHING_MANUAL &&
+    fiducialRegistrationWizardNode->GetUpdateMode() == vtkMRMLFiducialRegistrationWizardNode::UPDATE_MODE_AUTOMATIC &&
+    (fiducialRegistrationWizardNode->GetRegistrationMode() == vtkMRMLFiducialRegistrationWizardNode::REGISTRATION_MODE_RIGID ||
+    fiducialRegistrationWizardNode->GetRegistrationMode() == vtkMRMLFiducialRegistrationWizardNode::REGISTRATION_MODE_SIMILARITY))
+  {
+    std::map< std::string, IncrementalRegistrationEntry >::iterator entryIt = this->IncrementalRegistrations.find(fiducialRegistrationWizardNode->GetID());
+    if (entryIt != this->IncrementalRegistrations.end()
+      && entryIt->second.PairsFollowListIndices
+      && entryIt->second.PendingRemovedPointIndex < 0
+      && entryIt->second.FromFiducialListNodeID == fromMarkupsFiducialNode->GetID()
+      && entryIt->second.ToFiducialListNodeID == toMarkupsFiducialNode->GetID()
+      && fromMarkupsFiducialNode->GetNumberOfControlPoints() == entryIt->second.Registration->GetNumberOfPointPairs()
+      && toMarkupsFiducialNode->GetNumberOfControlPoints() == entryIt->second.Registration->GetNumberOfPointPairs())
+    {
+      double covariance[3][3];
+      entryIt->second.Registration->GetFromPointsCovariance(covariance);
+      if (this->CheckCollinear(covariance))
+      {
+        fiducialRegistrationWizardNode->SetCalibrationStatusMessage("'From' fiducial list has strictly collinear or singular points.");
+        return false;
+      }
+      entryIt->second.Registration->GetToPointsCovariance(covariance);
+      if (this->CheckCollinear(covariance))
+      {
+        fiducialRegistrationWizardNode->SetCalibrationStatusMessage("'To' fiducial list has strictly collinear or singular points.");
+        return false;
+      }
+      return this->UpdateLinearCalibration(fiducialRegistrationWizardNode, entryIt->second.Registration);
+    }
+  }
+
   // Convert the markupsfiducial nodes into vtk points
   vtkSmartPointer< vtkPoints > fromPointsUnordered = vtkSmartPointer< vtkPoints >::New();
   MarkupsFiducialNodeToVTKPoints(fromMarkupsFiducialNode, fromPointsUnordered);
@@ -289,36 +383,55 @@ bool vtkSlicerFiducialRegistrationWizardLogic::UpdateCalibration(vtkMRMLNode* no
         << " registration is being used." << std::endl << "Unexpected results may occur.";
       fiducialRegistrationWizardNode->AddToCalibrationStatusMessage(msg.str());
     }
-    const int MAX_NUMBER_OF_POINTS_FOR_POINT_MATCHING_AUTOMATIC = 30; // more than this and it tends to take a long time. Algorithm is at least N!
-    int fromNumberOfPoints = fromPointsUnordered->GetNumberOfPoints();
-    int toNumberOfPoints = toPointsUnordered->GetNumberOfPoints();
-    int numberOfPointsToMatch = std::max(fromNumberOfPoints, toNumberOfPoints);
-    if (numberOfPointsToMatch > MAX_NUMBER_OF_POINTS_FOR_POINT_MATCHING_AUTOMATIC)
+    // While points are only dragged around in automatic update mode, the matching almost never changes,
+    // so the previous matching is reused as long as it is still valid
+    bool matchingAmbiguous = false;
+    bool cachedMatchingValid = false;
+    if (fiducialRegistrationWizardNode->GetUpdateMode() == vtkMRMLFiducialRegistrationWizardNode::UPDATE_MODE_AUTOMATIC)
     {
-      std::stringstream msg;
-      msg << "Too many points to compute point pairing " << numberOfPointsToMatch << "." << std::endl
-        << "To avoid long computation time, there should be at most " << MAX_NUMBER_OF_POINTS_FOR_POINT_MATCHING_AUTOMATIC << " points." << std::endl
-        << "Aborting registration.";
-      fiducialRegistrationWizardNode->AddToCalibrationStatusMessage(msg.str());
-      return false;
+      fromPointsOrdered = vtkSmartPointer< vtkPoints >::New();
+      toPointsOrdered = vtkSmartPointer< vtkPoints >::New();
+      cachedMatchingValid = this->GetCachedPointMatching(fiducialRegistrationWizardNode, toPointsUnordered,
+        fromPointsOrdered, toPointsOrdered, matchingAmbiguous);
     }
-    vtkSmartPointer< vtkPointMatcher > pointMatcher = vtkSmartPointer< vtkPointMatcher >::New();
-    pointMatcher->SetInputSourcePoints(fromPointsUnordered);
-    pointMatcher->SetInputTargetPoints(toPointsUnordered);
-    pointMatcher->SetMaximumDifferenceInNumberOfPoints(2);
-    pointMatcher->SetTolerableDistanceErrorMultiple(0.05);
-    pointMatcher->SetAmbiguityDistanceErrorMultiple(0.025);
-    pointMatcher->Update();
-    if (!pointMatcher->IsMatchingWithinTolerance())
+    if (!cachedMatchingValid)
     {
-      std::stringstream msg;
-      msg << "Could not find a good mapping." << std::endl
-        << "Mean squared distance error was " << pointMatcher->GetComputedDistanceError()
-        << ", but tolerance is " << pointMatcher->GetTolerableDistanceError() << "." << std::endl
-        << "Results are not expected to be accurate.";
-      fiducialRegistrationWizardNode->AddToCalibrationStatusMessage(msg.str());
+      vtkSmartPointer< vtkPointMatcher > pointMatcher = vtkSmartPointer< vtkPointMatcher >::New();
+      pointMatcher->SetInputSourcePoints(fromPointsUnordered);
+      pointMatcher->SetInputTargetPoints(toPointsUnordered);
+      pointMatcher->SetMaximumDifferenceInNumberOfPoints(2);
+      pointMatcher->SetTolerableDistanceErrorMultiple(POINT_MATCHING_TOLERABLE_DISTANCE_ERROR_MULTIPLE);
+      pointMatcher->SetAmbiguityDistanceErrorMultiple(POINT_MATCHING_AMBIGUITY_DISTANCE_ERROR_MULTIPLE);
+      pointMatcher->SetMaximumComputationTimeSec(fiducialRegistrationWizardNode->GetPointMatchingTimeLimitSec());
+      pointMatcher->Update();
+      if (pointMatcher->IsComputationTimeLimitReached())
+      {
+        std::stringstream msg;
+        msg << "Point matching was stopped after reaching the time limit of "
+          << fiducialRegistrationWizardNode->GetPointMatchingTimeLimitSec() << "s." << std::endl
+          << "The best matching found so far is used.";
+        fiducialRegistrationWizardNode->AddToCalibrationStatusMessage(msg.str());
+      }
+      matchingAmbiguous = pointMatcher->IsMatchingAmbiguous();
+      fromPointsOrdered = pointMatcher->GetOutputSourcePoints();
+      toPointsOrdered = pointMatcher->GetOutputTargetPoints();
+      if (pointMatcher->IsMatchingWithinTolerance())
+      {
+        this->UpdatePointMatchingCache(fiducialRegistrationWizardNode, fromPointsUnordered, toPointsUnordered,
+          fromPointsOrdered, toPointsOrdered, matchingAmbiguous);
+      }
+      else
+      {
+        this->PointMatchingCache.erase(fiducialRegistrationWizardNode->GetID());
+        std::stringstream msg;
+        msg << "Could not find a good mapping." << std::endl
+          << "Mean squared distance error was " << pointMatcher->GetComputedDistanceError()
+          << ", but tolerance is " << pointMatcher->GetTolerableDistanceError() << "." << std::endl
+          << "Results are not expected to be accurate.";
+        fiducialRegistrationWizardNode->AddToCalibrationStatusMessage(msg.str());
+      }
     }
-    if (pointMatcher->IsMatchingAmbiguous())
+    if (matchingAmbiguous)
     {
       std::stringstream msg;
       msg << "The 'best' point matching is reported as ambiguous and may be incorrect." << std::endl
@@ -326,8 +439,6 @@ bool vtkSlicerFiducialRegistrationWizardLogic::UpdateCalibration(vtkMRMLNode* no
         << "Results are not necessarily expected to be accurate.";
       fiducialRegistrationWizardNode->AddToCalibrationStatusMessage(msg.str());
     }
-    fromPointsOrdered = pointMatcher->GetOutputSourcePoints();
-    toPointsOrdered = pointMatcher->GetOutputTargetPoints();
   }
   else
   {
@@ -356,36 +467,19 @@ bool vtkSlicerFiducialRegistrationWizardLogic::UpdateCalibration(vtkMRMLNode* no
   if (registrationMode == vtkMRMLFiducialRegistrationWizardNode::REGISTRATION_MODE_RIGID ||
     registrationMode == vtkMRMLFiducialRegistrationWizardNode::REGISTRATION_MODE_SIMILARITY)
   {
-    // Compute transformation matrix. We don't set the landmark transform in the node directly because
-    // vtkLandmarkTransform is not fully supported (e.g., it cannot be stored in file).
-    vtkNew<vtkLandmarkTransform> landmarkTransform;
-    landmarkTransform->SetSourceLandmarks(fromPointsOrdered);
-    landmarkTransform->SetTargetLandmarks(toPointsOrdered);
-    if (registrationMode == vtkMRMLFiducialRegistrationWizardNode::REGISTRATION_MODE_RIGID)
-    {
-      landmarkTransform->SetModeToRigidBody();
-    }
-    else
+    // Store the point pairs. With manual point matching they are updated by the point events from now on.
+    IncrementalRegistrationEntry& entry = this->IncrementalRegistrations[fiducialRegistrationWizardNode->GetID()];
+    if (entry.Registration == NULL)
     {
-      landmarkTransform->SetModeToSimilarity();
-    }
-    landmarkTransform->Update();
-    vtkNew< vtkMatrix4x4 > calculatedTransform;
-    landmarkTransform->GetMatrix(calculatedTransform.GetPointer());
-
-    // Copy the resulting transform into the outputTransformNode
-    if (!outputTransformNode->IsLinear())
-    {
-      // SetMatrix... only works on linear transforms, if we have a non-linear transform
-      // in the node then we have to manually place a linear transform into it
-      vtkNew< vtkTransform > newLinearTransform;
-      newLinearTransform->SetMatrix(calculatedTransform.GetPointer());
-      outputTransformNode->SetAndObserveTransformToParent(newLinearTransform.GetPointer());
-    }
-    else
-    {
-      outputTransformNode->SetMatrixTransformToParent(calculatedTransform.GetPointer());
+      entry.Registration = vtkSmartPointer< vtkIncrementalLandmarkRegistration >::New();
     }
+    entry.Registration->SetPointPairs(fromPointsOrdered, toPointsOrdered);
+    entry.FromFiducialListNodeID = fromMarkupsFiducialNode->GetID();
+    entry.ToFiducialListNodeID = toMarkupsFiducialNode->GetID();
+    entry.PairsFollowListIndices = (pointMatching == vtkMRMLFiducialRegistrationWizardNode::POINT_MATCHING_MANUAL
+      && fromMarkupsFiducialNode != toMarkupsFiducialNode);
+    entry.PendingRemovedPointIndex = -1;
+    return this->UpdateLinearCalibration(fiducialRegistrationWizardNode, entry.Registration);
   }
   else if (registrationMode == vtkMRMLFiducialRegistrationWizardNode::REGISTRATION_MODE_WARPING)
   {
@@ -396,48 +490,118 @@ bool vtkSlicerFiducialRegistrationWizardLogic::UpdateCalibration(vtkMRMLNode* no
       return false;
     }
 
-    // Setup the transform
-    // Warping transforms are usually defined using FromParent direction to make transformation of images faster and more accurate.
-    bool logErrorIfFails = false; // parameters from http://apidocs.slicer.org/master/classvtkMRMLTransformNode.html#a79e612958c341ea681ac84282df42261
-    bool modifiableOnly = true;
-    vtkThinPlateSplineTransform* tpsTransform = NULL;
+    // Landmarks in the direction of the stored transform
+    vtkPoints* sourceLandmarks = fromPointsOrdered;
+    vtkPoints* targetLandmarks = toPointsOrdered;
     if (fiducialRegistrationWizardNode->GetWarpingTransformFromParent())
     {
-      tpsTransform = vtkThinPlateSplineTransform::SafeDownCast(
-        outputTransformNode->GetTransformFromParentAs("vtkThinPlateSplineTransform", logErrorIfFails, modifiableOnly));
+      sourceLandmarks = toPointsOrdered;
+      targetLandmarks = fromPointsOrdered;
     }
-    else
+
+    // For large fiducial lists use fewer control points that approximate the fiducials
+    vtkSmartPointer< vtkPoints > controlPointSourceLandmarks = sourceLandmarks;
+    vtkSmartPointer< vtkPoints > controlPointTargetLandmarks = targetLandmarks;
+    int numberOfControlPoints = fiducialRegistrationWizardNode->GetWarpingNumberOfControlPoints();
+    bool reducedControlPoints = (numberOfControlPoints > 0 && numberOfControlPoints < sourceLandmarks->GetNumberOfPoints());
+    if (reducedControlPoints || fiducialRegistrationWizardNode->GetWarpingRegularization() > 0.0)
     {
-      tpsTransform = vtkThinPlateSplineTransform::SafeDownCast(
-        outputTransformNode->GetTransformToParentAs("vtkThinPlateSplineTransform", logErrorIfFails, modifiableOnly));
+      vtkNew< vtkThinPlateSplineApproximator > approximator;
+      approximator->SetSourceLandmarks(sourceLandmarks);
+      approximator->SetTargetLandmarks(targetLandmarks);
+      approximator->SetNumberOfCenters(reducedControlPoints ? numberOfControlPoints : sourceLandmarks->GetNumberOfPoints());
+      approximator->SetRegularization(fiducialRegistrationWizardNode->GetWarpingRegularization());
+      controlPointSourceLandmarks = vtkSmartPointer< vtkPoints >::New();
+      controlPointTargetLandmarks = vtkSmartPointer< vtkPoints >::New();
+      if (!approximator->ComputeApproximatingLandmarks(controlPointSourceLandmarks, controlPointTargetLandmarks))
+      {
+        fiducialRegistrationWizardNode->SetCalibrationStatusMessage("Failed to compute warping control points.\nFiducials may be coplanar.");
+        return false;
+      }
     }
-    if (tpsTransform == NULL)
+
+    // Setup the transform
+    // Warping transforms are usually defined using FromParent direction to make transformation of images faster and more accurate.
+    bool logErrorIfFails = false; // parameters from http://apidocs.slicer.org/master/classvtkMRMLTransformNode.html#a79e612958c341ea681ac84282df42261
+    bool modifiableOnly = true;
+    if (fiducialRegistrationWizardNode->GetWarpingConvertToGridTransform())
     {
-      // we cannot reuse the existing transform, create a new one
-      vtkNew< vtkThinPlateSplineTransform > newTpsTransform;
-      newTpsTransform->SetBasisToR();
-      tpsTransform = newTpsTransform.GetPointer();
+      vtkNew< vtkThinPlateSplineTransform > controlPointTpsTransform;
+      controlPointTpsTransform->SetBasisToR();
+      controlPointTpsTransform->SetSourceLandmarks(controlPointSourceLandmarks);
+      controlPointTpsTransform->SetTargetLandmarks(controlPointTargetLandmarks);
+
+      vtkNew< vtkImageData > displacementGrid;
+      if (!this->ComputeWarpingDisplacementGrid(controlPointTpsTransform.GetPointer(), sourceLandmarks,
+        fiducialRegistrationWizardNode->GetWarpingGridSpacingMm(), displacementGrid.GetPointer()))
+      {
+        fiducialRegistrationWizardNode->SetCalibrationStatusMessage("Failed to compute warping grid transform.");
+        return false;
+      }
+
+      vtkOrientedGridTransform* gridTransform = NULL;
       if (fiducialRegistrationWizardNode->GetWarpingTransformFromParent())
       {
-        outputTransformNode->SetAndObserveTransformFromParent(tpsTransform);
+        gridTransform = vtkOrientedGridTransform::SafeDownCast(
+          outputTransformNode->GetTransformFromParentAs("vtkOrientedGridTransform", logErrorIfFails, modifiableOnly));
       }
       else
       {
-        outputTransformNode->SetAndObserveTransformToParent(tpsTransform);
+        gridTransform = vtkOrientedGridTransform::SafeDownCast(
+          outputTransformNode->GetTransformToParentAs("vtkOrientedGridTransform", logErrorIfFails, modifiableOnly));
       }
-    }
-    // Set inputs
-    if (fiducialRegistrationWizardNode->GetWarpingTransformFromParent())
-    {
-      tpsTransform->SetSourceLandmarks(toPointsOrdered);
-      tpsTransform->SetTargetLandmarks(fromPointsOrdered);
+      if (gridTransform == NULL)
+      {
+        // we cannot reuse the existing transform, create a new one
+        vtkNew< vtkOrientedGridTransform > newGridTransform;
+        newGridTransform->SetInterpolationModeToCubic();
+        gridTransform = newGridTransform.GetPointer();
+        if (fiducialRegistrationWizardNode->GetWarpingTransformFromParent())
+        {
+          outputTransformNode->SetAndObserveTransformFromParent(gridTransform);
+        }
+        else
+        {
+          outputTransformNode->SetAndObserveTransformToParent(gridTransform);
+        }
+      }
+      gridTransform->SetDisplacementGridData(displacementGrid.GetPointer());
+      gridTransform->SetDisplacementScale(1.0);
+      gridTransform->SetDisplacementShift(0.0);
     }
     else
     {
-      tpsTransform->SetSourceLandmarks(fromPointsOrdered);
-      tpsTransform->SetTargetLandmarks(toPointsOrdered);
+      vtkThinPlateSplineTransform* tpsTransform = NULL;
+      if (fiducialRegistrationWizardNode->GetWarpingTransformFromParent())
+      {
+        tpsTransform = vtkThinPlateSplineTransform::SafeDownCast(
+          outputTransformNode->GetTransformFromParentAs("vtkThinPlateSplineTransform", logErrorIfFails, modifiableOnly));
+      }
+      else
+      {
+        tpsTransform = vtkThinPlateSplineTransform::SafeDownCast(
+          outputTransformNode->GetTransformToParentAs("vtkThinPlateSplineTransform", logErrorIfFails, modifiableOnly));
+      }
+      if (tpsTransform == NULL)
+      {
+        // we cannot reuse the existing transform, create a new one
+        vtkNew< vtkThinPlateSplineTransform > newTpsTransform;
+        newTpsTransform->SetBasisToR();
+        tpsTransform = newTpsTransform.GetPointer();
+        if (fiducialRegistrationWizardNode->GetWarpingTransformFromParent())
+        {
+          outputTransformNode->SetAndObserveTransformFromParent(tpsTransform);
+        }
+        else
+        {
+          outputTransformNode->SetAndObserveTransformToParent(tpsTransform);
+        }
+      }
+      // Set inputs
+      tpsTransform->SetSourceLandmarks(controlPointSourceLandmarks);
+      tpsTransform->SetTargetLandmarks(controlPointTargetLandmarks);
+      tpsTransform->Update();
     }
-    tpsTransform->Update();
   }
   else
   {
@@ -467,6 +631,159 @@ bool vtkSlicerFiducialRegistrationWizardLogic::UpdateCalibration(vtkMRMLNode* no
   return true;
 }
 
+//------------------------------------------------------------------------------
+bool vtkSlicerFiducialRegistrationWizardLogic::UpdateLinearCalibration(vtkMRMLFiducialRegistrationWizardNode* fiducialRegistrationWizardNode,
+  vtkIncrementalLandmarkRegistration* incrementalRegistration)
+{
+  vtkMRMLTransformNode* outputTransformNode = fiducialRegistrationWizardNode->GetOutputTransformNode();
+  if (fiducialRegistrationWizardNode->GetRegistrationMode() == vtkMRMLFiducialRegistrationWizardNode::REGISTRATION_MODE_RIGID)
+  {
+    incrementalRegistration->SetModeToRigidBody();
+  }
+  else
+  {
+    incrementalRegistration->SetModeToSimilarity();
+  }
+  vtkNew< vtkMatrix4x4 > calculatedTransform;
+  if (!incrementalRegistration->GetMatrix(calculatedTransform.GetPointer()))
+  {
+    fiducialRegistrationWizardNode->SetCalibrationStatusMessage("Registration could not be computed from the fiducial lists.");
+    return false;
+  }
+
+  // Copy the resulting transform into the outputTransformNode
+  if (!outputTransformNode->IsLinear())
+  {
+    // SetMatrix... only works on linear transforms, if we have a non-linear transform
+    // in the node then we have to manually place a linear transform into it
+    vtkNew< vtkTransform > newLinearTransform;
+    newLinearTransform->SetMatrix(calculatedTransform.GetPointer());
+    outputTransformNode->SetAndObserveTransformToParent(newLinearTransform.GetPointer());
+  }
+  else
+  {
+    outputTransformNode->SetMatrixTransformToParent(calculatedTransform.GetPointer());
+  }
+
+  std::stringstream completeMessage;
+  double rmsError = incrementalRegistration->ComputeRootMeanSquareError(calculatedTransform.GetPointer());
+  completeMessage << "Registration Complete. RMS Error: " << rmsError;
+  fiducialRegistrationWizardNode->AddToCalibrationStatusMessage(completeMessage.str());
+  fiducialRegistrationWizardNode->SetCalibrationError( rmsError );
+#if Slicer_VERSION_MAJOR >= 5 || (Slicer_VERSION_MAJOR >= 4 && Slicer_VERSION_MINOR >= 11)
+  outputTransformNode->SetNodeReferenceID(vtkMRMLTransformNode::GetMovingNodeReferenceRole(), fiducialRegistrationWizardNode->GetFromFiducialListNode()->GetID());
+  outputTransformNode->SetNodeReferenceID(vtkMRMLTransformNode::GetFixedNodeReferenceRole(), fiducialRegistrationWizardNode->GetToFiducialListNode()->GetID());
+#endif
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerFiducialRegistrationWizardLogic::IsIncrementalRegistrationInSync( vtkMRMLFiducialRegistrationWizardNode* fiducialRegistrationWizardNode )
+{
+  if ( fiducialRegistrationWizardNode == NULL || fiducialRegistrationWizardNode->GetID() == NULL )
+  {
+    return false;
+  }
+  std::map< std::string, IncrementalRegistrationEntry >::iterator entryIt = this->IncrementalRegistrations.find( fiducialRegistrationWizardNode->GetID() );
+  return ( entryIt != this->IncrementalRegistrations.end()
+    && entryIt->second.PairsFollowListIndices
+    && entryIt->second.PendingRemovedPointIndex < 0 );
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerFiducialRegistrationWizardLogic::UpdateIncrementalRegistration(vtkMRMLFiducialRegistrationWizardNode* fiducialRegistrationWizardNode,
+  const vtkMRMLFiducialRegistrationWizardNode::InputPointEventData& eventData)
+{
+  if (fiducialRegistrationWizardNode->GetID() == NULL)
+  {
+    return;
+  }
+  std::map< std::string, IncrementalRegistrationEntry >::iterator entryIt = this->IncrementalRegistrations.find(fiducialRegistrationWizardNode->GetID());
+  if (entryIt == this->IncrementalRegistrations.end() || !entryIt->second.PairsFollowListIndices)
+  {
+    return;
+  }
+  IncrementalRegistrationEntry& entry = entryIt->second;
+  vtkMRMLMarkupsFiducialNode* fromMarkupsFiducialNode = fiducialRegistrationWizardNode->GetFromFiducialListNode();
+  vtkMRMLMarkupsFiducialNode* toMarkupsFiducialNode = fiducialRegistrationWizardNode->GetToFiducialListNode();
+  if (fromMarkupsFiducialNode == NULL || toMarkupsFiducialNode == NULL || eventData.PointIndex < 0
+    || entry.FromFiducialListNodeID != fromMarkupsFiducialNode->GetID()
+    || entry.ToFiducialListNodeID != toMarkupsFiducialNode->GetID())
+  {
+    // the pairs will be recomputed from all points in the next update
+    entry.PairsFollowListIndices = false;
+    return;
+  }
+
+  vtkIncrementalLandmarkRegistration* registration = entry.Registration;
+  int numberOfPairs = registration->GetNumberOfPointPairs();
+  int numberOfFromPoints = fromMarkupsFiducialNode->GetNumberOfControlPoints();
+  int numberOfToPoints = toMarkupsFiducialNode->GetNumberOfControlPoints();
+  int pointIndex = eventData.PointIndex;
+
+  if (entry.PendingRemovedPointIndex >= 0)
+  {
+    // Only the matching removal from the other list makes the pairs valid again
+    if (eventData.MarkupsEvent == vtkMRMLMarkupsNode::PointRemovedEvent
+      && eventData.FromList == entry.PendingRemovalInFromList
+      && pointIndex == entry.PendingRemovedPointIndex)
+    {
+      entry.PendingRemovedPointIndex = -1;
+    }
+    else
+    {
+      entry.PairsFollowListIndices = false;
+    }
+    return;
+  }
+
+  double fromPoint[3] = { 0.0, 0.0, 0.0 };
+  double toPoint[3] = { 0.0, 0.0, 0.0 };
+  if (eventData.MarkupsEvent == vtkMRMLMarkupsNode::PointModifiedEvent)
+  {
+    // points without a pair in the other list do not affect the registration
+    if (pointIndex < numberOfPairs)
+    {
+      fromMarkupsFiducialNode->GetNthControlPointPosition(pointIndex, fromPoint);
+      toMarkupsFiducialNode->GetNthControlPointPosition(pointIndex, toPoint);
+      registration->UpdatePointPair(pointIndex, fromPoint, toPoint);
+    }
+  }
+  else if (eventData.MarkupsEvent == vtkMRMLMarkupsNode::PointAddedEvent)
+  {
+    if (pointIndex < numberOfPairs)
+    {
+      // inserted before existing pairs, all later points are paired differently
+      entry.PairsFollowListIndices = false;
+      return;
+    }
+    // appended point, it forms a new pair if the other list already has a point with the same index
+    for (int pairIndex = numberOfPairs; pairIndex < std::min(numberOfFromPoints, numberOfToPoints); pairIndex++)
+    {
+      fromMarkupsFiducialNode->GetNthControlPointPosition(pairIndex, fromPoint);
+      toMarkupsFiducialNode->GetNthControlPointPosition(pairIndex, toPoint);
+      registration->AddPointPair(fromPoint, toPoint);
+    }
+  }
+  else if (eventData.MarkupsEvent == vtkMRMLMarkupsNode::PointRemovedEvent)
+  {
+    if (pointIndex >= numberOfPairs)
+    {
+      // the point did not have a pair
+      return;
+    }
+    registration->RemovePointPair(pointIndex);
+    int numberOfPointsAfterRemoval = (eventData.FromList ? numberOfFromPoints : numberOfToPoints);
+    if (pointIndex < numberOfPointsAfterRemoval)
+    {
+      // Removed from the middle of the list, the later points are shifted. Usually the point with the
+      // same index is removed from the other list next, which restores the pairing of the later points.
+      entry.PendingRemovedPointIndex = pointIndex;
+      entry.PendingRemovalInFromList = !eventData.FromList; // the removal is expected from the other list
+    }
+  }
+}
+
 //------------------------------------------------------------------------------
 double vtkSlicerFiducialRegistrationWizardLogic::CalculateRegistrationError(vtkPoints* fromPoints, vtkPoints* toPoints, vtkAbstractTransform* transform)
 {
@@ -489,6 +806,324 @@ double vtkSlicerFiducialRegistrationWizardLogic::CalculateRegistrationError(vtkP
   return sqrt(sumSquaredError / toPoints->GetNumberOfPoints());
 }
 
+//------------------------------------------------------------------------------
+bool vtkSlicerFiducialRegistrationWizardLogic::ComputeWarpingDisplacementGrid(vtkAbstractTransform* transform, vtkPoints* points, double spacingMm, vtkImageData* displacementGrid)
+{
+  if (transform == NULL || points == NULL || displacementGrid == NULL || points->GetNumberOfPoints() == 0)
+  {
+    vtkErrorMacro("ComputeWarpingDisplacementGrid: invalid inputs");
+    return false;
+  }
+  if (spacingMm <= 0.0)
+  {
+    vtkErrorMacro("ComputeWarpingDisplacementGrid: grid spacing must be positive, it is " << spacingMm);
+    return false;
+  }
+
+  double bounds[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  points->GetBounds(bounds);
+  double maximumSize = std::max(bounds[1] - bounds[0], std::max(bounds[3] - bounds[2], bounds[5] - bounds[4]));
+  double margin = std::max(WARPING_GRID_MARGIN_FRACTION * maximumSize, spacingMm);
+  double origin[3] = { 0.0, 0.0, 0.0 };
+  double size[3] = { 0.0, 0.0, 0.0 };
+  for (int i = 0; i < 3; i++)
+  {
+    origin[i] = bounds[2 * i] - margin;
+    size[i] = bounds[2 * i + 1] - bounds[2 * i] + 2.0 * margin;
+  }
+
+  int dimensions[3] = { 1, 1, 1 };
+  for (int attempt = 0; attempt < 2; attempt++)
+  {
+    vtkIdType numberOfVoxels = 1;
+    for (int i = 0; i < 3; i++)
+    {
+      dimensions[i] = static_cast<int>(ceil(size[i] / spacingMm)) + 1;
+      numberOfVoxels *= dimensions[i];
+    }
+    if (numberOfVoxels <= WARPING_GRID_MAXIMUM_NUMBER_OF_VOXELS)
+    {
+      break;
+    }
+    double newSpacingMm = spacingMm * std::cbrt(static_cast<double>(numberOfVoxels) / WARPING_GRID_MAXIMUM_NUMBER_OF_VOXELS) * 1.01;
+    vtkWarningMacro("ComputeWarpingDisplacementGrid: grid spacing is increased from " << spacingMm << " to " << newSpacingMm << "mm to limit grid size");
+    spacingMm = newSpacingMm;
+  }
+
+  vtkNew<vtkTransformToGrid> transformToGrid;
+  transformToGrid->SetInput(transform);
+  transformToGrid->SetGridScalarTypeToDouble();
+  transformToGrid->SetGridOrigin(origin);
+  transformToGrid->SetGridSpacing(spacingMm, spacingMm, spacingMm);
+  transformToGrid->SetGridExtent(0, dimensions[0] - 1, 0, dimensions[1] - 1, 0, dimensions[2] - 1);
+  transformToGrid->Update();
+  displacementGrid->DeepCopy(transformToGrid->GetOutput());
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Evaluates the Fitzpatrick TRE model for one slice of the output volume per call.
+// Each voxel only depends on its own position, so slices can be computed by any thread.
+class TargetRegistrationErrorVolumeFunctor
+{
+public:
+  TargetRegistrationErrorVolumeFunctor(float* treValues, const int dimensions[3], const double origin[3], double spacing,
+    const double centroid[3], double principalAxes[3][3], const double meanSquaredDistancesFromAxes[3], double fleSquaredPerFiducial)
+    : TreValues(treValues)
+    , Spacing(spacing)
+    , FleSquaredPerFiducial(fleSquaredPerFiducial)
+  {
+    for (int i = 0; i < 3; i++)
+    {
+      this->Dimensions[i] = dimensions[i];
+      this->Origin[i] = origin[i];
+      this->Centroid[i] = centroid[i];
+      this->MeanSquaredDistancesFromAxes[i] = meanSquaredDistancesFromAxes[i];
+      for (int j = 0; j < 3; j++)
+      {
+        // store axes as rows for cache-friendly dot products
+        this->PrincipalAxes[i][j] = principalAxes[j][i];
+      }
+    }
+  }
+
+  void operator()(vtkIdType beginSlice, vtkIdType endSlice) const
+  {
+    vtkIdType sliceSize = static_cast<vtkIdType>(this->Dimensions[0]) * this->Dimensions[1];
+    for (vtkIdType k = beginSlice; k < endSlice; k++)
+    {
+      float* treValue = this->TreValues + k * sliceSize;
+      double position[3] = { 0.0, 0.0, this->Origin[2] + k * this->Spacing - this->Centroid[2] };
+      for (int j = 0; j < this->Dimensions[1]; j++)
+      {
+        position[1] = this->Origin[1] + j * this->Spacing - this->Centroid[1];
+        for (int i = 0; i < this->Dimensions[0]; i++)
+        {
+          position[0] = this->Origin[0] + i * this->Spacing - this->Centroid[0];
+          double squaredDistanceFromCentroid = vtkMath::Dot(position, position);
+          double sumOfRelativeSquaredDistancesFromAxes = 0.0;
+          for (int axis = 0; axis < 3; axis++)
+          {
+            double projection = vtkMath::Dot(position, this->PrincipalAxes[axis]);
+            sumOfRelativeSquaredDistancesFromAxes += (squaredDistanceFromCentroid - projection * projection) / this->MeanSquaredDistancesFromAxes[axis];
+          }
+          *(treValue++) = static_cast<float>(sqrt(this->FleSquaredPerFiducial * (1.0 + sumOfRelativeSquaredDistancesFromAxes / 3.0)));
+        }
+      }
+    }
+  }
+
+private:
+  float* TreValues;
+  int Dimensions[3];
+  double Origin[3];
+  double Spacing;
+  double Centroid[3];
+  double PrincipalAxes[3][3];
+  double MeanSquaredDistancesFromAxes[3];
+  double FleSquaredPerFiducial;
+};
+
+//------------------------------------------------------------------------------
+bool vtkSlicerFiducialRegistrationWizardLogic::UpdateTargetRegistrationErrorVolume(vtkMRMLFiducialRegistrationWizardNode* fiducialRegistrationWizardNode,
+  vtkMRMLScalarVolumeNode* treVolumeNode, const double roiBounds[6], double spacingMm, double fiducialLocalizationErrorMm/*=0.0*/)
+{
+  if (fiducialRegistrationWizardNode == NULL || treVolumeNode == NULL || roiBounds == NULL)
+  {
+    vtkErrorMacro("UpdateTargetRegistrationErrorVolume: invalid inputs");
+    return false;
+  }
+  if (spacingMm <= 0.0)
+  {
+    vtkErrorMacro("UpdateTargetRegistrationErrorVolume: spacing must be positive, it is " << spacingMm);
+    return false;
+  }
+  int registrationMode = fiducialRegistrationWizardNode->GetRegistrationMode();
+  if (registrationMode != vtkMRMLFiducialRegistrationWizardNode::REGISTRATION_MODE_RIGID &&
+    registrationMode != vtkMRMLFiducialRegistrationWizardNode::REGISTRATION_MODE_SIMILARITY)
+  {
+    vtkErrorMacro("UpdateTargetRegistrationErrorVolume: target registration error model is only available for rigid and similarity registration");
+    return false;
+  }
+
+  vtkMRMLMarkupsFiducialNode* toMarkupsFiducialNode = fiducialRegistrationWizardNode->GetToFiducialListNode();
+  if (toMarkupsFiducialNode == NULL)
+  {
+    vtkErrorMacro("UpdateTargetRegistrationErrorVolume: 'To' fiducial list is not set");
+    return false;
+  }
+  vtkNew<vtkPoints> toPoints;
+  MarkupsFiducialNodeToVTKPoints(toMarkupsFiducialNode, toPoints.GetPointer());
+  int numberOfFiducials = toPoints->GetNumberOfPoints();
+  if (numberOfFiducials < 3)
+  {
+    vtkErrorMacro("UpdateTargetRegistrationErrorVolume: at least 3 fiducials are required");
+    return false;
+  }
+
+  // Fiducial localization error. The expected fiducial registration error is FLE^2 * (1 - 2/N).
+  double fleSquared = fiducialLocalizationErrorMm * fiducialLocalizationErrorMm;
+  if (fiducialLocalizationErrorMm <= 0.0)
+  {
+    double fre = fiducialRegistrationWizardNode->GetCalibrationError();
+    if (fre == VTK_DOUBLE_MAX)
+    {
+      vtkErrorMacro("UpdateTargetRegistrationErrorVolume: fiducial localization error cannot be estimated, the registration has not been computed");
+      return false;
+    }
+    fleSquared = fre * fre * numberOfFiducials / (numberOfFiducials - 2.0);
+  }
+
+  // Principal axes of the fiducial configuration
+  double centroid[3] = { 0.0, 0.0, 0.0 };
+  for (int i = 0; i < numberOfFiducials; i++)
+  {
+    vtkMath::Add(centroid, toPoints->GetPoint(i), centroid);
+  }
+  vtkMath::MultiplyScalar(centroid, 1.0 / numberOfFiducials);
+  double covariance[3][3] = { { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 } };
+  for (int i = 0; i < numberOfFiducials; i++)
+  {
+    double position[3] = { 0.0, 0.0, 0.0 };
+    vtkMath::Subtract(toPoints->GetPoint(i), centroid, position);
+    for (int row = 0; row < 3; row++)
+    {
+      for (int column = 0; column < 3; column++)
+      {
+        covariance[row][column] += position[row] * position[column] / numberOfFiducials;
+      }
+    }
+  }
+  double eigenvalues[3] = { 0.0, 0.0, 0.0 };
+  double principalAxes[3][3]; // eigenvectors in columns
+  vtkMath::Diagonalize3x3(covariance, eigenvalues, principalAxes);
+  // mean squared distance of the fiducials from a principal axis is the sum of the variances along the other two axes
+  double traceOfCovariance = eigenvalues[0] + eigenvalues[1] + eigenvalues[2];
+  double meanSquaredDistancesFromAxes[3] = { 0.0, 0.0, 0.0 };
+  for (int axis = 0; axis < 3; axis++)
+  {
+    meanSquaredDistancesFromAxes[axis] = traceOfCovariance - eigenvalues[axis];
+    if (meanSquaredDistancesFromAxes[axis] <= EIGENVALUE_THRESHOLD)
+    {
+      vtkErrorMacro("UpdateTargetRegistrationErrorVolume: fiducials are collinear");
+      return false;
+    }
+  }
+
+  // Output geometry
+  double origin[3] = { roiBounds[0], roiBounds[2], roiBounds[4] };
+  int dimensions[3] = { 1, 1, 1 };
+  for (int i = 0; i < 3; i++)
+  {
+    dimensions[i] = std::max(1, static_cast<int>(floor((roiBounds[2 * i + 1] - roiBounds[2 * i]) / spacingMm)) + 1);
+  }
+
+  vtkNew<vtkImageData> treImageData;
+  treImageData->SetDimensions(dimensions);
+  treImageData->AllocateScalars(VTK_FLOAT, 1);
+  float* treValues = static_cast<float*>(treImageData->GetScalarPointer());
+
+  TargetRegistrationErrorVolumeFunctor treFunctor(treValues, dimensions, origin, spacingMm,
+    centroid, principalAxes, meanSquaredDistancesFromAxes, fleSquared / numberOfFiducials);
+  vtkSMPTools::For(0, dimensions[2], treFunctor);
+
+  double ijkToRasDirections[3][3] = { { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 }, { 0.0, 0.0, 1.0 } };
+  treVolumeNode->SetIJKToRASDirections(ijkToRasDirections);
+  treVolumeNode->SetOrigin(origin);
+  treVolumeNode->SetSpacing(spacingMm, spacingMm, spacingMm);
+  treVolumeNode->SetAndObserveImageData(treImageData.GetPointer());
+  if (treVolumeNode->GetDisplayNode() == NULL && treVolumeNode->GetScene() != NULL)
+  {
+    treVolumeNode->CreateDefaultDisplayNodes();
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerFiducialRegistrationWizardLogic::GetCachedPointMatching(vtkMRMLFiducialRegistrationWizardNode* fiducialRegistrationWizardNode,
+  vtkPoints* toPointsUnordered, vtkPoints* fromPointsOrdered, vtkPoints* toPointsOrdered, bool& matchingAmbiguous)
+{
+  std::map< std::string, PointMatchingCacheEntry >::iterator cacheIt = this->PointMatchingCache.find(fiducialRegistrationWizardNode->GetID());
+  if (cacheIt == this->PointMatchingCache.end())
+  {
+    return false;
+  }
+  const PointMatchingCacheEntry& cacheEntry = cacheIt->second;
+
+  // the matching has to be recomputed if the lists or any of their points have been changed, added, or removed
+  vtkMRMLMarkupsFiducialNode* fromMarkupsFiducialNode = fiducialRegistrationWizardNode->GetFromFiducialListNode();
+  vtkMRMLMarkupsFiducialNode* toMarkupsFiducialNode = fiducialRegistrationWizardNode->GetToFiducialListNode();
+  if (cacheEntry.FromFiducialListNodeID != fromMarkupsFiducialNode->GetID()
+    || cacheEntry.ToFiducialListNodeID != toMarkupsFiducialNode->GetID())
+  {
+    return false;
+  }
+  std::vector<std::string> fromPointIDs;
+  GetControlPointIDs(fromMarkupsFiducialNode, fromPointIDs);
+  std::vector<std::string> toPointIDs;
+  GetControlPointIDs(toMarkupsFiducialNode, toPointIDs);
+  if (fromPointIDs != cacheEntry.FromPointIDs || toPointIDs != cacheEntry.ToPointIDs)
+  {
+    return false;
+  }
+
+  // the same points are present, but they may have been moved
+  fromPointsOrdered->Reset();
+  toPointsOrdered->Reset();
+  for (unsigned int pairIndex = 0; pairIndex < cacheEntry.MatchedFromPointIDs.size(); pairIndex++)
+  {
+    double fromPoint[3] = { 0, 0, 0 };
+    fromMarkupsFiducialNode->GetNthControlPointPosition(
+      fromMarkupsFiducialNode->GetNthControlPointIndexByID(cacheEntry.MatchedFromPointIDs[pairIndex].c_str()), fromPoint);
+    fromPointsOrdered->InsertNextPoint(fromPoint);
+    double toPoint[3] = { 0, 0, 0 };
+    toMarkupsFiducialNode->GetNthControlPointPosition(
+      toMarkupsFiducialNode->GetNthControlPointIndexByID(cacheEntry.MatchedToPointIDs[pairIndex].c_str()), toPoint);
+    toPointsOrdered->InsertNextPoint(toPoint);
+  }
+
+  // same criterion as the point matcher uses for accepting a matching
+  double tolerableDistanceError = POINT_MATCHING_TOLERABLE_DISTANCE_ERROR_MULTIPLE * vtkPointMatcher::ComputeMaximumDistanceInPointSet(toPointsUnordered);
+  if (vtkPointMatcher::ComputeRegistrationRootMeanSquareError(fromPointsOrdered, toPointsOrdered) > tolerableDistanceError)
+  {
+    return false;
+  }
+
+  matchingAmbiguous = cacheEntry.MatchingAmbiguous;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerFiducialRegistrationWizardLogic::UpdatePointMatchingCache(vtkMRMLFiducialRegistrationWizardNode* fiducialRegistrationWizardNode,
+  vtkPoints* fromPointsUnordered, vtkPoints* toPointsUnordered, vtkPoints* fromPointsOrdered, vtkPoints* toPointsOrdered, bool matchingAmbiguous)
+{
+  // the matcher outputs coordinates, find out which points they belong to
+  std::vector<int> matchedFromPointIndices;
+  std::vector<int> matchedToPointIndices;
+  if (!FindPointIndicesInList(fromPointsUnordered, fromPointsOrdered, matchedFromPointIndices)
+    || !FindPointIndicesInList(toPointsUnordered, toPointsOrdered, matchedToPointIndices))
+  {
+    this->PointMatchingCache.erase(fiducialRegistrationWizardNode->GetID());
+    return;
+  }
+
+  vtkMRMLMarkupsFiducialNode* fromMarkupsFiducialNode = fiducialRegistrationWizardNode->GetFromFiducialListNode();
+  vtkMRMLMarkupsFiducialNode* toMarkupsFiducialNode = fiducialRegistrationWizardNode->GetToFiducialListNode();
+  PointMatchingCacheEntry& cacheEntry = this->PointMatchingCache[fiducialRegistrationWizardNode->GetID()];
+  cacheEntry.FromFiducialListNodeID = fromMarkupsFiducialNode->GetID();
+  cacheEntry.ToFiducialListNodeID = toMarkupsFiducialNode->GetID();
+  GetControlPointIDs(fromMarkupsFiducialNode, cacheEntry.FromPointIDs);
+  GetControlPointIDs(toMarkupsFiducialNode, cacheEntry.ToPointIDs);
+  cacheEntry.MatchedFromPointIDs.clear();
+  cacheEntry.MatchedToPointIDs.clear();
+  for (unsigned int pairIndex = 0; pairIndex < matchedFromPointIndices.size(); pairIndex++)
+  {
+    cacheEntry.MatchedFromPointIDs.push_back(cacheEntry.FromPointIDs[matchedFromPointIndices[pairIndex]]);
+    cacheEntry.MatchedToPointIDs.push_back(cacheEntry.ToPointIDs[matchedToPointIndices[pairIndex]]);
+  }
+  cacheEntry.MatchingAmbiguous = matchingAmbiguous;
+}
+
 //------------------------------------------------------------------------------
 bool vtkSlicerFiducialRegistrationWizardLogic::CheckCollinear(vtkPoints* points)
 {
@@ -549,7 +1184,25 @@ bool vtkSlicerFiducialRegistrationWizardLogic::CheckCollinear(vtkPoints* points)
 }
 
 //------------------------------------------------------------------------------
-void vtkSlicerFiducialRegistrationWizardLogic::ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* vtkNotUsed(callData))
+bool vtkSlicerFiducialRegistrationWizardLogic::CheckCollinear(double covariance[3][3])
+{
+  // same test as for the points, using the eigenvalues of the covariance matrix
+  double eigenvalues[3] = { 0.0, 0.0, 0.0 };
+  double eigenvectors[3][3];
+  vtkMath::Diagonalize3x3(covariance, eigenvalues, eigenvectors);
+  int goodEigenvalues = 0;
+  for (int i = 0; i < 3; i++)
+  {
+    if (fabs(eigenvalues[i]) > EIGENVALUE_THRESHOLD)
+    {
+      goodEigenvalues++;
+    }
+  }
+  return (goodEigenvalues <= 1);
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerFiducialRegistrationWizardLogic::ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData)
 {
   vtkMRMLFiducialRegistrationWizardNode* frwNode = vtkMRMLFiducialRegistrationWizardNode::SafeDownCast(caller);
   if (frwNode == NULL)
@@ -557,6 +1210,13 @@ void vtkSlicerFiducialRegistrationWizardLogic::ProcessMRMLNodesEvents(vtkObject*
     return;
   }
 
+  // keep the point pairs up to date even if the calibration is not updated automatically
+  if (event == vtkMRMLFiducialRegistrationWizardNode::InputPointModifiedEvent && callData != NULL)
+  {
+    this->UpdateIncrementalRegistration(frwNode,
+      *(static_cast<vtkMRMLFiducialRegistrationWizardNode::InputPointEventData*>(callData)));
+  }
+
   // only recompute output if the input is changed
   // (for example we do not recompute the calibration output if the computed calibration transform or status message is changed)
   if (event == vtkMRMLFiducialRegistrationWizardNode::InputDataModifiedEvent)
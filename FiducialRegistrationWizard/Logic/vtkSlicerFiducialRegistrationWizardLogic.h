@@ -22,7 +22,9 @@
 #define __vtkSlicerFiducialRegistrationWizardLogic_h
 
 
+#include <map>
 #include <string>
+#include <vector>
 
 // Slicer includes
 #include "vtkSlicerModuleLogic.h"
@@ -39,13 +41,16 @@
 #include "vtkMRMLFiducialRegistrationWizardNode.h"
 
 class vtkMRMLMarkupsFiducialNode;
+class vtkImageData;
 class vtkMRMLLinearTransformNode;
+class vtkMRMLScalarVolumeNode;
 
 
 // STD includes
 #include <cstdlib>
 
 // helper classes
+#include "vtkIncrementalLandmarkRegistration.h"
 #include "vtkPointDistanceMatrix.h"
 
 #include "vtkSlicerFiducialRegistrationWizardModuleLogicExport.h"
@@ -67,6 +72,20 @@ public:
 
   bool UpdateCalibration( vtkMRMLNode* node );
 
+  /// Compute the expected target registration error (TRE) of a rigid or similarity registration
+  /// at each voxel of a grid that covers roiBounds (xmin, xmax, ymin, ymax, zmin, zmax in the
+  /// coordinate system of the 'To' fiducial list), based on the 'To' fiducial configuration
+  /// (Fitzpatrick, West, Maurer: Predicting error in rigid-body point-based registration, IEEE TMI 1998).
+  /// If fiducialLocalizationErrorMm is not positive then it is estimated from the calibration error
+  /// of the last registration. The result is stored in treVolumeNode, voxels are computed in parallel.
+  bool UpdateTargetRegistrationErrorVolume( vtkMRMLFiducialRegistrationWizardNode* fiducialRegistrationWizardNode,
+    vtkMRMLScalarVolumeNode* treVolumeNode, const double roiBounds[6], double spacingMm, double fiducialLocalizationErrorMm = 0.0 );
+
+  /// Returns true if the point pairs of the rigid or similarity registration of the node are kept up to date
+  /// by the point events of the fiducial lists (manual point matching), so that the next automatic update
+  /// computes the registration without reading all points of the lists.
+  bool IsIncrementalRegistrationInSync( vtkMRMLFiducialRegistrationWizardNode* fiducialRegistrationWizardNode );
+
   vtkGetMacro(MarkupsLogic, vtkSlicerMarkupsLogic*);
   vtkSetMacro(MarkupsLogic, vtkSlicerMarkupsLogic*);
   
@@ -103,6 +122,58 @@ private:
 
   double CalculateRegistrationError( vtkPoints* fromPoints, vtkPoints* toPoints, vtkAbstractTransform* transform );
   bool CheckCollinear( vtkPoints* points );
+  bool CheckCollinear( double covariance[3][3] );
+
+  // Sample the transform on a grid that covers the points with some margin.
+  // Spacing is increased if needed to keep the grid size reasonable.
+  bool ComputeWarpingDisplacementGrid( vtkAbstractTransform* transform, vtkPoints* points, double spacingMm, vtkImageData* displacementGrid );
+
+  // Result of the last automatic point matching of a registration wizard node, stored by point IDs.
+  // While points are only moved (not added or removed), the matching is reused if it is still valid,
+  // so the point matching search is not repeated on every modification.
+  struct PointMatchingCacheEntry
+  {
+    PointMatchingCacheEntry() : MatchingAmbiguous(false) {}
+    std::string FromFiducialListNodeID;
+    std::string ToFiducialListNodeID;
+    std::vector< std::string > FromPointIDs; // all points of the lists when the matching was computed
+    std::vector< std::string > ToPointIDs;
+    std::vector< std::string > MatchedFromPointIDs; // matched pairs, in order
+    std::vector< std::string > MatchedToPointIDs;
+    bool MatchingAmbiguous;
+  };
+  std::map< std::string, PointMatchingCacheEntry > PointMatchingCache; // key: registration wizard node ID
+
+  // Returns true if the cached matching is still valid, i.e., the same points are in the lists
+  // and the ordered points can be registered within the tolerable distance error.
+  bool GetCachedPointMatching( vtkMRMLFiducialRegistrationWizardNode* fiducialRegistrationWizardNode, vtkPoints* toPointsUnordered,
+    vtkPoints* fromPointsOrdered, vtkPoints* toPointsOrdered, bool& matchingAmbiguous );
+  void UpdatePointMatchingCache( vtkMRMLFiducialRegistrationWizardNode* fiducialRegistrationWizardNode,
+    vtkPoints* fromPointsUnordered, vtkPoints* toPointsUnordered, vtkPoints* fromPointsOrdered, vtkPoints* toPointsOrdered, bool matchingAmbiguous );
+
+  // Running sums of the ordered point pairs, so that adding or moving a fiducial
+  // does not require recomputing the rigid/similarity registration from all points.
+  // With manual point matching pair i is made of the i-th points of the 'From' and 'To' lists,
+  // and the pairs are updated from the point added, removed, and modified events of the lists.
+  struct IncrementalRegistrationEntry
+  {
+    IncrementalRegistrationEntry() : PairsFollowListIndices(false), PendingRemovedPointIndex(-1), PendingRemovalInFromList(false) {}
+    vtkSmartPointer< vtkIncrementalLandmarkRegistration > Registration;
+    std::string FromFiducialListNodeID;
+    std::string ToFiducialListNodeID;
+    bool PairsFollowListIndices; // pairs are kept up to date by the point events
+    // A point was removed from the middle of one list, the pairs are valid again when
+    // the point with the same index is removed from the other list
+    int PendingRemovedPointIndex;
+    bool PendingRemovalInFromList; // the list that the pending removal is expected from
+  };
+  std::map< std::string, IncrementalRegistrationEntry > IncrementalRegistrations; // key: registration wizard node ID
+
+  void UpdateIncrementalRegistration( vtkMRMLFiducialRegistrationWizardNode* fiducialRegistrationWizardNode,
+    const vtkMRMLFiducialRegistrationWizardNode::InputPointEventData& eventData );
+  // Set the output transform from the registration of the point pairs, and the registration error
+  bool UpdateLinearCalibration( vtkMRMLFiducialRegistrationWizardNode* fiducialRegistrationWizardNode,
+    vtkIncrementalLandmarkRegistration* incrementalRegistration );
 
   std::map< std::string, std::string > OutputMessages;
 
@@ -0,0 +1,345 @@
+#include "vtkThinPlateSplineApproximator.h"
+
+#include <vtkMath.h>
+#include <vtkObjectFactory.h> //for vtkStandardNewMacro() macro
+#include <vtkPoints.h>
+
+// std includes
+#include <algorithm>
+
+#define MAXIMUM_NUMBER_OF_CLUSTERING_ITERATIONS 20
+// the affine part of the spline cannot be determined from fewer (non-coplanar) centers
+#define MINIMUM_NUMBER_OF_CENTERS 4
+// 1 constant + 3 linear terms per output coordinate
+#define NUMBER_OF_AFFINE_TERMS 4
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro( vtkThinPlateSplineApproximator );
+
+//------------------------------------------------------------------------------
+vtkThinPlateSplineApproximator::vtkThinPlateSplineApproximator()
+{
+  this->SourceLandmarks = NULL;
+  this->TargetLandmarks = NULL;
+  this->NumberOfCenters = 0;
+  this->Regularization = 0.0;
+}
+
+//------------------------------------------------------------------------------
+vtkThinPlateSplineApproximator::~vtkThinPlateSplineApproximator()
+{
+  if ( this->SourceLandmarks != NULL )
+  {
+    this->SourceLandmarks->Delete();
+    this->SourceLandmarks = NULL;
+  }
+  if ( this->TargetLandmarks != NULL )
+  {
+    this->TargetLandmarks->Delete();
+    this->TargetLandmarks = NULL;
+  }
+}
+
+//------------------------------------------------------------------------------
+void vtkThinPlateSplineApproximator::PrintSelf( std::ostream &os, vtkIndent indent )
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "NumberOfCenters: " << this->NumberOfCenters << std::endl;
+  os << indent << "Regularization: " << this->Regularization << std::endl;
+}
+
+//------------------------------------------------------------------------------
+void vtkThinPlateSplineApproximator::SetSourceLandmarks( vtkPoints* points )
+{
+  vtkSetObjectBodyMacro( SourceLandmarks, vtkPoints, points );
+}
+
+//------------------------------------------------------------------------------
+void vtkThinPlateSplineApproximator::SetTargetLandmarks( vtkPoints* points )
+{
+  vtkSetObjectBodyMacro( TargetLandmarks, vtkPoints, points );
+}
+
+//------------------------------------------------------------------------------
+// The spline is f(x) = sum_k( w_k * |x - c_k| ) + a_0 + A * x with the side conditions
+// sum_k( w_k ) = 0 and sum_k( w_k * c_k ) = 0. Minimizing
+//   |Phi * w + P * a - T|^2 - Regularization * w^T * PhiCC * w
+// (the bending energy of the r basis in 3D is proportional to -w^T * PhiCC * w)
+// subject to the side conditions gives the linear system
+//   [ Phi^T * Phi - Regularization * PhiCC   Phi^T * P   PC ] [ w  ]   [ Phi^T * T ]
+//   [ P^T * Phi                              P^T * P     0  ] [ a  ] = [ P^T * T   ]
+//   [ PC^T                                   0           0  ] [ mu ]   [ 0         ]
+// where Phi is the landmark-to-center basis matrix, PhiCC is the center-to-center basis matrix,
+// P and PC are the rows [ 1, x, y, z ] of the landmarks and centers respectively.
+bool vtkThinPlateSplineApproximator::ComputeApproximatingLandmarks( vtkPoints* outputSourceLandmarks, vtkPoints* outputTargetLandmarks )
+{
+  if ( this->SourceLandmarks == NULL || this->TargetLandmarks == NULL )
+  {
+    vtkWarningMacro( "Input landmarks are null. Returning." );
+    return false;
+  }
+
+  if ( outputSourceLandmarks == NULL || outputTargetLandmarks == NULL )
+  {
+    vtkWarningMacro( "Output landmarks are null. Returning." );
+    return false;
+  }
+
+  int numberOfLandmarks = this->SourceLandmarks->GetNumberOfPoints();
+  if ( this->TargetLandmarks->GetNumberOfPoints() != numberOfLandmarks )
+  {
+    vtkWarningMacro( "Number of source landmarks " << numberOfLandmarks << " does not match number of target landmarks " << this->TargetLandmarks->GetNumberOfPoints() << ". Returning." );
+    return false;
+  }
+
+  if ( numberOfLandmarks < MINIMUM_NUMBER_OF_CENTERS )
+  {
+    vtkWarningMacro( "At least " << MINIMUM_NUMBER_OF_CENTERS << " landmarks are needed, there are " << numberOfLandmarks << ". Returning." );
+    return false;
+  }
+
+  if ( this->Regularization < 0.0 )
+  {
+    vtkWarningMacro( "Regularization " << this->Regularization << " is negative. Returning." );
+    return false;
+  }
+
+  std::vector< double > sourceCoordinates( 3 * numberOfLandmarks );
+  std::vector< double > targetCoordinates( 3 * numberOfLandmarks );
+  for ( int landmarkIndex = 0; landmarkIndex < numberOfLandmarks; landmarkIndex++ )
+  {
+    this->SourceLandmarks->GetPoint( landmarkIndex, &sourceCoordinates[ 3 * landmarkIndex ] );
+    this->TargetLandmarks->GetPoint( landmarkIndex, &targetCoordinates[ 3 * landmarkIndex ] );
+  }
+
+  int numberOfCenters = vtkMath::Max( this->NumberOfCenters, MINIMUM_NUMBER_OF_CENTERS );
+  std::vector< double > centerCoordinates;
+  if ( numberOfCenters >= numberOfLandmarks )
+  {
+    numberOfCenters = numberOfLandmarks;
+    centerCoordinates = sourceCoordinates;
+  }
+  else
+  {
+    vtkThinPlateSplineApproximator::ComputeClusterCenters( sourceCoordinates, numberOfCenters, centerCoordinates );
+  }
+
+  // basis matrix between the landmarks and the centers
+  std::vector< double > landmarkBasis( numberOfLandmarks * numberOfCenters );
+  for ( int landmarkIndex = 0; landmarkIndex < numberOfLandmarks; landmarkIndex++ )
+  {
+    for ( int centerIndex = 0; centerIndex < numberOfCenters; centerIndex++ )
+    {
+      landmarkBasis[ landmarkIndex * numberOfCenters + centerIndex ] =
+        sqrt( vtkMath::Distance2BetweenPoints( &sourceCoordinates[ 3 * landmarkIndex ], &centerCoordinates[ 3 * centerIndex ] ) );
+    }
+  }
+
+  // assemble the linear system
+  int systemSize = numberOfCenters + 2 * NUMBER_OF_AFFINE_TERMS;
+  int affineOffset = numberOfCenters;
+  int constraintOffset = numberOfCenters + NUMBER_OF_AFFINE_TERMS;
+  std::vector< double > systemMatrixValues( systemSize * systemSize, 0.0 );
+  std::vector< double* > systemMatrix( systemSize );
+  for ( int row = 0; row < systemSize; row++ )
+  {
+    systemMatrix[ row ] = &systemMatrixValues[ row * systemSize ];
+  }
+  std::vector< double > rightHandSides( 3 * systemSize, 0.0 ); // one column per output coordinate
+
+  for ( int landmarkIndex = 0; landmarkIndex < numberOfLandmarks; landmarkIndex++ )
+  {
+    const double* basisRow = &landmarkBasis[ landmarkIndex * numberOfCenters ];
+    const double* sourcePoint = &sourceCoordinates[ 3 * landmarkIndex ];
+    const double* targetPoint = &targetCoordinates[ 3 * landmarkIndex ];
+    double affineRow[ NUMBER_OF_AFFINE_TERMS ] = { 1.0, sourcePoint[ 0 ], sourcePoint[ 1 ], sourcePoint[ 2 ] };
+
+    for ( int i = 0; i < numberOfCenters; i++ )
+    {
+      for ( int j = i; j < numberOfCenters; j++ )
+      {
+        systemMatrix[ i ][ j ] += basisRow[ i ] * basisRow[ j ];
+      }
+      for ( int j = 0; j < NUMBER_OF_AFFINE_TERMS; j++ )
+      {
+        systemMatrix[ i ][ affineOffset + j ] += basisRow[ i ] * affineRow[ j ];
+      }
+      for ( int coordinate = 0; coordinate < 3; coordinate++ )
+      {
+        rightHandSides[ coordinate * systemSize + i ] += basisRow[ i ] * targetPoint[ coordinate ];
+      }
+    }
+    for ( int i = 0; i < NUMBER_OF_AFFINE_TERMS; i++ )
+    {
+      for ( int j = i; j < NUMBER_OF_AFFINE_TERMS; j++ )
+      {
+        systemMatrix[ affineOffset + i ][ affineOffset + j ] += affineRow[ i ] * affineRow[ j ];
+      }
+      for ( int coordinate = 0; coordinate < 3; coordinate++ )
+      {
+        rightHandSides[ coordinate * systemSize + affineOffset + i ] += affineRow[ i ] * targetPoint[ coordinate ];
+      }
+    }
+  }
+
+  for ( int i = 0; i < numberOfCenters; i++ )
+  {
+    const double* center = &centerCoordinates[ 3 * i ];
+    for ( int j = i; j < numberOfCenters; j++ )
+    {
+      double centerBasis = sqrt( vtkMath::Distance2BetweenPoints( center, &centerCoordinates[ 3 * j ] ) );
+      systemMatrix[ i ][ j ] -= this->Regularization * centerBasis;
+    }
+    double centerAffineRow[ NUMBER_OF_AFFINE_TERMS ] = { 1.0, center[ 0 ], center[ 1 ], center[ 2 ] };
+    for ( int j = 0; j < NUMBER_OF_AFFINE_TERMS; j++ )
+    {
+      systemMatrix[ i ][ constraintOffset + j ] = centerAffineRow[ j ];
+    }
+  }
+
+  // only the upper triangle has been filled so far
+  for ( int i = 0; i < systemSize; i++ )
+  {
+    for ( int j = 0; j < i; j++ )
+    {
+      systemMatrix[ i ][ j ] = systemMatrix[ j ][ i ];
+    }
+  }
+
+  std::vector< int > pivotIndices( systemSize );
+  if ( vtkMath::LUFactorLinearSystem( &systemMatrix[ 0 ], &pivotIndices[ 0 ], systemSize ) == 0 )
+  {
+    vtkWarningMacro( "Thin-plate spline system is singular, centers may be coplanar. Returning." );
+    return false;
+  }
+  for ( int coordinate = 0; coordinate < 3; coordinate++ )
+  {
+    vtkMath::LUSolveLinearSystem( &systemMatrix[ 0 ], &pivotIndices[ 0 ], &rightHandSides[ coordinate * systemSize ], systemSize );
+  }
+
+  // evaluate the spline at the centers
+  outputSourceLandmarks->SetNumberOfPoints( numberOfCenters );
+  outputTargetLandmarks->SetNumberOfPoints( numberOfCenters );
+  for ( int i = 0; i < numberOfCenters; i++ )
+  {
+    const double* center = &centerCoordinates[ 3 * i ];
+    double transformedCenter[ 3 ] = { 0.0, 0.0, 0.0 };
+    for ( int coordinate = 0; coordinate < 3; coordinate++ )
+    {
+      const double* solution = &rightHandSides[ coordinate * systemSize ];
+      double value = solution[ affineOffset ]
+        + solution[ affineOffset + 1 ] * center[ 0 ]
+        + solution[ affineOffset + 2 ] * center[ 1 ]
+        + solution[ affineOffset + 3 ] * center[ 2 ];
+      for ( int j = 0; j < numberOfCenters; j++ )
+      {
+        value += solution[ j ] * sqrt( vtkMath::Distance2BetweenPoints( center, &centerCoordinates[ 3 * j ] ) );
+      }
+      transformedCenter[ coordinate ] = value;
+    }
+    outputSourceLandmarks->SetPoint( i, center );
+    outputTargetLandmarks->SetPoint( i, transformedCenter );
+  }
+  outputSourceLandmarks->Modified();
+  outputTargetLandmarks->Modified();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// k-means clustering. Initial centers are chosen deterministically by farthest point
+// sampling, starting from the point closest to the centroid, so that repeated updates
+// with the same landmarks give the same result.
+void vtkThinPlateSplineApproximator::ComputeClusterCenters( const std::vector< double >& pointCoordinates, int numberOfCenters, std::vector< double >& centerCoordinates )
+{
+  int numberOfPoints = pointCoordinates.size() / 3;
+  centerCoordinates.assign( 3 * numberOfCenters, 0.0 );
+
+  double centroid[ 3 ] = { 0.0, 0.0, 0.0 };
+  for ( int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+  {
+    vtkMath::Add( centroid, &pointCoordinates[ 3 * pointIndex ], centroid );
+  }
+  vtkMath::MultiplyScalar( centroid, 1.0 / numberOfPoints );
+
+  std::vector< double > distance2ToClosestCenter( numberOfPoints, VTK_DOUBLE_MAX );
+  int nextCenterPointIndex = 0;
+  double minimumDistance2ToCentroid = VTK_DOUBLE_MAX;
+  for ( int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+  {
+    double distance2ToCentroid = vtkMath::Distance2BetweenPoints( &pointCoordinates[ 3 * pointIndex ], centroid );
+    if ( distance2ToCentroid < minimumDistance2ToCentroid )
+    {
+      minimumDistance2ToCentroid = distance2ToCentroid;
+      nextCenterPointIndex = pointIndex;
+    }
+  }
+  for ( int centerIndex = 0; centerIndex < numberOfCenters; centerIndex++ )
+  {
+    const double* centerPoint = &pointCoordinates[ 3 * nextCenterPointIndex ];
+    std::copy( centerPoint, centerPoint + 3, &centerCoordinates[ 3 * centerIndex ] );
+    double maximumDistance2 = -1.0;
+    for ( int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+    {
+      double distance2 = vtkMath::Distance2BetweenPoints( &pointCoordinates[ 3 * pointIndex ], centerPoint );
+      distance2ToClosestCenter[ pointIndex ] = vtkMath::Min( distance2ToClosestCenter[ pointIndex ], distance2 );
+      if ( distance2ToClosestCenter[ pointIndex ] > maximumDistance2 )
+      {
+        maximumDistance2 = distance2ToClosestCenter[ pointIndex ];
+        nextCenterPointIndex = pointIndex;
+      }
+    }
+  }
+
+  std::vector< int > clusterIndices( numberOfPoints, -1 );
+  std::vector< double > clusterSums( 3 * numberOfCenters );
+  std::vector< int > clusterSizes( numberOfCenters );
+  for ( int iteration = 0; iteration < MAXIMUM_NUMBER_OF_CLUSTERING_ITERATIONS; iteration++ )
+  {
+    bool assignmentChanged = false;
+    for ( int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+    {
+      int closestCenterIndex = 0;
+      double minimumDistance2 = VTK_DOUBLE_MAX;
+      for ( int centerIndex = 0; centerIndex < numberOfCenters; centerIndex++ )
+      {
+        double distance2 = vtkMath::Distance2BetweenPoints( &pointCoordinates[ 3 * pointIndex ], &centerCoordinates[ 3 * centerIndex ] );
+        if ( distance2 < minimumDistance2 )
+        {
+          minimumDistance2 = distance2;
+          closestCenterIndex = centerIndex;
+        }
+      }
+      if ( clusterIndices[ pointIndex ] != closestCenterIndex )
+      {
+        clusterIndices[ pointIndex ] = closestCenterIndex;
+        assignmentChanged = true;
+      }
+    }
+    if ( !assignmentChanged )
+    {
+      break;
+    }
+
+    std::fill( clusterSums.begin(), clusterSums.end(), 0.0 );
+    std::fill( clusterSizes.begin(), clusterSizes.end(), 0 );
+    for ( int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++ )
+    {
+      double* clusterSum = &clusterSums[ 3 * clusterIndices[ pointIndex ] ];
+      vtkMath::Add( clusterSum, &pointCoordinates[ 3 * pointIndex ], clusterSum );
+      clusterSizes[ clusterIndices[ pointIndex ] ]++;
+    }
+    for ( int centerIndex = 0; centerIndex < numberOfCenters; centerIndex++ )
+    {
+      if ( clusterSizes[ centerIndex ] == 0 )
+      {
+        // keep the previous center of an empty cluster
+        continue;
+      }
+      for ( int coordinate = 0; coordinate < 3; coordinate++ )
+      {
+        centerCoordinates[ 3 * centerIndex + coordinate ] = clusterSums[ 3 * centerIndex + coordinate ] / clusterSizes[ centerIndex ];
+      }
+    }
+  }
+}
@@ -0,0 +1,66 @@
+#ifndef __vtkThinPlateSplineApproximator_h
+#define __vtkThinPlateSplineApproximator_h
+
+#include <vtkObject.h>
+
+// std includes
+#include <vector>
+
+class vtkPoints;
+
+// export
+#include "vtkSlicerFiducialRegistrationWizardModuleLogicExport.h"
+
+// Fits a thin-plate spline (r basis, same as vtkThinPlateSplineTransform::SetBasisToR)
+// that approximates, rather than interpolates, a large set of landmarks.
+// The spline is defined on a smaller number of centers, found by k-means clustering
+// of the source landmarks, and its coefficients are computed by regularized least squares:
+//   minimize sum( |f(source_i) - target_i|^2 ) + Regularization * bending energy
+// This costs O(N*K^2 + K^3) instead of O(N^3), and evaluating the result costs O(K) per point.
+//
+// The fitted spline is returned as K source/target landmark pairs: an exact
+// vtkThinPlateSplineTransform through these pairs is identical to the fitted spline.
+class VTK_SLICER_FIDUCIALREGISTRATIONWIZARD_MODULE_LOGIC_EXPORT vtkThinPlateSplineApproximator : public vtkObject
+{
+  public:
+    vtkTypeMacro( vtkThinPlateSplineApproximator, vtkObject );
+    static vtkThinPlateSplineApproximator* New();
+
+    void PrintSelf( ostream &os, vtkIndent indent ) override;
+
+    // Input landmarks, must be the same length
+    void SetSourceLandmarks( vtkPoints* points );
+    void SetTargetLandmarks( vtkPoints* points );
+
+    // Number of spline centers. If it is not smaller than the number of landmarks
+    // then the landmarks themselves are used as centers.
+    vtkSetMacro( NumberOfCenters, int );
+    vtkGetMacro( NumberOfCenters, int );
+
+    // Weight of the bending energy relative to the squared distance error.
+    // 0 means least squares fit, larger values make the warping smoother (closer to affine).
+    vtkSetMacro( Regularization, double );
+    vtkGetMacro( Regularization, double );
+
+    // Fit the spline and store it in the output landmark lists (centers and their transformed positions).
+    // Returns false if the inputs are invalid or the system cannot be solved (e.g., coplanar centers).
+    bool ComputeApproximatingLandmarks( vtkPoints* outputSourceLandmarks, vtkPoints* outputTargetLandmarks );
+
+  protected:
+    vtkThinPlateSplineApproximator();
+    ~vtkThinPlateSplineApproximator();
+
+  private:
+    vtkPoints* SourceLandmarks;
+    vtkPoints* TargetLandmarks;
+    int NumberOfCenters;
+    double Regularization;
+
+    // centers are stored as x, y, z triplets
+    static void ComputeClusterCenters( const std::vector< double >& pointCoordinates, int numberOfCenters, std::vector< double >& centerCoordinates );
+
+    vtkThinPlateSplineApproximator(const vtkThinPlateSplineApproximator&); // Not implemented.
+    void operator=(const vtkThinPlateSplineApproximator&); // Not implemented.
+};
+
+#endif
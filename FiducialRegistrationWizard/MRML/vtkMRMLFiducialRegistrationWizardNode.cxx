@@ -66,7 +66,12 @@ vtkMRMLFiducialRegistrationWizardNode::vtkMRMLFiducialRegistrationWizardNode()
   this->RegistrationMode = REGISTRATION_MODE_RIGID;
   this->UpdateMode = UPDATE_MODE_AUTOMATIC;
   this->PointMatching = POINT_MATCHING_MANUAL;
+  this->PointMatchingTimeLimitSec = 5.0;
   this->WarpingTransformFromParent = true;
+  this->WarpingNumberOfControlPoints = 0;
+  this->WarpingRegularization = 0.0;
+  this->WarpingConvertToGridTransform = false;
+  this->WarpingGridSpacingMm = 5.0;
   this->CalibrationError = VTK_DOUBLE_MAX;
 }
 
@@ -82,9 +87,14 @@ void vtkMRMLFiducialRegistrationWizardNode::WriteXML( ostream& of, int nIndent )
 
   vtkIndent indent(nIndent); 
   of << indent << " PointMatching=\"" << PointMatchingAsString( this->PointMatching ) << "\"";
+  of << indent << " PointMatchingTimeLimitSec=\"" << this->PointMatchingTimeLimitSec << "\"";
   of << indent << " RegistrationMode=\"" << RegistrationModeAsString( this->RegistrationMode ) << "\"";
   of << indent << " UpdateMode=\"" << UpdateModeAsString( this->UpdateMode ) << "\"";
   of << indent << " WarpingTransformFromParent=\"" << (this->WarpingTransformFromParent ? "true" : "false") << "\"";
+  of << indent << " WarpingNumberOfControlPoints=\"" << this->WarpingNumberOfControlPoints << "\"";
+  of << indent << " WarpingRegularization=\"" << this->WarpingRegularization << "\"";
+  of << indent << " WarpingConvertToGridTransform=\"" << (this->WarpingConvertToGridTransform ? "true" : "false") << "\"";
+  of << indent << " WarpingGridSpacingMm=\"" << this->WarpingGridSpacingMm << "\"";
 }
 
 //------------------------------------------------------------------------------
@@ -104,6 +114,12 @@ void vtkMRMLFiducialRegistrationWizardNode::ReadXMLAttributes( const char** atts
     {
       this->PointMatching = PointMatchingFromString( std::string( attValue ) );
     }
+    else if ( ! strcmp( attName, "PointMatchingTimeLimitSec" ) )
+    {
+      std::stringstream ss;
+      ss << attValue;
+      ss >> this->PointMatchingTimeLimitSec;
+    }
     else if ( ! strcmp( attName, "RegistrationMode" ) )
     {
       this->RegistrationMode = RegistrationModeFromString( std::string( attValue ) );
@@ -116,6 +132,28 @@ void vtkMRMLFiducialRegistrationWizardNode::ReadXMLAttributes( const char** atts
     {
       this->WarpingTransformFromParent = (strcmp(attValue,"true") ? false : true);
     }
+    else if ( ! strcmp( attName, "WarpingNumberOfControlPoints" ) )
+    {
+      std::stringstream ss;
+      ss << attValue;
+      ss >> this->WarpingNumberOfControlPoints;
+    }
+    else if ( ! strcmp( attName, "WarpingRegularization" ) )
+    {
+      std::stringstream ss;
+      ss << attValue;
+      ss >> this->WarpingRegularization;
+    }
+    else if (!strcmp(attName, "WarpingConvertToGridTransform"))
+    {
+      this->WarpingConvertToGridTransform = (strcmp(attValue,"true") ? false : true);
+    }
+    else if ( ! strcmp( attName, "WarpingGridSpacingMm" ) )
+    {
+      std::stringstream ss;
+      ss << attValue;
+      ss >> this->WarpingGridSpacingMm;
+    }
   }
 
   this->Modified();
@@ -130,7 +168,12 @@ void vtkMRMLFiducialRegistrationWizardNode::Copy( vtkMRMLNode *anode )
   this->RegistrationMode = node->RegistrationMode;
   this->UpdateMode = node->UpdateMode;
   this->PointMatching = node->PointMatching;
+  this->PointMatchingTimeLimitSec = node->PointMatchingTimeLimitSec;
   this->WarpingTransformFromParent = node->WarpingTransformFromParent;
+  this->WarpingNumberOfControlPoints = node->WarpingNumberOfControlPoints;
+  this->WarpingRegularization = node->WarpingRegularization;
+  this->WarpingConvertToGridTransform = node->WarpingConvertToGridTransform;
+  this->WarpingGridSpacingMm = node->WarpingGridSpacingMm;
   this->Modified();
 }
 
@@ -139,9 +182,14 @@ void vtkMRMLFiducialRegistrationWizardNode::PrintSelf( ostream& os, vtkIndent in
 {
   vtkMRMLNode::PrintSelf(os,indent); // This will take care of referenced nodes
   os << indent << "PointMatching: " << PointMatchingAsString( this->PointMatching ) << "\n";
+  os << indent << "PointMatchingTimeLimitSec: " << this->PointMatchingTimeLimitSec << "\n";
   os << indent << "RegistrationMode: " << RegistrationModeAsString( this->RegistrationMode ) << "\n";
   os << indent << "UpdateMode: " << UpdateModeAsString( this->UpdateMode ) << "\n";
   os << indent << "WarpingTransformFromParent: " << (this->WarpingTransformFromParent ? "true" : "false") << "\n";
+  os << indent << "WarpingNumberOfControlPoints: " << this->WarpingNumberOfControlPoints << "\n";
+  os << indent << "WarpingRegularization: " << this->WarpingRegularization << "\n";
+  os << indent << "WarpingConvertToGridTransform: " << (this->WarpingConvertToGridTransform ? "true" : "false") << "\n";
+  os << indent << "WarpingGridSpacingMm: " << this->WarpingGridSpacingMm << "\n";
 }
 
 //------------------------------------------------------------------------------
@@ -397,6 +445,19 @@ int vtkMRMLFiducialRegistrationWizardNode::PointMatchingFromString( std::string
   return POINT_MATCHING_MANUAL;
 }
 
+//------------------------------------------------------------------------------
+void vtkMRMLFiducialRegistrationWizardNode::SetPointMatchingTimeLimitSec( double timeLimitSec )
+{
+  if ( this->GetPointMatchingTimeLimitSec() == timeLimitSec )
+  {
+    // no change
+    return;
+  }
+  this->PointMatchingTimeLimitSec = timeLimitSec;
+  this->Modified();
+  this->InvokeCustomModifiedEvent(InputDataModifiedEvent);
+}
+
 //------------------------------------------------------------------------------
 void vtkMRMLFiducialRegistrationWizardNode::AddToCalibrationStatusMessage( std::string text )
 {
@@ -431,14 +492,23 @@ void vtkMRMLFiducialRegistrationWizardNode::ProcessMRMLEvents( vtkObject *caller
     if ( event == vtkMRMLMarkupsNode::PointModifiedEvent ||
          event == vtkMRMLMarkupsNode::PointAddedEvent ||
          event == vtkMRMLMarkupsNode::PointRemovedEvent )
+    {
+      // the markups node passes the index of the point as call data
+      InputPointEventData eventData;
+      eventData.FromList = ( callerNode == this->GetFromFiducialListNode() );
+      eventData.MarkupsEvent = event;
+      eventData.PointIndex = ( callData != NULL ? *( static_cast< int* >( callData ) ) : -1 );
+      this->InvokeEvent( InputPointModifiedEvent, &eventData );
+      this->InvokeCustomModifiedEvent( InputDataModifiedEvent );
+    }
 #else
     if ( event == vtkMRMLMarkupsNode::PointModifiedEvent ||
          event == vtkMRMLMarkupsNode::MarkupAddedEvent ||
          event == vtkMRMLMarkupsNode::MarkupRemovedEvent )
-#endif
     {
       this->InvokeCustomModifiedEvent( InputDataModifiedEvent );
     }
+#endif
   }
 }
 
@@ -454,3 +524,55 @@ void vtkMRMLFiducialRegistrationWizardNode::SetWarpingTransformFromParent(bool w
   this->Modified();
   this->InvokeCustomModifiedEvent(InputDataModifiedEvent);
 }
+
+//------------------------------------------------------------------------------
+void vtkMRMLFiducialRegistrationWizardNode::SetWarpingNumberOfControlPoints( int numberOfControlPoints )
+{
+  if ( this->GetWarpingNumberOfControlPoints() == numberOfControlPoints )
+  {
+    // no change
+    return;
+  }
+  this->WarpingNumberOfControlPoints = numberOfControlPoints;
+  this->Modified();
+  this->InvokeCustomModifiedEvent(InputDataModifiedEvent);
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLFiducialRegistrationWizardNode::SetWarpingRegularization( double regularization )
+{
+  if ( this->GetWarpingRegularization() == regularization )
+  {
+    // no change
+    return;
+  }
+  this->WarpingRegularization = regularization;
+  this->Modified();
+  this->InvokeCustomModifiedEvent(InputDataModifiedEvent);
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLFiducialRegistrationWizardNode::SetWarpingConvertToGridTransform( bool convertToGridTransform )
+{
+  if ( this->GetWarpingConvertToGridTransform() == convertToGridTransform )
+  {
+    // no change
+    return;
+  }
+  this->WarpingConvertToGridTransform = convertToGridTransform;
+  this->Modified();
+  this->InvokeCustomModifiedEvent(InputDataModifiedEvent);
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLFiducialRegistrationWizardNode::SetWarpingGridSpacingMm( double spacingMm )
+{
+  if ( this->GetWarpingGridSpacingMm() == spacingMm )
+  {
+    // no change
+    return;
+  }
+  this->WarpingGridSpacingMm = spacingMm;
+  this->Modified();
+  this->InvokeCustomModifiedEvent(InputDataModifiedEvent);
+}
@@ -52,7 +52,17 @@ public:
     /// InputDataModifiedEvent is only invoked when input parameters are changed.
     /// In contrast, ModifiedEvent event is called if either an input or output parameter is changed.
     // vtkCommand::UserEvent + 555 is just a random value that is very unlikely to be used for anything else in this class
-    InputDataModifiedEvent = vtkCommand::UserEvent + 555
+    InputDataModifiedEvent = vtkCommand::UserEvent + 555,
+    /// Invoked when a single point of the 'From' or 'To' fiducial list is added, removed, or modified,
+    /// before InputDataModifiedEvent. Call data is a pointer to an InputPointEventData.
+    InputPointModifiedEvent
+  };
+
+  struct InputPointEventData
+  {
+    bool FromList; // true if the point is in the 'From' list, false if in the 'To' list
+    unsigned long MarkupsEvent; // PointAddedEvent, PointRemovedEvent, or PointModifiedEvent of the markups node
+    int PointIndex; // -1 if the markups node did not specify the point
   };
 
   enum
@@ -139,6 +149,12 @@ public:
   static std::string PointMatchingAsString( int );
   static int PointMatchingFromString( std::string );
 
+  /// Get/Set the time limit (in seconds) for automatic point matching.
+  /// If the limit is reached then the best matching found so far is used.
+  /// Non-positive value means there is no time limit.
+  vtkGetMacro( PointMatchingTimeLimitSec, double );
+  void SetPointMatchingTimeLimitSec( double );
+
   vtkSetMacro( CalibrationStatusMessage, std::string );
   vtkGetMacro( CalibrationStatusMessage, std::string );
   void AddToCalibrationStatusMessage( std::string text );
@@ -156,6 +172,30 @@ public:
   vtkGetMacro(WarpingTransformFromParent, bool);
   vtkBooleanMacro(WarpingTransformFromParent, bool);
 
+  /// Get/Set number of control points of the warping transform.
+  /// If it is 0 (default) or not less than the number of fiducials then every fiducial is a control point.
+  /// Otherwise the control points are found by clustering the fiducials and the warping approximates
+  /// the fiducials, which makes computing and applying the transform much faster for large fiducial lists.
+  vtkGetMacro( WarpingNumberOfControlPoints, int );
+  void SetWarpingNumberOfControlPoints( int );
+
+  /// Get/Set smoothness of the warping transform. 0 (default) means the transform is fitted as closely
+  /// as possible to the fiducials, larger values make the warping smoother (closer to an affine transform).
+  vtkGetMacro( WarpingRegularization, double );
+  void SetWarpingRegularization( double );
+
+  /// Get/Set if the warping transform is converted to a grid transform.
+  /// Applying a grid transform takes the same time regardless of the number of control points,
+  /// which makes resampling of volumes faster. The grid covers the fiducials with some margin.
+  /// \sa WarpingGridSpacingMm
+  void SetWarpingConvertToGridTransform( bool );
+  vtkGetMacro( WarpingConvertToGridTransform, bool );
+  vtkBooleanMacro( WarpingConvertToGridTransform, bool );
+
+  /// Get/Set spacing of the grid transform, used if WarpingConvertToGridTransform is enabled.
+  vtkGetMacro( WarpingGridSpacingMm, double );
+  void SetWarpingGridSpacingMm( double );
+
   void ProcessMRMLEvents( vtkObject *caller, unsigned long event, void *callData ) override;
 
 private:
@@ -181,10 +221,21 @@ private:
   //   is being performed (similarity and warping are not yet supported).
   int PointMatching;
 
+  // Automatic point matching is stopped after this time, to keep the application responsive
+  // for large point sets.
+  double PointMatchingTimeLimitSec;
+
   /// If true then transformation speedi is optimized for images, otherwise
   /// transformation speed is optimized for models and markups.
   bool WarpingTransformFromParent;
 
+  // Reduced number of control points and regularization for approximating warping transform
+  // of large fiducial lists. Optionally the result is stored as a grid transform.
+  int WarpingNumberOfControlPoints;
+  double WarpingRegularization;
+  bool WarpingConvertToGridTransform;
+  double WarpingGridSpacingMm;
+
   // The Calibration status message reports the RMS error,
   // as well as any warnings about how the registration
   // was set up.
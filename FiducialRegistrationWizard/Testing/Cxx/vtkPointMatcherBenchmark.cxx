@@ -0,0 +1,425 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+==============================================================================*/
+
+// Benchmark and regression test for automatic point matching.
+//
+// Synthetic fiducial layouts (random and near-symmetric) are transformed by a random
+// rigid transform, then noise, outliers, and missing points are added. The matcher output
+// is compared to the known correspondences. Success rate, ambiguity rate, and wall time
+// percentiles of each scenario are reported as JSON.
+//
+// Usage: vtkPointMatcherBenchmark [output JSON file] [number of trials per scenario] [full]
+// Without arguments a short run (a few point set sizes, one trial each) is done, which is fast enough
+// to be run as a regular test, and the JSON report is printed to the standard output.
+// If "full" is specified then all point set sizes (up to 200 points) are tested.
+// The test fails if the success rate on random layouts drops below MINIMUM_SUCCESS_RATE.
+
+// SlicerIGT includes
+#include <vtkPointMatcher.h>
+
+// VTK includes
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkTimerLog.h>
+#include <vtkTransform.h>
+
+// STD includes
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+int DEFAULT_NUMBER_OF_TRIALS_PER_SCENARIO = 1;
+const int QUICK_NUMBERS_OF_POINTS[] = { 4, 6, 10, 20 };
+const int FULL_NUMBERS_OF_POINTS[] = { 3, 4, 5, 6, 8, 10, 15, 20, 50, 100, 200 };
+double MINIMUM_SUCCESS_RATE = 0.9; // on random layouts, over all scenarios
+double LAYOUT_SIZE_MM = 200.0;
+double NOISE_STANDARD_DEVIATION_MM = 0.5;
+double NEAR_SYMMETRIC_PERTURBATION_MM = 3.0;
+double MATCHING_TIME_LIMIT_SEC = 10.0;
+double POINT_IDENTITY_TOLERANCE_MM = 1.0e-3;
+unsigned int RANDOM_SEED = 12345;
+
+enum LayoutType
+{
+  LAYOUT_RANDOM = 0,
+  LAYOUT_NEAR_SYMMETRIC,
+  LAYOUT_LAST
+};
+
+enum PerturbationType
+{
+  PERTURBATION_NONE = 0,
+  PERTURBATION_NOISE,
+  PERTURBATION_OUTLIERS,
+  PERTURBATION_MISSING,
+  PERTURBATION_LAST
+};
+
+//----------------------------------------------------------------------------
+std::string LayoutTypeAsString(int layoutType)
+{
+  switch (layoutType)
+  {
+    case LAYOUT_RANDOM: return "random";
+    case LAYOUT_NEAR_SYMMETRIC: return "nearSymmetric";
+    default: return "unknown";
+  }
+}
+
+//----------------------------------------------------------------------------
+std::string PerturbationTypeAsString(int perturbationType)
+{
+  switch (perturbationType)
+  {
+    case PERTURBATION_NONE: return "none";
+    case PERTURBATION_NOISE: return "noise";
+    case PERTURBATION_OUTLIERS: return "outliers";
+    case PERTURBATION_MISSING: return "missing";
+    default: return "unknown";
+  }
+}
+
+//----------------------------------------------------------------------------
+struct ScenarioResult
+{
+  int LayoutType;
+  int PerturbationType;
+  int NumberOfPoints;
+  int NumberOfTrials;
+  int NumberOfSuccesses;
+  int NumberOfAmbiguousResults;
+  int NumberOfTimeLimitsReached;
+  std::vector<double> WallTimesSec;
+};
+
+//----------------------------------------------------------------------------
+void GenerateLayout(int layoutType, int numberOfPoints, std::mt19937& randomGenerator, std::vector<double>& pointCoordinates)
+{
+  std::uniform_real_distribution<double> uniformDistribution(-0.5 * LAYOUT_SIZE_MM, 0.5 * LAYOUT_SIZE_MM);
+  std::uniform_real_distribution<double> perturbationDistribution(-NEAR_SYMMETRIC_PERTURBATION_MM, NEAR_SYMMETRIC_PERTURBATION_MM);
+  pointCoordinates.resize(3 * numberOfPoints);
+  for (int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
+  {
+    double* point = &pointCoordinates[3 * pointIndex];
+    if (layoutType == LAYOUT_RANDOM)
+    {
+      for (int i = 0; i < 3; i++)
+      {
+        point[i] = uniformDistribution(randomGenerator);
+      }
+    }
+    else
+    {
+      // points on a helix around a cylinder, nearly invariant to rotation around its axis
+      double angle = 2.0 * vtkMath::Pi() * pointIndex / std::min(numberOfPoints, 8);
+      point[0] = 0.5 * LAYOUT_SIZE_MM * cos(angle) + perturbationDistribution(randomGenerator);
+      point[1] = 0.5 * LAYOUT_SIZE_MM * sin(angle) + perturbationDistribution(randomGenerator);
+      point[2] = LAYOUT_SIZE_MM * (pointIndex / 8) / std::max(1, numberOfPoints / 8) + perturbationDistribution(randomGenerator);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void GenerateRandomRigidTransform(std::mt19937& randomGenerator, vtkTransform* transform)
+{
+  std::uniform_real_distribution<double> angleDistribution(-180.0, 180.0);
+  std::uniform_real_distribution<double> axisDistribution(-1.0, 1.0);
+  std::uniform_real_distribution<double> translationDistribution(-LAYOUT_SIZE_MM, LAYOUT_SIZE_MM);
+  double axis[3] = { axisDistribution(randomGenerator), axisDistribution(randomGenerator), axisDistribution(randomGenerator) };
+  if (vtkMath::Normalize(axis) == 0.0)
+  {
+    axis[2] = 1.0;
+  }
+  transform->Identity();
+  transform->Translate(translationDistribution(randomGenerator), translationDistribution(randomGenerator), translationDistribution(randomGenerator));
+  transform->RotateWXYZ(angleDistribution(randomGenerator), axis);
+}
+
+//----------------------------------------------------------------------------
+// Matcher outputs are copies of the input points, but they may be stored in float precision
+int FindPointIndex(const std::vector<double>& pointCoordinates, const double point[3])
+{
+  for (unsigned int pointIndex = 0; 3 * pointIndex < pointCoordinates.size(); pointIndex++)
+  {
+    if (vtkMath::Distance2BetweenPoints(point, &pointCoordinates[3 * pointIndex]) < POINT_IDENTITY_TOLERANCE_MM * POINT_IDENTITY_TOLERANCE_MM)
+    {
+      return pointIndex;
+    }
+  }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+bool RunTrial(int layoutType, int perturbationType, int numberOfPoints, unsigned int maximumDifferenceInNumberOfPoints,
+  std::mt19937& randomGenerator, ScenarioResult& result)
+{
+  std::vector<double> sourceCoordinates;
+  GenerateLayout(layoutType, numberOfPoints, randomGenerator, sourceCoordinates);
+
+  vtkNew<vtkTransform> sourceToTargetTransform;
+  GenerateRandomRigidTransform(randomGenerator, sourceToTargetTransform.GetPointer());
+  std::normal_distribution<double> noiseDistribution(0.0, NOISE_STANDARD_DEVIATION_MM);
+  std::vector<double> targetCoordinates;
+  std::vector<int> targetToSourceIndices;
+  for (int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
+  {
+    double targetPoint[3] = { 0.0, 0.0, 0.0 };
+    sourceToTargetTransform->TransformPoint(&sourceCoordinates[3 * pointIndex], targetPoint);
+    if (perturbationType != PERTURBATION_NONE)
+    {
+      // noise is added in all perturbed scenarios
+      for (int i = 0; i < 3; i++)
+      {
+        targetPoint[i] += noiseDistribution(randomGenerator);
+      }
+    }
+    targetCoordinates.insert(targetCoordinates.end(), targetPoint, targetPoint + 3);
+    targetToSourceIndices.push_back(pointIndex);
+  }
+
+  if (perturbationType == PERTURBATION_OUTLIERS)
+  {
+    // extra source points that have no pair
+    std::uniform_real_distribution<double> uniformDistribution(-0.5 * LAYOUT_SIZE_MM, 0.5 * LAYOUT_SIZE_MM);
+    for (unsigned int outlierIndex = 0; outlierIndex < maximumDifferenceInNumberOfPoints; outlierIndex++)
+    {
+      for (int i = 0; i < 3; i++)
+      {
+        sourceCoordinates.push_back(uniformDistribution(randomGenerator));
+      }
+    }
+  }
+  else if (perturbationType == PERTURBATION_MISSING)
+  {
+    // target points that were not collected
+    for (unsigned int missingIndex = 0; missingIndex < maximumDifferenceInNumberOfPoints; missingIndex++)
+    {
+      std::uniform_int_distribution<int> indexDistribution(0, static_cast<int>(targetToSourceIndices.size()) - 1);
+      int removedIndex = indexDistribution(randomGenerator);
+      targetCoordinates.erase(targetCoordinates.begin() + 3 * removedIndex, targetCoordinates.begin() + 3 * removedIndex + 3);
+      targetToSourceIndices.erase(targetToSourceIndices.begin() + removedIndex);
+    }
+  }
+
+  // shuffle the target points, the input order must not matter
+  std::vector<int> targetOrder(targetToSourceIndices.size());
+  for (unsigned int i = 0; i < targetOrder.size(); i++)
+  {
+    targetOrder[i] = i;
+  }
+  std::shuffle(targetOrder.begin(), targetOrder.end(), randomGenerator);
+  std::vector<double> shuffledTargetCoordinates;
+  std::vector<int> shuffledTargetToSourceIndices;
+  for (unsigned int i = 0; i < targetOrder.size(); i++)
+  {
+    const double* targetPoint = &targetCoordinates[3 * targetOrder[i]];
+    shuffledTargetCoordinates.insert(shuffledTargetCoordinates.end(), targetPoint, targetPoint + 3);
+    shuffledTargetToSourceIndices.push_back(targetToSourceIndices[targetOrder[i]]);
+  }
+
+  vtkNew<vtkPoints> sourcePoints;
+  sourcePoints->SetDataTypeToDouble();
+  for (unsigned int pointIndex = 0; 3 * pointIndex < sourceCoordinates.size(); pointIndex++)
+  {
+    sourcePoints->InsertNextPoint(&sourceCoordinates[3 * pointIndex]);
+  }
+  vtkNew<vtkPoints> targetPoints;
+  targetPoints->SetDataTypeToDouble();
+  for (unsigned int pointIndex = 0; 3 * pointIndex < shuffledTargetCoordinates.size(); pointIndex++)
+  {
+    targetPoints->InsertNextPoint(&shuffledTargetCoordinates[3 * pointIndex]);
+  }
+
+  vtkNew<vtkPointMatcher> pointMatcher;
+  pointMatcher->SetInputSourcePoints(sourcePoints.GetPointer());
+  pointMatcher->SetInputTargetPoints(targetPoints.GetPointer());
+  pointMatcher->SetMaximumDifferenceInNumberOfPoints(maximumDifferenceInNumberOfPoints);
+  pointMatcher->SetMaximumComputationTimeSec(MATCHING_TIME_LIMIT_SEC);
+  double startTimeSec = vtkTimerLog::GetUniversalTime();
+  pointMatcher->Update();
+  result.WallTimesSec.push_back(vtkTimerLog::GetUniversalTime() - startTimeSec);
+
+  // all output pairs must be true correspondences, and at most the allowed number of true pairs may be left out
+  vtkPoints* outputSourcePoints = pointMatcher->GetOutputSourcePoints();
+  vtkPoints* outputTargetPoints = pointMatcher->GetOutputTargetPoints();
+  int numberOfTruePairs = static_cast<int>(shuffledTargetToSourceIndices.size());
+  int numberOfOutputPairs = outputSourcePoints->GetNumberOfPoints();
+  bool success = (numberOfOutputPairs >= 3 && numberOfOutputPairs >= numberOfTruePairs - static_cast<int>(maximumDifferenceInNumberOfPoints));
+  for (int pairIndex = 0; success && pairIndex < numberOfOutputPairs; pairIndex++)
+  {
+    int sourceIndex = FindPointIndex(sourceCoordinates, outputSourcePoints->GetPoint(pairIndex));
+    int targetIndex = FindPointIndex(shuffledTargetCoordinates, outputTargetPoints->GetPoint(pairIndex));
+    if (sourceIndex < 0 || targetIndex < 0 || shuffledTargetToSourceIndices[targetIndex] != sourceIndex)
+    {
+      success = false;
+    }
+  }
+
+  result.NumberOfTrials++;
+  if (success)
+  {
+    result.NumberOfSuccesses++;
+  }
+  if (pointMatcher->IsMatchingAmbiguous())
+  {
+    result.NumberOfAmbiguousResults++;
+  }
+  if (pointMatcher->IsComputationTimeLimitReached())
+  {
+    result.NumberOfTimeLimitsReached++;
+  }
+  return success;
+}
+
+//----------------------------------------------------------------------------
+double GetPercentile(std::vector<double> values, double percentile)
+{
+  if (values.empty())
+  {
+    return 0.0;
+  }
+  std::sort(values.begin(), values.end());
+  int index = static_cast<int>(ceil(percentile / 100.0 * values.size())) - 1;
+  return values[std::max(0, std::min(index, static_cast<int>(values.size()) - 1))];
+}
+
+//----------------------------------------------------------------------------
+void WriteResultsAsJson(const std::vector<ScenarioResult>& results, std::ostream& os)
+{
+  os << "{" << std::endl;
+  os << "  \"scenarios\": [" << std::endl;
+  for (unsigned int resultIndex = 0; resultIndex < results.size(); resultIndex++)
+  {
+    const ScenarioResult& result = results[resultIndex];
+    double numberOfTrials = std::max(1, result.NumberOfTrials);
+    os << "    {"
+      << " \"layout\": \"" << LayoutTypeAsString(result.LayoutType) << "\","
+      << " \"perturbation\": \"" << PerturbationTypeAsString(result.PerturbationType) << "\","
+      << " \"numberOfPoints\": " << result.NumberOfPoints << ","
+      << " \"trials\": " << result.NumberOfTrials << ","
+      << " \"successRate\": " << result.NumberOfSuccesses / numberOfTrials << ","
+      << " \"ambiguityRate\": " << result.NumberOfAmbiguousResults / numberOfTrials << ","
+      << " \"timeLimitReachedRate\": " << result.NumberOfTimeLimitsReached / numberOfTrials << ","
+      << " \"wallTimeSec\": {"
+      << " \"p50\": " << GetPercentile(result.WallTimesSec, 50.0) << ","
+      << " \"p90\": " << GetPercentile(result.WallTimesSec, 90.0) << ","
+      << " \"p99\": " << GetPercentile(result.WallTimesSec, 99.0) << ","
+      << " \"max\": " << GetPercentile(result.WallTimesSec, 100.0) << " } }"
+      << (resultIndex + 1 < results.size() ? "," : "") << std::endl;
+  }
+  os << "  ]" << std::endl;
+  os << "}" << std::endl;
+}
+
+//----------------------------------------------------------------------------
+int vtkPointMatcherBenchmark(int argc, char* argv[])
+{
+  std::string outputFileName;
+  if (argc > 1)
+  {
+    outputFileName = argv[1];
+  }
+  int numberOfTrialsPerScenario = DEFAULT_NUMBER_OF_TRIALS_PER_SCENARIO;
+  if (argc > 2)
+  {
+    numberOfTrialsPerScenario = std::max(1, atoi(argv[2]));
+  }
+  bool fullSweep = (argc > 3 && std::string(argv[3]) == "full");
+
+  std::vector<int> numbersOfPoints;
+  if (fullSweep)
+  {
+    numbersOfPoints.assign(FULL_NUMBERS_OF_POINTS, FULL_NUMBERS_OF_POINTS + sizeof(FULL_NUMBERS_OF_POINTS) / sizeof(FULL_NUMBERS_OF_POINTS[0]));
+  }
+  else
+  {
+    numbersOfPoints.assign(QUICK_NUMBERS_OF_POINTS, QUICK_NUMBERS_OF_POINTS + sizeof(QUICK_NUMBERS_OF_POINTS) / sizeof(QUICK_NUMBERS_OF_POINTS[0]));
+  }
+  const int numberOfSizes = static_cast<int>(numbersOfPoints.size());
+  vtkNew<vtkPointMatcher> defaultPointMatcher;
+  unsigned int maximumDifferenceInNumberOfPoints = defaultPointMatcher->GetMaximumDifferenceInNumberOfPoints();
+
+  std::mt19937 randomGenerator(RANDOM_SEED);
+  std::vector<ScenarioResult> results;
+  int numberOfRandomLayoutTrials = 0;
+  int numberOfRandomLayoutSuccesses = 0;
+  for (int layoutType = 0; layoutType < LAYOUT_LAST; layoutType++)
+  {
+    for (int perturbationType = 0; perturbationType < PERTURBATION_LAST; perturbationType++)
+    {
+      for (int sizeIndex = 0; sizeIndex < numberOfSizes; sizeIndex++)
+      {
+        int numberOfPoints = numbersOfPoints[sizeIndex];
+        if (perturbationType == PERTURBATION_MISSING && numberOfPoints - static_cast<int>(maximumDifferenceInNumberOfPoints) < 3)
+        {
+          // too few points would remain for matching
+          continue;
+        }
+        ScenarioResult result;
+        result.LayoutType = layoutType;
+        result.PerturbationType = perturbationType;
+        result.NumberOfPoints = numberOfPoints;
+        result.NumberOfTrials = 0;
+        result.NumberOfSuccesses = 0;
+        result.NumberOfAmbiguousResults = 0;
+        result.NumberOfTimeLimitsReached = 0;
+        for (int trialIndex = 0; trialIndex < numberOfTrialsPerScenario; trialIndex++)
+        {
+          RunTrial(layoutType, perturbationType, numberOfPoints, maximumDifferenceInNumberOfPoints, randomGenerator, result);
+        }
+        if (layoutType == LAYOUT_RANDOM)
+        {
+          numberOfRandomLayoutTrials += result.NumberOfTrials;
+          numberOfRandomLayoutSuccesses += result.NumberOfSuccesses;
+        }
+        results.push_back(result);
+      }
+    }
+  }
+
+  if (outputFileName.empty())
+  {
+    WriteResultsAsJson(results, std::cout);
+  }
+  else
+  {
+    std::ofstream outputFile(outputFileName.c_str());
+    if (!outputFile)
+    {
+      std::cerr << "Could not write benchmark results to " << outputFileName << std::endl;
+      return EXIT_FAILURE;
+    }
+    WriteResultsAsJson(results, outputFile);
+    std::cout << "Benchmark results written to " << outputFileName << std::endl;
+  }
+
+  double randomLayoutSuccessRate = static_cast<double>(numberOfRandomLayoutSuccesses) / std::max(1, numberOfRandomLayoutTrials);
+  if (randomLayoutSuccessRate < MINIMUM_SUCCESS_RATE)
+  {
+    std::cerr << "Point matching success rate on random layouts is too low: " << randomLayoutSuccessRate
+      << " (expected at least " << MINIMUM_SUCCESS_RATE << ")" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Point matching success rate on random layouts: " << randomLayoutSuccessRate << std::endl;
+  return EXIT_SUCCESS;
+}
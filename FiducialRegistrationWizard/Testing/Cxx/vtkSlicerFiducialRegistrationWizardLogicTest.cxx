@@ -0,0 +1,130 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+==============================================================================*/
+
+// Test of the incremental rigid registration of the fiducial registration wizard logic.
+//
+// With manual point matching and automatic update, the point pairs are updated from the point events
+// of the fiducial lists. Removing the point with the same index from both lists must keep the point pairs
+// in sync, so that the registration is not recomputed from all points, and the result must still be correct.
+
+#include "vtkSlicerVersionConfigure.h" // For Slicer_VERSION_MAJOR,Slicer_VERSION_MINOR
+
+// FiducialRegistrationWizard includes
+#include <vtkMRMLFiducialRegistrationWizardNode.h>
+#include <vtkSlicerFiducialRegistrationWizardLogic.h>
+
+// MRML includes
+#include <vtkMRMLLinearTransformNode.h>
+#include <vtkMRMLMarkupsFiducialNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkTransform.h>
+#include <vtkVector.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+const int NUMBER_OF_POINTS = 6;
+const int REMOVED_POINT_INDEX = 2;
+double FROM_POINTS[NUMBER_OF_POINTS][3] = {
+  { 0.0, 0.0, 0.0 }, { 50.0, 0.0, 0.0 }, { 0.0, 40.0, 0.0 }, { 0.0, 0.0, 30.0 }, { 25.0, 35.0, 10.0 }, { -20.0, 15.0, 45.0 } };
+double MAXIMUM_CALIBRATION_ERROR_MM = 1.0e-6;
+double MAXIMUM_MATRIX_ELEMENT_ERROR = 1.0e-6;
+
+//----------------------------------------------------------------------------
+int vtkSlicerFiducialRegistrationWizardLogicTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+#if Slicer_VERSION_MAJOR >= 5 || (Slicer_VERSION_MAJOR >= 4 && Slicer_VERSION_MINOR >= 11)
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkSlicerFiducialRegistrationWizardLogic> logic;
+  logic->SetMRMLScene(scene.GetPointer());
+
+  vtkNew<vtkTransform> fromToTransform;
+  fromToTransform->Translate(10.0, -5.0, 20.0);
+  fromToTransform->RotateZ(30.0);
+  fromToTransform->RotateX(10.0);
+
+  vtkNew<vtkMRMLMarkupsFiducialNode> fromFiducialNode;
+  scene->AddNode(fromFiducialNode.GetPointer());
+  vtkNew<vtkMRMLMarkupsFiducialNode> toFiducialNode;
+  scene->AddNode(toFiducialNode.GetPointer());
+  for (int i = 0; i < NUMBER_OF_POINTS; i++)
+  {
+    double toPoint[3] = { 0.0, 0.0, 0.0 };
+    fromToTransform->TransformPoint(FROM_POINTS[i], toPoint);
+    fromFiducialNode->AddControlPoint(vtkVector3d(FROM_POINTS[i][0], FROM_POINTS[i][1], FROM_POINTS[i][2]));
+    toFiducialNode->AddControlPoint(vtkVector3d(toPoint[0], toPoint[1], toPoint[2]));
+  }
+  vtkNew<vtkMRMLLinearTransformNode> outputTransformNode;
+  scene->AddNode(outputTransformNode.GetPointer());
+
+  vtkNew<vtkMRMLFiducialRegistrationWizardNode> registrationNode;
+  scene->AddNode(registrationNode.GetPointer());
+  registrationNode->SetRegistrationModeToRigid();
+  registrationNode->SetPointMatchingToInputOrder();
+  registrationNode->SetUpdateModeToAuto();
+  registrationNode->SetOutputTransformNodeId(outputTransformNode->GetID());
+  registrationNode->SetAndObserveFromFiducialListNodeId(fromFiducialNode->GetID());
+  registrationNode->SetAndObserveToFiducialListNodeId(toFiducialNode->GetID());
+  if (!logic->IsIncrementalRegistrationInSync(registrationNode.GetPointer()))
+  {
+    std::cerr << "Point pairs are not followed by the point events after the initial registration" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // The pairs after the removed point are shifted until the point is removed from the other list too
+  fromFiducialNode->RemoveNthControlPoint(REMOVED_POINT_INDEX);
+  if (logic->IsIncrementalRegistrationInSync(registrationNode.GetPointer()))
+  {
+    std::cerr << "Point pairs are reported in sync while a point is only removed from the 'From' list" << std::endl;
+    return EXIT_FAILURE;
+  }
+  toFiducialNode->RemoveNthControlPoint(REMOVED_POINT_INDEX);
+  if (!logic->IsIncrementalRegistrationInSync(registrationNode.GetPointer()))
+  {
+    std::cerr << "Point pairs are not in sync after the point with the same index is removed from both lists" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (registrationNode->GetCalibrationError() > MAXIMUM_CALIBRATION_ERROR_MM)
+  {
+    std::cerr << "Calibration error after the removal is " << registrationNode->GetCalibrationError()
+      << ", expected at most " << MAXIMUM_CALIBRATION_ERROR_MM << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtkNew<vtkMatrix4x4> computedMatrix;
+  outputTransformNode->GetMatrixTransformToParent(computedMatrix.GetPointer());
+  for (int row = 0; row < 4; row++)
+  {
+    for (int column = 0; column < 4; column++)
+    {
+      double expected = fromToTransform->GetMatrix()->GetElement(row, column);
+      if (std::fabs(computedMatrix->GetElement(row, column) - expected) > MAXIMUM_MATRIX_ELEMENT_ERROR)
+      {
+        std::cerr << "Registration matrix element (" << row << ", " << column << ") is "
+          << computedMatrix->GetElement(row, column) << ", expected " << expected << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+#endif
+  return EXIT_SUCCESS;
+}
@@ -237,6 +237,7 @@ void qSlicerFiducialRegistrationWizardModuleWidget::setup()
 
   // Make connections to update the mrml from the widget
   connect( d->PointMatchingComboBox, SIGNAL( currentIndexChanged(int)), this, SLOT(updateMRMLFromGUI()) );
+  connect( d->PointMatchingTimeLimitSpinBox, SIGNAL( valueChanged(double)), this, SLOT(updateMRMLFromGUI()) );
   connect( d->ProbeTransformFromComboBox, SIGNAL(currentNodeChanged(vtkMRMLNode*)), this, SLOT(updateMRMLFromGUI()) );
   connect( d->ProbeTransformToComboBox, SIGNAL(currentNodeChanged(vtkMRMLNode*)), this, SLOT(updateMRMLFromGUI()) );
   connect( d->OutputTransformComboBox, SIGNAL(currentNodeChanged(vtkMRMLNode*)), this, SLOT(updateMRMLFromGUI()) );
@@ -308,6 +309,7 @@ void qSlicerFiducialRegistrationWizardModuleWidget::updateMRMLFromGUI()
   std::string pointMatchingAsString = d->PointMatchingComboBox->currentText().toStdString();
   int pointMatchingAsEnum = vtkMRMLFiducialRegistrationWizardNode::PointMatchingFromString( pointMatchingAsString );
   fiducialRegistrationWizardNode->SetPointMatching( pointMatchingAsEnum );
+  fiducialRegistrationWizardNode->SetPointMatchingTimeLimitSec( d->PointMatchingTimeLimitSpinBox->value() );
 
   fiducialRegistrationWizardNode->SetProbeTransformFromNodeId(d->ProbeTransformFromComboBox->currentNode()?d->ProbeTransformFromComboBox->currentNode()->GetID():NULL);
   fiducialRegistrationWizardNode->SetProbeTransformToNodeId(d->ProbeTransformToComboBox->currentNode()?d->ProbeTransformToComboBox->currentNode()->GetID():NULL);
@@ -349,6 +351,7 @@ void qSlicerFiducialRegistrationWizardModuleWidget::updateGUIFromMRML()
   if ( fiducialRegistrationWizardNode == NULL )
   {
     d->PointMatchingComboBox->setEnabled(false);
+    d->PointMatchingTimeLimitSpinBox->setEnabled(false);
     d->ProbeTransformFromComboBox->setEnabled(false);
     d->ProbeTransformToComboBox->setEnabled(false);
     d->RecordFromButton->setEnabled(false);
@@ -366,6 +369,7 @@ void qSlicerFiducialRegistrationWizardModuleWidget::updateGUIFromMRML()
 
   // Disconnect to prevent signals form triggering events
   bool wasPointMatchingComboBoxBlocked = d->PointMatchingComboBox->blockSignals(true);
+  bool wasPointMatchingTimeLimitSpinBoxBlocked = d->PointMatchingTimeLimitSpinBox->blockSignals(true);
   bool wasProbeTransformFromComboBoxBlocked = d->ProbeTransformFromComboBox->blockSignals(true);
   bool wasProbeTransformToComboBoxBlocked = d->ProbeTransformToComboBox->blockSignals(true);
   bool wasOutputTransformComboBoxBlocked = d->OutputTransformComboBox->blockSignals(true);
@@ -381,6 +385,7 @@ void qSlicerFiducialRegistrationWizardModuleWidget::updateGUIFromMRML()
     pointMatchingIndex = 0;
   }
   d->PointMatchingComboBox->setCurrentIndex( pointMatchingIndex );
+  d->PointMatchingTimeLimitSpinBox->setValue( fiducialRegistrationWizardNode->GetPointMatchingTimeLimitSec() );
 
   d->ProbeTransformFromComboBox->setCurrentNode( fiducialRegistrationWizardNode->GetProbeTransformFromNode() );
   d->ProbeTransformToComboBox->setCurrentNode( fiducialRegistrationWizardNode->GetProbeTransformToNode() );
@@ -421,6 +426,7 @@ void qSlicerFiducialRegistrationWizardModuleWidget::updateGUIFromMRML()
 
   // Restore signals
   d->PointMatchingComboBox->blockSignals(wasPointMatchingComboBoxBlocked);
+  d->PointMatchingTimeLimitSpinBox->blockSignals(wasPointMatchingTimeLimitSpinBoxBlocked);
   d->ProbeTransformFromComboBox->blockSignals(wasProbeTransformFromComboBoxBlocked);
   d->ProbeTransformToComboBox->blockSignals(wasProbeTransformToComboBoxBlocked);
   d->OutputTransformComboBox->blockSignals(wasOutputTransformComboBoxBlocked);
@@ -444,6 +450,7 @@ void qSlicerFiducialRegistrationWizardModuleWidget::updateGUIFromMRML()
 
   // Results section
   d->PointMatchingComboBox->setEnabled(true);
+  d->PointMatchingTimeLimitSpinBox->setEnabled( fiducialRegistrationWizardNode->GetPointMatching() == vtkMRMLFiducialRegistrationWizardNode::POINT_MATCHING_AUTOMATIC );
   d->OutputTransformComboBox->setEnabled(true);
   d->RigidRadioButton->setEnabled(true);
   d->SimilarityRadioButton->setEnabled(true);
@@ -39,11 +39,41 @@
 //#include <vtkQuaternionInterpolator.h>
 
 // STD includes
+#include <algorithm>
 #include <cassert>
 #include <sstream>
+#include <vector>
 
 const float EPSILON = 0.00001;
 
+// Stabilization filter is updated more frequently at higher cut-off frequencies to reduce latency,
+// but not less frequently than the maximum period to keep the output motion smooth.
+static const double STABILIZATION_MINIMUM_UPDATE_PERIOD_SEC = 0.010;
+static const double STABILIZATION_MAXIMUM_UPDATE_PERIOD_SEC = 0.033; // about 30 fps update rate
+// Stabilized output is considered settled (no more updates are needed) if it is this close to the input
+static const double STABILIZATION_SETTLED_ROTATION_TOLERANCE = 1e-5; // difference in rotation matrix elements
+static const double STABILIZATION_SETTLED_TRANSLATION_TOLERANCE_MM = 1e-3;
+
+//-----------------------------------------------------------------------------
+static bool AreTransformMatricesClose(vtkMatrix4x4* matrixA, vtkMatrix4x4* matrixB)
+{
+  for (int row = 0; row < 3; row++)
+  {
+    for (int column = 0; column < 3; column++)
+    {
+      if (fabs(matrixA->GetElement(row, column) - matrixB->GetElement(row, column)) > STABILIZATION_SETTLED_ROTATION_TOLERANCE)
+      {
+        return false;
+      }
+    }
+    if (fabs(matrixA->GetElement(row, 3) - matrixB->GetElement(row, 3)) > STABILIZATION_SETTLED_TRANSLATION_TOLERANCE_MM)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
 vtkStandardNewMacro( vtkSlicerTransformProcessorLogic );
 
 //-----------------------------------------------------------------------------
@@ -103,6 +133,7 @@ void vtkSlicerTransformProcessorLogic::OnMRMLSceneNodeAdded( vtkMRMLNode* node )
     events->InsertNextValue( vtkMRMLTransformProcessorNode::InputDataModifiedEvent );
     vtkObserveMRMLNodeEventsMacro( pNode, events.GetPointer() );
     this->UpdateContinuouslyUpdatedNodesList(pNode);
+    this->InvokeEvent(OutputUpdateScheduleModifiedEvent);
   }
 }
 
@@ -121,6 +152,7 @@ void vtkSlicerTransformProcessorLogic::OnMRMLSceneNodeRemoved( vtkMRMLNode* node
     vtkDebugMacro( "OnMRMLSceneNodeRemoved" );
     vtkUnObserveMRMLNodeMacro( pNode );
     this->UpdateContinuouslyUpdatedNodesList(pNode);
+    this->InvokeEvent(OutputUpdateScheduleModifiedEvent);
   }
 }
 
@@ -170,6 +202,19 @@ void vtkSlicerTransformProcessorLogic::UpdateContinuouslyUpdatedNodesList(vtkMRM
   }
 }
 
+//-----------------------------------------------------------------------------
+bool vtkSlicerTransformProcessorLogic::IsContinuouslyUpdatedNode(vtkMRMLTransformProcessorNode* paramNode)
+{
+  for (auto continuouslyUpdatedNode : this->ContinuouslyUpdatedNodes)
+  {
+    if (continuouslyUpdatedNode == paramNode)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
 //-----------------------------------------------------------------------------
 void vtkSlicerTransformProcessorLogic::ProcessMRMLNodesEvents( vtkObject* caller, unsigned long event, void* vtkNotUsed(callData) )
 {
@@ -186,12 +231,18 @@ void vtkSlicerTransformProcessorLogic::ProcessMRMLNodesEvents( vtkObject* caller
     {
       this->UpdateOutputTransform( paramNode );
     }
+    if (this->IsContinuouslyUpdatedNode(paramNode))
+    {
+      // output may not have settled after the input change
+      this->InvokeEvent(OutputUpdateScheduleModifiedEvent);
+    }
   }
   else if (event == vtkCommand::ModifiedEvent)
   {
     // This is less frequent than vtkMRMLTransformProcessorNode::InputDataModifiedEvent
     // (which is called at every input transform node change)
     this->UpdateContinuouslyUpdatedNodesList(paramNode);
+    this->InvokeEvent(OutputUpdateScheduleModifiedEvent);
   }
 }
 
@@ -227,6 +278,10 @@ void vtkSlicerTransformProcessorLogic::UpdateOutputTransform( vtkMRMLTransformPr
   {
     this->ComputeStabilizedTransform(paramNode);
   }
+  else if (mode == vtkMRMLTransformProcessorNode::PROCESSING_MODE_WEIGHTED_FUSION)
+  {
+    this->ComputeWeightedFusion(paramNode);
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -923,7 +978,8 @@ bool vtkSlicerTransformProcessorLogic::IsTransformProcessingPossible( vtkMRMLTra
     }
   }
 
-  if ( mode == vtkMRMLTransformProcessorNode::PROCESSING_MODE_QUATERNION_AVERAGE )
+  if ( mode == vtkMRMLTransformProcessorNode::PROCESSING_MODE_QUATERNION_AVERAGE ||
+       mode == vtkMRMLTransformProcessorNode::PROCESSING_MODE_WEIGHTED_FUSION )
   {
     if ( node->GetNumberOfInputCombineTransformNodes() < 1 )
     {
@@ -968,13 +1024,7 @@ void vtkSlicerTransformProcessorLogic::ComputeStabilizedTransform(vtkMRMLTransfo
 
   // Get timestamps
   double currentTimeSec = vtkTimerLog::GetUniversalTime();
-  double lastUpdateTimeSec = 0.0;
-  const char* lastUpdateTimeSecStr = outputNode->GetAttribute("TransformProcessor.LastUpdateTimeSec");
-  if (lastUpdateTimeSecStr)
-  {
-    std::istringstream convertedStream(lastUpdateTimeSecStr);
-    convertedStream >> lastUpdateTimeSec;
-  }
+  double lastUpdateTimeSec = vtkSlicerTransformProcessorLogic::GetLastUpdateTimeSec(outputNode);
   std::stringstream ss;
   ss.precision(4);
   ss << std::fixed << currentTimeSec;
@@ -992,7 +1042,11 @@ void vtkSlicerTransformProcessorLogic::ComputeStabilizedTransform(vtkMRMLTransfo
   else
   {
     // Compute weights (low-pass filter with w_cutoff frequency)
-    const double elapsedTimeSec = currentTimeSec - lastUpdateTimeSec;
+    // Outputs are not updated while they are settled, so the time elapsed since the last update may be
+    // arbitrarily long. The filter must not jump to the new input in this case, so the elapsed time
+    // is limited to a single filter update period.
+    const double elapsedTimeSec = std::min(currentTimeSec - lastUpdateTimeSec,
+      vtkSlicerTransformProcessorLogic::GetStabilizationUpdatePeriodSec(paramNode));
     const double cutoff_frequency = paramNode->GetStabilizationCutOffFrequency();
     const double weightPrevious = 1;
     const double weightCurrent = elapsedTimeSec * cutoff_frequency;
@@ -1002,8 +1056,251 @@ void vtkSlicerTransformProcessorLogic::ComputeStabilizedTransform(vtkMRMLTransfo
 
     vtkNew<vtkMatrix4x4> matrixOutput;
     this->GetInterpolatedTransform(matrixPrevious, matrixCurrent, weightPrevious, weightCurrent, matrixOutput);
-    outputNode->SetMatrixTransformToParent(matrixOutput);
+    if (AreTransformMatricesClose(matrixOutput, matrixCurrent))
+    {
+      // Converged, snap to the input to make the output settled
+      outputNode->SetMatrixTransformToParent(matrixCurrent);
+    }
+    else
+    {
+      outputNode->SetMatrixTransformToParent(matrixOutput);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerTransformProcessorLogic::GetLastUpdateTimeSec(vtkMRMLLinearTransformNode* outputNode)
+{
+  double lastUpdateTimeSec = 0.0;
+  const char* lastUpdateTimeSecStr = outputNode->GetAttribute("TransformProcessor.LastUpdateTimeSec");
+  if (lastUpdateTimeSecStr)
+  {
+    std::istringstream convertedStream(lastUpdateTimeSecStr);
+    convertedStream >> lastUpdateTimeSec;
+  }
+  return lastUpdateTimeSec;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerTransformProcessorLogic::GetStabilizationUpdatePeriodSec(vtkMRMLTransformProcessorNode* paramNode)
+{
+  // A quarter of the filter time constant provides smooth output
+  const double cutoffFrequency = paramNode->GetStabilizationCutOffFrequency();
+  if (cutoffFrequency <= 0.0)
+  {
+    return STABILIZATION_MAXIMUM_UPDATE_PERIOD_SEC;
   }
+  double periodSec = 0.25 / cutoffFrequency;
+  return std::max(STABILIZATION_MINIMUM_UPDATE_PERIOD_SEC, std::min(periodSec, STABILIZATION_MAXIMUM_UPDATE_PERIOD_SEC));
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformProcessorLogic::IsStabilizedOutputSettled(vtkMRMLTransformProcessorNode* paramNode)
+{
+  vtkMRMLLinearTransformNode* inputNode = paramNode->GetInputUnstabilizedTransformNode();
+  vtkMRMLLinearTransformNode* outputNode = paramNode->GetOutputTransformNode();
+  if (inputNode == NULL || outputNode == NULL)
+  {
+    // nothing to update
+    return true;
+  }
+  vtkNew<vtkMatrix4x4> inputMatrix;
+  inputNode->GetMatrixTransformToParent(inputMatrix);
+  vtkNew<vtkMatrix4x4> outputMatrix;
+  outputNode->GetMatrixTransformToParent(outputMatrix);
+  return AreTransformMatricesClose(inputMatrix, outputMatrix);
+}
+
+//----------------------------------------------------------------------------
+// Fuse redundant measurements of the same rigid pose (e.g., multiple markers on a reference frame).
+// Each input is weighted by the value of its FusionWeightAttributeName attribute (1.0 if missing).
+// The input that agrees best with all the others is chosen as consensus and inputs that deviate
+// from it by more than the rotation or translation threshold are rejected. The rotation of the
+// remaining inputs is averaged as described in:
+//   F. Landis Markley, Yang Cheng, John Lucas Crassidis, and Yaakov Oshman.
+//   "Averaging Quaternions", Journal of Guidance, Control, and Dynamics,
+//   Vol. 30, No. 4 (2007), pp. 1193-1197.
+// (eigenvector of the weighted sum of quaternion outer products that has the largest eigenvalue),
+// translation is the weighted average of the input translations.
+void vtkSlicerTransformProcessorLogic::ComputeWeightedFusion(vtkMRMLTransformProcessorNode* paramNode)
+{
+  bool verboseWarnings = true;
+  bool conditionsMetForProcessing = this->IsTransformProcessingPossible(paramNode, verboseWarnings);
+  if (conditionsMetForProcessing == false)
+  {
+    return;
+  }
+
+  vtkMRMLLinearTransformNode* outputNode = paramNode->GetOutputTransformNode();
+  // the existence of outputNode is already checked in IsTransformProcessingPossible, no error check necessary
+
+  const std::string weightAttributeName = paramNode->GetFusionWeightAttributeName();
+  const double rotationThresholdDegrees = paramNode->GetFusionRotationThresholdDegrees();
+  const double translationThresholdMm = paramNode->GetFusionTranslationThresholdMm();
+
+  // Collect rotation (as quaternion), translation, and weight of all valid inputs
+  int numberOfInputs = paramNode->GetNumberOfInputCombineTransformNodes();
+  std::vector<double> weights;
+  std::vector<double> quaternions; // 4 values (w, x, y, z) per input
+  std::vector<double> translations; // 3 values per input
+  weights.reserve(numberOfInputs);
+  quaternions.reserve(numberOfInputs * 4);
+  translations.reserve(numberOfInputs * 3);
+  vtkNew<vtkMatrix4x4> inputMatrix;
+  double rotationMatrix[3][3] = { {0,0,0},{0,0,0},{0,0,0} };
+  for (int inputIndex = 0; inputIndex < numberOfInputs; inputIndex++)
+  {
+    vtkMRMLLinearTransformNode* inputNode = paramNode->GetNthInputCombineTransformNode(inputIndex);
+    if (inputNode == NULL)
+    {
+      continue;
+    }
+    double weight = 1.0;
+    const char* weightStr = weightAttributeName.empty() ? NULL : inputNode->GetAttribute(weightAttributeName.c_str());
+    if (weightStr)
+    {
+      std::istringstream convertedStream(weightStr);
+      if (!(convertedStream >> weight))
+      {
+        vtkWarningMacro("ComputeWeightedFusion: Invalid weight value '" << weightStr << "' in input " << inputNode->GetName() << ". Input is ignored.");
+        weight = 0.0;
+      }
+    }
+    if (weight <= 0.0)
+    {
+      // zero weight means the input is currently not valid (e.g., marker is not visible)
+      continue;
+    }
+    inputNode->GetMatrixTransformToParent(inputMatrix);
+    for (int row = 0; row < 3; row++)
+    {
+      for (int column = 0; column < 3; column++)
+      {
+        rotationMatrix[row][column] = inputMatrix->GetElement(row, column);
+      }
+    }
+    // Remove any scaling or shearing that would prevent quaternion conversion
+    vtkMath::Orthogonalize3x3(rotationMatrix, rotationMatrix);
+    double quaternion[4] = { 1.0, 0.0, 0.0, 0.0 };
+    vtkMath::Matrix3x3ToQuaternion(rotationMatrix, quaternion);
+    weights.push_back(weight);
+    quaternions.insert(quaternions.end(), quaternion, quaternion + 4);
+    translations.push_back(inputMatrix->GetElement(0, 3));
+    translations.push_back(inputMatrix->GetElement(1, 3));
+    translations.push_back(inputMatrix->GetElement(2, 3));
+  }
+
+  const int numberOfValidInputs = static_cast<int>(weights.size());
+  if (numberOfValidInputs == 0)
+  {
+    vtkDebugMacro("ComputeWeightedFusion: No inputs with positive weight. Output is not updated.");
+    return;
+  }
+
+  // Pose difference between two inputs: rotation angle (in degrees) and translation distance (in mm).
+  // q and -q represent the same rotation, therefore the absolute value of the dot product is used.
+  auto getRotationDifferenceDegrees = [&quaternions](int a, int b)
+  {
+    const double* qa = &quaternions[4 * a];
+    const double* qb = &quaternions[4 * b];
+    double dot = fabs(qa[0] * qb[0] + qa[1] * qb[1] + qa[2] * qb[2] + qa[3] * qb[3]);
+    return vtkMath::DegreesFromRadians(2.0 * acos(std::min(dot, 1.0)));
+  };
+  auto getTranslationDifferenceMm = [&translations](int a, int b)
+  {
+    return sqrt(vtkMath::Distance2BetweenPoints(&translations[3 * a], &translations[3 * b]));
+  };
+
+  // Consensus is the input that has the smallest weighted sum of pose differences to all the other inputs
+  // (weighted medoid). Unlike the mean, it is not pulled away by the outliers that are to be rejected.
+  // Rotation and translation differences are made comparable by normalizing them by the thresholds.
+  const double rotationScale = (rotationThresholdDegrees > 0.0 ? 1.0 / rotationThresholdDegrees : 1.0);
+  const double translationScale = (translationThresholdMm > 0.0 ? 1.0 / translationThresholdMm : 1.0);
+  int consensusIndex = 0;
+  double consensusCost = VTK_DOUBLE_MAX;
+  for (int candidateIndex = 0; candidateIndex < numberOfValidInputs; candidateIndex++)
+  {
+    double cost = 0.0;
+    for (int otherIndex = 0; otherIndex < numberOfValidInputs; otherIndex++)
+    {
+      if (otherIndex == candidateIndex)
+      {
+        continue;
+      }
+      cost += weights[otherIndex] * (rotationScale * getRotationDifferenceDegrees(candidateIndex, otherIndex)
+        + translationScale * getTranslationDifferenceMm(candidateIndex, otherIndex));
+    }
+    if (cost < consensusCost)
+    {
+      consensusCost = cost;
+      consensusIndex = candidateIndex;
+    }
+  }
+
+  // Accumulate weighted quaternion outer products and translations of inliers
+  double quaternionProductSum[4][4] = { {0,0,0,0},{0,0,0,0},{0,0,0,0},{0,0,0,0} };
+  double translationSum[3] = { 0.0, 0.0, 0.0 };
+  double weightSum = 0.0;
+  int numberOfInliers = 0;
+  for (int inputIndex = 0; inputIndex < numberOfValidInputs; inputIndex++)
+  {
+    if (rotationThresholdDegrees > 0.0 && getRotationDifferenceDegrees(inputIndex, consensusIndex) > rotationThresholdDegrees)
+    {
+      continue;
+    }
+    if (translationThresholdMm > 0.0 && getTranslationDifferenceMm(inputIndex, consensusIndex) > translationThresholdMm)
+    {
+      continue;
+    }
+    const double weight = weights[inputIndex];
+    const double* quaternion = &quaternions[4 * inputIndex];
+    for (int row = 0; row < 4; row++)
+    {
+      for (int column = 0; column < 4; column++)
+      {
+        quaternionProductSum[row][column] += weight * quaternion[row] * quaternion[column];
+      }
+    }
+    const double* translation = &translations[3 * inputIndex];
+    translationSum[0] += weight * translation[0];
+    translationSum[1] += weight * translation[1];
+    translationSum[2] += weight * translation[2];
+    weightSum += weight;
+    numberOfInliers++;
+  }
+  vtkDebugMacro("ComputeWeightedFusion: " << numberOfInliers << " of " << numberOfValidInputs << " valid inputs are used.");
+
+  // Average rotation is the eigenvector corresponding to the largest eigenvalue
+  // (vtkMath::JacobiN returns eigenvalues in decreasing order and eigenvectors in columns)
+  double* quaternionProductSumRows[4] = { quaternionProductSum[0], quaternionProductSum[1], quaternionProductSum[2], quaternionProductSum[3] };
+  double eigenvalues[4] = { 0.0, 0.0, 0.0, 0.0 };
+  double eigenvectors[4][4] = { {0,0,0,0},{0,0,0,0},{0,0,0,0},{0,0,0,0} };
+  double* eigenvectorsRows[4] = { eigenvectors[0], eigenvectors[1], eigenvectors[2], eigenvectors[3] };
+  if (!vtkMath::JacobiN(quaternionProductSumRows, 4, eigenvalues, eigenvectorsRows))
+  {
+    vtkErrorMacro("ComputeWeightedFusion: Failed to compute average rotation. Output is not updated.");
+    return;
+  }
+  double averageQuaternion[4] = { eigenvectors[0][0], eigenvectors[1][0], eigenvectors[2][0], eigenvectors[3][0] };
+  double averageQuaternionNorm = sqrt(averageQuaternion[0] * averageQuaternion[0] + averageQuaternion[1] * averageQuaternion[1]
+    + averageQuaternion[2] * averageQuaternion[2] + averageQuaternion[3] * averageQuaternion[3]);
+  for (int i = 0; i < 4; i++)
+  {
+    averageQuaternion[i] /= averageQuaternionNorm;
+  }
+  double averageRotationMatrix[3][3] = { {0,0,0},{0,0,0},{0,0,0} };
+  vtkMath::QuaternionToMatrix3x3(averageQuaternion, averageRotationMatrix);
+
+  vtkNew<vtkMatrix4x4> resultMatrix;
+  for (int row = 0; row < 3; row++)
+  {
+    for (int column = 0; column < 3; column++)
+    {
+      resultMatrix->SetElement(row, column, averageRotationMatrix[row][column]);
+    }
+    resultMatrix->SetElement(row, 3, translationSum[row] / weightSum);
+  }
+  outputNode->SetMatrixTransformToParent(resultMatrix);
 }
 
 //----------------------------------------------------------------------------
@@ -1114,10 +1411,44 @@ void vtkSlicerTransformProcessorLogic::UpdateAllOutputs()
 {
   for (auto paramNode : this->ContinuouslyUpdatedNodes)
   {
+    if (paramNode == nullptr)
+    {
+      continue;
+    }
     if (paramNode->GetUpdateMode() == vtkMRMLTransformProcessorNode::UPDATE_MODE_AUTO &&
-      paramNode->GetProcessingMode() == vtkMRMLTransformProcessorNode::PROCESSING_MODE_STABILIZE && paramNode->GetStabilizationEnabled())
+      paramNode->GetProcessingMode() == vtkMRMLTransformProcessorNode::PROCESSING_MODE_STABILIZE && paramNode->GetStabilizationEnabled()
+      && !this->IsStabilizedOutputSettled(paramNode))
     {
       this->UpdateOutputTransform(paramNode);
     }
   }
 }
+
+//----------------------------------------------------------------------------
+double vtkSlicerTransformProcessorLogic::GetNextOutputUpdateDelaySec()
+{
+  double currentTimeSec = vtkTimerLog::GetUniversalTime();
+  double nextUpdateDelaySec = -1.0;
+  for (auto paramNode : this->ContinuouslyUpdatedNodes)
+  {
+    if (paramNode == nullptr)
+    {
+      continue;
+    }
+    if (paramNode->GetUpdateMode() != vtkMRMLTransformProcessorNode::UPDATE_MODE_AUTO
+      || paramNode->GetProcessingMode() != vtkMRMLTransformProcessorNode::PROCESSING_MODE_STABILIZE
+      || !paramNode->GetStabilizationEnabled()
+      || this->IsStabilizedOutputSettled(paramNode))
+    {
+      continue;
+    }
+    // The filter is still converging towards its input, next update is due one update period after the last one
+    double lastUpdateTimeSec = vtkSlicerTransformProcessorLogic::GetLastUpdateTimeSec(paramNode->GetOutputTransformNode());
+    double delaySec = std::max(0.0, lastUpdateTimeSec + vtkSlicerTransformProcessorLogic::GetStabilizationUpdatePeriodSec(paramNode) - currentTimeSec);
+    if (nextUpdateDelaySec < 0.0 || delaySec < nextUpdateDelaySec)
+    {
+      nextUpdateDelaySec = delaySec;
+    }
+  }
+  return nextUpdateDelaySec;
+}
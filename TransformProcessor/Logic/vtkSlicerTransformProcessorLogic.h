@@ -45,6 +45,7 @@ class vtkMRMLLinearTransformNode;
 #include <cstdlib>
 
 // vtk includes
+#include "vtkCommand.h"
 #include "vtkGeneralTransform.h"
 #include "vtkTransform.h"
 #include "vtkSmartPointer.h"
@@ -57,16 +58,29 @@ class VTK_SLICER_TRANSFORMPROCESSOR_MODULE_LOGIC_EXPORT vtkSlicerTransformProces
   public vtkSlicerModuleLogic
 {
 public:
-  
+
+  enum Events
+  {
+    /// Invoked when an output may need continuous updates at a different time than scheduled before
+    /// (e.g., input of a stabilized transform changed). The application should call
+    /// GetNextOutputUpdateDelaySec() and schedule the next UpdateAllOutputs() call accordingly.
+    OutputUpdateScheduleModifiedEvent = vtkCommand::UserEvent + 174
+  };
+
   static vtkSlicerTransformProcessorLogic *New();
   vtkTypeMacro( vtkSlicerTransformProcessorLogic, vtkSlicerModuleLogic );
   void PrintSelf( ostream& os, vtkIndent indent ) override;
   
 public:
-  // Update all output transforms that are to be updated continuously.
-  // This method is called regularly by the application.
+  // Update all output transforms that are to be updated continuously and have not settled yet.
+  // This method is called by the application when the delay returned by GetNextOutputUpdateDelaySec() elapsed.
   void UpdateAllOutputs();
 
+  // Returns time (in seconds) until UpdateAllOutputs() has to be called next.
+  // Returns a negative value if all continuously updated outputs have settled
+  // (output is the same as the input), therefore no update is needed until an input changes.
+  double GetNextOutputUpdateDelaySec();
+
   void UpdateOutputTransform( vtkMRMLTransformProcessorNode* );
   void QuaternionAverage( vtkMRMLTransformProcessorNode* );
   void ComputeShaftPivotTransform( vtkMRMLTransformProcessorNode* );
@@ -75,6 +89,7 @@ public:
   void ComputeFullTransform( vtkMRMLTransformProcessorNode* );
   void ComputeInverseTransform( vtkMRMLTransformProcessorNode* );
   void ComputeStabilizedTransform(vtkMRMLTransformProcessorNode*);
+  void ComputeWeightedFusion(vtkMRMLTransformProcessorNode*);
   bool IsTransformProcessingPossible( vtkMRMLTransformProcessorNode*, bool verbose = false );
 
   static void GetRotationAllAxesFromTransform ( vtkGeneralTransform*, vtkTransform* );
@@ -102,6 +117,13 @@ private:
   void GetRotationSingleAxisFromTransform( vtkGeneralTransform*, int, const double*, const double*, vtkTransform* );
 
   void UpdateContinuouslyUpdatedNodesList(vtkMRMLTransformProcessorNode* paramNode);
+  bool IsContinuouslyUpdatedNode(vtkMRMLTransformProcessorNode* paramNode);
+
+  // Returns true if the stabilized output transform has converged to the input
+  bool IsStabilizedOutputSettled(vtkMRMLTransformProcessorNode* paramNode);
+  // Time between stabilization filter updates, depends on the cut-off frequency
+  static double GetStabilizationUpdatePeriodSec(vtkMRMLTransformProcessorNode* paramNode);
+  static double GetLastUpdateTimeSec(vtkMRMLLinearTransformNode* outputNode);
 
   void Slerp(double* result, double t, double* from, double* to, bool adjustSign = true);
   void GetInterpolatedTransform(vtkMatrix4x4* itemAmatrix, vtkMatrix4x4* itemBmatrix,
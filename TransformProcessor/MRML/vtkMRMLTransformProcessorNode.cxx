@@ -78,6 +78,9 @@ vtkMRMLTransformProcessorNode::vtkMRMLTransformProcessorNode()
   this->SecondaryAxisLabel = AXIS_LABEL_Y;
   this->StabilizationEnabled = true;
   this->StabilizationCutOffFrequency = 7.5;
+  this->FusionWeightAttributeName = "TransformProcessor.FusionWeight";
+  this->FusionRotationThresholdDegrees = 5.0;
+  this->FusionTranslationThresholdMm = 3.0;
 }
 
 //----------------------------------------------------------------------------
@@ -103,6 +106,9 @@ void vtkMRMLTransformProcessorNode::ReadXMLAttributes( const char** atts )
   vtkMRMLReadXMLBooleanMacro(copyTranslationZ, CopyTranslationZ);
   vtkMRMLReadXMLBooleanMacro(stabilizationEnabled, StabilizationEnabled);
   vtkMRMLReadXMLFloatMacro(stabilizationCutOffFrequency, StabilizationCutOffFrequency);
+  vtkMRMLReadXMLStdStringMacro(fusionWeightAttributeName, FusionWeightAttributeName);
+  vtkMRMLReadXMLFloatMacro(fusionRotationThresholdDegrees, FusionRotationThresholdDegrees);
+  vtkMRMLReadXMLFloatMacro(fusionTranslationThresholdMm, FusionTranslationThresholdMm);
   vtkMRMLReadXMLEndMacro();
 }
 
@@ -123,6 +129,9 @@ void vtkMRMLTransformProcessorNode::WriteXML( ostream& of, int nIndent )
   vtkMRMLWriteXMLBooleanMacro(copyTranslationZ, CopyTranslationZ);
   vtkMRMLWriteXMLBooleanMacro(stabilizationEnabled, StabilizationEnabled);
   vtkMRMLWriteXMLFloatMacro(stabilizationCutOffFrequency, StabilizationCutOffFrequency);
+  vtkMRMLWriteXMLStdStringMacro(fusionWeightAttributeName, FusionWeightAttributeName);
+  vtkMRMLWriteXMLFloatMacro(fusionRotationThresholdDegrees, FusionRotationThresholdDegrees);
+  vtkMRMLWriteXMLFloatMacro(fusionTranslationThresholdMm, FusionTranslationThresholdMm);
   vtkMRMLWriteXMLEndMacro();
 }
 
@@ -142,6 +151,9 @@ void vtkMRMLTransformProcessorNode::PrintSelf( ostream& os, vtkIndent indent )
   vtkMRMLPrintBooleanMacro(CopyTranslationZ);
   vtkMRMLPrintBooleanMacro(StabilizationEnabled);
   vtkMRMLPrintFloatMacro(StabilizationCutOffFrequency);
+  vtkMRMLPrintStdStringMacro(FusionWeightAttributeName);
+  vtkMRMLPrintFloatMacro(FusionRotationThresholdDegrees);
+  vtkMRMLPrintFloatMacro(FusionTranslationThresholdMm);
   vtkMRMLPrintEndMacro();
 }
 
@@ -163,6 +175,9 @@ void vtkMRMLTransformProcessorNode::Copy(vtkMRMLNode *anode)
   vtkMRMLCopyBooleanMacro(CopyTranslationZ);
   vtkMRMLCopyBooleanMacro(StabilizationEnabled);
   vtkMRMLCopyFloatMacro(StabilizationCutOffFrequency);
+  vtkMRMLCopyStdStringMacro(FusionWeightAttributeName);
+  vtkMRMLCopyFloatMacro(FusionRotationThresholdDegrees);
+  vtkMRMLCopyFloatMacro(FusionTranslationThresholdMm);
   vtkMRMLCopyEndMacro();
 }
 
@@ -651,6 +666,8 @@ const char* vtkMRMLTransformProcessorNode::GetProcessingModeAsString( int mode )
     return "Compute Inverse";
   case PROCESSING_MODE_STABILIZE:
     return "Stabilize";
+  case PROCESSING_MODE_WEIGHTED_FUSION:
+    return "Weighted Fusion";
   default:
     vtkGenericWarningMacro("Unknown processing mode provided as input to GetProcessingModeAsString: " << mode << ". Returning \"Unknown Processing Mode\"");
     return "Unknown Processing Mode";
@@ -843,3 +860,42 @@ void vtkMRMLTransformProcessorNode::SetStabilizationEnabled(bool enabled)
   this->Modified();
   this->InvokeCustomModifiedEvent(InputDataModifiedEvent);
 }
+
+//----------------------------------------------------------------------------
+void vtkMRMLTransformProcessorNode::SetFusionWeightAttributeName(const std::string& attributeName)
+{
+  if (this->FusionWeightAttributeName == attributeName)
+  {
+    // no change
+    return;
+  }
+  this->FusionWeightAttributeName = attributeName;
+  this->Modified();
+  this->InvokeCustomModifiedEvent(InputDataModifiedEvent);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLTransformProcessorNode::SetFusionRotationThresholdDegrees(double thresholdDegrees)
+{
+  if (this->FusionRotationThresholdDegrees == thresholdDegrees)
+  {
+    // no change
+    return;
+  }
+  this->FusionRotationThresholdDegrees = thresholdDegrees;
+  this->Modified();
+  this->InvokeCustomModifiedEvent(InputDataModifiedEvent);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLTransformProcessorNode::SetFusionTranslationThresholdMm(double thresholdMm)
+{
+  if (this->FusionTranslationThresholdMm == thresholdMm)
+  {
+    // no change
+    return;
+  }
+  this->FusionTranslationThresholdMm = thresholdMm;
+  this->Modified();
+  this->InvokeCustomModifiedEvent(InputDataModifiedEvent);
+}
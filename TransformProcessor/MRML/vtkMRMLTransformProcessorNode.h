@@ -64,6 +64,7 @@ public:
     PROCESSING_MODE_COMPUTE_FULL_TRANSFORM,
     PROCESSING_MODE_COMPUTE_INVERSE,
     PROCESSING_MODE_STABILIZE,
+    PROCESSING_MODE_WEIGHTED_FUSION,
     PROCESSING_MODE_LAST // do not set to this type, insert valid types above this line
   };
 
@@ -168,6 +169,22 @@ public:
   vtkGetMacro(StabilizationEnabled, bool);
   void SetStabilizationEnabled(bool);
 
+  /// Name of the input transform node attribute that stores the weight (or tracking quality)
+  /// of that input in weighted fusion mode. Inputs without this attribute get a weight of 1.0,
+  /// inputs with zero or negative weight are ignored. If empty then all inputs have the same weight.
+  vtkGetMacro(FusionWeightAttributeName, std::string);
+  void SetFusionWeightAttributeName(const std::string&);
+
+  /// Inputs that differ from the consensus pose by more than this rotation angle are
+  /// rejected in weighted fusion mode. Non-positive value disables rotation-based rejection.
+  vtkGetMacro(FusionRotationThresholdDegrees, double);
+  void SetFusionRotationThresholdDegrees(double);
+
+  /// Inputs that differ from the consensus pose by more than this translation are
+  /// rejected in weighted fusion mode. Non-positive value disables translation-based rejection.
+  vtkGetMacro(FusionTranslationThresholdMm, double);
+  void SetFusionTranslationThresholdMm(double);
+
   void CheckAndCorrectForDuplicateAxes();
 
   static const char* GetProcessingModeAsString( int );
@@ -220,6 +237,9 @@ protected:
   int SecondaryAxisLabel;
   double StabilizationCutOffFrequency;
   bool StabilizationEnabled;
+  std::string FusionWeightAttributeName;
+  double FusionRotationThresholdDegrees;
+  double FusionTranslationThresholdMm;
 };
 
 #endif
@@ -30,8 +30,6 @@
 #include "qSlicerTransformProcessorModule.h"
 #include "qSlicerTransformProcessorModuleWidget.h"
 
-static const double UPDATE_OUTPUTS_PERIOD_SEC = 0.033; // about 30 fps update rate
-
 //-----------------------------------------------------------------------------
 #if (QT_VERSION < QT_VERSION_CHECK(5, 0, 0))
 #include <QtPlugin>
@@ -65,14 +63,9 @@ qSlicerTransformProcessorModule::qSlicerTransformProcessorModule(QObject* _paren
   , d_ptr(new qSlicerTransformProcessorModulePrivate)
 {
   Q_D(qSlicerTransformProcessorModule);
+  // The timer is only started when an output needs to be updated (see scheduleNextOutputsUpdate)
+  d->UpdateAllOutputsTimer.setSingleShot(true);
   connect(&d->UpdateAllOutputsTimer, SIGNAL(timeout()), this, SLOT(updateAllOutputs()));
-  vtkMRMLScene* scene = qSlicerCoreApplication::application()->mrmlScene();
-  if (scene)
-  {
-    // Need to listen for any new watchdog nodes being added to start/stop timer
-    this->qvtkConnect(scene, vtkMRMLScene::NodeAddedEvent, this, SLOT(onNodeAddedEvent(vtkObject*, vtkObject*)));
-    this->qvtkConnect(scene, vtkMRMLScene::NodeRemovedEvent, this, SLOT(onNodeRemovedEvent(vtkObject*, vtkObject*)));
-  }
 }
 
 //-----------------------------------------------------------------------------
@@ -123,6 +116,17 @@ QIcon qSlicerTransformProcessorModule::icon()const
 void qSlicerTransformProcessorModule::setup()
 {
   this->Superclass::setup();
+
+  vtkSlicerTransformProcessorLogic* processorLogic = vtkSlicerTransformProcessorLogic::SafeDownCast(this->logic());
+  if (processorLogic)
+  {
+    // Logic notifies us when an output starts to need continuous updates (e.g., input of a stabilized transform changed)
+    this->qvtkConnect(processorLogic, vtkSlicerTransformProcessorLogic::OutputUpdateScheduleModifiedEvent, this, SLOT(scheduleNextOutputsUpdate()));
+  }
+  else
+  {
+    qWarning("vtkSlicerTransformProcessorLogic is not available");
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -137,51 +141,20 @@ vtkMRMLAbstractLogic* qSlicerTransformProcessorModule::createLogic()
   return vtkSlicerTransformProcessorLogic::New();
 }
 
-// --------------------------------------------------------------------------
-void qSlicerTransformProcessorModule::onNodeAddedEvent(vtkObject*, vtkObject* node)
-{
-  Q_D(qSlicerTransformProcessorModule);
-
-  vtkMRMLTransformProcessorNode* processorNode = vtkMRMLTransformProcessorNode::SafeDownCast(node);
-  if (processorNode)
-  {
-    // If the timer is not active
-    if (!d->UpdateAllOutputsTimer.isActive())
-    {
-      d->UpdateAllOutputsTimer.start(UPDATE_OUTPUTS_PERIOD_SEC * 1000.0);
-    }
-  }
-}
-
-// --------------------------------------------------------------------------
-void qSlicerTransformProcessorModule::onNodeRemovedEvent(vtkObject*, vtkObject* node)
+//-----------------------------------------------------------------------------
+void qSlicerTransformProcessorModule::updateAllOutputs()
 {
-  Q_D(qSlicerTransformProcessorModule);
-
-  vtkMRMLTransformProcessorNode* processorNode = vtkMRMLTransformProcessorNode::SafeDownCast(node);
-  if (processorNode)
+  vtkSlicerTransformProcessorLogic* processorLogic = vtkSlicerTransformProcessorLogic::SafeDownCast(this->Superclass::logic());
+  if (!processorLogic)
   {
-    // If the timer is active
-    if (d->UpdateAllOutputsTimer.isActive())
-    {
-      // Check if there is any other sequence browser node left in the Scene
-      vtkMRMLScene* scene = qSlicerCoreApplication::application()->mrmlScene();
-      if (scene)
-      {
-        std::vector<vtkMRMLNode*> nodes;
-        this->mrmlScene()->GetNodesByClass("vtkMRMLTransformProcessorNode", nodes);
-        if (nodes.size() == 0)
-        {
-          // The last sequence browser was removed
-          d->UpdateAllOutputsTimer.stop();
-        }
-      }
-    }
+    return;
   }
+  processorLogic->UpdateAllOutputs();
+  this->scheduleNextOutputsUpdate();
 }
 
 //-----------------------------------------------------------------------------
-void qSlicerTransformProcessorModule::updateAllOutputs()
+void qSlicerTransformProcessorModule::scheduleNextOutputsUpdate()
 {
   Q_D(qSlicerTransformProcessorModule);
   vtkSlicerTransformProcessorLogic* processorLogic = vtkSlicerTransformProcessorLogic::SafeDownCast(this->Superclass::logic());
@@ -189,5 +162,12 @@ void qSlicerTransformProcessorModule::updateAllOutputs()
   {
     return;
   }
-  processorLogic->UpdateAllOutputs();
+  double nextUpdateDelaySec = processorLogic->GetNextOutputUpdateDelaySec();
+  if (nextUpdateDelaySec < 0)
+  {
+    // all outputs have settled, no need to wake up until an input changes
+    d->UpdateAllOutputsTimer.stop();
+    return;
+  }
+  d->UpdateAllOutputsTimer.start(static_cast<int>(nextUpdateDelaySec * 1000.0 + 0.5));
 }
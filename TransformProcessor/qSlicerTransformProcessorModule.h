@@ -63,9 +63,9 @@ public:
   virtual QStringList categories() const override;
 
 public slots:
-  void onNodeAddedEvent(vtkObject*, vtkObject*);
-  void onNodeRemovedEvent(vtkObject*, vtkObject*);
   void updateAllOutputs();
+  /// Start the update timer if any of the outputs needs to be updated, stop it if all the outputs have settled
+  void scheduleNextOutputsUpdate();
 
 protected:
 
@@ -106,6 +106,8 @@ void qSlicerTransformProcessorModuleWidget::setup()
   d->processingModeComboBox->setItemData( 5, "Compute a constrained version of an Source transform, the translation and z direction are preserved but the other axes resemble the Target coordinate system.", Qt::ToolTipRole );
   d->processingModeComboBox->addItem(vtkMRMLTransformProcessorNode::GetProcessingModeAsString(vtkMRMLTransformProcessorNode::PROCESSING_MODE_STABILIZE));
   d->processingModeComboBox->setItemData( 6, "Compute a stabilized transform by low-pass filtering.", Qt::ToolTipRole);
+  d->processingModeComboBox->addItem(vtkMRMLTransformProcessorNode::GetProcessingModeAsString(vtkMRMLTransformProcessorNode::PROCESSING_MODE_WEIGHTED_FUSION));
+  d->processingModeComboBox->setItemData( 7, "Compute the weighted average of redundant Source transforms, rejecting the ones that disagree with the consensus.", Qt::ToolTipRole);
 
   d->advancedRotationModeComboBox->addItem( vtkMRMLTransformProcessorNode::GetRotationModeAsString( vtkMRMLTransformProcessorNode::ROTATION_MODE_COPY_ALL_AXES ));
   d->advancedRotationModeComboBox->addItem( vtkMRMLTransformProcessorNode::GetRotationModeAsString( vtkMRMLTransformProcessorNode::ROTATION_MODE_COPY_SINGLE_AXIS ));
@@ -153,6 +155,10 @@ void qSlicerTransformProcessorModuleWidget::setup()
 
   connect(d->stabilizationFilterCheckBox, SIGNAL(toggled(bool)), this, SLOT(onStabilizationFilterCheckBoxToggled(bool)));
   connect(d->stabilizationCutOffFrequencySlider, SIGNAL(valueChanged(double)), this, SLOT(onStabilizationCutOffFrequencyChanged(double)));
+
+  connect(d->fusionWeightAttributeNameLineEdit, SIGNAL(editingFinished()), this, SLOT(onFusionWeightAttributeNameChanged()));
+  connect(d->fusionRotationThresholdSpinBox, SIGNAL(valueChanged(double)), this, SLOT(onFusionRotationThresholdChanged(double)));
+  connect(d->fusionTranslationThresholdSpinBox, SIGNAL(valueChanged(double)), this, SLOT(onFusionTranslationThresholdChanged(double)));
 }
 
 //-----------------------------------------------------------------------------
@@ -215,6 +221,9 @@ void qSlicerTransformProcessorModuleWidget::setSignalsBlocked( bool newBlock )
   d->stabilizationFilterCheckBox->blockSignals(newBlock);
   d->stabilizationCutOffFrequencySlider->blockSignals(newBlock);
   d->stabilizationCutOffFrequencySpinBox->blockSignals(newBlock);
+  d->fusionWeightAttributeNameLineEdit->blockSignals(newBlock);
+  d->fusionRotationThresholdSpinBox->blockSignals(newBlock);
+  d->fusionTranslationThresholdSpinBox->blockSignals(newBlock);
 }
 
 //-----------------------------------------------------------------------------
@@ -244,7 +253,10 @@ bool qSlicerTransformProcessorModuleWidget::getSignalsBlocked()
        parameterNodeBlocked == d->updateButton->signalsBlocked() &&
        parameterNodeBlocked == d->stabilizationFilterCheckBox->signalsBlocked() &&
        parameterNodeBlocked == d->stabilizationCutOffFrequencySlider->signalsBlocked() &&
-       parameterNodeBlocked == d->stabilizationCutOffFrequencySpinBox->signalsBlocked() )
+       parameterNodeBlocked == d->stabilizationCutOffFrequencySpinBox->signalsBlocked() &&
+       parameterNodeBlocked == d->fusionWeightAttributeNameLineEdit->signalsBlocked() &&
+       parameterNodeBlocked == d->fusionRotationThresholdSpinBox->signalsBlocked() &&
+       parameterNodeBlocked == d->fusionTranslationThresholdSpinBox->signalsBlocked() )
   {
     return parameterNodeBlocked;
   }
@@ -327,7 +339,9 @@ void qSlicerTransformProcessorModuleWidget::updateGUIFromMRML()
 
   // == update visibility of widgets ==
 
-  bool showCombineTransformList = ( pNode->GetProcessingMode() == vtkMRMLTransformProcessorNode::PROCESSING_MODE_QUATERNION_AVERAGE );
+  bool showFusionOptions = ( pNode->GetProcessingMode() == vtkMRMLTransformProcessorNode::PROCESSING_MODE_WEIGHTED_FUSION );
+  bool showCombineTransformList = ( pNode->GetProcessingMode() == vtkMRMLTransformProcessorNode::PROCESSING_MODE_QUATERNION_AVERAGE ||
+                                    showFusionOptions );
   d->inputCombineTransformListGroupBox->setVisible( showCombineTransformList );
 
   bool showFromToTransform = ( pNode->GetProcessingMode() == vtkMRMLTransformProcessorNode::PROCESSING_MODE_COMPUTE_ROTATION ||
@@ -420,6 +434,11 @@ void qSlicerTransformProcessorModuleWidget::updateGUIFromMRML()
   d->stabilizationCutOffFrequencySlider->setValue(pNode->GetStabilizationCutOffFrequency());
   d->stabilizationCutOffFrequencySpinBox->setValue(pNode->GetStabilizationCutOffFrequency());
 
+  d->fusionOptionsGroupBox->setVisible(showFusionOptions);
+  d->fusionWeightAttributeNameLineEdit->setText(QString::fromStdString(pNode->GetFusionWeightAttributeName()));
+  d->fusionRotationThresholdSpinBox->setValue(pNode->GetFusionRotationThresholdDegrees());
+  d->fusionTranslationThresholdSpinBox->setValue(pNode->GetFusionTranslationThresholdMm());
+
   this->setSignalsBlocked( wasBlocked );
 }
 
@@ -821,3 +840,42 @@ void qSlicerTransformProcessorModuleWidget::onStabilizationCutOffFrequencyChange
   }
   pNode->SetStabilizationCutOffFrequency(cutOffFreequency);
 }
+
+//-----------------------------------------------------------------------------
+void qSlicerTransformProcessorModuleWidget::onFusionWeightAttributeNameChanged()
+{
+  Q_D(qSlicerTransformProcessorModuleWidget);
+  vtkMRMLTransformProcessorNode* pNode = vtkMRMLTransformProcessorNode::SafeDownCast(d->parameterNodeComboBox->currentNode());
+  if (pNode == NULL || this->mrmlScene() == NULL)
+  {
+    qCritical() << Q_FUNC_INFO << " failed: no parameter node/scene found.";
+    return;
+  }
+  pNode->SetFusionWeightAttributeName(d->fusionWeightAttributeNameLineEdit->text().toStdString());
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerTransformProcessorModuleWidget::onFusionRotationThresholdChanged(double thresholdDegrees)
+{
+  Q_D(qSlicerTransformProcessorModuleWidget);
+  vtkMRMLTransformProcessorNode* pNode = vtkMRMLTransformProcessorNode::SafeDownCast(d->parameterNodeComboBox->currentNode());
+  if (pNode == NULL || this->mrmlScene() == NULL)
+  {
+    qCritical() << Q_FUNC_INFO << " failed: no parameter node/scene found.";
+    return;
+  }
+  pNode->SetFusionRotationThresholdDegrees(thresholdDegrees);
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerTransformProcessorModuleWidget::onFusionTranslationThresholdChanged(double thresholdMm)
+{
+  Q_D(qSlicerTransformProcessorModuleWidget);
+  vtkMRMLTransformProcessorNode* pNode = vtkMRMLTransformProcessorNode::SafeDownCast(d->parameterNodeComboBox->currentNode());
+  if (pNode == NULL || this->mrmlScene() == NULL)
+  {
+    qCritical() << Q_FUNC_INFO << " failed: no parameter node/scene found.";
+    return;
+  }
+  pNode->SetFusionTranslationThresholdMm(thresholdMm);
+}
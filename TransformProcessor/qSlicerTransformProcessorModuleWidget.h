@@ -79,6 +79,10 @@ protected slots:
   void onStabilizationFilterCheckBoxToggled(bool);
   void onStabilizationCutOffFrequencyChanged(double);
 
+  void onFusionWeightAttributeNameChanged();
+  void onFusionRotationThresholdChanged(double);
+  void onFusionTranslationThresholdChanged(double);
+
 protected:
   QScopedPointer< qSlicerTransformProcessorModuleWidgetPrivate > d_ptr;
   
@@ -0,0 +1,807 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+==============================================================================*/
+
+#include "vtkBrickedVolumeAccumulator.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkTemplateAliasMacro.h>
+#include <vtkTypeTraits.h>
+
+// VTKSYS includes
+#include <vtksys/FStream.hxx>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <winioctl.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//---------------------------------------------------------------------------
+vtkStandardNewMacro(vtkBrickedVolumeAccumulator);
+
+namespace
+{
+  // Brick indices are packed into a single key, 21 bits for each axis
+  const int BRICK_INDEX_BITS = 21;
+
+  // Bricks in the scratch file start at cache line boundaries
+  const size_t SCRATCH_BRICK_ALIGNMENT = 64;
+
+  //---------------------------------------------------------------------------
+  const char* GetNrrdTypeName(int scalarType)
+  {
+    switch (scalarType)
+    {
+    case VTK_CHAR:
+    case VTK_SIGNED_CHAR: return "int8";
+    case VTK_UNSIGNED_CHAR: return "uint8";
+    case VTK_SHORT: return "int16";
+    case VTK_UNSIGNED_SHORT: return "uint16";
+    case VTK_INT: return "int32";
+    case VTK_UNSIGNED_INT: return "uint32";
+    case VTK_LONG: return sizeof(long) == 8 ? "int64" : "int32";
+    case VTK_UNSIGNED_LONG: return sizeof(unsigned long) == 8 ? "uint64" : "uint32";
+    case VTK_LONG_LONG: return "int64";
+    case VTK_UNSIGNED_LONG_LONG: return "uint64";
+    case VTK_FLOAT: return "float";
+    case VTK_DOUBLE: return "double";
+    default: return nullptr;
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  template <class T>
+  T CastVoxelValue(double value)
+  {
+    if (std::numeric_limits<T>::is_integer)
+    {
+      value = std::round(value);
+    }
+    value = std::max(value, static_cast<double>(vtkTypeTraits<T>::Min()));
+    value = std::min(value, static_cast<double>(vtkTypeTraits<T>::Max()));
+    return static_cast<T>(value);
+  }
+}
+
+//---------------------------------------------------------------------------
+// Read-write memory mapping of a scratch file. The file is deleted when the mapping is closed.
+struct vtkBrickedVolumeAccumulator::ScratchFileMapping
+{
+  std::string FileName;
+  char* Data{ nullptr };
+  size_t Size{ 0 };
+#ifdef _WIN32
+  HANDLE File{ INVALID_HANDLE_VALUE };
+  HANDLE Mapping{ nullptr };
+#else
+  int File{ -1 };
+#endif
+
+  ~ScratchFileMapping()
+  {
+    this->Close();
+  }
+
+  // The file is created with the requested size. Pages that are never written do not use disk space
+  // on file systems that support sparse files, and they are read as zeros.
+  // An existing file is not overwritten, as it may be mapped by another process.
+  bool Open(const std::string& fileName, size_t size)
+  {
+    this->Close();
+    this->FileName = fileName;
+    this->Size = size;
+#ifdef _WIN32
+    this->File = CreateFileA(fileName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_NEW,
+      FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+    if (this->File == INVALID_HANDLE_VALUE)
+    {
+      return false;
+    }
+    DWORD bytesReturned = 0;
+    DeviceIoControl(this->File, FSCTL_SET_SPARSE, nullptr, 0, nullptr, 0, &bytesReturned, nullptr);
+    LARGE_INTEGER fileSize;
+    fileSize.QuadPart = static_cast<LONGLONG>(size);
+    this->Mapping = CreateFileMappingA(this->File, nullptr, PAGE_READWRITE, fileSize.HighPart, fileSize.LowPart, nullptr);
+    if (!this->Mapping)
+    {
+      this->Close();
+      return false;
+    }
+    this->Data = static_cast<char*>(MapViewOfFile(this->Mapping, FILE_MAP_ALL_ACCESS, 0, 0, size));
+#else
+    this->File = open(fileName.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if (this->File < 0)
+    {
+      return false;
+    }
+    if (ftruncate(this->File, static_cast<off_t>(size)) != 0)
+    {
+      this->Close();
+      return false;
+    }
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, this->File, 0);
+    this->Data = data != MAP_FAILED ? static_cast<char*>(data) : nullptr;
+#endif
+    if (!this->Data)
+    {
+      this->Close();
+      return false;
+    }
+    return true;
+  }
+
+  void Close()
+  {
+#ifdef _WIN32
+    if (this->Data)
+    {
+      UnmapViewOfFile(this->Data);
+    }
+    if (this->Mapping)
+    {
+      CloseHandle(this->Mapping);
+    }
+    if (this->File != INVALID_HANDLE_VALUE)
+    {
+      // Deleted on close
+      CloseHandle(this->File);
+    }
+    this->Mapping = nullptr;
+    this->File = INVALID_HANDLE_VALUE;
+#else
+    if (this->Data)
+    {
+      munmap(this->Data, this->Size);
+    }
+    if (this->File >= 0)
+    {
+      close(this->File);
+      unlink(this->FileName.c_str());
+    }
+    this->File = -1;
+#endif
+    this->Data = nullptr;
+    this->Size = 0;
+  }
+};
+
+//---------------------------------------------------------------------------
+vtkBrickedVolumeAccumulator::vtkBrickedVolumeAccumulator()
+  : OutputScalarType(VTK_UNSIGNED_CHAR)
+  , BrickSize(32)
+  , CompoundingMode(MAXIMUM_COMPOUNDING)
+  , ScratchFileName(nullptr)
+{
+  for (int i = 0; i < 3; ++i)
+  {
+    this->OutputExtent[2 * i] = 0;
+    this->OutputExtent[2 * i + 1] = -1;
+    this->OutputOrigin[i] = 0.0;
+    this->OutputSpacing[i] = 1.0;
+    this->PastedExtent[2 * i] = 0;
+    this->PastedExtent[2 * i + 1] = -1;
+  }
+  this->ClipRectangleOrigin[0] = 0;
+  this->ClipRectangleOrigin[1] = 0;
+  this->ClipRectangleSize[0] = 0;
+  this->ClipRectangleSize[1] = 0;
+}
+
+//---------------------------------------------------------------------------
+vtkBrickedVolumeAccumulator::~vtkBrickedVolumeAccumulator()
+{
+  this->Reset();
+  this->SetScratchFileName(nullptr);
+}
+
+//---------------------------------------------------------------------------
+void vtkBrickedVolumeAccumulator::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "OutputExtent: " << this->OutputExtent[0] << " " << this->OutputExtent[1] << " " << this->OutputExtent[2] << " "
+    << this->OutputExtent[3] << " " << this->OutputExtent[4] << " " << this->OutputExtent[5] << std::endl;
+  os << indent << "OutputOrigin: " << this->OutputOrigin[0] << " " << this->OutputOrigin[1] << " " << this->OutputOrigin[2] << std::endl;
+  os << indent << "OutputSpacing: " << this->OutputSpacing[0] << " " << this->OutputSpacing[1] << " " << this->OutputSpacing[2] << std::endl;
+  os << indent << "OutputScalarType: " << this->OutputScalarType << std::endl;
+  os << indent << "BrickSize: " << this->BrickSize << std::endl;
+  os << indent << "CompoundingMode: " << this->CompoundingMode << std::endl;
+  os << indent << "ScratchFileName: " << (this->ScratchFileName ? this->ScratchFileName : "(none)") << std::endl;
+  os << indent << "NumberOfAllocatedBricks: " << this->Bricks.size() << std::endl;
+}
+
+//---------------------------------------------------------------------------
+void vtkBrickedVolumeAccumulator::SetBrickSize(int brickSize)
+{
+  brickSize = std::max(brickSize, 1);
+  if (brickSize == this->BrickSize)
+  {
+    return;
+  }
+  this->BrickSize = brickSize;
+  this->Reset();
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+void vtkBrickedVolumeAccumulator::Reset()
+{
+  this->Bricks.clear();
+  this->ScratchFile.reset();
+  for (int i = 0; i < 3; ++i)
+  {
+    this->PastedExtent[2 * i] = 0;
+    this->PastedExtent[2 * i + 1] = -1;
+  }
+}
+
+//---------------------------------------------------------------------------
+int64_t vtkBrickedVolumeAccumulator::GetBrickKey(int brickI, int brickJ, int brickK)
+{
+  return (static_cast<int64_t>(brickI) << (2 * BRICK_INDEX_BITS)) | (static_cast<int64_t>(brickJ) << BRICK_INDEX_BITS) | static_cast<int64_t>(brickK);
+}
+
+//---------------------------------------------------------------------------
+vtkBrickedVolumeAccumulator::Brick* vtkBrickedVolumeAccumulator::GetBrick(int brickI, int brickJ, int brickK)
+{
+  auto brickIt = this->Bricks.find(this->GetBrickKey(brickI, brickJ, brickK));
+  return brickIt != this->Bricks.end() ? brickIt->second.get() : nullptr;
+}
+
+//---------------------------------------------------------------------------
+vtkBrickedVolumeAccumulator::Brick* vtkBrickedVolumeAccumulator::GetOrCreateBrick(int brickI, int brickJ, int brickK)
+{
+  std::unique_ptr<Brick>& brick = this->Bricks[this->GetBrickKey(brickI, brickJ, brickK)];
+  if (!brick)
+  {
+    size_t numberOfVoxels = static_cast<size_t>(this->BrickSize) * this->BrickSize * this->BrickSize;
+    brick.reset(new Brick);
+    if (this->ScratchFile)
+    {
+      // Bricks are stored in the file in I, J, K brick order
+      int numberOfBricks[3] = { 0, 0, 0 };
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        numberOfBricks[axis] = (this->OutputExtent[2 * axis + 1] - this->OutputExtent[2 * axis]) / this->BrickSize + 1;
+      }
+      size_t brickOffset = ((static_cast<size_t>(brickK) * numberOfBricks[1] + brickJ) * numberOfBricks[0] + brickI) * this->GetBrickStrideBytes();
+      char* brickData = this->ScratchFile->Data + brickOffset;
+      brick->Values = reinterpret_cast<float*>(brickData);
+      brick->Counts = reinterpret_cast<uint16_t*>(brickData + numberOfVoxels * sizeof(float));
+    }
+    else
+    {
+      brick->ValuesBuffer.resize(numberOfVoxels, 0.0f);
+      brick->CountsBuffer.resize(numberOfVoxels, 0);
+      brick->Values = brick->ValuesBuffer.data();
+      brick->Counts = brick->CountsBuffer.data();
+    }
+  }
+  return brick.get();
+}
+
+//---------------------------------------------------------------------------
+size_t vtkBrickedVolumeAccumulator::GetBrickStrideBytes()
+{
+  size_t numberOfVoxels = static_cast<size_t>(this->BrickSize) * this->BrickSize * this->BrickSize;
+  size_t brickBytes = numberOfVoxels * (sizeof(float) + sizeof(uint16_t));
+  return (brickBytes + SCRATCH_BRICK_ALIGNMENT - 1) / SCRATCH_BRICK_ALIGNMENT * SCRATCH_BRICK_ALIGNMENT;
+}
+
+//---------------------------------------------------------------------------
+bool vtkBrickedVolumeAccumulator::OpenScratchFile()
+{
+  size_t numberOfBricks = 1;
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    numberOfBricks *= static_cast<size_t>((this->OutputExtent[2 * axis + 1] - this->OutputExtent[2 * axis]) / this->BrickSize + 1);
+  }
+
+  // Existing bricks would point to released memory
+  this->Bricks.clear();
+  this->ScratchFile.reset(new ScratchFileMapping);
+  if (!this->ScratchFile->Open(this->ScratchFileName, numberOfBricks * this->GetBrickStrideBytes()))
+  {
+    vtkErrorMacro("OpenScratchFile: Failed to create memory-mapped scratch file " << this->ScratchFileName
+      << " (" << numberOfBricks * this->GetBrickStrideBytes() << " bytes)");
+    this->ScratchFile.reset();
+    return false;
+  }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+template <class T>
+void vtkBrickedVolumeAccumulator::PasteImagePixels(const T* scalars, const vtkIdType increments[3], const int pasteExtent[6],
+  const double imageToVoxel[3][4], int modifiedExtent[6])
+{
+  const int* outputExtent = this->OutputExtent;
+  const int brickSize = this->BrickSize;
+  const int compoundingMode = this->CompoundingMode;
+  Brick* lastBrick = nullptr;
+  int lastBrickIndex[3] = { -1, -1, -1 };
+
+  for (int k = pasteExtent[4]; k <= pasteExtent[5]; ++k)
+  {
+    for (int j = pasteExtent[2]; j <= pasteExtent[3]; ++j)
+    {
+      // Voxel position of the first pixel of the row, it changes by the first column of the matrix for each pixel
+      double position[3] = { 0.0, 0.0, 0.0 };
+      for (int row = 0; row < 3; ++row)
+      {
+        position[row] = imageToVoxel[row][0] * pasteExtent[0] + imageToVoxel[row][1] * j + imageToVoxel[row][2] * k + imageToVoxel[row][3];
+      }
+      const T* pixel = scalars + (j - pasteExtent[2]) * increments[1] + (k - pasteExtent[4]) * increments[2];
+      for (int i = pasteExtent[0]; i <= pasteExtent[1]; ++i, pixel += increments[0])
+      {
+        int voxel[3] = { 0, 0, 0 };
+        bool inside = true;
+        for (int row = 0; row < 3; ++row)
+        {
+          voxel[row] = static_cast<int>(std::floor(position[row] + 0.5));
+          position[row] += imageToVoxel[row][0];
+          if (voxel[row] < outputExtent[2 * row] || voxel[row] > outputExtent[2 * row + 1])
+          {
+            inside = false;
+          }
+        }
+        if (!inside)
+        {
+          continue;
+        }
+
+        int brickIndex[3] = { 0, 0, 0 };
+        int voxelInBrick[3] = { 0, 0, 0 };
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          brickIndex[axis] = (voxel[axis] - outputExtent[2 * axis]) / brickSize;
+          voxelInBrick[axis] = (voxel[axis] - outputExtent[2 * axis]) % brickSize;
+        }
+        if (!lastBrick || brickIndex[0] != lastBrickIndex[0] || brickIndex[1] != lastBrickIndex[1] || brickIndex[2] != lastBrickIndex[2])
+        {
+          lastBrick = this->GetOrCreateBrick(brickIndex[0], brickIndex[1], brickIndex[2]);
+          std::copy(brickIndex, brickIndex + 3, lastBrickIndex);
+        }
+
+        size_t voxelIndex = (static_cast<size_t>(voxelInBrick[2]) * brickSize + voxelInBrick[1]) * brickSize + voxelInBrick[0];
+        float value = static_cast<float>(*pixel);
+        float& voxelValue = lastBrick->Values[voxelIndex];
+        uint16_t& voxelCount = lastBrick->Counts[voxelIndex];
+        switch (compoundingMode)
+        {
+        case LATEST_COMPOUNDING:
+          voxelValue = value;
+          break;
+        case MAXIMUM_COMPOUNDING:
+          if (voxelCount == 0 || value > voxelValue)
+          {
+            voxelValue = value;
+          }
+          break;
+        default:
+          if (voxelCount == std::numeric_limits<uint16_t>::max())
+          {
+            // The mean does not change noticeably after so many values
+            continue;
+          }
+          voxelValue += value;
+          break;
+        }
+        if (voxelCount < std::numeric_limits<uint16_t>::max())
+        {
+          ++voxelCount;
+        }
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          modifiedExtent[2 * axis] = std::min(modifiedExtent[2 * axis], voxel[axis]);
+          modifiedExtent[2 * axis + 1] = std::max(modifiedExtent[2 * axis + 1], voxel[axis]);
+        }
+      }
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+bool vtkBrickedVolumeAccumulator::AddImage(vtkImageData* image, vtkMatrix4x4* imageToReferenceMatrix, int modifiedExtent[6]/*=nullptr*/)
+{
+  if (!image || !imageToReferenceMatrix || !image->GetPointData() || !image->GetPointData()->GetScalars())
+  {
+    vtkErrorMacro("AddImage: Invalid input image");
+    return false;
+  }
+  if (this->OutputExtent[0] > this->OutputExtent[1] || this->OutputExtent[2] > this->OutputExtent[3] || this->OutputExtent[4] > this->OutputExtent[5])
+  {
+    vtkErrorMacro("AddImage: Invalid output extent");
+    return false;
+  }
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    // Brick indices would overflow their bits in the brick key, and different bricks would share a key
+    long long numberOfBricks = (static_cast<long long>(this->OutputExtent[2 * axis + 1]) - this->OutputExtent[2 * axis]) / this->BrickSize + 1;
+    if (numberOfBricks >= (1LL << BRICK_INDEX_BITS))
+    {
+      vtkErrorMacro("AddImage: Output extent is too large, " << numberOfBricks << " bricks along axis " << axis
+        << " (maximum is " << (1LL << BRICK_INDEX_BITS) - 1 << "), increase the brick size or the output spacing");
+      return false;
+    }
+  }
+
+  // Region of the image that is pasted
+  int pasteExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  image->GetExtent(pasteExtent);
+  for (int axis = 0; axis < 2; ++axis)
+  {
+    if (this->ClipRectangleSize[axis] > 0)
+    {
+      int clipMin = pasteExtent[2 * axis] + this->ClipRectangleOrigin[axis];
+      int clipMax = clipMin + this->ClipRectangleSize[axis] - 1;
+      pasteExtent[2 * axis] = std::max(pasteExtent[2 * axis], clipMin);
+      pasteExtent[2 * axis + 1] = std::min(pasteExtent[2 * axis + 1], clipMax);
+    }
+  }
+  if (pasteExtent[0] > pasteExtent[1] || pasteExtent[2] > pasteExtent[3] || pasteExtent[4] > pasteExtent[5])
+  {
+    return true;
+  }
+
+  // Image IJK to output voxel coordinates
+  double imageToVoxel[3][4];
+  for (int row = 0; row < 3; ++row)
+  {
+    for (int column = 0; column < 4; ++column)
+    {
+      imageToVoxel[row][column] = imageToReferenceMatrix->GetElement(row, column) / this->OutputSpacing[row];
+    }
+    imageToVoxel[row][3] -= this->OutputOrigin[row] / this->OutputSpacing[row];
+  }
+
+  if (this->ScratchFileName && this->ScratchFileName[0] != '\0' && !this->ScratchFile && !this->OpenScratchFile())
+  {
+    return false;
+  }
+
+  int frameModifiedExtent[6] = { VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN };
+
+  // Only the first component is used
+  vtkIdType increments[3] = { 0, 0, 0 };
+  image->GetIncrements(increments);
+  void* scalars = image->GetScalarPointer(pasteExtent[0], pasteExtent[2], pasteExtent[4]);
+  switch (image->GetScalarType())
+  {
+    vtkTemplateAliasMacro(this->PasteImagePixels(static_cast<const VTK_TT*>(scalars), increments, pasteExtent, imageToVoxel, frameModifiedExtent));
+  default:
+    vtkErrorMacro("AddImage: Unsupported scalar type " << image->GetScalarType());
+    return false;
+  }
+
+  bool modified = frameModifiedExtent[0] <= frameModifiedExtent[1];
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    if (!modified)
+    {
+      frameModifiedExtent[2 * axis] = 0;
+      frameModifiedExtent[2 * axis + 1] = -1;
+    }
+    else if (this->PastedExtent[2 * axis] > this->PastedExtent[2 * axis + 1])
+    {
+      this->PastedExtent[2 * axis] = frameModifiedExtent[2 * axis];
+      this->PastedExtent[2 * axis + 1] = frameModifiedExtent[2 * axis + 1];
+    }
+    else
+    {
+      this->PastedExtent[2 * axis] = std::min(this->PastedExtent[2 * axis], frameModifiedExtent[2 * axis]);
+      this->PastedExtent[2 * axis + 1] = std::max(this->PastedExtent[2 * axis + 1], frameModifiedExtent[2 * axis + 1]);
+    }
+  }
+  if (modifiedExtent)
+  {
+    std::copy(frameModifiedExtent, frameModifiedExtent + 6, modifiedExtent);
+  }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void vtkBrickedVolumeAccumulator::GetPastedExtent(int extent[6])
+{
+  std::copy(this->PastedExtent, this->PastedExtent + 6, extent);
+}
+
+//---------------------------------------------------------------------------
+template <class T>
+void vtkBrickedVolumeAccumulator::CopyBrickVoxelsToImage(T* imageScalars, const vtkIdType imageIncrements[3], const int extent[6],
+  const int imageExtentOffset[3])
+{
+  const int* outputExtent = this->OutputExtent;
+  const int brickSize = this->BrickSize;
+
+  // Voxels that are not in any brick are empty
+  for (int k = extent[4]; k <= extent[5]; ++k)
+  {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+    {
+      T* row = imageScalars + (extent[0] - imageExtentOffset[0]) * imageIncrements[0]
+        + (j - imageExtentOffset[1]) * imageIncrements[1] + (k - imageExtentOffset[2]) * imageIncrements[2];
+      std::fill(row, row + (extent[1] - extent[0] + 1), static_cast<T>(0));
+    }
+  }
+
+  int firstBrick[3] = { 0, 0, 0 };
+  int lastBrick[3] = { 0, 0, 0 };
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    firstBrick[axis] = (extent[2 * axis] - outputExtent[2 * axis]) / brickSize;
+    lastBrick[axis] = (extent[2 * axis + 1] - outputExtent[2 * axis]) / brickSize;
+  }
+
+  for (int brickK = firstBrick[2]; brickK <= lastBrick[2]; ++brickK)
+  {
+    for (int brickJ = firstBrick[1]; brickJ <= lastBrick[1]; ++brickJ)
+    {
+      for (int brickI = firstBrick[0]; brickI <= lastBrick[0]; ++brickI)
+      {
+        Brick* brick = this->GetBrick(brickI, brickJ, brickK);
+        if (!brick)
+        {
+          continue;
+        }
+        // Intersection of the brick and the extent, in output voxel coordinates
+        int brickIndex[3] = { brickI, brickJ, brickK };
+        int copyExtent[6] = { 0, -1, 0, -1, 0, -1 };
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          int brickMin = outputExtent[2 * axis] + brickIndex[axis] * brickSize;
+          copyExtent[2 * axis] = std::max(extent[2 * axis], brickMin);
+          copyExtent[2 * axis + 1] = std::min(extent[2 * axis + 1], brickMin + brickSize - 1);
+        }
+
+        for (int k = copyExtent[4]; k <= copyExtent[5]; ++k)
+        {
+          for (int j = copyExtent[2]; j <= copyExtent[3]; ++j)
+          {
+            T* pixel = imageScalars + (copyExtent[0] - imageExtentOffset[0]) * imageIncrements[0]
+              + (j - imageExtentOffset[1]) * imageIncrements[1] + (k - imageExtentOffset[2]) * imageIncrements[2];
+            size_t voxelIndex = (static_cast<size_t>((k - outputExtent[4]) % brickSize) * brickSize
+              + (j - outputExtent[2]) % brickSize) * brickSize + (copyExtent[0] - outputExtent[0]) % brickSize;
+            for (int i = copyExtent[0]; i <= copyExtent[1]; ++i, ++voxelIndex, pixel += imageIncrements[0])
+            {
+              uint16_t count = brick->Counts[voxelIndex];
+              if (count == 0)
+              {
+                continue;
+              }
+              double value = brick->Values[voxelIndex];
+              if (this->CompoundingMode == MEAN_COMPOUNDING)
+              {
+                value /= count;
+              }
+              *pixel = CastVoxelValue<T>(value);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkBrickedVolumeAccumulator::CopyToImage(vtkImageData* image, const int extent[6], const int imageExtentOffset[3])
+{
+  vtkIdType increments[3] = { 0, 0, 0 };
+  image->GetIncrements(increments);
+  int imageExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  image->GetExtent(imageExtent);
+  void* scalars = image->GetScalarPointer(imageExtent[0], imageExtent[2], imageExtent[4]);
+  switch (image->GetScalarType())
+  {
+    vtkTemplateAliasMacro(this->CopyBrickVoxelsToImage(static_cast<VTK_TT*>(scalars), increments, extent, imageExtentOffset));
+  default:
+    vtkErrorMacro("CopyToImage: Unsupported scalar type " << image->GetScalarType());
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkBrickedVolumeAccumulator::GetOutputVolumeExtent(bool cropToPastedExtent, int extent[6])
+{
+  std::copy(this->OutputExtent, this->OutputExtent + 6, extent);
+  if (cropToPastedExtent && this->PastedExtent[0] <= this->PastedExtent[1])
+  {
+    std::copy(this->PastedExtent, this->PastedExtent + 6, extent);
+  }
+}
+
+//---------------------------------------------------------------------------
+bool vtkBrickedVolumeAccumulator::GetOutputVolume(vtkImageData* outputImage, bool cropToPastedExtent)
+{
+  if (!outputImage)
+  {
+    vtkErrorMacro("GetOutputVolume: Invalid output image");
+    return false;
+  }
+
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  this->GetOutputVolumeExtent(cropToPastedExtent, extent);
+  if (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5])
+  {
+    vtkErrorMacro("GetOutputVolume: Invalid output extent");
+    return false;
+  }
+
+  int imageExtentOffset[3] = { extent[0], extent[2], extent[4] };
+  outputImage->SetExtent(0, extent[1] - extent[0], 0, extent[3] - extent[2], 0, extent[5] - extent[4]);
+  outputImage->SetSpacing(this->OutputSpacing);
+  outputImage->SetOrigin(
+    this->OutputOrigin[0] + extent[0] * this->OutputSpacing[0],
+    this->OutputOrigin[1] + extent[2] * this->OutputSpacing[1],
+    this->OutputOrigin[2] + extent[4] * this->OutputSpacing[2]);
+  outputImage->AllocateScalars(this->OutputScalarType, 1);
+  this->CopyToImage(outputImage, extent, imageExtentOffset);
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool vtkBrickedVolumeAccumulator::UpdateOutputVolumeRegion(vtkImageData* outputImage, const int extent[6], bool cropToPastedExtent/*=false*/)
+{
+  int dimensions[3] = { 0, 0, 0 };
+  if (!outputImage || !outputImage->GetPointData()->GetScalars() || outputImage->GetScalarType() != this->OutputScalarType)
+  {
+    return false;
+  }
+  outputImage->GetDimensions(dimensions);
+  int imageVolumeExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  this->GetOutputVolumeExtent(cropToPastedExtent, imageVolumeExtent);
+  int regionExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    if (dimensions[axis] != imageVolumeExtent[2 * axis + 1] - imageVolumeExtent[2 * axis] + 1)
+    {
+      // The image does not cover the same voxels (e.g., the pasted extent has grown since the cropped image was created)
+      return false;
+    }
+    regionExtent[2 * axis] = std::max(extent[2 * axis], imageVolumeExtent[2 * axis]);
+    regionExtent[2 * axis + 1] = std::min(extent[2 * axis + 1], imageVolumeExtent[2 * axis + 1]);
+    if (regionExtent[2 * axis] > regionExtent[2 * axis + 1])
+    {
+      return true;
+    }
+  }
+
+  int imageExtentOffset[3] = { imageVolumeExtent[0], imageVolumeExtent[2], imageVolumeExtent[4] };
+  this->CopyToImage(outputImage, regionExtent, imageExtentOffset);
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool vtkBrickedVolumeAccumulator::WriteNrrdFile(const char* fileName, bool cropToPastedExtent, vtkMatrix4x4* referenceToSpaceMatrix/*=nullptr*/)
+{
+  if (!fileName)
+  {
+    vtkErrorMacro("WriteNrrdFile: Invalid file name");
+    return false;
+  }
+  const char* typeName = GetNrrdTypeName(this->OutputScalarType);
+  if (!typeName)
+  {
+    vtkErrorMacro("WriteNrrdFile: Unsupported scalar type " << this->OutputScalarType);
+    return false;
+  }
+
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  this->GetOutputVolumeExtent(cropToPastedExtent, extent);
+  if (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5])
+  {
+    vtkErrorMacro("WriteNrrdFile: Invalid output extent");
+    return false;
+  }
+
+  // Voxel to space: columns are the axis directions scaled by the spacing, the last column is the origin
+  vtkNew<vtkMatrix4x4> voxelToSpaceMatrix;
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    voxelToSpaceMatrix->SetElement(axis, axis, this->OutputSpacing[axis]);
+    voxelToSpaceMatrix->SetElement(axis, 3, this->OutputOrigin[axis] + extent[2 * axis] * this->OutputSpacing[axis]);
+  }
+  if (referenceToSpaceMatrix)
+  {
+    vtkMatrix4x4::Multiply4x4(referenceToSpaceMatrix, voxelToSpaceMatrix, voxelToSpaceMatrix);
+  }
+
+  vtksys::ofstream file(fileName, std::ios::out | std::ios::binary);
+  if (!file)
+  {
+    vtkErrorMacro("WriteNrrdFile: Failed to open file " << fileName);
+    return false;
+  }
+
+  // NRRD uses LPS coordinate system
+  const double rasToLps[3] = { -1.0, -1.0, 1.0 };
+  file.precision(17);
+  file << "NRRD0004\n";
+  file << "type: " << typeName << "\n";
+  file << "dimension: 3\n";
+  file << "space: left-posterior-superior\n";
+  file << "sizes: " << extent[1] - extent[0] + 1 << " " << extent[3] - extent[2] + 1 << " " << extent[5] - extent[4] + 1 << "\n";
+  file << "space directions:";
+  for (int column = 0; column < 3; ++column)
+  {
+    file << " (" << rasToLps[0] * voxelToSpaceMatrix->GetElement(0, column) << "," << rasToLps[1] * voxelToSpaceMatrix->GetElement(1, column)
+      << "," << rasToLps[2] * voxelToSpaceMatrix->GetElement(2, column) << ")";
+  }
+  file << "\n";
+  file << "kinds: domain domain domain\n";
+  const uint16_t endianTest = 1;
+  file << "endian: " << (*reinterpret_cast<const uint8_t*>(&endianTest) == 1 ? "little" : "big") << "\n";
+  file << "encoding: raw\n";
+  file << "space origin: (" << rasToLps[0] * voxelToSpaceMatrix->GetElement(0, 3) << "," << rasToLps[1] * voxelToSpaceMatrix->GetElement(1, 3)
+    << "," << rasToLps[2] * voxelToSpaceMatrix->GetElement(2, 3) << ")\n";
+  file << "\n";
+
+  // Only one slice is kept in memory
+  vtkNew<vtkImageData> slice;
+  slice->SetExtent(0, extent[1] - extent[0], 0, extent[3] - extent[2], 0, 0);
+  slice->AllocateScalars(this->OutputScalarType, 1);
+  std::streamsize sliceBytes = static_cast<std::streamsize>(slice->GetNumberOfPoints()) * slice->GetScalarSize();
+  for (int k = extent[4]; k <= extent[5]; ++k)
+  {
+    int sliceExtent[6] = { extent[0], extent[1], extent[2], extent[3], k, k };
+    int imageExtentOffset[3] = { extent[0], extent[2], k };
+    this->CopyToImage(slice, sliceExtent, imageExtentOffset);
+    file.write(static_cast<const char*>(slice->GetScalarPointer()), sliceBytes);
+    if (!file)
+    {
+      vtkErrorMacro("WriteNrrdFile: Failed to write file " << fileName);
+      return false;
+    }
+  }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkBrickedVolumeAccumulator::GetNumberOfAllocatedBricks()
+{
+  return static_cast<vtkIdType>(this->Bricks.size());
+}
+
+//---------------------------------------------------------------------------
+size_t vtkBrickedVolumeAccumulator::GetAllocatedMemoryBytes()
+{
+  if (this->ScratchFile)
+  {
+    return 0;
+  }
+  size_t voxelsPerBrick = static_cast<size_t>(this->BrickSize) * this->BrickSize * this->BrickSize;
+  return this->Bricks.size() * voxelsPerBrick * (sizeof(float) + sizeof(uint16_t));
+}
@@ -0,0 +1,177 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkBrickedVolumeAccumulator_h
+#define __vtkBrickedVolumeAccumulator_h
+
+#include "vtkSlicerVolumeReconstructionModuleLogicExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class vtkImageData;
+class vtkMatrix4x4;
+
+/// \ingroup Slicer_QtModules_VolumeReconstruction
+/// Sparse volume for compounding image slices. The volume is split into cubic bricks
+/// that are only allocated when a slice pixel is pasted into them, so a thin sweep in a large
+/// output extent only uses memory proportional to the swept region.
+/// Pixels are pasted into the nearest voxel (first component of the image only).
+/// The dense output image (full extent, or cropped to the pasted region) is only created on request.
+/// If a scratch file name is set then the bricks are stored in a memory-mapped file instead of in memory, in brick order,
+/// so that volumes that do not fit into memory can be reconstructed and written to a NRRD file.
+class VTK_SLICER_VOLUMERECONSTRUCTION_MODULE_LOGIC_EXPORT vtkBrickedVolumeAccumulator : public vtkObject
+{
+public:
+  static vtkBrickedVolumeAccumulator* New();
+  vtkTypeMacro(vtkBrickedVolumeAccumulator, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  enum CompoundingType
+  {
+    LATEST_COMPOUNDING,
+    MAXIMUM_COMPOUNDING,
+    MEAN_COMPOUNDING,
+  };
+
+  /// Geometry of the output volume in the reference coordinate system
+  vtkSetVector6Macro(OutputExtent, int);
+  vtkGetVector6Macro(OutputExtent, int);
+  vtkSetVector3Macro(OutputOrigin, double);
+  vtkGetVector3Macro(OutputOrigin, double);
+  vtkSetVector3Macro(OutputSpacing, double);
+  vtkGetVector3Macro(OutputSpacing, double);
+
+  /// Scalar type of the output image
+  vtkSetMacro(OutputScalarType, int);
+  vtkGetMacro(OutputScalarType, int);
+
+  /// Number of voxels along each side of a brick. Changing it resets the volume.
+  /// There can be at most 2^21-1 bricks along each axis of the output extent, images are not added to larger volumes.
+  void SetBrickSize(int brickSize);
+  vtkGetMacro(BrickSize, int);
+
+  vtkSetMacro(CompoundingMode, int);
+  vtkGetMacro(CompoundingMode, int);
+
+  /// Only pixels inside the clip rectangle are pasted (the whole image if the size is 0)
+  vtkSetVector2Macro(ClipRectangleOrigin, int);
+  vtkGetVector2Macro(ClipRectangleOrigin, int);
+  vtkSetVector2Macro(ClipRectangleSize, int);
+  vtkGetVector2Macro(ClipRectangleSize, int);
+
+  /// If set, the bricks are stored in a memory-mapped file at this path. The file is created when the first image is
+  /// added (space is reserved for all bricks of the output extent) and it is deleted by Reset() or when the object is destroyed.
+  /// Creating the file fails if it already exists, so the path must be unique across processes.
+  vtkSetStringMacro(ScratchFileName);
+  vtkGetStringMacro(ScratchFileName);
+
+  /// Remove all pasted data and release the bricks. Must be called after the output geometry is changed.
+  void Reset();
+
+  /// Paste an image into the volume.
+  /// The image to reference matrix transforms the IJK coordinates of the image to the reference coordinate system.
+  /// If modifiedExtent is specified then it is set to the extent of the voxels that were modified.
+  bool AddImage(vtkImageData* image, vtkMatrix4x4* imageToReferenceMatrix, int modifiedExtent[6] = nullptr);
+
+  /// Extent of all voxels that have been pasted into (empty if nothing has been pasted yet)
+  void GetPastedExtent(int extent[6]);
+
+  /// Create the dense output image. If cropToPastedExtent is true then the image only covers the voxels that
+  /// have been pasted into, otherwise the full output extent. The extent of the image starts at 0, the origin and
+  /// spacing are set so that the voxels are at the same position as in the output volume.
+  bool GetOutputVolume(vtkImageData* outputImage, bool cropToPastedExtent);
+
+  /// Update the voxels of an output image (created by GetOutputVolume with the same cropToPastedExtent) within an extent
+  /// of the output volume. Returns false if the image does not cover the same voxels anymore (e.g., the pasted extent
+  /// has grown since the cropped image was created), in which case the image has to be created again by GetOutputVolume.
+  bool UpdateOutputVolumeRegion(vtkImageData* outputImage, const int extent[6], bool cropToPastedExtent = false);
+
+  /// Write the volume to a NRRD file, one slice at a time, without creating the dense output image.
+  /// If referenceToSpaceMatrix is specified then voxel positions are transformed by it (e.g., ROI to RAS).
+  bool WriteNrrdFile(const char* fileName, bool cropToPastedExtent, vtkMatrix4x4* referenceToSpaceMatrix = nullptr);
+
+  /// Number of allocated bricks and the memory used by them (bricks stored in the scratch file are not included)
+  vtkIdType GetNumberOfAllocatedBricks();
+  size_t GetAllocatedMemoryBytes();
+
+protected:
+  vtkBrickedVolumeAccumulator();
+  ~vtkBrickedVolumeAccumulator() override;
+
+  struct Brick
+  {
+    // Compounded value (sum of the values for mean compounding)
+    float* Values{ nullptr };
+    // Number of pixels pasted into the voxel
+    uint16_t* Counts{ nullptr };
+    // Storage of the voxels if the brick is not in the scratch file
+    std::vector<float> ValuesBuffer;
+    std::vector<uint16_t> CountsBuffer;
+  };
+
+  struct ScratchFileMapping;
+
+  /// Create the memory-mapped scratch file with room for all bricks of the output extent
+  bool OpenScratchFile();
+  size_t GetBrickStrideBytes();
+
+  /// Get the brick that contains the voxel. The brick is created if it does not exist yet.
+  Brick* GetOrCreateBrick(int brickI, int brickJ, int brickK);
+  Brick* GetBrick(int brickI, int brickJ, int brickK);
+  int64_t GetBrickKey(int brickI, int brickJ, int brickK);
+
+  /// Extent of the output volume that is in the output image (the pasted extent if cropped)
+  void GetOutputVolumeExtent(bool cropToPastedExtent, int extent[6]);
+
+  /// Copy the voxels within the extent (in output volume voxel coordinates) into the image.
+  /// imageExtentOffset is the output volume voxel coordinate of the first voxel of the image.
+  void CopyToImage(vtkImageData* image, const int extent[6], const int imageExtentOffset[3]);
+
+  template <class T>
+  void PasteImagePixels(const T* scalars, const vtkIdType increments[3], const int pasteExtent[6],
+    const double imageToVoxel[3][4], int modifiedExtent[6]);
+  template <class T>
+  void CopyBrickVoxelsToImage(T* imageScalars, const vtkIdType imageIncrements[3], const int extent[6],
+    const int imageExtentOffset[3]);
+
+  int OutputExtent[6];
+  double OutputOrigin[3];
+  double OutputSpacing[3];
+  int OutputScalarType;
+  int BrickSize;
+  int CompoundingMode;
+  int ClipRectangleOrigin[2];
+  int ClipRectangleSize[2];
+
+  char* ScratchFileName;
+
+  std::unordered_map<int64_t, std::unique_ptr<Brick>> Bricks;
+  std::unique_ptr<ScratchFileMapping> ScratchFile;
+  int PastedExtent[6];
+
+private:
+  vtkBrickedVolumeAccumulator(const vtkBrickedVolumeAccumulator&); // Not implemented
+  void operator=(const vtkBrickedVolumeAccumulator&);               // Not implemented
+};
+
+#endif
@@ -24,6 +24,7 @@ Care Ontario.
 #include <vtkMRMLMarkupsROINode.h>
 #include <vtkMRMLScalarVolumeNode.h>
 #include <vtkMRMLScene.h>
+#include <vtkMRMLStreamingVolumeNode.h>
 #include <vtkMRMLVolumeNode.h>
 
 // Sequence MRML includes
@@ -40,32 +41,493 @@ Care Ontario.
 #include <vtkIGSIOPasteSliceIntoVolume.h>
 
 // vtkAddon includes
+#include <vtkStreamingVolumeCodec.h>
 #include <vtkStreamingVolumeCodecFactory.h>
 
 // VolumeReconstructor MRML includes
 #include "vtkMRMLVolumeReconstructionNode.h"
 
 // VolumeReconstruction Logic includes
+#include "vtkBrickedVolumeAccumulator.h"
 #include "vtkSlicerVolumeReconstructionLogic.h"
 
 // VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
 #include <vtkMatrix4x4.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
 #include <vtkTimerLog.h>
 #include <vtkTransform.h>
 #include <vtkSmartPointer.h>
 
+// STD includes
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h> // For _getpid
+#else
+#include <unistd.h> // For getpid
+#endif
+
 //---------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerVolumeReconstructionLogic);
 
+//---------------------------------------------------------------------------
+// Fixed capacity queue for passing items between threads.
+// Push blocks while the queue is full, Pop blocks while it is empty.
+template <typename T>
+class BoundedQueue
+{
+public:
+  BoundedQueue(size_t capacity)
+    : Capacity(std::max<size_t>(capacity, 1))
+  {
+  }
+
+  /// Returns false if the queue was closed, in which case the item is not added
+  bool Push(T&& item)
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    this->NotFull.wait(lock, [this] { return this->Closed || this->Items.size() < this->Capacity; });
+    if (this->Closed)
+    {
+      return false;
+    }
+    this->Items.push_back(std::move(item));
+    this->NotEmpty.notify_one();
+    return true;
+  }
+
+  /// Returns false if the queue is closed and there are no more items
+  bool Pop(T& item)
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    this->NotEmpty.wait(lock, [this] { return this->Closed || !this->Items.empty(); });
+    if (this->Items.empty())
+    {
+      return false;
+    }
+    item = std::move(this->Items.front());
+    this->Items.pop_front();
+    this->NotFull.notify_one();
+    return true;
+  }
+
+  /// Add the item if the queue is not full, without waiting. The item is only moved if it is added.
+  bool TryPush(T& item)
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    if (this->Closed || this->Items.size() >= this->Capacity)
+    {
+      return false;
+    }
+    this->Items.push_back(std::move(item));
+    this->NotEmpty.notify_one();
+    return true;
+  }
+
+  /// Remove the oldest item if the queue is not empty, without waiting
+  bool TryPop(T& item)
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    if (this->Items.empty())
+    {
+      return false;
+    }
+    item = std::move(this->Items.front());
+    this->Items.pop_front();
+    this->NotFull.notify_one();
+    return true;
+  }
+
+  size_t GetSize()
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    return this->Items.size();
+  }
+
+  bool IsFull()
+  {
+    return this->GetSize() >= this->Capacity;
+  }
+
+  /// No more items can be added. Items that are already in the queue can still be retrieved.
+  void Close()
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->Closed = true;
+    this->NotEmpty.notify_all();
+    this->NotFull.notify_all();
+  }
+
+private:
+  const size_t Capacity;
+  std::deque<T> Items;
+  bool Closed{false};
+  std::mutex Mutex;
+  std::condition_variable NotEmpty;
+  std::condition_variable NotFull;
+};
+
+//---------------------------------------------------------------------------
+// A frame that is being added to the reconstruction
+struct ReconstructionFrame
+{
+  int Index{-1};
+  // Empty if the image could not be read or its pose could not be computed
+  vtkSmartPointer<vtkImageData> Image;
+  // IJKToRAS after reading, ImageToROI after the pose is computed
+  vtkSmartPointer<vtkMatrix4x4> ImageToROIMatrix;
+};
+
+//---------------------------------------------------------------------------
+// Reads images and poses of the input volume directly from the sequences of a sequence browser,
+// without changing the selected item of the browser (and so without updating proxy nodes).
+// ReadImage and ApplyParentTransforms may be called from two different threads, but each of them
+// must only be called from one thread at a time, as they access different (non thread-safe) data nodes.
+class SequenceFrameSource
+{
+public:
+  /// Returns false if the volume or any of its parent transforms cannot be read from the sequences
+  bool Initialize(vtkMRMLSequenceBrowserNode* sequenceBrowserNode, vtkMRMLVolumeNode* proxyVolumeNode)
+  {
+    this->ParentTransforms.clear();
+    this->MasterSequence = sequenceBrowserNode ? sequenceBrowserNode->GetMasterSequenceNode() : nullptr;
+    this->ImageSequence = sequenceBrowserNode ? sequenceBrowserNode->GetSequenceNode(proxyVolumeNode) : nullptr;
+    if (!this->MasterSequence || !this->ImageSequence)
+    {
+      // The volume is not a proxy node of the browser
+      return false;
+    }
+
+    // Transforms that are proxy nodes of the browser are read from their sequence for each frame,
+    // other transforms are constant.
+    for (vtkMRMLTransformNode* transformNode = proxyVolumeNode->GetParentTransformNode(); transformNode; transformNode = transformNode->GetParentTransformNode())
+    {
+      ParentTransform parentTransform;
+      parentTransform.Sequence = sequenceBrowserNode->GetSequenceNode(transformNode);
+      if (!parentTransform.Sequence && !transformNode->GetMatrixTransformToParent(parentTransform.ToParentMatrix))
+      {
+        // Non-linear transforms are not supported
+        return false;
+      }
+      this->ParentTransforms.push_back(parentTransform);
+    }
+    return true;
+  }
+
+  int GetNumberOfFrames()
+  {
+    return this->MasterSequence ? this->MasterSequence->GetNumberOfDataNodes() : 0;
+  }
+
+  /// Get the image of the frame and its IJKToRAS matrix. Compressed frames are decoded.
+  /// Images that are already decoded are not copied.
+  bool ReadImage(int frameIndex, ReconstructionFrame& frame)
+  {
+    frame.Index = frameIndex;
+    frame.Image = nullptr;
+    vtkMRMLVolumeNode* frameVolumeNode = vtkMRMLVolumeNode::SafeDownCast(this->GetDataNode(this->ImageSequence, frameIndex));
+    if (!frameVolumeNode)
+    {
+      return false;
+    }
+
+    vtkMRMLStreamingVolumeNode* frameStreamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(frameVolumeNode);
+    if (frameStreamingVolumeNode && frameStreamingVolumeNode->GetFrame())
+    {
+      // Decode into a new image instead of calling GetImageData, which would keep the decoded image in the sequence
+      std::string codecFourCC = frameStreamingVolumeNode->GetCodecFourCC();
+      if (!this->Codec || codecFourCC != this->CodecFourCC)
+      {
+        this->Codec = vtkSmartPointer<vtkStreamingVolumeCodec>::Take(vtkStreamingVolumeCodecFactory::GetInstance()->CreateCodecByFourCC(codecFourCC));
+        this->CodecFourCC = codecFourCC;
+      }
+      if (!this->Codec)
+      {
+        return false;
+      }
+      vtkSmartPointer<vtkImageData> decodedImage = vtkSmartPointer<vtkImageData>::New();
+      if (!this->Codec->DecodeFrame(frameStreamingVolumeNode->GetFrame(), decodedImage))
+      {
+        return false;
+      }
+      frame.Image = decodedImage;
+    }
+    else
+    {
+      frame.Image = frameVolumeNode->GetImageData();
+    }
+    if (!frame.Image)
+    {
+      return false;
+    }
+
+    if (!frame.ImageToROIMatrix)
+    {
+      frame.ImageToROIMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    }
+    frameVolumeNode->GetIJKToRASMatrix(frame.ImageToROIMatrix);
+    return true;
+  }
+
+  /// Get the IJKToRAS matrix and extent of the frame, without reading or decoding the image
+  bool ReadImageGeometry(int frameIndex, vtkMatrix4x4* ijkToRASMatrix, int extent[6])
+  {
+    vtkMRMLVolumeNode* frameVolumeNode = vtkMRMLVolumeNode::SafeDownCast(this->GetDataNode(this->ImageSequence, frameIndex));
+    if (!frameVolumeNode)
+    {
+      return false;
+    }
+
+    vtkMRMLStreamingVolumeNode* frameStreamingVolumeNode = vtkMRMLStreamingVolumeNode::SafeDownCast(frameVolumeNode);
+    if (frameStreamingVolumeNode && frameStreamingVolumeNode->GetFrame())
+    {
+      int* dimensions = frameStreamingVolumeNode->GetFrame()->GetDimensions();
+      for (int i = 0; i < 3; ++i)
+      {
+        extent[2 * i] = 0;
+        extent[2 * i + 1] = dimensions[i] - 1;
+      }
+    }
+    else if (frameVolumeNode->GetImageData())
+    {
+      frameVolumeNode->GetImageData()->GetExtent(extent);
+    }
+    else
+    {
+      return false;
+    }
+    frameVolumeNode->GetIJKToRASMatrix(ijkToRASMatrix);
+    return true;
+  }
+
+  /// Transform the matrix from the coordinate system of the volume node to world coordinates,
+  /// using the parent transforms at the frame.
+  bool ApplyParentTransforms(int frameIndex, vtkMatrix4x4* matrix)
+  {
+    for (ParentTransform& parentTransform : this->ParentTransforms)
+    {
+      vtkMatrix4x4* toParentMatrix = parentTransform.ToParentMatrix;
+      if (parentTransform.Sequence)
+      {
+        vtkMRMLTransformNode* frameTransformNode = vtkMRMLTransformNode::SafeDownCast(this->GetDataNode(parentTransform.Sequence, frameIndex));
+        if (!frameTransformNode || !frameTransformNode->GetMatrixTransformToParent(this->FrameToParentMatrix))
+        {
+          return false;
+        }
+        toParentMatrix = this->FrameToParentMatrix;
+      }
+      vtkMatrix4x4::Multiply4x4(toParentMatrix, matrix, matrix);
+    }
+    return true;
+  }
+
+private:
+  vtkMRMLNode* GetDataNode(vtkMRMLSequenceNode* sequenceNode, int frameIndex)
+  {
+    if (sequenceNode == this->MasterSequence)
+    {
+      return sequenceNode->GetNthDataNode(frameIndex);
+    }
+    return sequenceNode->GetDataNodeAtValue(this->MasterSequence->GetNthIndexValue(frameIndex), false);
+  }
+
+  struct ParentTransform
+  {
+    vtkMRMLSequenceNode* Sequence{nullptr};
+    vtkSmartPointer<vtkMatrix4x4> ToParentMatrix{vtkSmartPointer<vtkMatrix4x4>::New()};
+  };
+
+  vtkMRMLSequenceNode* MasterSequence{nullptr};
+  vtkMRMLSequenceNode* ImageSequence{nullptr};
+  // From the volume towards world
+  std::vector<ParentTransform> ParentTransforms;
+  vtkNew<vtkMatrix4x4> FrameToParentMatrix;
+  vtkSmartPointer<vtkStreamingVolumeCodec> Codec;
+  std::string CodecFourCC;
+};
+
+//---------------------------------------------------------------------------
+// Computes the bounding box of each frame in the ROI coordinate system, and the union of them.
+// Each frame is an image box (center and half size, in IJK) and its ImageToROI matrix. The bounds of the
+// transformed box are computed directly from the absolute values of the matrix elements instead of transforming
+// the 8 corners. Used with vtkSMPTools: each thread keeps its own bounds, which are combined in Reduce().
+class SequenceFrameBoundsFunctor
+{
+public:
+  // inputs, shared between the threads (read only)
+  // 12 values per frame: first three rows of ImageToROI matrix
+  const std::vector<double>* FrameImageToROIMatrices{nullptr};
+  // 6 values per frame: box center and half size in IJK coordinates
+  const std::vector<double>* FrameImageBoxes{nullptr};
+
+  // outputs
+  // 6 values per frame: bounds of the frame in ROI coordinates, written by the thread that processes the frame
+  std::vector<double>* FrameBounds{nullptr};
+  // union of all frame bounds, valid after Reduce()
+  double Bounds[6]{ VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN };
+
+  void Initialize()
+  {
+    std::array<double, 6>& bounds = this->ThreadBounds.Local();
+    bounds = { VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN };
+  }
+
+  void operator()(vtkIdType beginFrameIndex, vtkIdType endFrameIndex)
+  {
+    std::array<double, 6>& bounds = this->ThreadBounds.Local();
+    for (vtkIdType frameIndex = beginFrameIndex; frameIndex < endFrameIndex; ++frameIndex)
+    {
+      const double* m = this->FrameImageToROIMatrices->data() + 12 * frameIndex;
+      const double* box = this->FrameImageBoxes->data() + 6 * frameIndex;
+      double* frameBounds = this->FrameBounds->data() + 6 * frameIndex;
+      for (int row = 0; row < 3; ++row)
+      {
+        const double* r = m + 4 * row;
+        double center = r[0] * box[0] + r[1] * box[1] + r[2] * box[2] + r[3];
+        double halfSize = std::abs(r[0]) * box[3] + std::abs(r[1]) * box[4] + std::abs(r[2]) * box[5];
+        frameBounds[2 * row] = center - halfSize;
+        frameBounds[2 * row + 1] = center + halfSize;
+        bounds[2 * row] = std::min(bounds[2 * row], center - halfSize);
+        bounds[2 * row + 1] = std::max(bounds[2 * row + 1], center + halfSize);
+      }
+    }
+  }
+
+  void Reduce()
+  {
+    for (const std::array<double, 6>& bounds : this->ThreadBounds)
+    {
+      for (int i = 0; i < 3; ++i)
+      {
+        this->Bounds[2 * i] = std::min(this->Bounds[2 * i], bounds[2 * i]);
+        this->Bounds[2 * i + 1] = std::max(this->Bounds[2 * i + 1], bounds[2 * i + 1]);
+      }
+    }
+  }
+
+private:
+  vtkSMPThreadLocal<std::array<double, 6>> ThreadBounds;
+};
+
+//---------------------------------------------------------------------------
+// Pastes the frames of live reconstruction into the volume on a background thread
+struct LiveReconstructionWorker
+{
+  LiveReconstructionWorker(size_t queueSize, bool keepAllFrames)
+    : Frames(queueSize)
+    , KeepAllFrames(keepAllFrames)
+  {
+  }
+
+  BoundedQueue<ReconstructionFrame> Frames;
+  // If set, no frames are dropped: if the queue is full then the new frame waits until there is space for it
+  const bool KeepAllFrames;
+  std::thread Thread;
+
+  // Updated by the worker thread
+  std::atomic<int> NumberOfPastedFrames{0};
+  std::atomic<double> LastPasteTimeSeconds{0.0};
+
+  // Only accessed from the main thread
+  int NumberOfReceivedFrames{0};
+  int NumberOfDroppedFrames{0};
+};
+
 struct ReconstructionInfo
 {
   vtkSmartPointer<vtkIGSIOVolumeReconstructor> Reconstructor{nullptr};
   double LastUpdateTimeSeconds{0.0};
+
+  // Reused for every frame that is added to the reconstruction, to avoid per-frame allocations.
+  // The tracked frame image shares the pixel buffer of the input image (no copy).
+  std::shared_ptr<igsioTrackedFrame> TrackedFrame{std::make_shared<igsioTrackedFrame>()};
+  vtkSmartPointer<vtkIGSIOTransformRepository> TransformRepository{vtkSmartPointer<vtkIGSIOTransformRepository>::New()};
+  vtkSmartPointer<vtkMatrix4x4> ImageToROIMatrix{vtkSmartPointer<vtkMatrix4x4>::New()};
+
+  // Geometry of the output volume, set when the reconstruction is started
+  double OutputOrigin[3]{ 0.0, 0.0, 0.0 };
+  double OutputSpacing[3]{ 1.0, 1.0, 1.0 };
+  int OutputExtent[6]{ 0, -1, 0, -1, 0, -1 };
+
+  // Region of the output volume that may have changed since the output volume node was last updated (empty if unchanged)
+  int DirtyExtent[6]{ 0, -1, 0, -1, 0, -1 };
+  // If set, the whole output volume node has to be updated (including its geometry), because a new reconstruction was started
+  // since the output volume node was last updated. Voxels of the previous reconstruction must not remain in the output.
+  bool NeedsFullUpdate{true};
+  // Full reconstructed volume, retrieved from the reconstructor before the dirty region is copied to the output volume node
+  vtkSmartPointer<vtkImageData> ReconstructedVolumeBuffer{vtkSmartPointer<vtkImageData>::New()};
+
+  // If set, this volume is the result of the reconstruction (e.g., stitched from slabs) instead of the volume of the reconstructor
+  vtkSmartPointer<vtkImageData> StitchedVolume;
+
+  // If set, frames are pasted into this sparse volume instead of the reconstructor
+  vtkSmartPointer<vtkBrickedVolumeAccumulator> SparseAccumulator;
+  bool CropOutputVolume{false};
+
+  // Held while the reconstructor or the dirty extent is accessed, as frames may be pasted on a background thread
+  std::shared_ptr<std::mutex> ReconstructorMutex{std::make_shared<std::mutex>()};
+  // Only set while live reconstruction is in progress
+  std::shared_ptr<LiveReconstructionWorker> LiveWorker;
+
+  // Pose of the last frame that was not skipped because of too small pose change (not set if no frame was accepted yet)
+  vtkSmartPointer<vtkMatrix4x4> LastAcceptedImageToROIMatrix;
+  int NumberOfSkippedFrames{0};
+
+  // Coarse reconstruction that is shown in the output volume during live reconstruction, while the frames are
+  // pasted into the full resolution reconstruction on the live worker thread. Only set while live reconstruction is in progress.
+  std::shared_ptr<ReconstructionInfo> Preview;
 };
 
 typedef std::map<vtkMRMLVolumeReconstructionNode*, ReconstructionInfo> VolumeReconstuctorMap;
 
+//---------------------------------------------------------------------------
+// A slab of the output volume along its largest axis, reconstructed by its own reconstructor on its own thread
+struct ReconstructionSlab
+{
+  ReconstructionSlab(size_t queueSize)
+    : Frames(queueSize)
+  {
+  }
+
+  // Geometry of the slab volume, including the overlap with the neighboring slabs
+  ReconstructionInfo Info;
+  // Axis of the output volume that is split into slabs
+  int SlabAxis{0};
+  // Voxels of the output volume along the slab axis that are taken from this slab when the slabs are stitched
+  int FirstOutputVoxel{0};
+  int LastOutputVoxel{-1};
+  // First voxel of the slab volume along the slab axis, in output volume voxel coordinates
+  int SlabStartOutputVoxel{0};
+
+  BoundedQueue<ReconstructionFrame> Frames;
+  std::thread Thread;
+  // Only accessed from the slab thread until it is joined
+  int NumberOfPastedFrames{0};
+};
+
+// Overlap between slabs if holes are filled, so that hole filling has the same neighborhood at slab boundaries
+const int SLAB_HOLE_FILLING_OVERLAP_VOXELS = 8;
+
+// Rotation angles below this are considered as no rotation. The angle computed by acos from nearly identical
+// orientations is not exactly 0 (e.g., about 1e-6 degrees because of rounding errors).
+const double POSE_CHANGE_ROTATION_TOLERANCE_DEG = 1e-3;
+
 //---------------------------------------------------------------------------
 class vtkSlicerVolumeReconstructionLogic::vtkInternal
 {
@@ -77,6 +539,68 @@ public:
   vtkSlicerVolumeReconstructionLogic* External;
 
   VolumeReconstuctorMap Reconstructors;
+
+  /// Compute the transform from the IJK coordinates of the input volume to the coordinate system of the ROI
+  static bool GetImageToROIMatrix(vtkMRMLVolumeNode* inputVolumeNode, vtkMRMLNode* inputROINode, vtkMatrix4x4* imageToROIMatrix);
+
+  /// Compute the transform from world (RAS) coordinates to the coordinate system of the ROI
+  static bool GetWorldToROIMatrix(vtkMRMLNode* inputROINode, vtkMatrix4x4* worldToROIMatrix);
+
+  /// Compute the bounds of all frames of the sequence in the coordinate system of the ROI, reading the geometry and the
+  /// transforms directly from the sequences. If outlierPercentile is positive then on each side the bound is the
+  /// percentile of the frame bounds instead of the extreme value, so that a few frames with invalid pose are ignored.
+  /// Returns false if the volume or any of its parent transforms cannot be read from the sequences.
+  static bool GetSequenceBoundsInROI(vtkMRMLSequenceBrowserNode* sequenceBrowserNode, vtkMRMLVolumeNode* proxyVolumeNode,
+    vtkMRMLNode* roiNode, double outlierPercentile, double roiBounds[6]);
+
+  /// Extend the dirty extent of the reconstruction with the region of the output volume that the image may modify
+  static void ExtendDirtyExtent(ReconstructionInfo& info, vtkImageData* imageData, vtkMatrix4x4* imageToROIMatrix);
+  /// Get the region of the output volume that the image may modify. Returns false if the image is outside of the output volume.
+  static bool GetFrameFootprintExtent(ReconstructionInfo& info, vtkImageData* imageData, vtkMatrix4x4* imageToROIMatrix, int frameExtent[6]);
+  static void MergeDirtyExtent(ReconstructionInfo& info, const int extent[6]);
+
+  /// Set the output geometry and the reconstruction parameters of the node in the reconstructor and reset it
+  static void ConfigureReconstructor(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode, vtkIGSIOVolumeReconstructor* reconstructor,
+    int outputExtent[6], double outputOrigin[3], double outputSpacing[3], int numberOfThreads);
+
+  /// Returns true if the frame pose differs from the pose of the last accepted frame by less than the pose change thresholds of
+  /// the node, in which case the frame would paste into the same voxels and it should be skipped. The info is not modified.
+  static bool IsFramePoseRedundant(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode, const ReconstructionInfo& info, vtkMatrix4x4* imageToROIMatrix);
+
+  /// Store the pose of a frame that was pasted (or queued for pasting), the pose of the next frames is compared to it
+  static void SetLastAcceptedFramePose(ReconstructionInfo& info, vtkMatrix4x4* imageToROIMatrix);
+
+  /// Paste an image into the reconstructed volume. The image is not copied.
+  static bool AddImageToReconstruction(ReconstructionInfo& info, vtkImageData* imageData, vtkMatrix4x4* imageToROIMatrix,
+    bool isFirst, bool isLast);
+
+  /// Split the output volume into slabs along its largest axis and start a pasting thread for each slab
+  static void StartSlabReconstructions(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode, ReconstructionInfo& info,
+    int numberOfSlabs, size_t queueSize, std::vector<std::unique_ptr<ReconstructionSlab>>& slabs);
+
+  /// Queue the frame for all slabs that the frame may modify. Returns false if the frame is outside of all slabs.
+  static bool DispatchFrameToSlabs(std::vector<std::unique_ptr<ReconstructionSlab>>& slabs, const ReconstructionFrame& frame);
+
+  /// Wait until all slabs are reconstructed and copy them into the stitched volume of the reconstruction
+  static void StitchSlabReconstructions(ReconstructionInfo& info, std::vector<std::unique_ptr<ReconstructionSlab>>& slabs);
+
+  /// Start the background thread that pastes the frames of live reconstruction
+  static void StartLiveWorker(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode, ReconstructionInfo& info);
+
+  /// Create the coarse preview reconstruction if it is enabled in the node, with the same ROI as the full resolution reconstruction
+  static void StartLivePreview(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode, ReconstructionInfo& info);
+
+  /// The reconstruction that is shown in the output volume: the preview during live reconstruction with preview, otherwise the full resolution
+  static ReconstructionInfo& GetDisplayedReconstruction(ReconstructionInfo& info);
+
+  /// Paste all frames that are already in the queue and stop the background thread
+  static void StopLiveWorker(ReconstructionInfo& info);
+
+  /// Copy the current input volume and add it to the queue of the live worker, dropping frames according to the drop policy
+  static bool EnqueueLiveFrame(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode, ReconstructionInfo& info);
+
+  /// Copy the live reconstruction statistics of the worker to the reconstruction node
+  static void UpdateLiveStatistics(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode, ReconstructionInfo& info);
 };
 
 //----------------------------------------------------------------------------
@@ -91,6 +615,696 @@ vtkSlicerVolumeReconstructionLogic::vtkInternal::vtkInternal(vtkSlicerVolumeReco
 //---------------------------------------------------------------------------
 vtkSlicerVolumeReconstructionLogic::vtkInternal::~vtkInternal()
 {
+  for (VolumeReconstuctorMap::iterator it = this->Reconstructors.begin(); it != this->Reconstructors.end(); ++it)
+  {
+    vtkInternal::StopLiveWorker(it->second);
+  }
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerVolumeReconstructionLogic::vtkInternal::GetImageToROIMatrix(vtkMRMLVolumeNode* inputVolumeNode, vtkMRMLNode* inputROINode,
+  vtkMatrix4x4* imageToROIMatrix)
+{
+  if (!inputVolumeNode || !imageToROIMatrix)
+  {
+    return false;
+  }
+
+  vtkNew<vtkMatrix4x4> worldToROIMatrix;
+  if (!vtkInternal::GetWorldToROIMatrix(inputROINode, worldToROIMatrix))
+  {
+    return false;
+  }
+
+  // ImageToROI = WorldToROI * ImageParentToWorld * IJKToRAS
+  inputVolumeNode->GetIJKToRASMatrix(imageToROIMatrix);
+
+  vtkMRMLTransformNode* imageParentTransformNode = inputVolumeNode->GetParentTransformNode();
+  if (imageParentTransformNode)
+  {
+    vtkNew<vtkMatrix4x4> parentToWorldMatrix;
+    imageParentTransformNode->GetMatrixTransformToWorld(parentToWorldMatrix);
+    vtkMatrix4x4::Multiply4x4(parentToWorldMatrix, imageToROIMatrix, imageToROIMatrix);
+  }
+
+  vtkMatrix4x4::Multiply4x4(worldToROIMatrix, imageToROIMatrix, imageToROIMatrix);
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerVolumeReconstructionLogic::vtkInternal::GetWorldToROIMatrix(vtkMRMLNode* inputROINode, vtkMatrix4x4* worldToROIMatrix)
+{
+  vtkMRMLTransformableNode* transformableROINode = vtkMRMLTransformableNode::SafeDownCast(inputROINode);
+  if (!transformableROINode || !worldToROIMatrix)
+  {
+    return false;
+  }
+
+  // WorldToROI = NodeToObject * WorldToROIParent
+  worldToROIMatrix->Identity();
+
+  vtkMRMLTransformNode* roiParentTransformNode = transformableROINode->GetParentTransformNode();
+  if (roiParentTransformNode)
+  {
+    roiParentTransformNode->GetMatrixTransformFromWorld(worldToROIMatrix);
+  }
+
+  vtkMRMLMarkupsROINode* markupsROINode = vtkMRMLMarkupsROINode::SafeDownCast(inputROINode);
+  if (markupsROINode)
+  {
+    vtkNew<vtkMatrix4x4> nodeToObjectMatrix;
+    vtkMatrix4x4::Invert(markupsROINode->GetObjectToNodeMatrix(), nodeToObjectMatrix);
+    vtkMatrix4x4::Multiply4x4(nodeToObjectMatrix, worldToROIMatrix, worldToROIMatrix);
+  }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerVolumeReconstructionLogic::vtkInternal::GetSequenceBoundsInROI(vtkMRMLSequenceBrowserNode* sequenceBrowserNode,
+  vtkMRMLVolumeNode* proxyVolumeNode, vtkMRMLNode* roiNode, double outlierPercentile, double roiBounds[6])
+{
+  SequenceFrameSource frameSource;
+  if (!frameSource.Initialize(sequenceBrowserNode, proxyVolumeNode))
+  {
+    return false;
+  }
+
+  vtkNew<vtkMatrix4x4> worldToROIMatrix;
+  if (!vtkInternal::GetWorldToROIMatrix(roiNode, worldToROIMatrix))
+  {
+    return false;
+  }
+
+  // Gather the geometry of all frames. Data nodes are not thread-safe (and frames of non-master sequences
+  // may share data nodes), so this is done on one thread. It only copies a few numbers per frame.
+  const int numberOfFrames = frameSource.GetNumberOfFrames();
+  std::vector<double> frameImageToROIMatrices;
+  std::vector<double> frameImageBoxes;
+  frameImageToROIMatrices.reserve(12 * numberOfFrames);
+  frameImageBoxes.reserve(6 * numberOfFrames);
+  vtkNew<vtkMatrix4x4> imageToROIMatrix;
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  for (int i = 0; i < numberOfFrames; ++i)
+  {
+    if (!frameSource.ReadImageGeometry(i, imageToROIMatrix, extent)
+      || extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5]
+      || !frameSource.ApplyParentTransforms(i, imageToROIMatrix))
+    {
+      continue;
+    }
+    vtkMatrix4x4::Multiply4x4(worldToROIMatrix, imageToROIMatrix, imageToROIMatrix);
+    for (int row = 0; row < 3; ++row)
+    {
+      for (int column = 0; column < 4; ++column)
+      {
+        frameImageToROIMatrices.push_back(imageToROIMatrix->GetElement(row, column));
+      }
+    }
+    // Voxel centers are at integer IJK coordinates, include the full voxels at the boundary
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      frameImageBoxes.push_back(0.5 * (extent[2 * axis] + extent[2 * axis + 1]));
+    }
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      frameImageBoxes.push_back(0.5 * (extent[2 * axis + 1] - extent[2 * axis] + 1));
+    }
+  }
+
+  const vtkIdType numberOfValidFrames = static_cast<vtkIdType>(frameImageBoxes.size() / 6);
+  if (numberOfValidFrames == 0)
+  {
+    return false;
+  }
+
+  std::vector<double> frameBounds(6 * numberOfValidFrames);
+  SequenceFrameBoundsFunctor boundsFunctor;
+  boundsFunctor.FrameImageToROIMatrices = &frameImageToROIMatrices;
+  boundsFunctor.FrameImageBoxes = &frameImageBoxes;
+  boundsFunctor.FrameBounds = &frameBounds;
+  vtkSMPTools::For(0, numberOfValidFrames, boundsFunctor);
+  std::copy(boundsFunctor.Bounds, boundsFunctor.Bounds + 6, roiBounds);
+
+  if (outlierPercentile > 0.0)
+  {
+    double fraction = std::min(outlierPercentile, 50.0) / 100.0;
+    vtkIdType lowerRank = static_cast<vtkIdType>(std::floor(fraction * (numberOfValidFrames - 1)));
+    vtkIdType upperRank = numberOfValidFrames - 1 - lowerRank;
+    std::vector<double> values(numberOfValidFrames);
+    for (int i = 0; i < 6; ++i)
+    {
+      for (vtkIdType frameIndex = 0; frameIndex < numberOfValidFrames; ++frameIndex)
+      {
+        values[frameIndex] = frameBounds[6 * frameIndex + i];
+      }
+      // Lower bounds: ignore the smallest values, upper bounds: ignore the largest values
+      vtkIdType rank = (i % 2 == 0) ? lowerRank : upperRank;
+      std::nth_element(values.begin(), values.begin() + rank, values.end());
+      roiBounds[i] = values[rank];
+    }
+  }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerVolumeReconstructionLogic::vtkInternal::AddImageToReconstruction(ReconstructionInfo& info, vtkImageData* imageData,
+  vtkMatrix4x4* imageToROIMatrix, bool isFirst, bool isLast)
+{
+  if (!info.Reconstructor || !imageData || !imageToROIMatrix)
+  {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(*info.ReconstructorMutex);
+
+  if (info.SparseAccumulator)
+  {
+    int modifiedExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    info.SparseAccumulator->SetOutputScalarType(imageData->GetScalarType());
+    if (!info.SparseAccumulator->AddImage(imageData, imageToROIMatrix, modifiedExtent))
+    {
+      return false;
+    }
+    vtkInternal::MergeDirtyExtent(info, modifiedExtent);
+    return true;
+  }
+
+  // Ensure that output scalar type matches input (only same scalar type can be added to the volume)
+  info.Reconstructor->SetOutputScalarType(imageData->GetScalarType());
+
+  info.TransformRepository->SetTransform(igsioTransformName("ImageToROI"), imageToROIMatrix);
+
+  // The reconstructor only reads the image during the call, so the input buffer can be shared instead of copied
+  info.TrackedFrame->GetImageData()->GetImage()->ShallowCopy(imageData);
+
+  bool insertedIntoVolume = false;
+  if (info.Reconstructor->AddTrackedFrame(info.TrackedFrame.get(), info.TransformRepository, isFirst, isLast, &insertedIntoVolume) != IGSIO_SUCCESS)
+  {
+    return false;
+  }
+  if (insertedIntoVolume)
+  {
+    vtkInternal::ExtendDirtyExtent(info, imageData, imageToROIMatrix);
+  }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVolumeReconstructionLogic::vtkInternal::ConfigureReconstructor(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode,
+  vtkIGSIOVolumeReconstructor* reconstructor, int outputExtent[6], double outputOrigin[3], double outputSpacing[3], int numberOfThreads)
+{
+  reconstructor->SetOutputExtent(outputExtent);
+  reconstructor->SetOutputOrigin(outputOrigin);
+  reconstructor->SetOutputSpacing(outputSpacing);
+  reconstructor->SetCompoundingMode(vtkIGSIOPasteSliceIntoVolume::CompoundingType(volumeReconstructionNode->GetCompoundingMode()));
+  reconstructor->SetOptimization(vtkIGSIOPasteSliceIntoVolume::OptimizationType(volumeReconstructionNode->GetOptimizationMode()));
+  reconstructor->SetInterpolation(vtkIGSIOPasteSliceIntoVolume::InterpolationType(volumeReconstructionNode->GetInterpolationMode()));
+  reconstructor->SetNumberOfThreads(numberOfThreads);
+  reconstructor->SetFillHoles(volumeReconstructionNode->GetFillHoles());
+  if (volumeReconstructionNode->GetFillHoles())
+  {
+    vtkIGSIOFillHolesInVolume* holeFiller = reconstructor->GetHoleFiller();
+    holeFiller->SetNumHFElements(1);
+    holeFiller->AllocateHFElements();
+    FillHolesInVolumeElement hfElement;
+    hfElement.setupAsStick(9, 1);
+    holeFiller->SetHFElement(0, hfElement);
+  }
+  reconstructor->SetImageCoordinateFrame("Image");
+  reconstructor->SetReferenceCoordinateFrame("ROI");
+  reconstructor->SetClipRectangleOrigin(volumeReconstructionNode->GetClipRectangleOrigin());
+  reconstructor->SetClipRectangleSize(volumeReconstructionNode->GetClipRectangleSize());
+  reconstructor->Reset();
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerVolumeReconstructionLogic::vtkInternal::IsFramePoseRedundant(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode,
+  const ReconstructionInfo& info, vtkMatrix4x4* imageToROIMatrix)
+{
+  double translationThresholdMm = volumeReconstructionNode->GetPoseChangeTranslationThresholdMm();
+  double rotationThresholdDeg = volumeReconstructionNode->GetPoseChangeRotationThresholdDeg();
+  if ((translationThresholdMm <= 0.0 && rotationThresholdDeg <= 0.0) || !info.LastAcceptedImageToROIMatrix)
+  {
+    return false;
+  }
+
+  vtkMatrix4x4* lastMatrix = info.LastAcceptedImageToROIMatrix;
+  double translationSquared = 0.0;
+  for (int row = 0; row < 3; ++row)
+  {
+    double difference = imageToROIMatrix->GetElement(row, 3) - lastMatrix->GetElement(row, 3);
+    translationSquared += difference * difference;
+  }
+
+  // Angle of the relative rotation, from the trace of lastRotation^T * rotation (columns are normalized to remove the spacing)
+  double trace = 0.0;
+  for (int column = 0; column < 3; ++column)
+  {
+    double axis[3] = { imageToROIMatrix->GetElement(0, column), imageToROIMatrix->GetElement(1, column), imageToROIMatrix->GetElement(2, column) };
+    double lastAxis[3] = { lastMatrix->GetElement(0, column), lastMatrix->GetElement(1, column), lastMatrix->GetElement(2, column) };
+    vtkMath::Normalize(axis);
+    vtkMath::Normalize(lastAxis);
+    trace += vtkMath::Dot(axis, lastAxis);
+  }
+  double angleDeg = vtkMath::DegreesFromRadians(std::acos(std::max(-1.0, std::min(1.0, (trace - 1.0) / 2.0))));
+
+  // A non-positive threshold means that the criterion is ignored
+  bool translationWithinThreshold = (translationThresholdMm <= 0.0 || translationSquared <= translationThresholdMm * translationThresholdMm);
+  bool rotationWithinThreshold = (rotationThresholdDeg <= 0.0 || angleDeg <= rotationThresholdDeg + POSE_CHANGE_ROTATION_TOLERANCE_DEG);
+  return translationWithinThreshold && rotationWithinThreshold;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVolumeReconstructionLogic::vtkInternal::SetLastAcceptedFramePose(ReconstructionInfo& info, vtkMatrix4x4* imageToROIMatrix)
+{
+  if (!info.LastAcceptedImageToROIMatrix)
+  {
+    info.LastAcceptedImageToROIMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  }
+  info.LastAcceptedImageToROIMatrix->DeepCopy(imageToROIMatrix);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVolumeReconstructionLogic::vtkInternal::StartLiveWorker(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode, ReconstructionInfo& info)
+{
+  if (info.LiveWorker || volumeReconstructionNode->GetLiveFrameQueueSize() <= 0)
+  {
+    // Without queue the frames are pasted synchronously, when the input volume is modified
+    return;
+  }
+
+  // With preview, the full resolution reconstruction needs all frames, however long it takes to paste them.
+  // The queue is still limited, so that the memory of the copied frames does not grow without limit.
+  std::shared_ptr<LiveReconstructionWorker> worker = std::make_shared<LiveReconstructionWorker>(
+    static_cast<size_t>(volumeReconstructionNode->GetLiveFrameQueueSize()), info.Preview != nullptr);
+  worker->NumberOfPastedFrames = volumeReconstructionNode->GetNumberOfVolumesAddedToReconstruction();
+  worker->NumberOfDroppedFrames = volumeReconstructionNode->GetNumberOfDroppedLiveFrames();
+
+  // The info is stored in a map, so its address does not change while the worker is running
+  LiveReconstructionWorker* workerPtr = worker.get();
+  ReconstructionInfo* infoPtr = &info;
+  worker->Thread = std::thread([workerPtr, infoPtr]()
+  {
+    ReconstructionFrame frame;
+    while (workerPtr->Frames.Pop(frame))
+    {
+      double startTime = vtkTimerLog::GetUniversalTime();
+      bool isFirst = (workerPtr->NumberOfPastedFrames == 0);
+      if (vtkInternal::AddImageToReconstruction(*infoPtr, frame.Image, frame.ImageToROIMatrix, isFirst, false))
+      {
+        ++workerPtr->NumberOfPastedFrames;
+      }
+      workerPtr->LastPasteTimeSeconds = vtkTimerLog::GetUniversalTime() - startTime;
+      frame.Image = nullptr;
+    }
+  });
+  info.LiveWorker = worker;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVolumeReconstructionLogic::vtkInternal::StartSlabReconstructions(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode,
+  ReconstructionInfo& info, int numberOfSlabs, size_t queueSize, std::vector<std::unique_ptr<ReconstructionSlab>>& slabs)
+{
+  slabs.clear();
+
+  int slabAxis = 0;
+  for (int axis = 1; axis < 3; ++axis)
+  {
+    if (info.OutputExtent[2 * axis + 1] - info.OutputExtent[2 * axis] > info.OutputExtent[2 * slabAxis + 1] - info.OutputExtent[2 * slabAxis])
+    {
+      slabAxis = axis;
+    }
+  }
+  int numberOfVoxels = info.OutputExtent[2 * slabAxis + 1] - info.OutputExtent[2 * slabAxis] + 1;
+  numberOfSlabs = std::min(numberOfSlabs, numberOfVoxels);
+  if (numberOfSlabs < 2)
+  {
+    return;
+  }
+  int overlap = volumeReconstructionNode->GetFillHoles() ? SLAB_HOLE_FILLING_OVERLAP_VOXELS : 0;
+
+  // The slabs share the threads that a single reconstructor would use
+  int numberOfThreads = volumeReconstructionNode->GetNumberOfThreads();
+  if (numberOfThreads <= 0)
+  {
+    numberOfThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+  }
+  int numberOfThreadsPerSlab = std::max(numberOfThreads / numberOfSlabs, 1);
+
+  for (int slabIndex = 0; slabIndex < numberOfSlabs; ++slabIndex)
+  {
+    std::unique_ptr<ReconstructionSlab> slab(new ReconstructionSlab(queueSize));
+    slab->SlabAxis = slabAxis;
+    slab->FirstOutputVoxel = info.OutputExtent[2 * slabAxis] + static_cast<int>(static_cast<long long>(numberOfVoxels) * slabIndex / numberOfSlabs);
+    slab->LastOutputVoxel = info.OutputExtent[2 * slabAxis] + static_cast<int>(static_cast<long long>(numberOfVoxels) * (slabIndex + 1) / numberOfSlabs) - 1;
+    slab->SlabStartOutputVoxel = std::max(slab->FirstOutputVoxel - overlap, info.OutputExtent[2 * slabAxis]);
+    int slabEndOutputVoxel = std::min(slab->LastOutputVoxel + overlap, info.OutputExtent[2 * slabAxis + 1]);
+
+    // The slab volume starts at voxel 0, its origin is shifted to the first voxel of the slab
+    ReconstructionInfo& slabInfo = slab->Info;
+    std::copy(info.OutputExtent, info.OutputExtent + 6, slabInfo.OutputExtent);
+    std::copy(info.OutputOrigin, info.OutputOrigin + 3, slabInfo.OutputOrigin);
+    std::copy(info.OutputSpacing, info.OutputSpacing + 3, slabInfo.OutputSpacing);
+    slabInfo.OutputExtent[2 * slabAxis] = 0;
+    slabInfo.OutputExtent[2 * slabAxis + 1] = slabEndOutputVoxel - slab->SlabStartOutputVoxel;
+    slabInfo.OutputOrigin[slabAxis] += (slab->SlabStartOutputVoxel - info.OutputExtent[2 * slabAxis]) * info.OutputSpacing[slabAxis];
+    slabInfo.Reconstructor = vtkSmartPointer<vtkIGSIOVolumeReconstructor>::New();
+    vtkInternal::ConfigureReconstructor(volumeReconstructionNode, slabInfo.Reconstructor,
+      slabInfo.OutputExtent, slabInfo.OutputOrigin, slabInfo.OutputSpacing, numberOfThreadsPerSlab);
+
+    ReconstructionSlab* slabPtr = slab.get();
+    slab->Thread = std::thread([slabPtr]()
+    {
+      ReconstructionFrame frame;
+      while (slabPtr->Frames.Pop(frame))
+      {
+        if (vtkInternal::AddImageToReconstruction(slabPtr->Info, frame.Image, frame.ImageToROIMatrix, slabPtr->NumberOfPastedFrames == 0, false))
+        {
+          ++slabPtr->NumberOfPastedFrames;
+        }
+        frame.Image = nullptr;
+      }
+    });
+    slabs.push_back(std::move(slab));
+  }
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerVolumeReconstructionLogic::vtkInternal::DispatchFrameToSlabs(std::vector<std::unique_ptr<ReconstructionSlab>>& slabs,
+  const ReconstructionFrame& frame)
+{
+  bool dispatched = false;
+  for (std::unique_ptr<ReconstructionSlab>& slab : slabs)
+  {
+    int frameExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    if (!vtkInternal::GetFrameFootprintExtent(slab->Info, frame.Image, frame.ImageToROIMatrix, frameExtent))
+    {
+      continue;
+    }
+    // The image and the matrix are only read by the slab threads, so they can be shared
+    ReconstructionFrame slabFrame = frame;
+    slab->Frames.Push(std::move(slabFrame));
+    dispatched = true;
+  }
+  return dispatched;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVolumeReconstructionLogic::vtkInternal::StitchSlabReconstructions(ReconstructionInfo& info,
+  std::vector<std::unique_ptr<ReconstructionSlab>>& slabs)
+{
+  for (std::unique_ptr<ReconstructionSlab>& slab : slabs)
+  {
+    slab->Frames.Close();
+  }
+  for (std::unique_ptr<ReconstructionSlab>& slab : slabs)
+  {
+    if (slab->Thread.joinable())
+    {
+      slab->Thread.join();
+    }
+  }
+  if (slabs.empty())
+  {
+    return;
+  }
+
+  const int slabAxis = slabs[0]->SlabAxis;
+  vtkSmartPointer<vtkImageData> stitchedVolume = vtkSmartPointer<vtkImageData>::New();
+  vtkNew<vtkImageData> slabVolume;
+  for (std::unique_ptr<ReconstructionSlab>& slab : slabs)
+  {
+    if (slab->NumberOfPastedFrames == 0)
+    {
+      // Empty slab, voxels are left at 0
+      continue;
+    }
+    if (slab->Info.Reconstructor->GetReconstructedVolume(slabVolume) != IGSIO_SUCCESS)
+    {
+      vtkGenericWarningMacro("StitchSlabReconstructions: Could not retrieve reconstructed slab");
+      continue;
+    }
+    if (!stitchedVolume->GetPointData()->GetScalars())
+    {
+      stitchedVolume->SetExtent(info.OutputExtent);
+      stitchedVolume->SetOrigin(info.OutputOrigin);
+      stitchedVolume->SetSpacing(info.OutputSpacing);
+      stitchedVolume->AllocateScalars(slabVolume->GetScalarType(), slabVolume->GetNumberOfScalarComponents());
+      stitchedVolume->GetPointData()->GetScalars()->Fill(0.0);
+    }
+
+    // Shift the slab extent to output volume voxel coordinates (the voxel buffer is not changed)
+    int slabExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    slabVolume->GetExtent(slabExtent);
+    slabExtent[2 * slabAxis] += slab->SlabStartOutputVoxel;
+    slabExtent[2 * slabAxis + 1] += slab->SlabStartOutputVoxel;
+    slabVolume->SetExtent(slabExtent);
+
+    int copyExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    std::copy(info.OutputExtent, info.OutputExtent + 6, copyExtent);
+    copyExtent[2 * slabAxis] = slab->FirstOutputVoxel;
+    copyExtent[2 * slabAxis + 1] = slab->LastOutputVoxel;
+    stitchedVolume->CopyAndCastFrom(slabVolume, copyExtent);
+  }
+
+  if (stitchedVolume->GetPointData()->GetScalars())
+  {
+    std::lock_guard<std::mutex> lock(*info.ReconstructorMutex);
+    info.StitchedVolume = stitchedVolume;
+  }
+  slabs.clear();
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVolumeReconstructionLogic::vtkInternal::StartLivePreview(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode, ReconstructionInfo& info)
+{
+  info.Preview = nullptr;
+  double spacingFactor = volumeReconstructionNode->GetLivePreviewSpacingFactor();
+  if (spacingFactor <= 1.0 || !info.Reconstructor || volumeReconstructionNode->GetLiveFrameQueueSize() <= 0)
+  {
+    // The preview is only needed if the full resolution reconstruction is done on the background thread
+    return;
+  }
+
+  std::shared_ptr<ReconstructionInfo> preview = std::make_shared<ReconstructionInfo>();
+  int previewExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    double size = (info.OutputExtent[2 * axis + 1] - info.OutputExtent[2 * axis]) * info.OutputSpacing[axis];
+    preview->OutputOrigin[axis] = info.OutputOrigin[axis];
+    preview->OutputSpacing[axis] = info.OutputSpacing[axis] * spacingFactor;
+    previewExtent[2 * axis] = 0;
+    previewExtent[2 * axis + 1] = static_cast<int>(std::ceil(size / preview->OutputSpacing[axis]));
+  }
+  std::copy(previewExtent, previewExtent + 6, preview->OutputExtent);
+
+  // The preview is only for immediate feedback, so the fastest options are used
+  preview->Reconstructor = vtkSmartPointer<vtkIGSIOVolumeReconstructor>::New();
+  vtkIGSIOVolumeReconstructor* reconstructor = preview->Reconstructor;
+  reconstructor->SetOutputExtent(previewExtent);
+  reconstructor->SetOutputOrigin(preview->OutputOrigin);
+  reconstructor->SetOutputSpacing(preview->OutputSpacing);
+  reconstructor->SetCompoundingMode(vtkIGSIOPasteSliceIntoVolume::CompoundingType(volumeReconstructionNode->GetCompoundingMode()));
+  reconstructor->SetOptimization(vtkIGSIOPasteSliceIntoVolume::FULL_OPTIMIZATION);
+  reconstructor->SetInterpolation(vtkIGSIOPasteSliceIntoVolume::NEAREST_NEIGHBOR_INTERPOLATION);
+  reconstructor->SetNumberOfThreads(volumeReconstructionNode->GetNumberOfThreads());
+  reconstructor->SetFillHoles(false);
+  reconstructor->SetImageCoordinateFrame("Image");
+  reconstructor->SetReferenceCoordinateFrame("ROI");
+  reconstructor->SetClipRectangleOrigin(volumeReconstructionNode->GetClipRectangleOrigin());
+  reconstructor->SetClipRectangleSize(volumeReconstructionNode->GetClipRectangleSize());
+  reconstructor->Reset();
+
+  info.Preview = preview;
+}
+
+//---------------------------------------------------------------------------
+ReconstructionInfo& vtkSlicerVolumeReconstructionLogic::vtkInternal::GetDisplayedReconstruction(ReconstructionInfo& info)
+{
+  return info.Preview ? *info.Preview : info;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVolumeReconstructionLogic::vtkInternal::StopLiveWorker(ReconstructionInfo& info)
+{
+  if (!info.LiveWorker)
+  {
+    return;
+  }
+  info.LiveWorker->Frames.Close();
+  if (info.LiveWorker->Thread.joinable())
+  {
+    info.LiveWorker->Thread.join();
+  }
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerVolumeReconstructionLogic::vtkInternal::EnqueueLiveFrame(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode, ReconstructionInfo& info)
+{
+  LiveReconstructionWorker* worker = info.LiveWorker.get();
+  vtkMRMLVolumeNode* inputVolumeNode = volumeReconstructionNode->GetInputVolumeNode();
+  if (!worker || !inputVolumeNode || !inputVolumeNode->GetImageData())
+  {
+    return false;
+  }
+
+  ++worker->NumberOfReceivedFrames;
+  int dropPolicy = volumeReconstructionNode->GetLiveFrameDropPolicy();
+  if (dropPolicy == vtkMRMLVolumeReconstructionNode::KEEP_EVERY_NTH_FRAME && !worker->KeepAllFrames
+    && (worker->NumberOfReceivedFrames - 1) % std::max(volumeReconstructionNode->GetLiveFrameKeepInterval(), 1) != 0)
+  {
+    ++worker->NumberOfDroppedFrames;
+    return true;
+  }
+  if (dropPolicy != vtkMRMLVolumeReconstructionNode::DROP_OLDEST_FRAME && !worker->KeepAllFrames && worker->Frames.IsFull())
+  {
+    // Only the worker removes frames from the queue, so there will be no space for this frame: skip the copy
+    ++worker->NumberOfDroppedFrames;
+    return true;
+  }
+
+  ReconstructionFrame frame;
+  frame.Index = worker->NumberOfReceivedFrames - 1;
+  frame.ImageToROIMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  if (!vtkInternal::GetImageToROIMatrix(inputVolumeNode, volumeReconstructionNode->GetInputROINode(), frame.ImageToROIMatrix))
+  {
+    return false;
+  }
+  if (vtkInternal::IsFramePoseRedundant(volumeReconstructionNode, info, frame.ImageToROIMatrix))
+  {
+    ++info.NumberOfSkippedFrames;
+    return true;
+  }
+  // The frame only becomes the reference for the pose change after it is queued, as it may still be dropped
+  vtkSmartPointer<vtkMatrix4x4> imageToROIMatrix = frame.ImageToROIMatrix;
+  // The input image may be overwritten by the next frame before it is pasted, so it has to be copied
+  frame.Image = vtkSmartPointer<vtkImageData>::New();
+  frame.Image->DeepCopy(inputVolumeNode->GetImageData());
+
+  if (info.Preview)
+  {
+    // The coarse preview is fast enough to be updated immediately
+    vtkInternal::AddImageToReconstruction(*info.Preview, frame.Image, frame.ImageToROIMatrix, frame.Index == 0, false);
+  }
+
+  if (worker->KeepAllFrames)
+  {
+    // Wait until the worker makes space for the frame. This blocks the calling (usually the main) thread.
+    if (worker->Frames.Push(std::move(frame)))
+    {
+      vtkInternal::SetLastAcceptedFramePose(info, imageToROIMatrix);
+    }
+  }
+  else if (dropPolicy == vtkMRMLVolumeReconstructionNode::DROP_OLDEST_FRAME)
+  {
+    ReconstructionFrame droppedFrame;
+    while (!worker->Frames.TryPush(frame))
+    {
+      if (worker->Frames.TryPop(droppedFrame))
+      {
+        ++worker->NumberOfDroppedFrames;
+      }
+    }
+    vtkInternal::SetLastAcceptedFramePose(info, imageToROIMatrix);
+  }
+  else if (worker->Frames.TryPush(frame))
+  {
+    vtkInternal::SetLastAcceptedFramePose(info, imageToROIMatrix);
+  }
+  else
+  {
+    ++worker->NumberOfDroppedFrames;
+  }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVolumeReconstructionLogic::vtkInternal::UpdateLiveStatistics(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode, ReconstructionInfo& info)
+{
+  LiveReconstructionWorker* worker = info.LiveWorker.get();
+  if (!worker || !volumeReconstructionNode)
+  {
+    return;
+  }
+
+  int numberOfPastedFrames = worker->NumberOfPastedFrames;
+  {
+    MRMLNodeModifyBlocker blocker(volumeReconstructionNode);
+    volumeReconstructionNode->SetNumberOfLiveFramesInQueue(static_cast<int>(worker->Frames.GetSize()));
+    volumeReconstructionNode->SetNumberOfDroppedLiveFrames(worker->NumberOfDroppedFrames);
+    volumeReconstructionNode->SetLastFramePasteTimeSeconds(worker->LastPasteTimeSeconds);
+    volumeReconstructionNode->SetNumberOfSkippedFrames(info.NumberOfSkippedFrames);
+  }
+  if (numberOfPastedFrames != volumeReconstructionNode->GetNumberOfVolumesAddedToReconstruction())
+  {
+    volumeReconstructionNode->SetNumberOfVolumesAddedToReconstruction(numberOfPastedFrames);
+    volumeReconstructionNode->InvokeEvent(vtkMRMLVolumeReconstructionNode::VolumeAddedToReconstruction);
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVolumeReconstructionLogic::vtkInternal::ExtendDirtyExtent(ReconstructionInfo& info, vtkImageData* imageData, vtkMatrix4x4* imageToROIMatrix)
+{
+  int frameExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  if (vtkInternal::GetFrameFootprintExtent(info, imageData, imageToROIMatrix, frameExtent))
+  {
+    vtkInternal::MergeDirtyExtent(info, frameExtent);
+  }
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerVolumeReconstructionLogic::vtkInternal::GetFrameFootprintExtent(ReconstructionInfo& info, vtkImageData* imageData,
+  vtkMatrix4x4* imageToROIMatrix, int frameExtent[6])
+{
+  int imageExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  imageData->GetExtent(imageExtent);
+
+  // Bounds of the image box (including the full boundary voxels) in output voxel coordinates,
+  // computed from the absolute values of the matrix elements instead of transforming all corners.
+  for (int row = 0; row < 3; ++row)
+  {
+    double center = imageToROIMatrix->GetElement(row, 3);
+    double halfSize = 0.0;
+    for (int column = 0; column < 3; ++column)
+    {
+      double element = imageToROIMatrix->GetElement(row, column);
+      center += element * 0.5 * (imageExtent[2 * column] + imageExtent[2 * column + 1]);
+      halfSize += std::abs(element) * 0.5 * (imageExtent[2 * column + 1] - imageExtent[2 * column] + 1);
+    }
+    double minimumVoxel = (center - halfSize - info.OutputOrigin[row]) / info.OutputSpacing[row];
+    double maximumVoxel = (center + halfSize - info.OutputOrigin[row]) / info.OutputSpacing[row];
+    // Linear interpolation distributes each pixel into the neighboring voxels, add a voxel margin
+    frameExtent[2 * row] = std::max(static_cast<int>(std::floor(minimumVoxel)) - 1, info.OutputExtent[2 * row]);
+    frameExtent[2 * row + 1] = std::min(static_cast<int>(std::ceil(maximumVoxel)) + 1, info.OutputExtent[2 * row + 1]);
+    if (frameExtent[2 * row] > frameExtent[2 * row + 1])
+    {
+      // The image is outside of the output volume
+      return false;
+    }
+  }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVolumeReconstructionLogic::vtkInternal::MergeDirtyExtent(ReconstructionInfo& info, const int extent[6])
+{
+  if (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5])
+  {
+    return;
+  }
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    if (info.DirtyExtent[2 * axis] > info.DirtyExtent[2 * axis + 1])
+    {
+      info.DirtyExtent[2 * axis] = extent[2 * axis];
+      info.DirtyExtent[2 * axis + 1] = extent[2 * axis + 1];
+    }
+    else
+    {
+      info.DirtyExtent[2 * axis] = std::min(info.DirtyExtent[2 * axis], extent[2 * axis]);
+      info.DirtyExtent[2 * axis + 1] = std::max(info.DirtyExtent[2 * axis + 1], extent[2 * axis + 1]);
+    }
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -159,6 +1373,7 @@ void vtkSlicerVolumeReconstructionLogic::OnMRMLSceneNodeRemoved(vtkMRMLNode* nod
   VolumeReconstuctorMap::iterator volumeReconstructorIt = this->Internal->Reconstructors.find(volumeReconstructionNode);
   if (volumeReconstructorIt != this->Internal->Reconstructors.end())
   {
+    vtkInternal::StopLiveWorker(volumeReconstructorIt->second);
     this->Internal->Reconstructors.erase(volumeReconstructorIt);
   }
 }
@@ -169,33 +1384,91 @@ void vtkSlicerVolumeReconstructionLogic::ProcessMRMLNodesEvents(vtkObject* calle
   vtkMRMLVolumeReconstructionNode* volumeReconstructionNode = vtkMRMLVolumeReconstructionNode::SafeDownCast(caller);
   if (volumeReconstructionNode && event == vtkMRMLVolumeReconstructionNode::InputVolumeModified && volumeReconstructionNode->GetLiveVolumeReconstructionInProgress())
   {
-    this->AddVolumeNodeToReconstructedVolume(volumeReconstructionNode, volumeReconstructionNode->GetNumberOfVolumesAddedToReconstruction() == 0, false);
+    ReconstructionInfo& info = this->Internal->Reconstructors[volumeReconstructionNode];
+    if (info.LiveWorker)
+    {
+      // Pasting is done on the background thread, so that the application stays responsive
+      vtkInternal::EnqueueLiveFrame(volumeReconstructionNode, info);
+    }
+    else
+    {
+      // LiveFrameQueueSize is 0, the frame is pasted synchronously
+      this->AddVolumeNodeToReconstructedVolume(volumeReconstructionNode, volumeReconstructionNode->GetNumberOfVolumesAddedToReconstruction() == 0, false);
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVolumeReconstructionLogic::UpdateLiveVolumeReconstruction()
+{
+  vtkNew<vtkTimerLog> timer;
+  for (VolumeReconstuctorMap::iterator it = this->Internal->Reconstructors.begin(); it != this->Internal->Reconstructors.end(); ++it)
+  {
+    vtkMRMLVolumeReconstructionNode* volumeReconstructionNode = it->first;
+    ReconstructionInfo* info = &(it->second);
+    vtkIGSIOVolumeReconstructor* reconstructor = info->Reconstructor;
+    if (!volumeReconstructionNode || !reconstructor || !volumeReconstructionNode->GetLiveVolumeReconstructionInProgress())
+    {
+      continue;
+    }
+
+    vtkInternal::UpdateLiveStatistics(volumeReconstructionNode, *info);
+
+    double currentTime = timer->GetUniversalTime();
+    if (currentTime - info->LastUpdateTimeSeconds < volumeReconstructionNode->GetLiveUpdateIntervalSeconds())
+    {
+      continue;
+    }
+
+    this->UpdateReconstructedVolumeModifiedRegion(volumeReconstructionNode);
+    info->LastUpdateTimeSeconds = currentTime;
+  }
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerVolumeReconstructionLogic::WriteReconstructedVolumeToFile(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode, const char* fileName)
+{
+  if (!volumeReconstructionNode || !fileName)
+  {
+    vtkErrorMacro("WriteReconstructedVolumeToFile: Invalid input");
+    return false;
+  }
+  ReconstructionInfo& info = this->Internal->Reconstructors[volumeReconstructionNode];
+  if (!info.SparseAccumulator)
+  {
+    vtkErrorMacro("WriteReconstructedVolumeToFile: Sparse accumulation is not used by the reconstruction");
+    return false;
+  }
+
+  // Reconstructed volume is in ROI coordinates
+  vtkSmartPointer<vtkMatrix4x4> roiToNodeMatrix;
+  vtkMRMLMarkupsROINode* markupsROINode = vtkMRMLMarkupsROINode::SafeDownCast(volumeReconstructionNode->GetInputROINode());
+  if (markupsROINode)
+  {
+    roiToNodeMatrix = markupsROINode->GetObjectToNodeMatrix();
   }
+
+  std::lock_guard<std::mutex> lock(*info.ReconstructorMutex);
+  return info.SparseAccumulator->WriteNrrdFile(fileName, info.CropOutputVolume, roiToNodeMatrix);
 }
 
 //---------------------------------------------------------------------------
-void vtkSlicerVolumeReconstructionLogic::UpdateLiveVolumeReconstruction()
+void vtkSlicerVolumeReconstructionLogic::FinishVolumeReconstruction(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode)
 {
-  vtkNew<vtkTimerLog> timer;
-  for (VolumeReconstuctorMap::iterator it = this->Internal->Reconstructors.begin(); it != this->Internal->Reconstructors.end(); ++it)
+  ReconstructionInfo& info = this->Internal->Reconstructors[volumeReconstructionNode];
+  const char* outputVolumeFileName = volumeReconstructionNode->GetOutputVolumeFileName();
+  if (!info.SparseAccumulator || !outputVolumeFileName || outputVolumeFileName[0] == '\0')
   {
-    vtkMRMLVolumeReconstructionNode* volumeReconstructionNode = it->first;
-    ReconstructionInfo* info = &(it->second);
-    vtkIGSIOVolumeReconstructor* reconstructor = info->Reconstructor;
-    if (!volumeReconstructionNode || !reconstructor || !volumeReconstructionNode->GetLiveVolumeReconstructionInProgress())
-    {
-      continue;
-    }
-
-    double currentTime = timer->GetUniversalTime();
-    if (currentTime - info->LastUpdateTimeSeconds < volumeReconstructionNode->GetLiveUpdateIntervalSeconds())
-    {
-      continue;
-    }
-
     this->GetReconstructedVolume(volumeReconstructionNode);
-    info->LastUpdateTimeSeconds = currentTime;
+    return;
+  }
+
+  // The volume may not fit into memory, write it directly from the accumulation volume
+  if (!this->WriteReconstructedVolumeToFile(volumeReconstructionNode, outputVolumeFileName))
+  {
+    vtkErrorMacro("FinishVolumeReconstruction: Failed to write reconstructed volume to " << outputVolumeFileName);
   }
+  volumeReconstructionNode->InvokeEvent(vtkMRMLVolumeReconstructionNode::VolumeReconstructionFinished);
 }
 
 //---------------------------------------------------------------------------
@@ -255,30 +1528,77 @@ void vtkSlicerVolumeReconstructionLogic::StartVolumeReconstruction(vtkMRMLVolume
   };
   double outputOrigin[3] = { bounds[0], bounds[2], bounds[4] };
 
-  reconstructor->SetOutputExtent(outputExtent);
-  reconstructor->SetOutputOrigin(outputOrigin);
-  reconstructor->SetOutputSpacing(outputSpacing);
-  reconstructor->SetCompoundingMode(vtkIGSIOPasteSliceIntoVolume::CompoundingType(volumeReconstructionNode->GetCompoundingMode()));
-  reconstructor->SetOptimization(vtkIGSIOPasteSliceIntoVolume::OptimizationType(volumeReconstructionNode->GetOptimizationMode()));
-  reconstructor->SetInterpolation(vtkIGSIOPasteSliceIntoVolume::InterpolationType(volumeReconstructionNode->GetInterpolationMode()));
-  reconstructor->SetNumberOfThreads(volumeReconstructionNode->GetNumberOfThreads());
-  reconstructor->SetFillHoles(volumeReconstructionNode->GetFillHoles());
-  if (volumeReconstructionNode->GetFillHoles())
+  // Frames of a previous live reconstruction must not be pasted while the reconstructor is reset
+  ReconstructionInfo& info = this->Internal->Reconstructors[volumeReconstructionNode];
+  vtkInternal::StopLiveWorker(info);
+  info.LiveWorker = nullptr;
+  info.Preview = nullptr;
+  info.LastAcceptedImageToROIMatrix = nullptr;
+  info.NumberOfSkippedFrames = 0;
+
+  vtkInternal::ConfigureReconstructor(volumeReconstructionNode, reconstructor, outputExtent, outputOrigin, outputSpacing,
+    volumeReconstructionNode->GetNumberOfThreads());
+
+  std::copy(outputExtent, outputExtent + 6, info.OutputExtent);
+  std::copy(outputOrigin, outputOrigin + 3, info.OutputOrigin);
+  std::copy(outputSpacing, outputSpacing + 3, info.OutputSpacing);
+  for (int axis = 0; axis < 3; ++axis)
   {
-    vtkIGSIOFillHolesInVolume* holeFiller = reconstructor->GetHoleFiller();
-    holeFiller->SetNumHFElements(1);
-    holeFiller->AllocateHFElements();
-    FillHolesInVolumeElement hfElement;
-    hfElement.setupAsStick(9, 1);
-    holeFiller->SetHFElement(0, hfElement);
+    info.DirtyExtent[2 * axis] = 0;
+    info.DirtyExtent[2 * axis + 1] = -1;
+  }
+  info.NeedsFullUpdate = true;
+  info.StitchedVolume = nullptr;
+
+  info.SparseAccumulator = nullptr;
+  info.CropOutputVolume = volumeReconstructionNode->GetCropOutputVolume();
+  std::string scratchFileDirectory = volumeReconstructionNode->GetScratchFileDirectory() ? volumeReconstructionNode->GetScratchFileDirectory() : "";
+  if (volumeReconstructionNode->GetSparseAccumulation() || !scratchFileDirectory.empty())
+  {
+    if (volumeReconstructionNode->GetFillHoles())
+    {
+      vtkWarningMacro("StartVolumeReconstruction: Hole filling is not available with sparse accumulation");
+    }
+    if (volumeReconstructionNode->GetInterpolationMode() != vtkMRMLVolumeReconstructionNode::NEAREST_NEIGHBOR_INTERPOLATION)
+    {
+      vtkWarningMacro("StartVolumeReconstruction: Sparse accumulation uses nearest neighbor interpolation");
+    }
+    info.SparseAccumulator = vtkSmartPointer<vtkBrickedVolumeAccumulator>::New();
+    info.SparseAccumulator->SetBrickSize(volumeReconstructionNode->GetSparseBrickSize());
+    if (!scratchFileDirectory.empty())
+    {
+      // Node IDs are only unique within a scene, so instances that use the same directory are told apart by the process ID
+#ifdef _WIN32
+      int processId = _getpid();
+#else
+      int processId = static_cast<int>(getpid());
+#endif
+      std::string scratchFileName = scratchFileDirectory + "/VolumeReconstruction_"
+        + (volumeReconstructionNode->GetID() ? volumeReconstructionNode->GetID() : "Scratch")
+        + "_" + std::to_string(processId) + ".raw";
+      info.SparseAccumulator->SetScratchFileName(scratchFileName.c_str());
+    }
+    info.SparseAccumulator->SetOutputExtent(outputExtent);
+    info.SparseAccumulator->SetOutputOrigin(outputOrigin);
+    info.SparseAccumulator->SetOutputSpacing(outputSpacing);
+    info.SparseAccumulator->SetClipRectangleOrigin(volumeReconstructionNode->GetClipRectangleOrigin());
+    info.SparseAccumulator->SetClipRectangleSize(volumeReconstructionNode->GetClipRectangleSize());
+    switch (volumeReconstructionNode->GetCompoundingMode())
+    {
+    case vtkMRMLVolumeReconstructionNode::LATEST_COMPOUNDING_MODE:
+      info.SparseAccumulator->SetCompoundingMode(vtkBrickedVolumeAccumulator::LATEST_COMPOUNDING);
+      break;
+    case vtkMRMLVolumeReconstructionNode::MAXIMUM_COMPOUNDING_MODE:
+      info.SparseAccumulator->SetCompoundingMode(vtkBrickedVolumeAccumulator::MAXIMUM_COMPOUNDING);
+      break;
+    default:
+      info.SparseAccumulator->SetCompoundingMode(vtkBrickedVolumeAccumulator::MEAN_COMPOUNDING);
+      break;
+    }
   }
-  reconstructor->SetImageCoordinateFrame("Image");
-  reconstructor->SetReferenceCoordinateFrame("ROI");
-  reconstructor->SetClipRectangleOrigin(volumeReconstructionNode->GetClipRectangleOrigin());
-  reconstructor->SetClipRectangleSize(volumeReconstructionNode->GetClipRectangleSize());
-  reconstructor->Reset();
 
   volumeReconstructionNode->SetNumberOfVolumesAddedToReconstruction(0);
+  volumeReconstructionNode->SetNumberOfSkippedFrames(0);
   volumeReconstructionNode->InvokeEvent(vtkMRMLVolumeReconstructionNode::VolumeReconstructionStarted);
 }
 
@@ -290,6 +1610,8 @@ void vtkSlicerVolumeReconstructionLogic::StartLiveVolumeReconstruction(vtkMRMLVo
     return;
   }
   this->StartVolumeReconstruction(volumeReconstructionNode);
+  vtkInternal::StartLivePreview(volumeReconstructionNode, this->Internal->Reconstructors[volumeReconstructionNode]);
+  volumeReconstructionNode->SetNumberOfDroppedLiveFrames(0);
   this->ResumeLiveVolumeReconstruction(volumeReconstructionNode);
 }
 
@@ -303,6 +1625,7 @@ void vtkSlicerVolumeReconstructionLogic::ResumeLiveVolumeReconstruction(vtkMRMLV
   vtkNew<vtkIntArray> events;
   events->InsertNextValue(vtkMRMLVolumeReconstructionNode::InputVolumeModified);
   vtkObserveMRMLNodeEventsMacro(volumeReconstructionNode, events);
+  vtkInternal::StartLiveWorker(volumeReconstructionNode, this->Internal->Reconstructors[volumeReconstructionNode]);
   volumeReconstructionNode->LiveVolumeReconstructionInProgressOn();
 }
 
@@ -315,7 +1638,20 @@ void vtkSlicerVolumeReconstructionLogic::StopLiveVolumeReconstruction(vtkMRMLVol
   }
   volumeReconstructionNode->LiveVolumeReconstructionInProgressOff();
   vtkUnObserveMRMLNodeMacro(volumeReconstructionNode);
-  this->GetReconstructedVolume(volumeReconstructionNode);
+
+  // All frames that are already queued are pasted into the full resolution reconstruction before it replaces the preview
+  ReconstructionInfo& info = this->Internal->Reconstructors[volumeReconstructionNode];
+  if (info.LiveWorker && info.LiveWorker->Frames.GetSize() > 0)
+  {
+    vtkInfoMacro("StopLiveVolumeReconstruction: Pasting " << info.LiveWorker->Frames.GetSize()
+      << " queued frames before live reconstruction is finished");
+  }
+  vtkInternal::StopLiveWorker(info);
+  vtkInternal::UpdateLiveStatistics(volumeReconstructionNode, info);
+  info.LiveWorker = nullptr;
+  info.Preview = nullptr;
+
+  this->FinishVolumeReconstruction(volumeReconstructionNode);
 }
 
 //---------------------------------------------------------------------------
@@ -334,8 +1670,8 @@ bool vtkSlicerVolumeReconstructionLogic::AddVolumeNodeToReconstructedVolume(vtkM
     return false;
   }
 
-  vtkIGSIOVolumeReconstructor* reconstructor = this->Internal->Reconstructors[volumeReconstructionNode].Reconstructor;
-  if (!reconstructor)
+  ReconstructionInfo& info = this->Internal->Reconstructors[volumeReconstructionNode];
+  if (!info.Reconstructor)
   {
     vtkErrorMacro("Invalid volume reconstructor!");
     return false;
@@ -349,56 +1685,24 @@ bool vtkSlicerVolumeReconstructionLogic::AddVolumeNodeToReconstructedVolume(vtkM
     return false;
   }
 
-  vtkNew<vtkTransform> imageToROITransform;
-  imageToROITransform->PostMultiply();
-
-  vtkNew<vtkMatrix4x4> ijkToRASMatrix;
-  inputVolumeNode->GetIJKToRASMatrix(ijkToRASMatrix);
-  imageToROITransform->Concatenate(ijkToRASMatrix);
-
-  vtkMRMLTransformNode* imageParentTransformNode = inputVolumeNode->GetParentTransformNode();
-  if (imageParentTransformNode)
-  {
-    vtkNew<vtkMatrix4x4> parentToWorldMatrix;
-    imageParentTransformNode->GetMatrixTransformToWorld(parentToWorldMatrix);
-    imageToROITransform->Concatenate(parentToWorldMatrix);
-  }
-
-  vtkMRMLTransformNode* roiParentTransformNode = vtkMRMLTransformableNode::SafeDownCast(volumeReconstructionNode->GetInputROINode())->GetParentTransformNode();
-  if (roiParentTransformNode)
+  if (!vtkInternal::GetImageToROIMatrix(inputVolumeNode, volumeReconstructionNode->GetInputROINode(), info.ImageToROIMatrix))
   {
-    vtkNew<vtkMatrix4x4> worldToParentMatrix;
-    roiParentTransformNode->GetMatrixTransformFromWorld(worldToParentMatrix);
-    imageToROITransform->Concatenate(worldToParentMatrix);
-  }
-
-  if (markupsInputROINode)
-  {
-    vtkNew<vtkMatrix4x4> nodeToObjectMatrix;
-    vtkMatrix4x4::Invert(markupsInputROINode->GetObjectToNodeMatrix(), nodeToObjectMatrix);
-    imageToROITransform->Concatenate(nodeToObjectMatrix);
+    vtkErrorMacro("Could not compute image to ROI transform!");
+    return false;
   }
 
-  vtkNew<vtkIGSIOTransformRepository> transformRepository;
-  transformRepository->SetTransform(igsioTransformName("ImageToROI"), imageToROITransform->GetMatrix());
-
-  vtkImageData* inputImageData = inputVolumeNode->GetImageData();
-
-  // Ensure that output scalar type matches input (only same scalar type can be added to the volume)
-  if (inputImageData)
+  if (!isLast && vtkInternal::IsFramePoseRedundant(volumeReconstructionNode, info, info.ImageToROIMatrix))
   {
-    reconstructor->SetOutputScalarType(inputImageData->GetScalarType());
+    ++info.NumberOfSkippedFrames;
+    volumeReconstructionNode->SetNumberOfSkippedFrames(info.NumberOfSkippedFrames);
+    return true;
   }
 
-  std::string errorDetail;
-  igsioTrackedFrame trackedFrame;
-  trackedFrame.GetImageData()->DeepCopyFrom(inputImageData);
-
-  bool insertedIntoVolume = false;
-  if (reconstructor->AddTrackedFrame(&trackedFrame, transformRepository, isFirst, isLast, &insertedIntoVolume) != IGSIO_SUCCESS)
+  if (!vtkInternal::AddImageToReconstruction(info, inputVolumeNode->GetImageData(), info.ImageToROIMatrix, isFirst, isLast))
   {
     return false;
   }
+  vtkInternal::SetLastAcceptedFramePose(info, info.ImageToROIMatrix);
 
   int numberOfVolumesAddedToReconstruction = volumeReconstructionNode->GetNumberOfVolumesAddedToReconstruction();
   volumeReconstructionNode->SetNumberOfVolumesAddedToReconstruction(numberOfVolumesAddedToReconstruction + 1);
@@ -409,7 +1713,9 @@ bool vtkSlicerVolumeReconstructionLogic::AddVolumeNodeToReconstructedVolume(vtkM
 //---------------------------------------------------------------------------
 void vtkSlicerVolumeReconstructionLogic::GetReconstructedVolume(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode)
 {
-  vtkIGSIOVolumeReconstructor* reconstructor = this->Internal->Reconstructors[volumeReconstructionNode].Reconstructor;
+  ReconstructionInfo& reconstructionInfo = this->Internal->Reconstructors[volumeReconstructionNode];
+  ReconstructionInfo& info = vtkInternal::GetDisplayedReconstruction(reconstructionInfo);
+  vtkIGSIOVolumeReconstructor* reconstructor = info.Reconstructor;
   if (!reconstructor)
   {
     vtkErrorMacro("Invalid volume reconstructor!");
@@ -430,10 +1736,32 @@ void vtkSlicerVolumeReconstructionLogic::GetReconstructedVolume(vtkMRMLVolumeRec
     outputVolumeNode->SetAndObserveImageData(imageData);
   }
 
-  if (reconstructor->GetReconstructedVolume(outputVolumeNode->GetImageData()) != IGSIO_SUCCESS)
   {
-    vtkErrorMacro("Could not retrieve reconstructed image");
+    std::lock_guard<std::mutex> lock(*info.ReconstructorMutex);
+    if (info.SparseAccumulator)
+    {
+      if (!info.SparseAccumulator->GetOutputVolume(outputVolumeNode->GetImageData(), info.CropOutputVolume))
+      {
+        vtkErrorMacro("Could not retrieve reconstructed image");
+      }
+    }
+    else if (info.StitchedVolume)
+    {
+      outputVolumeNode->GetImageData()->ShallowCopy(info.StitchedVolume);
+    }
+    else if (reconstructor->GetReconstructedVolume(outputVolumeNode->GetImageData()) != IGSIO_SUCCESS)
+    {
+      vtkErrorMacro("Could not retrieve reconstructed image");
+    }
+
+    // The whole output is up-to-date
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      info.DirtyExtent[2 * axis] = 0;
+      info.DirtyExtent[2 * axis + 1] = -1;
+    }
   }
+  reconstructionInfo.NeedsFullUpdate = false;
 
   double spacing[3] = { 0.0, 0.0, 0.0 };
   outputVolumeNode->GetImageData()->GetSpacing(spacing);
@@ -469,6 +1797,102 @@ void vtkSlicerVolumeReconstructionLogic::GetReconstructedVolume(vtkMRMLVolumeRec
   volumeReconstructionNode->InvokeEvent(vtkMRMLVolumeReconstructionNode::VolumeReconstructionFinished);
 }
 
+//---------------------------------------------------------------------------
+void vtkSlicerVolumeReconstructionLogic::UpdateReconstructedVolumeModifiedRegion(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode)
+{
+  ReconstructionInfo& reconstructionInfo = this->Internal->Reconstructors[volumeReconstructionNode];
+  ReconstructionInfo& info = vtkInternal::GetDisplayedReconstruction(reconstructionInfo);
+  if (!info.Reconstructor)
+  {
+    vtkErrorMacro("Invalid volume reconstructor!");
+    return;
+  }
+
+  vtkMRMLVolumeNode* outputVolumeNode = volumeReconstructionNode->GetOutputVolumeNode();
+  vtkImageData* outputImageData = outputVolumeNode ? outputVolumeNode->GetImageData() : nullptr;
+  int outputImageExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  if (outputImageData)
+  {
+    outputImageData->GetExtent(outputImageExtent);
+  }
+  // Holes are not filled in the sparse volume and in the preview
+  bool holeFilling = volumeReconstructionNode->GetFillHoles() && !info.SparseAccumulator && !reconstructionInfo.Preview;
+  // The cropped sparse output covers the pasted extent only, the sparse volume checks if the output still covers it
+  bool outputExtentValid = (info.SparseAccumulator && info.CropOutputVolume)
+    || std::equal(outputImageExtent, outputImageExtent + 6, info.OutputExtent);
+  if (!outputImageData || !outputExtentValid || holeFilling
+    || reconstructionInfo.NeedsFullUpdate)
+  {
+    // Output volume is not initialized yet, it still contains the result of a previous reconstruction (that may have had
+    // a different ROI position or orientation), or hole filling may modify voxels anywhere
+    this->GetReconstructedVolume(volumeReconstructionNode);
+    return;
+  }
+
+  int dirtyExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  // Frames may be pasted on the live worker thread, so the dirty extent is only accessed while the lock is held
+  bool regionUpdated = false;
+  {
+    std::lock_guard<std::mutex> lock(*info.ReconstructorMutex);
+    std::copy(info.DirtyExtent, info.DirtyExtent + 6, dirtyExtent);
+    if (dirtyExtent[0] > dirtyExtent[1] || dirtyExtent[2] > dirtyExtent[3] || dirtyExtent[4] > dirtyExtent[5])
+    {
+      // Nothing has changed
+      return;
+    }
+
+    if (info.SparseAccumulator)
+    {
+      // The sparse volume can write the region directly into the output image
+      regionUpdated = info.SparseAccumulator->UpdateOutputVolumeRegion(outputImageData, dirtyExtent, info.CropOutputVolume);
+      if (regionUpdated)
+      {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          info.DirtyExtent[2 * axis] = 0;
+          info.DirtyExtent[2 * axis + 1] = -1;
+        }
+      }
+    }
+    else if (info.Reconstructor->GetReconstructedVolume(info.ReconstructedVolumeBuffer) != IGSIO_SUCCESS)
+    {
+      vtkErrorMacro("Could not retrieve reconstructed image");
+      return;
+    }
+    else
+    {
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        info.DirtyExtent[2 * axis] = 0;
+        info.DirtyExtent[2 * axis + 1] = -1;
+      }
+    }
+  }
+
+  if (info.SparseAccumulator)
+  {
+    if (!regionUpdated)
+    {
+      // Could not update the region (e.g., scalar type changed, or the cropped output has to grow)
+      this->GetReconstructedVolume(volumeReconstructionNode);
+      return;
+    }
+    outputImageData->Modified();
+    return;
+  }
+  if (info.ReconstructedVolumeBuffer->GetScalarType() != outputImageData->GetScalarType()
+    || info.ReconstructedVolumeBuffer->GetNumberOfScalarComponents() != outputImageData->GetNumberOfScalarComponents())
+  {
+    this->GetReconstructedVolume(volumeReconstructionNode);
+    return;
+  }
+
+  // Only the dirty region is copied, the output image keeps its buffer
+  outputImageData->CopyAndCastFrom(info.ReconstructedVolumeBuffer, dirtyExtent);
+
+  outputImageData->Modified();
+}
+
 //---------------------------------------------------------------------------
 void vtkSlicerVolumeReconstructionLogic::ReconstructVolumeFromSequence(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode)
 {
@@ -544,12 +1968,21 @@ void vtkSlicerVolumeReconstructionLogic::ReconstructVolumeFromSequence(vtkMRMLVo
       volumeReconstructionNode->SetAndObserveInputROINode(vtkMRMLMarkupsROINode::SafeDownCast(inputROINode));
     }
 
-    this->CalculateROIFromVolumeSequenceInternal(inputSequenceBrowser, inputVolumeNode, inputROINode);
+    this->CalculateROIFromVolumeSequenceInternal(inputSequenceBrowser, inputVolumeNode, inputROINode,
+      volumeReconstructionNode->GetROIOutlierPercentile());
   }
 
   // Begin volume reconstruction
   this->StartVolumeReconstruction(volumeReconstructionNode);
 
+  // Read the frames directly from the sequences if possible, so that the proxy nodes are not updated for each frame
+  if (this->AddSequenceFramesToReconstructedVolume(volumeReconstructionNode))
+  {
+    this->FinishVolumeReconstruction(volumeReconstructionNode);
+    this->GetApplicationLogic()->ResumeRender();
+    return;
+  }
+
   // Save the currently selected item to restore later
   int selectedItemNumber = inputSequenceBrowser->GetSelectedItemNumber();
 
@@ -560,28 +1993,174 @@ void vtkSlicerVolumeReconstructionLogic::ReconstructVolumeFromSequence(vtkMRMLVo
     this->AddVolumeNodeToReconstructedVolume(volumeReconstructionNode, i == 0, i == numberOfFrames - 1);
   }
 
-  this->GetReconstructedVolume(volumeReconstructionNode);
+  this->FinishVolumeReconstruction(volumeReconstructionNode);
   inputSequenceBrowser->SetSelectedItemNumber(selectedItemNumber);
   this->GetApplicationLogic()->ResumeRender();
 }
 
+//---------------------------------------------------------------------------
+bool vtkSlicerVolumeReconstructionLogic::AddSequenceFramesToReconstructedVolume(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode)
+{
+  vtkMRMLSequenceBrowserNode* inputSequenceBrowser = volumeReconstructionNode ? volumeReconstructionNode->GetInputSequenceBrowserNode() : nullptr;
+  vtkMRMLVolumeNode* inputVolumeNode = volumeReconstructionNode ? volumeReconstructionNode->GetInputVolumeNode() : nullptr;
+  if (!inputSequenceBrowser || !inputVolumeNode)
+  {
+    return false;
+  }
+
+  ReconstructionInfo& info = this->Internal->Reconstructors[volumeReconstructionNode];
+  if (!info.Reconstructor)
+  {
+    return false;
+  }
+
+  SequenceFrameSource frameSource;
+  if (!frameSource.Initialize(inputSequenceBrowser, inputVolumeNode))
+  {
+    return false;
+  }
+
+  // The ROI is not expected to move during reconstruction
+  vtkNew<vtkMatrix4x4> worldToROIMatrix;
+  if (!vtkInternal::GetWorldToROIMatrix(volumeReconstructionNode->GetInputROINode(), worldToROIMatrix))
+  {
+    return false;
+  }
+
+  const int numberOfFrames = frameSource.GetNumberOfFrames();
+  const int queueDepth = volumeReconstructionNode->GetPipelineQueueDepth();
+
+  // Slab-parallel pasting, each slab of the output volume is pasted into by its own reconstructor on its own thread
+  std::vector<std::unique_ptr<ReconstructionSlab>> slabs;
+  if (volumeReconstructionNode->GetNumberOfSlabs() > 1 && !info.SparseAccumulator)
+  {
+    vtkInternal::StartSlabReconstructions(volumeReconstructionNode, info, volumeReconstructionNode->GetNumberOfSlabs(),
+      static_cast<size_t>(std::max(queueDepth, 1)), slabs);
+  }
+
+  // Pose stage: ImageToROI = WorldToROI * ImageParentToWorld * IJKToRAS
+  auto computePose = [&](ReconstructionFrame& frame)
+  {
+    if (!frame.Image)
+    {
+      return;
+    }
+    if (!frameSource.ApplyParentTransforms(frame.Index, frame.ImageToROIMatrix))
+    {
+      frame.Image = nullptr;
+      return;
+    }
+    vtkMatrix4x4::Multiply4x4(worldToROIMatrix, frame.ImageToROIMatrix, frame.ImageToROIMatrix);
+  };
+
+  // Paste stage, always on the calling thread, as it modifies the reconstruction node (with slabs, it only dispatches the frames)
+  auto pasteFrame = [&](ReconstructionFrame& frame)
+  {
+    if (!frame.Image)
+    {
+      vtkWarningMacro("AddSequenceFramesToReconstructedVolume: No valid image or linear transform found for frame " << frame.Index << ", skipping");
+      return;
+    }
+    bool isLast = (frame.Index == numberOfFrames - 1);
+    if (!isLast && vtkInternal::IsFramePoseRedundant(volumeReconstructionNode, info, frame.ImageToROIMatrix))
+    {
+      ++info.NumberOfSkippedFrames;
+      volumeReconstructionNode->SetNumberOfSkippedFrames(info.NumberOfSkippedFrames);
+      return;
+    }
+    if (!slabs.empty())
+    {
+      if (!vtkInternal::DispatchFrameToSlabs(slabs, frame))
+      {
+        return;
+      }
+    }
+    else if (!vtkInternal::AddImageToReconstruction(info, frame.Image, frame.ImageToROIMatrix, frame.Index == 0, isLast))
+    {
+      return;
+    }
+    vtkInternal::SetLastAcceptedFramePose(info, frame.ImageToROIMatrix);
+    int numberOfVolumesAddedToReconstruction = volumeReconstructionNode->GetNumberOfVolumesAddedToReconstruction();
+    volumeReconstructionNode->SetNumberOfVolumesAddedToReconstruction(numberOfVolumesAddedToReconstruction + 1);
+    volumeReconstructionNode->InvokeEvent(vtkMRMLVolumeReconstructionNode::VolumeAddedToReconstruction);
+  };
+
+  if (queueDepth <= 0)
+  {
+    for (int i = 0; i < numberOfFrames; ++i)
+    {
+      // A new frame for each index, as slabs may still hold the previous one
+      ReconstructionFrame frame;
+      frameSource.ReadImage(i, frame);
+      computePose(frame);
+      pasteFrame(frame);
+    }
+    vtkInternal::StitchSlabReconstructions(info, slabs);
+    return true;
+  }
+
+  // Reading (and decoding), pose computation and pasting run on separate threads,
+  // so that they overlap with each other. The queues limit the number of frames held in memory.
+  BoundedQueue<ReconstructionFrame> readFrames(queueDepth);
+  BoundedQueue<ReconstructionFrame> posedFrames(queueDepth);
+
+  std::thread readerThread([&]()
+  {
+    for (int i = 0; i < numberOfFrames; ++i)
+    {
+      ReconstructionFrame frame;
+      frameSource.ReadImage(i, frame);
+      if (!readFrames.Push(std::move(frame)))
+      {
+        break;
+      }
+    }
+    readFrames.Close();
+  });
+
+  std::thread poseThread([&]()
+  {
+    ReconstructionFrame frame;
+    while (readFrames.Pop(frame))
+    {
+      computePose(frame);
+      if (!posedFrames.Push(std::move(frame)))
+      {
+        break;
+      }
+    }
+    posedFrames.Close();
+  });
+
+  ReconstructionFrame frame;
+  while (posedFrames.Pop(frame))
+  {
+    pasteFrame(frame);
+  }
+
+  readerThread.join();
+  poseThread.join();
+  vtkInternal::StitchSlabReconstructions(info, slabs);
+  return true;
+}
+
 //---------------------------------------------------------------------------
 void vtkSlicerVolumeReconstructionLogic::CalculateROIFromVolumeSequence(vtkMRMLSequenceBrowserNode* inputSequenceBrowser,
-  vtkMRMLVolumeNode* inputVolumeNode, vtkMRMLAnnotationROINode* outputROINodeRAS)
+  vtkMRMLVolumeNode* inputVolumeNode, vtkMRMLAnnotationROINode* outputROINodeRAS, double outlierPercentile/*=0.0*/)
 {
-  this->CalculateROIFromVolumeSequenceInternal(inputSequenceBrowser, inputVolumeNode, outputROINodeRAS);
+  this->CalculateROIFromVolumeSequenceInternal(inputSequenceBrowser, inputVolumeNode, outputROINodeRAS, outlierPercentile);
 }
 
 //---------------------------------------------------------------------------
 void vtkSlicerVolumeReconstructionLogic::CalculateROIFromVolumeSequence(vtkMRMLSequenceBrowserNode* inputSequenceBrowser,
-  vtkMRMLVolumeNode* inputVolumeNode, vtkMRMLMarkupsROINode* outputROINodeRAS)
+  vtkMRMLVolumeNode* inputVolumeNode, vtkMRMLMarkupsROINode* outputROINodeRAS, double outlierPercentile/*=0.0*/)
 {
-  this->CalculateROIFromVolumeSequenceInternal(inputSequenceBrowser, inputVolumeNode, outputROINodeRAS);
+  this->CalculateROIFromVolumeSequenceInternal(inputSequenceBrowser, inputVolumeNode, outputROINodeRAS, outlierPercentile);
 }
 
 //---------------------------------------------------------------------------
 void vtkSlicerVolumeReconstructionLogic::CalculateROIFromVolumeSequenceInternal(vtkMRMLSequenceBrowserNode* inputSequenceBrowser,
-  vtkMRMLVolumeNode* inputVolumeNode, vtkMRMLNode* outputROINodeRAS)
+  vtkMRMLVolumeNode* inputVolumeNode, vtkMRMLNode* outputROINodeRAS, double outlierPercentile/*=0.0*/)
 {
   if (!inputSequenceBrowser)
   {
@@ -602,13 +2181,48 @@ void vtkSlicerVolumeReconstructionLogic::CalculateROIFromVolumeSequenceInternal(
     return;
   }
 
-  vtkNew<vtkTransform> imageToROITransform;
-  imageToROITransform->PostMultiply();
-
   double roiBounds[6] = { VTK_DOUBLE_MAX, VTK_DOUBLE_MIN,
                           VTK_DOUBLE_MAX, VTK_DOUBLE_MIN,
                           VTK_DOUBLE_MAX, VTK_DOUBLE_MIN };
 
+  // Read the frames directly from the sequences if possible, otherwise select each frame in the browser
+  if (!vtkInternal::GetSequenceBoundsInROI(inputSequenceBrowser, inputVolumeNode, outputROINodeRAS, outlierPercentile, roiBounds))
+  {
+    this->CalculateROIFromVolumeSequenceByBrowsing(inputSequenceBrowser, inputVolumeNode, outputROINodeRAS, roiBounds);
+  }
+
+  double radius[3] = { 0 };
+  double center[3] = { 0 };
+  for (int i = 0; i < 3; ++i)
+  {
+    radius[i] = 0.5 * (roiBounds[2 * i + 1] - roiBounds[2 * i]);
+    center[i] = (roiBounds[2 * i + 1] + roiBounds[2 * i]) / 2.0;
+  }
+
+  vtkMRMLAnnotationROINode* outputAnnotationROINode = vtkMRMLAnnotationROINode::SafeDownCast(outputROINodeRAS);
+  if (outputAnnotationROINode)
+  {
+    outputAnnotationROINode->SetXYZ(center);
+    outputAnnotationROINode->SetRadiusXYZ(radius);
+  }
+
+  vtkMRMLMarkupsROINode* outputMarkupsROINode = vtkMRMLMarkupsROINode::SafeDownCast(outputROINodeRAS);
+  if (outputMarkupsROINode)
+  {
+    outputMarkupsROINode->SetCenter(center);
+    outputMarkupsROINode->SetSize(radius);
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVolumeReconstructionLogic::CalculateROIFromVolumeSequenceByBrowsing(vtkMRMLSequenceBrowserNode* inputSequenceBrowser,
+  vtkMRMLVolumeNode* inputVolumeNode, vtkMRMLNode* outputROINodeRAS, double roiBounds[6])
+{
+  vtkMRMLSequenceNode* masterSequence = inputSequenceBrowser->GetMasterSequenceNode();
+
+  vtkNew<vtkTransform> imageToROITransform;
+  imageToROITransform->PostMultiply();
+
   const int numberOfFrames = masterSequence->GetNumberOfDataNodes();
   int selectedItemNumber = inputSequenceBrowser->GetSelectedItemNumber();
   for (int i = 0; i < numberOfFrames; ++i)
@@ -675,28 +2289,6 @@ void vtkSlicerVolumeReconstructionLogic::CalculateROIFromVolumeSequenceInternal(
     }
   }
   inputSequenceBrowser->SetSelectedItemNumber(selectedItemNumber);
-
-  double radius[3] = { 0 };
-  double center[3] = { 0 };
-  for (int i = 0; i < 3; ++i)
-  {
-    radius[i] = 0.5 * (roiBounds[2 * i + 1] - roiBounds[2 * i]);
-    center[i] = (roiBounds[2 * i + 1] + roiBounds[2 * i]) / 2.0;
-  }
-
-  vtkMRMLAnnotationROINode* outputAnnotationROINode = vtkMRMLAnnotationROINode::SafeDownCast(outputROINodeRAS);
-  if (outputAnnotationROINode)
-  {
-    outputAnnotationROINode->SetXYZ(center);
-    outputAnnotationROINode->SetRadiusXYZ(radius);
-  }
-
-  vtkMRMLMarkupsROINode* outputMarkupsROINode = vtkMRMLMarkupsROINode::SafeDownCast(outputROINodeRAS);
-  if (outputMarkupsROINode)
-  {
-    outputMarkupsROINode->SetCenter(center);
-    outputMarkupsROINode->SetSize(radius);
-  }
 }
 
 //---------------------------------------------------------------------------
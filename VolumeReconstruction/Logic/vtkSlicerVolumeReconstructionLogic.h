@@ -60,18 +60,36 @@ public:
   void StartVolumeReconstruction(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode);
   void StartLiveVolumeReconstruction(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode);
   void ResumeLiveVolumeReconstruction(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode);
+  /// Stop live reconstruction and update the output volume with the result.
+  /// The call blocks until all frames that are waiting in the live queue are pasted into the reconstruction
+  /// (with live preview this may take a while if pasting could not keep up with the frame rate).
   void StopLiveVolumeReconstruction(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode);
   bool AddVolumeNodeToReconstructedVolume(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode, bool isFirst, bool isLast);
   void GetReconstructedVolume(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode);
 
+  /// Update the output volume node with the region of the reconstruction that was modified since the last update.
+  /// The rest of the output image is not changed. If the output volume cannot be updated partially (for example it has not been
+  /// created yet or hole filling is enabled) then the whole output is updated as in GetReconstructedVolume.
+  /// This only reduces the cost of copying the reconstruction into the output image: the output image is still marked as
+  /// modified as a whole, so display pipelines update the whole volume.
+  void UpdateReconstructedVolumeModifiedRegion(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode);
+
+  /// Write the reconstructed volume to a NRRD file directly from the sparse (or out-of-core) accumulation volume,
+  /// without creating the output image in memory. The volume is written in the coordinate system of the ROI's parent.
+  /// Returns false if sparse accumulation is not used by the reconstruction.
+  bool WriteReconstructedVolumeToFile(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode, const char* fileName);
+
   void ReconstructVolumeFromSequence(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode);
 
+  /// Set the ROI to the bounds of all frames of the input volume in the sequence.
+  /// If outlierPercentile is positive then the given percentage of frames with the most extreme bounds
+  /// is ignored on each side (e.g., frames with tracking errors that would make the ROI very large).
   void CalculateROIFromVolumeSequence(vtkMRMLSequenceBrowserNode* inputSequenceBrowser,
-    vtkMRMLVolumeNode* inputVolumeNode, vtkMRMLAnnotationROINode* outputROINodeRAS);
+    vtkMRMLVolumeNode* inputVolumeNode, vtkMRMLAnnotationROINode* outputROINodeRAS, double outlierPercentile = 0.0);
   void CalculateROIFromVolumeSequence(vtkMRMLSequenceBrowserNode* inputSequenceBrowser,
-    vtkMRMLVolumeNode* inputVolumeNode, vtkMRMLMarkupsROINode* outputROINodeRAS);
+    vtkMRMLVolumeNode* inputVolumeNode, vtkMRMLMarkupsROINode* outputROINodeRAS, double outlierPercentile = 0.0);
   void CalculateROIFromVolumeSequenceInternal(vtkMRMLSequenceBrowserNode* inputSequenceBrowser,
-    vtkMRMLVolumeNode* inputVolumeNode, vtkMRMLNode* outputROINodeRAS);
+    vtkMRMLVolumeNode* inputVolumeNode, vtkMRMLNode* outputROINodeRAS, double outlierPercentile = 0.0);
 
   vtkMRMLVolumeNode* GetOrAddOutputVolumeNode(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode);
 
@@ -85,6 +103,19 @@ protected:
 
   virtual void ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData);
 
+  /// Add all frames of the input sequence browser to the reconstruction by reading the image and transform
+  /// nodes directly from the sequence nodes. The selected item of the browser and the proxy nodes are not modified.
+  /// Returns false without adding any frames if the input volume or its parent transforms cannot be read from the sequences.
+  bool AddSequenceFramesToReconstructedVolume(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode);
+
+  /// Write the result to the output volume file if it is specified in the node, otherwise update the output volume node
+  void FinishVolumeReconstruction(vtkMRMLVolumeReconstructionNode* volumeReconstructionNode);
+
+  /// Extend the bounds with all frames of the input volume by selecting each item of the browser.
+  /// Used if the input volume cannot be read directly from the sequences.
+  void CalculateROIFromVolumeSequenceByBrowsing(vtkMRMLSequenceBrowserNode* inputSequenceBrowser,
+    vtkMRMLVolumeNode* inputVolumeNode, vtkMRMLNode* outputROINodeRAS, double roiBounds[6]);
+
   //----------------------------------------------------------------
   // Constructor, destructor etc.
   //----------------------------------------------------------------
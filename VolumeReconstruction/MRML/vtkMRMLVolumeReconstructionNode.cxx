@@ -57,9 +57,25 @@ vtkMRMLVolumeReconstructionNode::vtkMRMLVolumeReconstructionNode()
   this->CompoundingMode = MAXIMUM_COMPOUNDING_MODE;
   this->FillHoles = false;
   this->NumberOfThreads = 0;
+  this->PipelineQueueDepth = 8;
+  this->NumberOfSlabs = 1;
+  this->ROIOutlierPercentile = 0.0;
+  this->LiveFrameQueueSize = 5;
+  this->LiveFrameDropPolicy = DROP_OLDEST_FRAME;
+  this->LiveFrameKeepInterval = 2;
+  this->LivePreviewSpacingFactor = 1.0;
+  this->PoseChangeTranslationThresholdMm = 0.0;
+  this->PoseChangeRotationThresholdDeg = 0.0;
+  this->SparseAccumulation = false;
+  this->SparseBrickSize = 32;
+  this->CropOutputVolume = false;
 
   this->NumberOfVolumesAddedToReconstruction = 0;
   this->LiveVolumeReconstructionInProgress = false;
+  this->NumberOfLiveFramesInQueue = 0;
+  this->NumberOfDroppedLiveFrames = 0;
+  this->LastFramePasteTimeSeconds = 0.0;
+  this->NumberOfSkippedFrames = 0;
 
   this->AddNodeReferenceRole(this->GetInputSequenceBrowserNodeReferenceRole(), this->GetInputSequenceBrowserNodeReferenceMRMLAttributeName());
   this->AddNodeReferenceRole(this->GetInputROINodeReferenceRole(), this->GetInputROINodeReferenceMRMLAttributeName());
@@ -88,6 +104,20 @@ void vtkMRMLVolumeReconstructionNode::WriteXML(ostream& of, int nIndent)
   vtkMRMLWriteXMLEnumMacro(compoundingMode, CompoundingMode);
   vtkMRMLWriteXMLBooleanMacro(fillHoles, FillHoles);
   vtkMRMLWriteXMLIntMacro(numberOfThreads, NumberOfThreads);
+  vtkMRMLWriteXMLIntMacro(pipelineQueueDepth, PipelineQueueDepth);
+  vtkMRMLWriteXMLIntMacro(numberOfSlabs, NumberOfSlabs);
+  vtkMRMLWriteXMLFloatMacro(roiOutlierPercentile, ROIOutlierPercentile);
+  vtkMRMLWriteXMLIntMacro(liveFrameQueueSize, LiveFrameQueueSize);
+  vtkMRMLWriteXMLEnumMacro(liveFrameDropPolicy, LiveFrameDropPolicy);
+  vtkMRMLWriteXMLIntMacro(liveFrameKeepInterval, LiveFrameKeepInterval);
+  vtkMRMLWriteXMLFloatMacro(livePreviewSpacingFactor, LivePreviewSpacingFactor);
+  vtkMRMLWriteXMLFloatMacro(poseChangeTranslationThresholdMm, PoseChangeTranslationThresholdMm);
+  vtkMRMLWriteXMLFloatMacro(poseChangeRotationThresholdDeg, PoseChangeRotationThresholdDeg);
+  vtkMRMLWriteXMLBooleanMacro(sparseAccumulation, SparseAccumulation);
+  vtkMRMLWriteXMLIntMacro(sparseBrickSize, SparseBrickSize);
+  vtkMRMLWriteXMLBooleanMacro(cropOutputVolume, CropOutputVolume);
+  vtkMRMLWriteXMLStdStringMacro(scratchFileDirectory, ScratchFileDirectory);
+  vtkMRMLWriteXMLStdStringMacro(outputVolumeFileName, OutputVolumeFileName);
   vtkMRMLWriteXMLEndMacro();
 }
 
@@ -107,6 +137,20 @@ void vtkMRMLVolumeReconstructionNode::ReadXMLAttributes(const char** atts)
   vtkMRMLReadXMLEnumMacro(compoundingMode, CompoundingMode);
   vtkMRMLReadXMLBooleanMacro(fillHoles, FillHoles);
   vtkMRMLReadXMLIntMacro(numberOfThreads, NumberOfThreads);
+  vtkMRMLReadXMLIntMacro(pipelineQueueDepth, PipelineQueueDepth);
+  vtkMRMLReadXMLIntMacro(numberOfSlabs, NumberOfSlabs);
+  vtkMRMLReadXMLFloatMacro(roiOutlierPercentile, ROIOutlierPercentile);
+  vtkMRMLReadXMLIntMacro(liveFrameQueueSize, LiveFrameQueueSize);
+  vtkMRMLReadXMLEnumMacro(liveFrameDropPolicy, LiveFrameDropPolicy);
+  vtkMRMLReadXMLIntMacro(liveFrameKeepInterval, LiveFrameKeepInterval);
+  vtkMRMLReadXMLFloatMacro(livePreviewSpacingFactor, LivePreviewSpacingFactor);
+  vtkMRMLReadXMLFloatMacro(poseChangeTranslationThresholdMm, PoseChangeTranslationThresholdMm);
+  vtkMRMLReadXMLFloatMacro(poseChangeRotationThresholdDeg, PoseChangeRotationThresholdDeg);
+  vtkMRMLReadXMLBooleanMacro(sparseAccumulation, SparseAccumulation);
+  vtkMRMLReadXMLIntMacro(sparseBrickSize, SparseBrickSize);
+  vtkMRMLReadXMLBooleanMacro(cropOutputVolume, CropOutputVolume);
+  vtkMRMLReadXMLStdStringMacro(scratchFileDirectory, ScratchFileDirectory);
+  vtkMRMLReadXMLStdStringMacro(outputVolumeFileName, OutputVolumeFileName);
   vtkMRMLReadXMLEndMacro();
 }
 
@@ -127,6 +171,20 @@ void vtkMRMLVolumeReconstructionNode::Copy(vtkMRMLNode* anode)
   vtkMRMLCopyEnumMacro(CompoundingMode);
   vtkMRMLCopyBooleanMacro(FillHoles);
   vtkMRMLCopyIntMacro(NumberOfThreads);
+  vtkMRMLCopyIntMacro(PipelineQueueDepth);
+  vtkMRMLCopyIntMacro(NumberOfSlabs);
+  vtkMRMLCopyFloatMacro(ROIOutlierPercentile);
+  vtkMRMLCopyIntMacro(LiveFrameQueueSize);
+  vtkMRMLCopyEnumMacro(LiveFrameDropPolicy);
+  vtkMRMLCopyIntMacro(LiveFrameKeepInterval);
+  vtkMRMLCopyFloatMacro(LivePreviewSpacingFactor);
+  vtkMRMLCopyFloatMacro(PoseChangeTranslationThresholdMm);
+  vtkMRMLCopyFloatMacro(PoseChangeRotationThresholdDeg);
+  vtkMRMLCopyBooleanMacro(SparseAccumulation);
+  vtkMRMLCopyIntMacro(SparseBrickSize);
+  vtkMRMLCopyBooleanMacro(CropOutputVolume);
+  vtkMRMLCopyStdStringMacro(ScratchFileDirectory);
+  vtkMRMLCopyStdStringMacro(OutputVolumeFileName);
   vtkMRMLCopyEndMacro();
 }
 
@@ -146,8 +204,26 @@ void vtkMRMLVolumeReconstructionNode::PrintSelf(ostream& os, vtkIndent indent)
   vtkMRMLPrintEnumMacro(CompoundingMode);
   vtkMRMLPrintBooleanMacro(FillHoles);
   vtkMRMLPrintIntMacro(NumberOfThreads);
+  vtkMRMLPrintIntMacro(PipelineQueueDepth);
+  vtkMRMLPrintIntMacro(NumberOfSlabs);
+  vtkMRMLPrintFloatMacro(ROIOutlierPercentile);
+  vtkMRMLPrintIntMacro(LiveFrameQueueSize);
+  vtkMRMLPrintEnumMacro(LiveFrameDropPolicy);
+  vtkMRMLPrintIntMacro(LiveFrameKeepInterval);
+  vtkMRMLPrintFloatMacro(LivePreviewSpacingFactor);
+  vtkMRMLPrintFloatMacro(PoseChangeTranslationThresholdMm);
+  vtkMRMLPrintFloatMacro(PoseChangeRotationThresholdDeg);
+  vtkMRMLPrintBooleanMacro(SparseAccumulation);
+  vtkMRMLPrintIntMacro(SparseBrickSize);
+  vtkMRMLPrintBooleanMacro(CropOutputVolume);
+  vtkMRMLPrintStdStringMacro(ScratchFileDirectory);
+  vtkMRMLPrintStdStringMacro(OutputVolumeFileName);
   vtkMRMLPrintIntMacro(NumberOfVolumesAddedToReconstruction);
   vtkMRMLPrintIntMacro(LiveVolumeReconstructionInProgress);
+  vtkMRMLPrintIntMacro(NumberOfLiveFramesInQueue);
+  vtkMRMLPrintIntMacro(NumberOfDroppedLiveFrames);
+  vtkMRMLPrintFloatMacro(LastFramePasteTimeSeconds);
+  vtkMRMLPrintIntMacro(NumberOfSkippedFrames);
   vtkMRMLPrintEndMacro();
 }
 
@@ -208,6 +284,31 @@ int vtkMRMLVolumeReconstructionNode::GetCompoundingModeFromString(const char* co
   return MAXIMUM_COMPOUNDING_MODE;
 }
 
+//----------------------------------------------------------------------------
+const char* vtkMRMLVolumeReconstructionNode::GetLiveFrameDropPolicyAsString(int liveFrameDropPolicy)
+{
+  switch (liveFrameDropPolicy)
+  {
+  case DROP_OLDEST_FRAME: return "DROP_OLDEST";
+  case DROP_NEWEST_FRAME: return "DROP_NEWEST";
+  case KEEP_EVERY_NTH_FRAME: return "KEEP_EVERY_NTH";
+  default: return "";
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeReconstructionNode::GetLiveFrameDropPolicyFromString(const char* liveFrameDropPolicy)
+{
+  for (int i = 0; i < LIVE_FRAME_DROP_POLICY_LAST; ++i)
+  {
+    if (strcmp(this->GetLiveFrameDropPolicyAsString(i), liveFrameDropPolicy) == 0)
+    {
+      return i;
+    }
+  }
+  return DROP_OLDEST_FRAME;
+}
+
 
 //----------------------------------------------------------------------------
 void vtkMRMLVolumeReconstructionNode::ProcessMRMLEvents(vtkObject* caller, unsigned long eventID, void* callData)
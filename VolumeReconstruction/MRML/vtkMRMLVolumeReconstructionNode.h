@@ -100,6 +100,14 @@ public:
     COMPOUNDING_MODE_LAST
   };
 
+  enum LiveFrameDropPolicyType
+  {
+    DROP_OLDEST_FRAME,
+    DROP_NEWEST_FRAME,
+    KEEP_EVERY_NTH_FRAME,
+    LIVE_FRAME_DROP_POLICY_LAST
+  };
+
   /*!
   InputSequenceBrowserNode is used for reconstructing an image volume from a sequence.
   The InputSequenceBrowserNode should contain the sequences for the InputVolumeNode, as well as all recorded transforms.
@@ -231,6 +239,141 @@ public:
   vtkSetMacro(NumberOfThreads, int);
   vtkGetMacro(NumberOfThreads, int);
 
+  /*!
+  Maximum number of frames that can be waiting between the stages (read and decode, pose computation, pasting)
+  of the offline reconstruction from a sequence. The stages run on separate threads, so that reading and decoding
+  of the next frames overlaps with compounding. Choose 0 to process the frames sequentially on the calling thread.
+  */
+  vtkSetMacro(PipelineQueueDepth, int);
+  vtkGetMacro(PipelineQueueDepth, int);
+
+  /*!
+  Number of slabs for offline reconstruction from a sequence. If greater than 1, the output volume is split into slabs along
+  its largest axis, each slab is reconstructed by a separate reconstructor on its own thread (frames are only pasted into
+  the slabs that they intersect), and the slabs are stitched together when all frames are added.
+  NumberOfThreads is divided between the slabs. Not used with sparse accumulation. Default is 1 (no slabs).
+  */
+  vtkSetMacro(NumberOfSlabs, int);
+  vtkGetMacro(NumberOfSlabs, int);
+
+  /*!
+  Percentage of frames that are ignored on each side when the ROI is computed automatically from the sequence.
+  A small value (e.g., 1) prevents a few frames with tracking errors from making the ROI, and so the output volume, very large.
+  Choose 0 (this is the default) to include all frames.
+  */
+  vtkSetMacro(ROIOutlierPercentile, double);
+  vtkGetMacro(ROIOutlierPercentile, double);
+
+  /*!
+  During live reconstruction, the frames are pasted into the volume on a background thread.
+  LiveFrameQueueSize is the maximum number of frames that are waiting to be pasted.
+  If the queue is full then frames are dropped according to LiveFrameDropPolicy (or, with live preview, the new frame
+  waits until there is space in the queue).
+  Choose 0 to paste each frame synchronously on the calling thread when the input volume is modified
+  (no frames are dropped, but the application is blocked while the frame is pasted, and there is no live preview).
+  */
+  vtkSetMacro(LiveFrameQueueSize, int);
+  vtkGetMacro(LiveFrameQueueSize, int);
+
+  /*!
+  Set which frames are dropped during live reconstruction
+  DROP_OLDEST:     If the queue is full, the oldest waiting frame is dropped, so that the latest frame is always pasted. (default)
+  DROP_NEWEST:     If the queue is full, the new frame is dropped.
+  KEEP_EVERY_NTH:  Only every LiveFrameKeepInterval-th frame is added to the queue, the new frame is dropped if the queue is full.
+  */
+  vtkSetMacro(LiveFrameDropPolicy, int);
+  vtkGetMacro(LiveFrameDropPolicy, int);
+  const char* GetLiveFrameDropPolicyAsString(int liveFrameDropPolicy);
+  int GetLiveFrameDropPolicyFromString(const char* liveFrameDropPolicy);
+
+  /*!
+  The interval of kept frames if LiveFrameDropPolicy is KEEP_EVERY_NTH.
+  */
+  vtkSetMacro(LiveFrameKeepInterval, int);
+  vtkGetMacro(LiveFrameKeepInterval, int);
+
+  /*!
+  If greater than 1, live reconstruction shows a coarse preview in the output volume, reconstructed with the output spacing
+  multiplied by this factor (e.g., 4). All frames are pasted into the full resolution reconstruction on a background thread
+  (frames are not dropped: if LiveFrameQueueSize frames are already waiting then adding a new frame blocks the application until
+  the background thread has pasted a frame), and the output volume is switched to the full resolution result when live reconstruction
+  is stopped. Stopping blocks the application until the waiting frames are pasted.
+  Default is 1 (no preview).
+  */
+  vtkSetMacro(LivePreviewSpacingFactor, double);
+  vtkGetMacro(LivePreviewSpacingFactor, double);
+
+  /*!
+  Pose change thresholds for skipping redundant frames (e.g., while the probe is held still), in live and sequence reconstruction.
+  A frame is skipped if both its translation (in mm) and its rotation (in degrees) relative to the last added frame are
+  within the thresholds. A threshold that is 0 (or negative) is ignored, i.e., if only the translation threshold is set then
+  frames are skipped based on translation only, regardless of rotation (and vice versa).
+  Both are 0 by default, which means that no frames are skipped.
+  */
+  vtkSetMacro(PoseChangeTranslationThresholdMm, double);
+  vtkGetMacro(PoseChangeTranslationThresholdMm, double);
+  vtkSetMacro(PoseChangeRotationThresholdDeg, double);
+  vtkGetMacro(PoseChangeRotationThresholdDeg, double);
+
+  /*!
+  Number of frames that were skipped since the reconstruction was started, because their pose was within the pose change thresholds.
+  */
+  vtkSetMacro(NumberOfSkippedFrames, int);
+  vtkGetMacro(NumberOfSkippedFrames, int);
+
+  /*!
+  If enabled, the volume is accumulated in bricks that are only allocated where image pixels are pasted,
+  instead of the dense buffer of the reconstructor. This keeps memory usage proportional to the swept region
+  when the ROI is large compared to the sweep. Pixels are pasted into the nearest voxel and holes are not filled.
+  */
+  vtkSetMacro(SparseAccumulation, bool);
+  vtkGetMacro(SparseAccumulation, bool);
+  vtkBooleanMacro(SparseAccumulation, bool);
+
+  /*!
+  Number of voxels along each side of a brick if SparseAccumulation is enabled.
+  */
+  vtkSetMacro(SparseBrickSize, int);
+  vtkGetMacro(SparseBrickSize, int);
+
+  /*!
+  If enabled (and SparseAccumulation is enabled), the output volume is cropped to the region that
+  image pixels were pasted into. During live reconstruction only the modified region of the output volume is updated
+  while the pasted region does not grow, the whole output volume is updated when the pasted region grows.
+  */
+  vtkSetMacro(CropOutputVolume, bool);
+  vtkGetMacro(CropOutputVolume, bool);
+  vtkBooleanMacro(CropOutputVolume, bool);
+
+  /*!
+  Directory of the scratch file for out-of-core reconstruction. If set, the accumulation volume is stored in a
+  memory-mapped file in this directory (local disk is recommended) instead of in memory, and sparse accumulation is used.
+  The file name contains the node ID and the process ID, so the directory can be shared by several application instances.
+  Empty by default.
+  */
+  vtkSetStdStringFromCharMacro(ScratchFileDirectory);
+  vtkGetCharFromStdStringMacro(ScratchFileDirectory);
+
+  /*!
+  If set and sparse accumulation is used, the result is written to this NRRD file at the end of the reconstruction,
+  directly from the accumulation volume, and it is not loaded into the output volume node.
+  Empty by default.
+  */
+  vtkSetStdStringFromCharMacro(OutputVolumeFileName);
+  vtkGetCharFromStdStringMacro(OutputVolumeFileName);
+
+  /*!
+  Statistics of live reconstruction, updated periodically during live reconstruction:
+  number of frames waiting to be pasted, number of frames dropped since live reconstruction
+  was started, and time in seconds that pasting of the last frame took.
+  */
+  vtkSetMacro(NumberOfLiveFramesInQueue, int);
+  vtkGetMacro(NumberOfLiveFramesInQueue, int);
+  vtkSetMacro(NumberOfDroppedLiveFrames, int);
+  vtkGetMacro(NumberOfDroppedLiveFrames, int);
+  vtkSetMacro(LastFramePasteTimeSeconds, double);
+  vtkGetMacro(LastFramePasteTimeSeconds, double);
+
   /*!
   The number of individual volumes that have been added to the reconstruction.
   */
@@ -256,6 +399,24 @@ protected:
   int CompoundingMode;
   bool FillHoles;
   int NumberOfThreads;
+  int PipelineQueueDepth;
+  int NumberOfSlabs;
+  double ROIOutlierPercentile;
+  int LiveFrameQueueSize;
+  int LiveFrameDropPolicy;
+  int LiveFrameKeepInterval;
+  double LivePreviewSpacingFactor;
+  double PoseChangeTranslationThresholdMm;
+  double PoseChangeRotationThresholdDeg;
+  int NumberOfSkippedFrames;
+  bool SparseAccumulation;
+  int SparseBrickSize;
+  bool CropOutputVolume;
+  std::string ScratchFileDirectory;
+  std::string OutputVolumeFileName;
+  int NumberOfLiveFramesInQueue;
+  int NumberOfDroppedLiveFrames;
+  double LastFramePasteTimeSeconds;
   int NumberOfVolumesAddedToReconstruction;
   bool LiveVolumeReconstructionInProgress;
 };
@@ -0,0 +1,439 @@
+/*==============================================================================
+
+Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+==============================================================================*/
+
+// Benchmark and regression test for volume reconstruction from a sequence.
+//
+// A synthetic phantom volume is resliced along a scripted probe path (a linear sweep with a
+// wobbling tilt) and the slices are stored in a sequence node, as a tracked ultrasound sweep
+// would be. The sweep is reconstructed with all combinations of interpolation, compounding and
+// optimization modes and thread counts. Frames per second, the increase of the process memory
+// usage over the memory usage before the scenario (the output volume and the buffers of the
+// reconstructor are still allocated when it is measured), and RMS error of the filled voxels
+// against the phantom are reported as JSON.
+//
+// Usage: vtkVolumeReconstructionBenchmark [output JSON file] [number of frames]
+// Without arguments a short sweep is reconstructed and the JSON report is printed to the standard output.
+// The test fails if no voxels are filled or the RMS error exceeds MAXIMUM_RMS_ERROR in any scenario.
+
+// VolumeReconstruction includes
+#include <vtkMRMLVolumeReconstructionNode.h>
+#include <vtkSlicerVolumeReconstructionLogic.h>
+
+// Slicer includes
+#include <vtkSlicerApplicationLogic.h>
+
+// MRML includes
+#include <vtkMRMLMarkupsROINode.h>
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLScene.h>
+
+// Sequences includes
+#include <vtkMRMLSequenceBrowserNode.h>
+#include <vtkMRMLSequenceNode.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkImageReslice.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+#include <vtkTransform.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#else
+#include <unistd.h>
+#endif
+
+int DEFAULT_NUMBER_OF_FRAMES = 100;
+// Phantom values are between 28 and 228, a constant volume of 128 would have an RMS error of about 35,
+// a correct reconstruction differs from the phantom by a few grey levels
+double MAXIMUM_RMS_ERROR = 10.0;
+double PHANTOM_SIZE_MM = 80.0;
+double PHANTOM_SPACING_MM = 1.0;
+int IMAGE_SIZE_PIXELS[2] = { 100, 80 };
+double IMAGE_SPACING_MM = 0.5;
+double SWEEP_LENGTH_MM = 60.0;
+double WOBBLE_AMPLITUDE_DEG = 5.0;
+double OUTPUT_SPACING_MM = 1.0;
+
+//----------------------------------------------------------------------------
+// Smooth pattern with values in the range of an 8-bit ultrasound image, never 0 (0 is an empty voxel)
+double GetPhantomValue(const double position[3])
+{
+  return 128.0 + 100.0 * sin(2.0 * vtkMath::Pi() * position[0] / 40.0) * cos(2.0 * vtkMath::Pi() * position[1] / 50.0)
+    * sin(2.0 * vtkMath::Pi() * position[2] / 30.0);
+}
+
+//----------------------------------------------------------------------------
+// Current (not peak) resident memory of the process, so that the difference between two calls
+// shows the memory that was allocated in between
+double GetMemoryUsageMB()
+{
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+  {
+    return 0.0;
+  }
+  return counters.WorkingSetSize / (1024.0 * 1024.0);
+#elif defined(__APPLE__)
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS)
+  {
+    return 0.0;
+  }
+  return info.resident_size / (1024.0 * 1024.0);
+#else
+  // Second field of statm is the number of resident pages
+  std::ifstream statm("/proc/self/statm");
+  long totalPages = 0;
+  long residentPages = 0;
+  if (!(statm >> totalPages >> residentPages))
+  {
+    return 0.0;
+  }
+  return residentPages * static_cast<double>(sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0);
+#endif
+}
+
+//----------------------------------------------------------------------------
+struct ScenarioResult
+{
+  int InterpolationMode;
+  int CompoundingMode;
+  int OptimizationMode;
+  int NumberOfThreads;
+  int NumberOfFramesAdded;
+  double WallTimeSec;
+  double MemoryIncreaseMB;
+  double RmsError;
+  double FilledVoxelRatio;
+};
+
+//----------------------------------------------------------------------------
+void CreatePhantom(vtkImageData* phantom)
+{
+  int size = static_cast<int>(PHANTOM_SIZE_MM / PHANTOM_SPACING_MM);
+  phantom->SetExtent(0, size - 1, 0, size - 1, 0, size - 1);
+  phantom->SetSpacing(PHANTOM_SPACING_MM, PHANTOM_SPACING_MM, PHANTOM_SPACING_MM);
+  double origin = -0.5 * (size - 1) * PHANTOM_SPACING_MM;
+  phantom->SetOrigin(origin, origin, origin);
+  phantom->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  unsigned char* voxel = static_cast<unsigned char*>(phantom->GetScalarPointer());
+  for (int k = 0; k < size; k++)
+  {
+    for (int j = 0; j < size; j++)
+    {
+      for (int i = 0; i < size; i++, voxel++)
+      {
+        double position[3] = { origin + i * PHANTOM_SPACING_MM, origin + j * PHANTOM_SPACING_MM, origin + k * PHANTOM_SPACING_MM };
+        *voxel = static_cast<unsigned char>(std::round(GetPhantomValue(position)));
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+// Image plane: image I axis is lateral (X), image J axis is depth (Z), the probe is swept along Y
+// while it is tilted back and forth around the depth axis.
+void GetFramePose(int frameIndex, int numberOfFrames, vtkMatrix4x4* imageToPhantomDirectionMatrix)
+{
+  double sweepPosition = -0.5 * SWEEP_LENGTH_MM + SWEEP_LENGTH_MM * frameIndex / std::max(1, numberOfFrames - 1);
+  double tiltDeg = WOBBLE_AMPLITUDE_DEG * sin(2.0 * vtkMath::Pi() * frameIndex / 50.0);
+
+  vtkNew<vtkTransform> imageToPhantom;
+  imageToPhantom->Translate(0.0, sweepPosition, 0.0);
+  imageToPhantom->RotateZ(tiltDeg);
+  imageToPhantom->Translate(-0.5 * (IMAGE_SIZE_PIXELS[0] - 1) * IMAGE_SPACING_MM, 0.0, -0.5 * (IMAGE_SIZE_PIXELS[1] - 1) * IMAGE_SPACING_MM);
+  // image axes (I, J, normal) to phantom axes (X, Z, -Y)
+  vtkNew<vtkMatrix4x4> axesMatrix;
+  axesMatrix->SetElement(1, 1, 0.0);
+  axesMatrix->SetElement(2, 1, 1.0);
+  axesMatrix->SetElement(1, 2, -1.0);
+  axesMatrix->SetElement(2, 2, 0.0);
+  imageToPhantom->Concatenate(axesMatrix.GetPointer());
+  imageToPhantomDirectionMatrix->DeepCopy(imageToPhantom->GetMatrix());
+}
+
+//----------------------------------------------------------------------------
+void CreateSweep(vtkMRMLScene* scene, vtkImageData* phantom, int numberOfFrames,
+  vtkMRMLSequenceBrowserNode* sequenceBrowserNode, vtkMRMLScalarVolumeNode* proxyVolumeNode)
+{
+  vtkNew<vtkMRMLSequenceNode> sequenceNode;
+  sequenceNode->SetIndexName("time");
+  sequenceNode->SetIndexUnit("s");
+  scene->AddNode(sequenceNode.GetPointer());
+
+  vtkNew<vtkImageReslice> reslice;
+  reslice->SetInputData(phantom);
+  reslice->SetInterpolationModeToLinear();
+  reslice->SetOutputExtent(0, IMAGE_SIZE_PIXELS[0] - 1, 0, IMAGE_SIZE_PIXELS[1] - 1, 0, 0);
+  reslice->SetOutputSpacing(IMAGE_SPACING_MM, IMAGE_SPACING_MM, 1.0);
+  reslice->SetOutputOrigin(0.0, 0.0, 0.0);
+  reslice->SetBackgroundLevel(0.0);
+
+  for (int frameIndex = 0; frameIndex < numberOfFrames; frameIndex++)
+  {
+    vtkNew<vtkMatrix4x4> imageToPhantomDirectionMatrix;
+    GetFramePose(frameIndex, numberOfFrames, imageToPhantomDirectionMatrix.GetPointer());
+    reslice->SetResliceAxes(imageToPhantomDirectionMatrix.GetPointer());
+    reslice->Update();
+
+    // Geometry is stored in the volume node, the image data has unit spacing and zero origin
+    vtkNew<vtkImageData> frameImage;
+    frameImage->DeepCopy(reslice->GetOutput());
+    frameImage->SetSpacing(1.0, 1.0, 1.0);
+    frameImage->SetOrigin(0.0, 0.0, 0.0);
+
+    vtkNew<vtkMatrix4x4> ijkToRASMatrix;
+    ijkToRASMatrix->DeepCopy(imageToPhantomDirectionMatrix.GetPointer());
+    for (int row = 0; row < 3; row++)
+    {
+      for (int column = 0; column < 3; column++)
+      {
+        ijkToRASMatrix->SetElement(row, column, imageToPhantomDirectionMatrix->GetElement(row, column) * IMAGE_SPACING_MM);
+      }
+    }
+
+    vtkNew<vtkMRMLScalarVolumeNode> frameVolumeNode;
+    frameVolumeNode->SetAndObserveImageData(frameImage.GetPointer());
+    frameVolumeNode->SetIJKToRASMatrix(ijkToRASMatrix.GetPointer());
+    sequenceNode->SetDataNodeAtValue(frameVolumeNode.GetPointer(), std::to_string(frameIndex * 0.05));
+    if (frameIndex == 0)
+    {
+      proxyVolumeNode->SetAndObserveImageData(frameImage.GetPointer());
+      proxyVolumeNode->SetIJKToRASMatrix(ijkToRASMatrix.GetPointer());
+    }
+  }
+
+  scene->AddNode(proxyVolumeNode);
+  scene->AddNode(sequenceBrowserNode);
+  sequenceBrowserNode->SetAndObserveMasterSequenceNodeID(sequenceNode->GetID());
+  sequenceBrowserNode->AddProxyNode(proxyVolumeNode, sequenceNode.GetPointer(), false);
+}
+
+//----------------------------------------------------------------------------
+// RMS difference of the filled (non-zero) voxels of the reconstructed volume and the phantom
+void ComputeError(vtkMRMLScalarVolumeNode* outputVolumeNode, ScenarioResult& result)
+{
+  result.RmsError = 0.0;
+  result.FilledVoxelRatio = 0.0;
+  vtkImageData* outputImage = outputVolumeNode ? outputVolumeNode->GetImageData() : nullptr;
+  if (!outputImage || outputImage->GetNumberOfPoints() == 0)
+  {
+    return;
+  }
+
+  vtkNew<vtkMatrix4x4> ijkToRASMatrix;
+  outputVolumeNode->GetIJKToRASMatrix(ijkToRASMatrix.GetPointer());
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  outputImage->GetExtent(extent);
+  double sumSquaredError = 0.0;
+  vtkIdType numberOfFilledVoxels = 0;
+  for (int k = extent[4]; k <= extent[5]; k++)
+  {
+    for (int j = extent[2]; j <= extent[3]; j++)
+    {
+      for (int i = extent[0]; i <= extent[1]; i++)
+      {
+        double value = outputImage->GetScalarComponentAsDouble(i, j, k, 0);
+        if (value == 0.0)
+        {
+          continue;
+        }
+        double ijk[4] = { static_cast<double>(i), static_cast<double>(j), static_cast<double>(k), 1.0 };
+        double ras[4] = { 0.0, 0.0, 0.0, 1.0 };
+        ijkToRASMatrix->MultiplyPoint(ijk, ras);
+        double error = value - GetPhantomValue(ras);
+        sumSquaredError += error * error;
+        numberOfFilledVoxels++;
+      }
+    }
+  }
+  if (numberOfFilledVoxels > 0)
+  {
+    result.RmsError = sqrt(sumSquaredError / numberOfFilledVoxels);
+  }
+  result.FilledVoxelRatio = static_cast<double>(numberOfFilledVoxels) / outputImage->GetNumberOfPoints();
+}
+
+//----------------------------------------------------------------------------
+void WriteResultsAsJson(const std::vector<ScenarioResult>& results, int numberOfFrames, std::ostream& os)
+{
+  vtkNew<vtkMRMLVolumeReconstructionNode> modeNames;
+  os << "{" << std::endl;
+  os << "  \"numberOfFrames\": " << numberOfFrames << "," << std::endl;
+  os << "  \"imageSize\": [" << IMAGE_SIZE_PIXELS[0] << ", " << IMAGE_SIZE_PIXELS[1] << "]," << std::endl;
+  os << "  \"scenarios\": [" << std::endl;
+  for (unsigned int resultIndex = 0; resultIndex < results.size(); resultIndex++)
+  {
+    const ScenarioResult& result = results[resultIndex];
+    os << "    {"
+      << " \"interpolation\": \"" << modeNames->GetInterpolationModeAsString(result.InterpolationMode) << "\","
+      << " \"compounding\": \"" << modeNames->GetCompoundingModeAsString(result.CompoundingMode) << "\","
+      << " \"optimization\": \"" << modeNames->GetOptimizationModeAsString(result.OptimizationMode) << "\","
+      << " \"numberOfThreads\": " << result.NumberOfThreads << ","
+      << " \"framesAdded\": " << result.NumberOfFramesAdded << ","
+      << " \"wallTimeSec\": " << result.WallTimeSec << ","
+      << " \"framesPerSecond\": " << (result.WallTimeSec > 0.0 ? result.NumberOfFramesAdded / result.WallTimeSec : 0.0) << ","
+      << " \"memoryIncreaseMB\": " << result.MemoryIncreaseMB << ","
+      << " \"rmsError\": " << result.RmsError << ","
+      << " \"filledVoxelRatio\": " << result.FilledVoxelRatio << " }"
+      << (resultIndex + 1 < results.size() ? "," : "") << std::endl;
+  }
+  os << "  ]" << std::endl;
+  os << "}" << std::endl;
+}
+
+//----------------------------------------------------------------------------
+int vtkVolumeReconstructionBenchmark(int argc, char* argv[])
+{
+  std::string outputFileName;
+  if (argc > 1)
+  {
+    outputFileName = argv[1];
+  }
+  int numberOfFrames = DEFAULT_NUMBER_OF_FRAMES;
+  if (argc > 2)
+  {
+    numberOfFrames = std::max(2, atoi(argv[2]));
+  }
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkSlicerApplicationLogic> applicationLogic;
+  applicationLogic->SetMRMLScene(scene.GetPointer());
+  vtkNew<vtkSlicerVolumeReconstructionLogic> logic;
+  logic->SetMRMLApplicationLogic(applicationLogic.GetPointer());
+  logic->SetMRMLScene(scene.GetPointer());
+
+  vtkNew<vtkImageData> phantom;
+  CreatePhantom(phantom.GetPointer());
+  vtkNew<vtkMRMLSequenceBrowserNode> sequenceBrowserNode;
+  vtkNew<vtkMRMLScalarVolumeNode> proxyVolumeNode;
+  CreateSweep(scene.GetPointer(), phantom.GetPointer(), numberOfFrames, sequenceBrowserNode.GetPointer(), proxyVolumeNode.GetPointer());
+
+  // ROI around the swept region
+  vtkNew<vtkMRMLMarkupsROINode> roiNode;
+  scene->AddNode(roiNode.GetPointer());
+  roiNode->SetCenter(0.0, 0.0, 0.0);
+  roiNode->SetSize(IMAGE_SIZE_PIXELS[0] * IMAGE_SPACING_MM, SWEEP_LENGTH_MM, IMAGE_SIZE_PIXELS[1] * IMAGE_SPACING_MM);
+
+  const int interpolationModes[] = { vtkMRMLVolumeReconstructionNode::NEAREST_NEIGHBOR_INTERPOLATION,
+    vtkMRMLVolumeReconstructionNode::LINEAR_INTERPOLATION };
+  const int compoundingModes[] = { vtkMRMLVolumeReconstructionNode::LATEST_COMPOUNDING_MODE,
+    vtkMRMLVolumeReconstructionNode::MAXIMUM_COMPOUNDING_MODE, vtkMRMLVolumeReconstructionNode::MEAN_COMPOUNDING_MODE };
+  const int optimizationModes[] = { vtkMRMLVolumeReconstructionNode::NO_OPTIMIZATION,
+    vtkMRMLVolumeReconstructionNode::PARTIAL_OPTIMIZATION, vtkMRMLVolumeReconstructionNode::FULL_OPTIMIZATION };
+  const int numbersOfThreads[] = { 1, 2, 4, 0 }; // 0: number of processors
+
+  std::vector<ScenarioResult> results;
+  bool failed = false;
+  for (int interpolationMode : interpolationModes)
+  {
+    for (int compoundingMode : compoundingModes)
+    {
+      for (int optimizationMode : optimizationModes)
+      {
+        for (int numberOfThreads : numbersOfThreads)
+        {
+          vtkNew<vtkMRMLVolumeReconstructionNode> volumeReconstructionNode;
+          scene->AddNode(volumeReconstructionNode.GetPointer());
+          volumeReconstructionNode->SetAndObserveInputSequenceBrowserNode(sequenceBrowserNode.GetPointer());
+          volumeReconstructionNode->SetAndObserveInputVolumeNode(proxyVolumeNode.GetPointer());
+          volumeReconstructionNode->SetAndObserveInputROINode(roiNode.GetPointer());
+          double outputSpacing[3] = { OUTPUT_SPACING_MM, OUTPUT_SPACING_MM, OUTPUT_SPACING_MM };
+          volumeReconstructionNode->SetOutputSpacing(outputSpacing);
+          volumeReconstructionNode->SetInterpolationMode(interpolationMode);
+          volumeReconstructionNode->SetCompoundingMode(compoundingMode);
+          volumeReconstructionNode->SetOptimizationMode(optimizationMode);
+          volumeReconstructionNode->SetNumberOfThreads(numberOfThreads);
+          volumeReconstructionNode->SetFillHoles(false);
+
+          // Memory of the previous scenario is released by now (if the memory allocator keeps released memory for reuse
+          // instead of returning it to the operating system then the increase may be underestimated)
+          double startMemoryMB = GetMemoryUsageMB();
+          double startTimeSec = vtkTimerLog::GetUniversalTime();
+          logic->ReconstructVolumeFromSequence(volumeReconstructionNode.GetPointer());
+
+          ScenarioResult result;
+          result.WallTimeSec = vtkTimerLog::GetUniversalTime() - startTimeSec;
+          result.InterpolationMode = interpolationMode;
+          result.CompoundingMode = compoundingMode;
+          result.OptimizationMode = optimizationMode;
+          result.NumberOfThreads = numberOfThreads;
+          result.NumberOfFramesAdded = volumeReconstructionNode->GetNumberOfVolumesAddedToReconstruction();
+          result.MemoryIncreaseMB = GetMemoryUsageMB() - startMemoryMB;
+          vtkMRMLScalarVolumeNode* outputVolumeNode = vtkMRMLScalarVolumeNode::SafeDownCast(volumeReconstructionNode->GetOutputVolumeNode());
+          ComputeError(outputVolumeNode, result);
+          results.push_back(result);
+
+          if (result.FilledVoxelRatio == 0.0 || result.RmsError > MAXIMUM_RMS_ERROR)
+          {
+            std::cerr << "Reconstruction error is too high: interpolation=" << volumeReconstructionNode->GetInterpolationModeAsString(interpolationMode)
+              << " compounding=" << volumeReconstructionNode->GetCompoundingModeAsString(compoundingMode)
+              << " optimization=" << volumeReconstructionNode->GetOptimizationModeAsString(optimizationMode)
+              << " threads=" << numberOfThreads << ": RMS error " << result.RmsError
+              << ", filled voxel ratio " << result.FilledVoxelRatio << std::endl;
+            failed = true;
+          }
+
+          // Release the output volume before the next scenario
+          if (outputVolumeNode)
+          {
+            scene->RemoveNode(outputVolumeNode);
+          }
+          scene->RemoveNode(volumeReconstructionNode.GetPointer());
+        }
+      }
+    }
+  }
+
+  if (outputFileName.empty())
+  {
+    WriteResultsAsJson(results, numberOfFrames, std::cout);
+  }
+  else
+  {
+    std::ofstream outputFile(outputFileName.c_str());
+    if (!outputFile)
+    {
+      std::cerr << "Could not write benchmark results to " << outputFileName << std::endl;
+      return EXIT_FAILURE;
+    }
+    WriteResultsAsJson(results, numberOfFrames, outputFile);
+    std::cout << "Benchmark results written to " << outputFileName << std::endl;
+  }
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}